@@ -13,7 +13,13 @@
 #define MODELS_AUGMENTATION_AUGMENTATION_HPP
 
 #include <mlpack.hpp>
-#include <boost/regex.hpp>
+#include <optional>
+#include <random>
+#include "operations.hpp"
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
 
 namespace mlpack {
 namespace models {
@@ -22,9 +28,21 @@ namespace models {
  * Augmentation class used to perform augmentations by transforming the data.
  * For the list of supported augmentation, take a look at our wiki page.
  *
+ * The augmentations are parsed once, when the object is constructed, into
+ * typed operations. Transforming a dataset then only runs those operations.
+ * Resize is applied to the whole dataset, every other augmentation is applied
+ * to each data point independently with the given probability. It is meant to
+ * be called on each minibatch as it is drawn, so every epoch sees different
+ * augmentations without storing augmented copies of the dataset.
+ *
+ * Data points are processed in parallel. Each thread draws from its own
+ * random number stream, so for a fixed seed and number of threads the
+ * augmentations are reproducible.
+ *
  * @code
- * Augmentation augmentation({"horizontal-flip", "resize = (224, 224)"}, 0.2);
- * augmentation.Transform(dataloader.TrainFeatures);
+ * Augmentation augmentation({"horizontal-flip", "rotation = 15"}, 0.2);
+ * arma::mat batch = dataset.cols(0, 31);
+ * augmentation.Transform(batch, 224, 224, 3);
  * @endcode
  */
 class Augmentation
@@ -32,10 +50,9 @@ class Augmentation
  public:
   //! Create the augmentation class object.
   Augmentation() :
-      augmentations(std::vector<std::string>()),
       augmentationProbability(0.2)
   {
-    // Nothing to do here.
+    Seed(mlpack::RandInt(std::numeric_limits<int>::max()));
   }
 
   /**
@@ -47,27 +64,19 @@ class Augmentation
    *                                the dataset.
    *                                NOTE : This doesn't apply to augmentations
    *                                such as resize.
+   * @param seed Seed for the random number streams. Defaults to a value drawn
+   *             from mlpack's random number generator, so mlpack::RandomSeed()
+   *             makes the augmentations reproducible.
    */
   Augmentation(const std::vector<std::string>& augmentations,
-               const double augmentationProbability) :
-               augmentations(augmentations),
-               augmentationProbability(augmentationProbability)
-  {
-    // Convert strings to lower case.
-    for (size_t i = 0; i < augmentations.size(); i++)
-      this->augmentations[i] = mlpack::util::ToLower(augmentations[i]);
-
-    // Sort the vector to place resize parameter to the front of the string.
-    // This prevents constant lookups for resize.
-    sort(this->augmentations.begin(), this->augmentations.end(), [](
-        std::string& str1, std::string& str2)
-        {
-          return str1.find("resize") != std::string::npos;
-        });
-  }
+               const double augmentationProbability,
+               const size_t seed = mlpack::RandInt(
+                   std::numeric_limits<int>::max()));
 
   /**
-   * Applies augmentation to the passed dataset.
+   * Applies augmentation to the passed dataset or minibatch. Each call
+   * advances the random number streams, so every call draws new
+   * augmentations.
    *
    * @tparam DatasetType Datatype on which augmentation will be done.
    * 
@@ -86,7 +95,7 @@ class Augmentation
                  const size_t datapointDepth = 1);
 
   /**
-   * Applies resize transform to the entire dataset.
+   * Applies only the resize transform, if any, to the entire dataset.
    *
    * @tparam DatasetType Datatype on which augmentation will be done.
    * 
@@ -97,90 +106,85 @@ class Augmentation
    * @param datapointHeight Height of a single data point.
    * @param datapointDepth Depth of a single data point. For one 2-dimensional
    *                       data point, set it to 1. Defaults to 1.
-   * @param augmentation String containing the transform.
    */
   template<typename DatasetType>
   void ResizeTransform(DatasetType& dataset,
                        const size_t datapointWidth,
                        const size_t datapointHeight,
-                       const size_t datapointDepth,
-                       const std::string& augmentation);
+                       const size_t datapointDepth = 1) const;
 
- private:
   /**
-   * Function to determine if augmentation has Resize function.
+   * Reseed the random number streams. Stream i is seeded with seed + i.
    *
-   * @param augmentation Optional argument to check if a string has
-   *                     resize substring.
+   * @param seed Seed for the random number streams.
    */
-  bool HasResizeParam(const std::string& augmentation = "")
-  {
-    if (augmentation.length())
-      return augmentation.find("resize") != std::string::npos;
+  void Seed(const size_t seed);
 
+  //! Determine whether a resize augmentation was given.
+  bool HasResize() const { return resize.has_value(); }
 
-    // Search in augmentation vector.
-    return augmentations.size() <= 0 ? false :
-        augmentations[0].find("resize") != std::string::npos;
+  //! Get the parsed random augmentations that are applied per data point.
+  const std::vector<AugmentationOperation>& Operations() const
+  {
+    return operations;
   }
 
+  //! Get the augmentation probability.
+  double AugmentationProbability() const { return augmentationProbability; }
+
+ private:
   /**
-   * Sets size of output width and output height of the new data.
+   * Parse a single augmentation string. The name of the augmentation is the
+   * leading word of the string and any numbers that follow are its
+   * parameters, e.g. "resize = (64, 32)", "resize : 8" or "rotation = 15".
+   * Resize is stored separately, every other augmentation is added to the
+   * operations. Throws if the augmentation is unknown or its parameters are
+   * invalid.
    *
-   * @param outWidth Output width of resized data point.
-   * @param outHeight Output height of resized data point.
-   * @param augmentation String from which output width and height
-   *                     are extracted.
+   * @param augmentation String containing the augmentation.
    */
-  void GetResizeParam(size_t& outWidth,
-                      size_t& outHeight,
-                      const std::string& augmentation)
-  {
-    if (!HasResizeParam())
-      return;
-
-    outWidth = 0;
-    outHeight = 0;
-
-    // Use regex to find one or two numbers. If only one provided
-    // set output width equal to output height.
-    boost::regex regex{"[0-9]+"};
-
-    // Create an iterator to find matches.
-    boost::sregex_token_iterator matches(augmentation.begin(),
-        augmentation.end(), regex, 0), end;
-
-    size_t matchesCount = std::distance(matches, end);
-
-    if (matchesCount == 0)
-    {
-      mlpack::Log::Fatal << "Invalid size / shape in " <<
-          augmentation << std::endl;
-    }
-
-    if (matchesCount == 1)
-    {
-      outWidth = std::stoi(*matches);
-      outHeight = outWidth;
-    }
-    else
-    {
-      outWidth = std::stoi(*matches);
-      matches++;
-      outHeight = std::stoi(*matches);
-    }
-  }
+  void Parse(const std::string& augmentation);
+
+  /**
+   * Split an augmentation string into its lowercase name and the numbers that
+   * follow it.
+   *
+   * @param augmentation String containing the augmentation.
+   * @param name Set to the name of the augmentation.
+   * @param parameters Set to the parameters of the augmentation.
+   */
+  static void Tokenize(const std::string& augmentation,
+                       std::string& name,
+                       std::vector<double>& parameters);
+
+  /**
+   * Checks for a size made of one or two positive integers. If only one is
+   * provided the width and height are set to the same value.
+   */
+  static bool IsValidSize(const std::vector<double>& parameters);
+
+  //! Get the resize operation. Must only be called if HasResize() is true.
+  const ResizeAugmentation& Resize() const { return *resize; }
 
-  //! Locally held augmentations and transforms that need to be applied.
-  std::vector<std::string> augmentations;
+  //! Locally held resize transform, if any.
+  std::optional<ResizeAugmentation> resize;
+
+  //! Locally held random augmentations that need to be applied.
+  std::vector<AugmentationOperation> operations;
 
   //! Locally held value of augmentation probability.
   double augmentationProbability;
 
+  //! Locally held random number stream of each thread.
+  std::vector<std::mt19937> generators;
+
   // The dataloader class should have access to internal functions of
   // the augmentation class.
   template<typename DatasetX, typename DatasetY, class ScalerType>
   friend class DataLoader;
+
+  // Augmentations of detection data are parsed the same way.
+  friend class BoxAugmentation;
 };
 
 } // namespace models
@@ -18,32 +18,223 @@
 namespace mlpack {
 namespace models {
 
+inline Augmentation::Augmentation(
+    const std::vector<std::string>& augmentations,
+    const double augmentationProbability,
+    const size_t seed) :
+    augmentationProbability(augmentationProbability)
+{
+  for (size_t i = 0; i < augmentations.size(); i++)
+    Parse(augmentations[i]);
+
+  Seed(seed);
+}
+
+inline void Augmentation::Seed(const size_t seed)
+{
+  size_t numThreads = 1;
+  #ifdef _OPENMP
+  numThreads = omp_get_max_threads();
+  #endif
+
+  generators.clear();
+  for (size_t i = 0; i < numThreads; ++i)
+    generators.push_back(std::mt19937(seed + i));
+}
+
+inline void Augmentation::Tokenize(const std::string& augmentation,
+                                   std::string& name,
+                                   std::vector<double>& parameters)
+{
+  const std::string lowerAugmentation = mlpack::util::ToLower(augmentation);
+
+  // The name is the leading word, it may contain hyphens.
+  size_t nameBegin = 0;
+  while (nameBegin < lowerAugmentation.length() &&
+      std::isspace(lowerAugmentation[nameBegin]))
+  {
+    nameBegin++;
+  }
+
+  size_t nameEnd = nameBegin;
+  while (nameEnd < lowerAugmentation.length() &&
+      (std::isalpha(lowerAugmentation[nameEnd]) ||
+      lowerAugmentation[nameEnd] == '-'))
+  {
+    nameEnd++;
+  }
+
+  name = lowerAugmentation.substr(nameBegin, nameEnd - nameBegin);
+
+  // Collect all the numbers that follow the name.
+  parameters.clear();
+  for (size_t i = nameEnd; i < lowerAugmentation.length(); )
+  {
+    if (!std::isdigit(lowerAugmentation[i]) && lowerAugmentation[i] != '.')
+    {
+      i++;
+      continue;
+    }
+
+    char* numberEnd = NULL;
+    const double value = std::strtod(lowerAugmentation.c_str() + i,
+        &numberEnd);
+    const size_t length = numberEnd - (lowerAugmentation.c_str() + i);
+    if (length == 0)
+    {
+      i++;
+      continue;
+    }
+
+    parameters.push_back(value);
+    i += length;
+  }
+}
+
+inline bool Augmentation::IsValidSize(const std::vector<double>& parameters)
+{
+  if (parameters.size() == 0 || parameters.size() > 2)
+    return false;
+
+  for (const double parameter : parameters)
+  {
+    if (parameter < 1 || std::floor(parameter) != parameter)
+      return false;
+  }
+
+  return true;
+}
+
+inline void Augmentation::Parse(const std::string& augmentation)
+{
+  std::string name;
+  std::vector<double> parameters;
+  Tokenize(augmentation, name, parameters);
+
+  if (name == "resize")
+  {
+    if (!IsValidSize(parameters))
+    {
+      mlpack::Log::Fatal << "Invalid size / shape in " << augmentation <<
+          std::endl;
+    }
+
+    if (resize.has_value())
+    {
+      mlpack::Log::Fatal << "Only a single resize augmentation can be "
+          << "applied." << std::endl;
+    }
+
+    resize = ResizeAugmentation(parameters[0], parameters.back());
+  }
+  else if (name == "horizontal-flip")
+  {
+    operations.push_back(HorizontalFlipAugmentation());
+  }
+  else if (name == "vertical-flip")
+  {
+    operations.push_back(VerticalFlipAugmentation());
+  }
+  else if (name == "random-crop")
+  {
+    if (!IsValidSize(parameters))
+    {
+      mlpack::Log::Fatal << "Invalid size / shape in " << augmentation <<
+          std::endl;
+    }
+
+    operations.push_back(RandomCropAugmentation(parameters[0],
+        parameters.back()));
+  }
+  else if (name == "rotation")
+  {
+    if (parameters.size() != 1 || parameters[0] > 180)
+    {
+      mlpack::Log::Fatal << "Rotation requires a single angle in degrees "
+          << "between 0 and 180, found " << augmentation << std::endl;
+    }
+
+    operations.push_back(RotationAugmentation(parameters[0]));
+  }
+  else if (name == "brightness" || name == "contrast")
+  {
+    if (parameters.size() != 1 || parameters[0] > 1)
+    {
+      mlpack::Log::Fatal << "Brightness and contrast require a single "
+          << "relative change between 0 and 1, found " << augmentation
+          << std::endl;
+    }
+
+    if (name == "brightness")
+      operations.push_back(BrightnessAugmentation(parameters[0]));
+    else
+      operations.push_back(ContrastAugmentation(parameters[0]));
+  }
+  else
+  {
+    mlpack::Log::Fatal << "Unknown augmentation : \'" << augmentation <<
+        "\' not found!" << std::endl;
+  }
+}
+
 template<typename DatasetType>
 void Augmentation::Transform(DatasetType& dataset,
                              const size_t datapointWidth,
                              const size_t datapointHeight,
                              const size_t datapointDepth)
 {
-  // Initialize the augmentation map.
-  std::unordered_map<std::string, void(*)(DatasetType&,
-       size_t, size_t, size_t, std::string&)> augmentationMap;
+  typedef typename DatasetType::elem_type ElemType;
 
-  for (size_t i = 0; i < augmentations.size(); i++)
+  size_t width = datapointWidth;
+  size_t height = datapointHeight;
+  if (HasResize())
+    Resize().Transform(dataset, width, height, datapointDepth);
+
+  if (operations.size() == 0)
+    return;
+
+  // Errors can't leave the parallel region, so the crop sizes are checked
+  // before it.
+  for (const AugmentationOperation& operation : operations)
   {
-    if (augmentationMap.count(augmentations[i]))
-    {
-      augmentationMap[augmentations[i]](dataset, datapointWidth,
-        datapointHeight, datapointDepth, augmentations[i]);
-    }
-    else if (this->HasResizeParam(augmentations[i]))
+    const RandomCropAugmentation* crop =
+        std::get_if<RandomCropAugmentation>(&operation);
+    if (crop && (crop->CropWidth() > width || crop->CropHeight() > height))
     {
-      this->ResizeTransform(dataset, datapointWidth, datapointHeight,
-        datapointDepth, augmentations[i]);
+      mlpack::Log::Fatal << "Crop size (" << crop->CropWidth() << ", "
+          << crop->CropHeight() << ") is larger than the data point (" << width
+          << ", " << height << ")." << std::endl;
     }
-    else
+  }
+
+  #pragma omp parallel num_threads(generators.size())
+  {
+    size_t thread = 0;
+    #ifdef _OPENMP
+    thread = omp_get_thread_num();
+    #endif
+
+    std::mt19937& generator = generators[thread];
+    std::uniform_real_distribution<double> distribution(0.0, 1.0);
+    arma::Col<ElemType> buffer;
+
+    // A static schedule hands every thread the same data points on each call,
+    // which keeps the augmentations reproducible.
+    #pragma omp for schedule(static)
+    for (omp_size_t i = 0; i < (omp_size_t) dataset.n_cols; ++i)
     {
-      mlpack::Log::Warn << "Unknown augmentation : \'" <<
-          augmentations[i] << "\' not found!" << std::endl;
+      ElemType* point = dataset.colptr(i);
+      for (const AugmentationOperation& operation : operations)
+      {
+        if (distribution(generator) >= augmentationProbability)
+          continue;
+
+        std::visit([&](const auto& op)
+            {
+              op.Transform(point, width, height, datapointDepth, generator,
+                  buffer);
+            }, operation);
+      }
     }
   }
 }
@@ -53,23 +244,14 @@ void Augmentation::ResizeTransform(
     DatasetType& dataset,
     const size_t datapointWidth,
     const size_t datapointHeight,
-    const size_t datapointDepth,
-    const std::string& augmentation)
+    const size_t datapointDepth) const
 {
-  size_t outputWidth = 0, outputHeight = 0;
-
-  // Get output width and output height.
-  GetResizeParam(outputWidth, outputHeight, augmentation);
-
-  // We will use mlpack's bilinear interpolation layer to
-  // resize the input.
-  mlpack::BilinearInterpolation<DatasetType, DatasetType> resizeLayer(
-      datapointWidth, datapointHeight, outputWidth, outputHeight,
-      datapointDepth);
+  if (!HasResize())
+    return;
 
-  DatasetType output;
-  resizeLayer.Forward(dataset, output);
-  dataset = std::move(output);
+  size_t width = datapointWidth;
+  size_t height = datapointHeight;
+  Resize().Transform(dataset, width, height, datapointDepth);
 }
 
 } // namespace models
@@ -0,0 +1,194 @@
+/**
+ * @file box_augmentation.hpp
+ * @author Kartik Dutt
+ *
+ * Definition of BoxAugmentation class for augmenting object detection data.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_AUGMENTATION_BOX_AUGMENTATION_HPP
+#define MODELS_AUGMENTATION_BOX_AUGMENTATION_HPP
+
+#include <mlpack.hpp>
+#include <optional>
+#include <random>
+#include "augmentation.hpp"
+#include "box_operations.hpp"
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+namespace mlpack {
+namespace models {
+
+/**
+ * Augmentation of object detection data that keeps the bounding boxes in sync
+ * with the image. The labels of each data point are a vector of boxes, each
+ * stored as (class, x1, y1, x2, y2) in pixels.
+ *
+ * Each augmentation is drawn independently for every data point with the
+ * given probability. The drawn augmentations are composed into a single map,
+ * so the image is resampled once however many of them are applied. Boxes are
+ * mapped with the image and clipped to it. Boxes that end up outside the image
+ * are removed from arma::field labels, and left with zero area in matrix
+ * labels, whose number of rows is fixed.
+ *
+ * Images are expected in the layout mlpack::data::Load produces, i.e. with the
+ * channels of each pixel stored next to each other. Like the Augmentation
+ * class, every thread draws from its own random number stream, so for a fixed
+ * seed and number of threads the augmentations are reproducible.
+ *
+ * Supported augmentations are "horizontal-flip", "vertical-flip",
+ * "random-crop = (width, height)", "translate = maxShift" and
+ * "scale-jitter = delta". A "resize" is recorded but not applied, the
+ * DataLoader resizes images while decoding them.
+ *
+ * @code
+ * BoxAugmentation augmentation({"horizontal-flip", "translate = 0.1",
+ *     "scale-jitter = 0.2"}, 0.5);
+ * augmentation.Transform(images, boxes, 416, 416, 3);
+ * @endcode
+ */
+class BoxAugmentation
+{
+ public:
+  //! Create the augmentation class object.
+  BoxAugmentation() :
+      augmentationProbability(0.2)
+  {
+    Seed(mlpack::RandInt(std::numeric_limits<int>::max()));
+  }
+
+  /**
+   * Constructor for the box augmentation class.
+   *
+   * @param augmentations List of strings containing one of the supported
+   *                      augmentations.
+   * @param augmentationProbability Probability of applying each augmentation
+   *                                to a data point.
+   * @param seed Seed for the random number streams.
+   */
+  BoxAugmentation(const std::vector<std::string>& augmentations,
+                  const double augmentationProbability,
+                  const size_t seed = mlpack::RandInt(
+                      std::numeric_limits<int>::max()));
+
+  /**
+   * Applies the augmentations to a minibatch of images and their boxes. Each
+   * call advances the random number streams, so every call draws new
+   * augmentations.
+   *
+   * @param dataset Images, each column is a data point.
+   * @param labels Boxes of each data point, either an arma::field of vectors
+   *               or a matrix with one column per data point.
+   * @param datapointWidth Width of a single data point.
+   * @param datapointHeight Height of a single data point.
+   * @param datapointDepth Depth of a single data point.
+   */
+  template<typename DatasetType, typename LabelsType>
+  void Transform(DatasetType& dataset,
+                 LabelsType& labels,
+                 const size_t datapointWidth,
+                 const size_t datapointHeight,
+                 const size_t datapointDepth);
+
+  /**
+   * Reseed the random number streams. Stream i is seeded with seed + i.
+   *
+   * @param seed Seed for the random number streams.
+   */
+  void Seed(const size_t seed);
+
+  //! Determine whether a resize augmentation was given.
+  bool HasResize() const { return resize.has_value(); }
+
+  //! Get the parsed augmentations.
+  const std::vector<BoxAugmentationOperation>& Operations() const
+  {
+    return operations;
+  }
+
+  //! Get the augmentation probability.
+  double AugmentationProbability() const { return augmentationProbability; }
+
+ private:
+  /**
+   * Parse a single augmentation string. Throws if the augmentation is not
+   * supported for detection data or its parameters are invalid.
+   *
+   * @param augmentation String containing the augmentation.
+   */
+  void Parse(const std::string& augmentation);
+
+  /**
+   * Resample an image with the inverse of the given map. Pixels that map to
+   * outside of the image are zero.
+   */
+  template<typename eT>
+  static void Warp(eT* point,
+                   arma::Col<eT>& buffer,
+                   const size_t width,
+                   const size_t height,
+                   const size_t depth,
+                   const BoxTransform& transform);
+
+  /**
+   * Map the boxes and clip them to the image. Boxes left outside of the image
+   * are moved behind the ones that are kept.
+   *
+   * @return Number of boxes that are kept.
+   */
+  template<typename eT>
+  static size_t MapBoxes(eT* boxes,
+                         const size_t numBoxes,
+                         const size_t width,
+                         const size_t height,
+                         const BoxTransform& transform);
+
+  //! Map the boxes of a data point stored in a field.
+  template<typename eT>
+  static void MapLabels(arma::field<arma::Col<eT>>& labels,
+                        const size_t i,
+                        const size_t width,
+                        const size_t height,
+                        const BoxTransform& transform);
+
+  //! Map the boxes of a data point stored in a matrix column.
+  template<typename eT>
+  static void MapLabels(arma::Mat<eT>& labels,
+                        const size_t i,
+                        const size_t width,
+                        const size_t height,
+                        const BoxTransform& transform);
+
+  //! Get the resize operation. Must only be called if HasResize() is true.
+  const ResizeAugmentation& Resize() const { return *resize; }
+
+  //! Locally held resize, which is applied when images are decoded.
+  std::optional<ResizeAugmentation> resize;
+
+  //! Locally held augmentations that need to be applied.
+  std::vector<BoxAugmentationOperation> operations;
+
+  //! Locally held value of augmentation probability.
+  double augmentationProbability;
+
+  //! Locally held random number stream of each thread.
+  std::vector<std::mt19937> generators;
+
+  // The dataloader class should have access to internal functions of
+  // the augmentation class.
+  template<typename DatasetX, typename DatasetY, class ScalerType>
+  friend class DataLoader;
+};
+
+} // namespace models
+} // namespace mlpack
+
+#include "box_augmentation_impl.hpp" // Include implementation.
+
+#endif
@@ -0,0 +1,322 @@
+/**
+ * @file box_augmentation_impl.hpp
+ * @author Kartik Dutt
+ *
+ * Implementation of BoxAugmentation class for augmenting object detection
+ * data.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_AUGMENTATION_BOX_AUGMENTATION_IMPL_HPP
+#define MODELS_AUGMENTATION_BOX_AUGMENTATION_IMPL_HPP
+
+// Incase it has not been included already.
+#include "box_augmentation.hpp"
+
+namespace mlpack {
+namespace models {
+
+inline BoxAugmentation::BoxAugmentation(
+    const std::vector<std::string>& augmentations,
+    const double augmentationProbability,
+    const size_t seed) :
+    augmentationProbability(augmentationProbability)
+{
+  for (size_t i = 0; i < augmentations.size(); i++)
+    Parse(augmentations[i]);
+
+  Seed(seed);
+}
+
+inline void BoxAugmentation::Seed(const size_t seed)
+{
+  size_t numThreads = 1;
+  #ifdef _OPENMP
+  numThreads = omp_get_max_threads();
+  #endif
+
+  generators.clear();
+  for (size_t i = 0; i < numThreads; ++i)
+    generators.push_back(std::mt19937(seed + i));
+}
+
+inline void BoxAugmentation::Parse(const std::string& augmentation)
+{
+  std::string name;
+  std::vector<double> parameters;
+  Augmentation::Tokenize(augmentation, name, parameters);
+
+  if (name == "resize")
+  {
+    if (!Augmentation::IsValidSize(parameters))
+    {
+      mlpack::Log::Fatal << "Invalid size / shape in " << augmentation <<
+          std::endl;
+    }
+
+    if (resize.has_value())
+    {
+      mlpack::Log::Fatal << "Only a single resize augmentation can be "
+          << "applied." << std::endl;
+    }
+
+    resize = ResizeAugmentation(parameters[0], parameters.back());
+  }
+  else if (name == "horizontal-flip")
+  {
+    operations.push_back(BoxHorizontalFlipAugmentation());
+  }
+  else if (name == "vertical-flip")
+  {
+    operations.push_back(BoxVerticalFlipAugmentation());
+  }
+  else if (name == "random-crop")
+  {
+    if (!Augmentation::IsValidSize(parameters))
+    {
+      mlpack::Log::Fatal << "Invalid size / shape in " << augmentation <<
+          std::endl;
+    }
+
+    operations.push_back(BoxRandomCropAugmentation(parameters[0],
+        parameters.back()));
+  }
+  else if (name == "translate" || name == "scale-jitter")
+  {
+    if (parameters.size() != 1 || parameters[0] >= 1)
+    {
+      mlpack::Log::Fatal << "Translate and scale jitter require a single "
+          << "relative change between 0 and 1, found " << augmentation
+          << std::endl;
+    }
+
+    if (name == "translate")
+      operations.push_back(BoxTranslateAugmentation(parameters[0]));
+    else
+      operations.push_back(BoxScaleJitterAugmentation(parameters[0]));
+  }
+  else
+  {
+    mlpack::Log::Fatal << "Augmentation \'" << augmentation << "\' is not "
+        << "supported for object detection!" << std::endl;
+  }
+}
+
+template<typename DatasetType, typename LabelsType>
+void BoxAugmentation::Transform(DatasetType& dataset,
+                                LabelsType& labels,
+                                const size_t datapointWidth,
+                                const size_t datapointHeight,
+                                const size_t datapointDepth)
+{
+  typedef typename DatasetType::elem_type ElemType;
+
+  if (operations.size() == 0)
+    return;
+
+  if (labels.n_elem != dataset.n_cols && labels.n_cols != dataset.n_cols)
+  {
+    mlpack::Log::Fatal << "Number of labels (" << labels.n_elem << ") must "
+        << "match the number of data points (" << dataset.n_cols << ")."
+        << std::endl;
+  }
+
+  // Errors can't leave the parallel region, so the crop sizes are checked
+  // before it.
+  for (const BoxAugmentationOperation& operation : operations)
+  {
+    const BoxRandomCropAugmentation* crop =
+        std::get_if<BoxRandomCropAugmentation>(&operation);
+    if (crop && (crop->CropWidth() > datapointWidth ||
+        crop->CropHeight() > datapointHeight))
+    {
+      mlpack::Log::Fatal << "Crop size (" << crop->CropWidth() << ", "
+          << crop->CropHeight() << ") is larger than the data point ("
+          << datapointWidth << ", " << datapointHeight << ")." << std::endl;
+    }
+  }
+
+  #pragma omp parallel num_threads(generators.size())
+  {
+    size_t thread = 0;
+    #ifdef _OPENMP
+    thread = omp_get_thread_num();
+    #endif
+
+    std::mt19937& generator = generators[thread];
+    std::uniform_real_distribution<double> distribution(0.0, 1.0);
+    arma::Col<ElemType> buffer;
+
+    // A static schedule hands every thread the same data points on each call,
+    // which keeps the augmentations reproducible.
+    #pragma omp for schedule(static)
+    for (omp_size_t i = 0; i < (omp_size_t) dataset.n_cols; ++i)
+    {
+      BoxTransform transform;
+      for (const BoxAugmentationOperation& operation : operations)
+      {
+        if (distribution(generator) >= augmentationProbability)
+          continue;
+
+        std::visit([&](const auto& op)
+            {
+              op.Compose(transform, datapointWidth, datapointHeight,
+                  generator);
+            }, operation);
+      }
+
+      if (transform.IsIdentity())
+        continue;
+
+      Warp(dataset.colptr(i), buffer, datapointWidth, datapointHeight,
+          datapointDepth, transform);
+      MapLabels(labels, i, datapointWidth, datapointHeight, transform);
+    }
+  }
+}
+
+template<typename eT>
+void BoxAugmentation::Warp(eT* point,
+                           arma::Col<eT>& buffer,
+                           const size_t width,
+                           const size_t height,
+                           const size_t depth,
+                           const BoxTransform& transform)
+{
+  // Source pixels and weights of every output column and row. The center of
+  // output pixel x is mapped back to the input, pixels whose center falls
+  // outside of the input are zero.
+  auto sourceAxis = [](const size_t size, const double scale,
+      const double offset, std::vector<size_t>& lower,
+      std::vector<double>& weights, std::vector<bool>& valid)
+  {
+    lower.resize(size);
+    weights.resize(size);
+    valid.resize(size);
+    for (size_t i = 0; i < size; ++i)
+    {
+      const double center = (i + 0.5 - offset) / scale;
+      valid[i] = (center >= 0.0 && center <= size);
+      const double position = std::min(std::max(center - 0.5, 0.0),
+          (double) size - 1);
+      lower[i] = std::min((size_t) position, size > 1 ? size - 2 : 0);
+      weights[i] = (size > 1) ? position - lower[i] : 0.0;
+    }
+  };
+
+  std::vector<size_t> xLower, yLower;
+  std::vector<double> xWeights, yWeights;
+  std::vector<bool> xValid, yValid;
+  sourceAxis(width, transform.xScale, transform.xOffset, xLower, xWeights,
+      xValid);
+  sourceAxis(height, transform.yScale, transform.yOffset, yLower, yWeights,
+      yValid);
+
+  buffer.set_size(width * height * depth);
+  std::copy(point, point + buffer.n_elem, buffer.memptr());
+  const eT* source = buffer.memptr();
+  const size_t xNext = (width > 1) ? depth : 0;
+  const size_t yNext = (height > 1) ? width * depth : 0;
+
+  for (size_t y = 0; y < height; ++y)
+  {
+    eT* row = point + y * width * depth;
+    if (!yValid[y])
+    {
+      std::fill(row, row + width * depth, eT(0));
+      continue;
+    }
+
+    const double dy = yWeights[y];
+    const eT* sourceRow = source + yLower[y] * width * depth;
+    for (size_t x = 0; x < width; ++x)
+    {
+      eT* pixel = row + x * depth;
+      if (!xValid[x])
+      {
+        std::fill(pixel, pixel + depth, eT(0));
+        continue;
+      }
+
+      const double dx = xWeights[x];
+      const eT* topLeft = sourceRow + xLower[x] * depth;
+      for (size_t c = 0; c < depth; ++c)
+      {
+        pixel[c] = (eT) ((1 - dx) * (1 - dy) * topLeft[c] +
+            dx * (1 - dy) * topLeft[c + xNext] +
+            (1 - dx) * dy * topLeft[c + yNext] +
+            dx * dy * topLeft[c + xNext + yNext]);
+      }
+    }
+  }
+}
+
+template<typename eT>
+size_t BoxAugmentation::MapBoxes(eT* boxes,
+                                 const size_t numBoxes,
+                                 const size_t width,
+                                 const size_t height,
+                                 const BoxTransform& transform)
+{
+  size_t kept = 0;
+  for (size_t b = 0; b < numBoxes; ++b)
+  {
+    eT* box = boxes + 5 * b;
+    double x1 = transform.xScale * box[1] + transform.xOffset;
+    double x2 = transform.xScale * box[3] + transform.xOffset;
+    double y1 = transform.yScale * box[2] + transform.yOffset;
+    double y2 = transform.yScale * box[4] + transform.yOffset;
+
+    // Flips swap the corners.
+    if (x1 > x2)
+      std::swap(x1, x2);
+    if (y1 > y2)
+      std::swap(y1, y2);
+
+    box[1] = (eT) std::min(std::max(x1, 0.0), (double) width);
+    box[2] = (eT) std::min(std::max(y1, 0.0), (double) height);
+    box[3] = (eT) std::min(std::max(x2, 0.0), (double) width);
+    box[4] = (eT) std::min(std::max(y2, 0.0), (double) height);
+
+    if (box[3] > box[1] && box[4] > box[2])
+    {
+      if (kept != b)
+        std::swap_ranges(box, box + 5, boxes + 5 * kept);
+      kept++;
+    }
+  }
+
+  return kept;
+}
+
+template<typename eT>
+void BoxAugmentation::MapLabels(arma::field<arma::Col<eT>>& labels,
+                                const size_t i,
+                                const size_t width,
+                                const size_t height,
+                                const BoxTransform& transform)
+{
+  arma::Col<eT>& boxes = labels(i);
+  const size_t kept = MapBoxes(boxes.memptr(), boxes.n_elem / 5, width,
+      height, transform);
+  if (kept * 5 < boxes.n_elem)
+    boxes.resize(kept * 5);
+}
+
+template<typename eT>
+void BoxAugmentation::MapLabels(arma::Mat<eT>& labels,
+                                const size_t i,
+                                const size_t width,
+                                const size_t height,
+                                const BoxTransform& transform)
+{
+  MapBoxes(labels.colptr(i), labels.n_rows / 5, width, height, transform);
+}
+
+} // namespace models
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,281 @@
+/**
+ * @file box_operations.hpp
+ * @author Kartik Dutt
+ *
+ * Definition of the typed operations that make up a bounding box aware
+ * augmentation pipeline. Every operation is an axis aligned affine map of the
+ * image plane, so the operations drawn for a data point compose into a single
+ * map that is applied to the image and its boxes at once.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_AUGMENTATION_BOX_OPERATIONS_HPP
+#define MODELS_AUGMENTATION_BOX_OPERATIONS_HPP
+
+#include <mlpack.hpp>
+#include <random>
+#include <variant>
+
+namespace mlpack {
+namespace models {
+
+/**
+ * Axis aligned affine map of the image plane, a point (x, y) is mapped to
+ * (xScale * x + xOffset, yScale * y + yOffset). Coordinates are continuous,
+ * i.e. an image of width w spans [0, w].
+ */
+struct BoxTransform
+{
+  //! Create the identity map.
+  BoxTransform() :
+      xScale(1.0),
+      xOffset(0.0),
+      yScale(1.0),
+      yOffset(0.0)
+  {
+    // Nothing to do here.
+  }
+
+  /**
+   * Apply the given map after the current one.
+   *
+   * @param xs Scale along the width.
+   * @param xo Offset along the width.
+   * @param ys Scale along the height.
+   * @param yo Offset along the height.
+   */
+  void Append(const double xs,
+              const double xo,
+              const double ys,
+              const double yo)
+  {
+    xScale *= xs;
+    xOffset = xs * xOffset + xo;
+    yScale *= ys;
+    yOffset = ys * yOffset + yo;
+  }
+
+  //! Determine whether the map leaves every point in place.
+  bool IsIdentity() const
+  {
+    return xScale == 1.0 && xOffset == 0.0 && yScale == 1.0 &&
+        yOffset == 0.0;
+  }
+
+  //! Scale along the width.
+  double xScale;
+  //! Offset along the width.
+  double xOffset;
+  //! Scale along the height.
+  double yScale;
+  //! Offset along the height.
+  double yOffset;
+};
+
+/**
+ * Mirrors the image and its boxes along the width.
+ */
+class BoxHorizontalFlipAugmentation
+{
+ public:
+  /**
+   * Add the operation to the map of a data point.
+   *
+   * @param transform Map of the data point.
+   * @param width Width of the data point.
+   * @param height Height of the data point.
+   * @param generator Random number generator of the calling thread.
+   */
+  template<typename GeneratorType>
+  void Compose(BoxTransform& transform,
+               const size_t width,
+               const size_t /* height */,
+               GeneratorType& /* generator */) const
+  {
+    transform.Append(-1.0, width, 1.0, 0.0);
+  }
+};
+
+/**
+ * Mirrors the image and its boxes along the height.
+ */
+class BoxVerticalFlipAugmentation
+{
+ public:
+  /**
+   * Add the operation to the map of a data point.
+   *
+   * @param transform Map of the data point.
+   * @param width Width of the data point.
+   * @param height Height of the data point.
+   * @param generator Random number generator of the calling thread.
+   */
+  template<typename GeneratorType>
+  void Compose(BoxTransform& transform,
+               const size_t /* width */,
+               const size_t height,
+               GeneratorType& /* generator */) const
+  {
+    transform.Append(1.0, 0.0, -1.0, height);
+  }
+};
+
+/**
+ * Crops a random window of fixed size and scales it back to the size of the
+ * data point. Boxes are moved with the window and clipped to it.
+ */
+class BoxRandomCropAugmentation
+{
+ public:
+  /**
+   * Create the random crop operation.
+   *
+   * @param cropWidth Width of the cropped window.
+   * @param cropHeight Height of the cropped window.
+   */
+  BoxRandomCropAugmentation(const size_t cropWidth, const size_t cropHeight) :
+      cropWidth(cropWidth),
+      cropHeight(cropHeight)
+  {
+    // Nothing to do here.
+  }
+
+  /**
+   * Add the operation to the map of a data point. The crop size must not be
+   * larger than the data point, which BoxAugmentation::Transform() checks
+   * before it applies the operations.
+   *
+   * @param transform Map of the data point.
+   * @param width Width of the data point.
+   * @param height Height of the data point.
+   * @param generator Random number generator of the calling thread.
+   */
+  template<typename GeneratorType>
+  void Compose(BoxTransform& transform,
+               const size_t width,
+               const size_t height,
+               GeneratorType& generator) const
+  {
+    std::uniform_int_distribution<size_t> xDistribution(0, width - cropWidth);
+    std::uniform_int_distribution<size_t> yDistribution(0,
+        height - cropHeight);
+    const double xOrigin = xDistribution(generator);
+    const double yOrigin = yDistribution(generator);
+
+    const double xScale = (double) width / cropWidth;
+    const double yScale = (double) height / cropHeight;
+    transform.Append(xScale, -xOrigin * xScale, yScale, -yOrigin * yScale);
+  }
+
+  //! Get the width of the cropped window.
+  size_t CropWidth() const { return cropWidth; }
+  //! Get the height of the cropped window.
+  size_t CropHeight() const { return cropHeight; }
+
+ private:
+  //! Locally stored width of the cropped window.
+  size_t cropWidth;
+
+  //! Locally stored height of the cropped window.
+  size_t cropHeight;
+};
+
+/**
+ * Shifts the image and its boxes by a random offset. Parts of the image that
+ * are shifted in are zero.
+ */
+class BoxTranslateAugmentation
+{
+ public:
+  /**
+   * Create the translate operation.
+   *
+   * @param maxShift Largest shift as a fraction of the width and height.
+   */
+  BoxTranslateAugmentation(const double maxShift) : maxShift(maxShift)
+  {
+    // Nothing to do here.
+  }
+
+  /**
+   * Add the operation to the map of a data point.
+   *
+   * @param transform Map of the data point.
+   * @param width Width of the data point.
+   * @param height Height of the data point.
+   * @param generator Random number generator of the calling thread.
+   */
+  template<typename GeneratorType>
+  void Compose(BoxTransform& transform,
+               const size_t width,
+               const size_t height,
+               GeneratorType& generator) const
+  {
+    std::uniform_real_distribution<double> distribution(-maxShift, maxShift);
+    const double xShift = std::round(distribution(generator) * width);
+    const double yShift = std::round(distribution(generator) * height);
+    transform.Append(1.0, xShift, 1.0, yShift);
+  }
+
+ private:
+  //! Locally stored largest shift.
+  double maxShift;
+};
+
+/**
+ * Zooms the image and its boxes in or out around the center by a random
+ * factor.
+ */
+class BoxScaleJitterAugmentation
+{
+ public:
+  /**
+   * Create the scale jitter operation.
+   *
+   * @param delta The scale factor is drawn from [1 - delta, 1 + delta].
+   */
+  BoxScaleJitterAugmentation(const double delta) : delta(delta)
+  {
+    // Nothing to do here.
+  }
+
+  /**
+   * Add the operation to the map of a data point.
+   *
+   * @param transform Map of the data point.
+   * @param width Width of the data point.
+   * @param height Height of the data point.
+   * @param generator Random number generator of the calling thread.
+   */
+  template<typename GeneratorType>
+  void Compose(BoxTransform& transform,
+               const size_t width,
+               const size_t height,
+               GeneratorType& generator) const
+  {
+    std::uniform_real_distribution<double> distribution(1.0 - delta,
+        1.0 + delta);
+    const double factor = distribution(generator);
+    transform.Append(factor, 0.5 * width * (1.0 - factor), factor,
+        0.5 * height * (1.0 - factor));
+  }
+
+ private:
+  //! Locally stored range of the scale factor.
+  double delta;
+};
+
+//! Any of the bounding box aware augmentations.
+typedef std::variant<BoxHorizontalFlipAugmentation,
+                     BoxVerticalFlipAugmentation,
+                     BoxRandomCropAugmentation,
+                     BoxTranslateAugmentation,
+                     BoxScaleJitterAugmentation> BoxAugmentationOperation;
+
+} // namespace models
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,522 @@
+/**
+ * @file operations.hpp
+ * @author Kartik Dutt
+ *
+ * Definition of the typed operations that make up an augmentation pipeline.
+ * Each operation is created once from its string specification and holds
+ * validated parameters, so applying it does no string processing.
+ *
+ * Every data point is a column holding an image in the layout decoded images
+ * have, i.e. the `depth` channels of each pixel are stored next to each
+ * other, the pixels of a row one after another and the rows one after
+ * another.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_AUGMENTATION_OPERATIONS_HPP
+#define MODELS_AUGMENTATION_OPERATIONS_HPP
+
+#include <mlpack.hpp>
+#include <variant>
+#include "resize_kernel.hpp"
+
+namespace mlpack {
+namespace models {
+
+/**
+ * Sample a channel at a fractional position using bilinear interpolation.
+ * Positions outside of the channel are treated as zero.
+ *
+ * @param channel Pointer to the channel in the first pixel of the image.
+ * @param width Width of the image.
+ * @param height Height of the image.
+ * @param depth Number of channels of each pixel.
+ * @param x Position along the width.
+ * @param y Position along the height.
+ */
+template<typename eT>
+inline double BilinearSample(const eT* channel,
+                             const size_t width,
+                             const size_t height,
+                             const size_t depth,
+                             const double x,
+                             const double y)
+{
+  if (x < 0 || y < 0 || x > width - 1 || y > height - 1)
+    return 0.0;
+
+  const size_t x0 = std::min((size_t) x, width > 1 ? width - 2 : 0);
+  const size_t y0 = std::min((size_t) y, height > 1 ? height - 2 : 0);
+  const size_t x1 = std::min(x0 + 1, width - 1);
+  const size_t y1 = std::min(y0 + 1, height - 1);
+  const double dx = x - x0;
+  const double dy = y - y0;
+
+  return (1 - dx) * (1 - dy) * channel[(y0 * width + x0) * depth] +
+      dx * (1 - dy) * channel[(y0 * width + x1) * depth] +
+      (1 - dx) * dy * channel[(y1 * width + x0) * depth] +
+      dx * dy * channel[(y1 * width + x1) * depth];
+}
+
+/**
+ * Resizes every data point of the dataset to a fixed width and height using
+ * bilinear interpolation. Resize changes the shape of the data, so it is
+ * applied to every data point irrespective of the augmentation probability.
+ * Copies of the operation share the resize kernel and its cached tables.
+ *
+ * The data points are resized in chunks of columns into a bounded scratch
+ * buffer. When the resized data points are not larger than the input, every
+ * chunk is written back into the memory of the dataset, so no copy of the
+ * whole dataset is made.
+ */
+class ResizeAugmentation
+{
+ public:
+  /**
+   * Create the resize operation.
+   *
+   * @param outputWidth Width of a data point after resizing.
+   * @param outputHeight Height of a data point after resizing.
+   * @param scratchSize Maximum number of bytes of the chunk of resized data
+   *     points; at least one data point is resized at once.
+   */
+  ResizeAugmentation(const size_t outputWidth,
+                     const size_t outputHeight,
+                     const size_t scratchSize = 16 * 1024 * 1024) :
+      outputWidth(outputWidth),
+      outputHeight(outputHeight),
+      scratchSize(scratchSize),
+      kernel(std::make_shared<BilinearResizeKernel>())
+  {
+    // Nothing to do here.
+  }
+
+  /**
+   * Resize the dataset. The width and height are updated to the new shape.
+   *
+   * @param dataset Dataset to resize, each column is a data point.
+   * @param width Width of a single data point.
+   * @param height Height of a single data point.
+   * @param depth Depth of a single data point.
+   */
+  template<typename DatasetType>
+  void Transform(DatasetType& dataset,
+                 size_t& width,
+                 size_t& height,
+                 const size_t depth) const
+  {
+    typedef typename DatasetType::elem_type ElemType;
+
+    // Data points which already have the desired shape are left untouched.
+    if (width == outputWidth && height == outputHeight)
+      return;
+
+    // The resized data points are written into the memory of the dataset if
+    // they fit in it and the matrix keeps that memory when it shrinks, which
+    // it does for memory it allocated, but not for external memory or the
+    // small buffer inside the matrix object.
+    const size_t inputSize = width * height * depth;
+    const size_t outputSize = outputWidth * outputHeight * depth;
+    if (outputSize > inputSize || dataset.mem_state != 0 ||
+        outputSize * dataset.n_cols <= arma::arma_config::mat_prealloc)
+    {
+      DatasetType output;
+      kernel->Resize(dataset, output, width, height, depth, outputWidth,
+          outputHeight, true);
+      dataset = std::move(output);
+    }
+    else
+    {
+      // A chunk is written back over columns that were already read.
+      const size_t chunkSize = std::max((size_t) 1,
+          scratchSize / (outputSize * sizeof(ElemType)));
+      ElemType* resized = dataset.memptr();
+      DatasetType scratch;
+      for (size_t begin = 0; begin < dataset.n_cols; begin += chunkSize)
+      {
+        const size_t cols = std::min(chunkSize, dataset.n_cols - begin);
+        const DatasetType chunk(dataset.colptr(begin), dataset.n_rows, cols,
+            false, true);
+        kernel->Resize(chunk, scratch, width, height, depth, outputWidth,
+            outputHeight, true);
+        std::copy(scratch.begin(), scratch.end(), resized +
+            begin * outputSize);
+      }
+
+      // A matrix that shrinks keeps its memory, which now holds the resized
+      // data points one after another.
+      dataset.set_size(outputSize, dataset.n_cols);
+    }
+
+    width = outputWidth;
+    height = outputHeight;
+  }
+
+  //! Get the output width.
+  size_t OutputWidth() const { return outputWidth; }
+  //! Get the output height.
+  size_t OutputHeight() const { return outputHeight; }
+
+ private:
+  //! Locally stored width of the resized data point.
+  size_t outputWidth;
+
+  //! Locally stored height of the resized data point.
+  size_t outputHeight;
+
+  //! Locally stored maximum number of bytes of a chunk of resized data points.
+  size_t scratchSize;
+
+  //! Locally stored resize kernel, shared between copies.
+  std::shared_ptr<BilinearResizeKernel> kernel;
+};
+
+/**
+ * Mirrors a data point along its width, i.e. the order of the pixels of each
+ * row is reversed while the channels of each pixel keep their order.
+ */
+class HorizontalFlipAugmentation
+{
+ public:
+  /**
+   * Flip a single data point in place.
+   *
+   * @param point Pointer to the data point.
+   * @param width Width of the data point.
+   * @param height Height of the data point.
+   * @param depth Depth of the data point.
+   * @param generator Random number generator of the calling thread.
+   * @param buffer Scratch memory of the calling thread.
+   */
+  template<typename eT, typename GeneratorType>
+  void Transform(eT* point,
+                 const size_t width,
+                 const size_t height,
+                 const size_t depth,
+                 GeneratorType& /* generator */,
+                 arma::Col<eT>& /* buffer */) const
+  {
+    for (size_t y = 0; y < height; ++y)
+    {
+      eT* row = point + y * width * depth;
+      for (size_t left = 0; left < width / 2; ++left)
+      {
+        std::swap_ranges(row + left * depth, row + (left + 1) * depth,
+            row + (width - 1 - left) * depth);
+      }
+    }
+  }
+};
+
+/**
+ * Mirrors a data point along its height, i.e. the order of the rows is
+ * reversed.
+ */
+class VerticalFlipAugmentation
+{
+ public:
+  /**
+   * Flip a single data point in place.
+   *
+   * @param point Pointer to the data point.
+   * @param width Width of the data point.
+   * @param height Height of the data point.
+   * @param depth Depth of the data point.
+   * @param generator Random number generator of the calling thread.
+   * @param buffer Scratch memory of the calling thread.
+   */
+  template<typename eT, typename GeneratorType>
+  void Transform(eT* point,
+                 const size_t width,
+                 const size_t height,
+                 const size_t depth,
+                 GeneratorType& /* generator */,
+                 arma::Col<eT>& /* buffer */) const
+  {
+    const size_t rowSize = width * depth;
+    for (size_t top = 0; top < height / 2; ++top)
+    {
+      std::swap_ranges(point + top * rowSize, point + (top + 1) * rowSize,
+          point + (height - 1 - top) * rowSize);
+    }
+  }
+};
+
+/**
+ * Crops a random window of fixed size out of a data point and scales it back
+ * to the size of the data point, so the shape of the data doesn't change.
+ */
+class RandomCropAugmentation
+{
+ public:
+  /**
+   * Create the random crop operation.
+   *
+   * @param cropWidth Width of the cropped window.
+   * @param cropHeight Height of the cropped window.
+   */
+  RandomCropAugmentation(const size_t cropWidth, const size_t cropHeight) :
+      cropWidth(cropWidth),
+      cropHeight(cropHeight)
+  {
+    // Nothing to do here.
+  }
+
+  /**
+   * Crop a single data point in place. The crop size must not be larger than
+   * the data point, which Augmentation::Transform() checks before it applies
+   * the operations.
+   *
+   * @param point Pointer to the data point.
+   * @param width Width of the data point.
+   * @param height Height of the data point.
+   * @param depth Depth of the data point.
+   * @param generator Random number generator of the calling thread.
+   * @param buffer Scratch memory of the calling thread.
+   */
+  template<typename eT, typename GeneratorType>
+  void Transform(eT* point,
+                 const size_t width,
+                 const size_t height,
+                 const size_t depth,
+                 GeneratorType& generator,
+                 arma::Col<eT>& buffer) const
+  {
+    std::uniform_int_distribution<size_t> xDistribution(0, width - cropWidth);
+    std::uniform_int_distribution<size_t> yDistribution(0,
+        height - cropHeight);
+    const size_t xOffset = xDistribution(generator);
+    const size_t yOffset = yDistribution(generator);
+
+    const double xScale = width > 1 ?
+        (cropWidth - 1) / (double) (width - 1) : 0.0;
+    const double yScale = height > 1 ?
+        (cropHeight - 1) / (double) (height - 1) : 0.0;
+
+    buffer.set_size(width * height * depth);
+    std::copy(point, point + buffer.n_elem, buffer.memptr());
+    for (size_t y = 0; y < height; ++y)
+    {
+      eT* row = point + y * width * depth;
+      for (size_t x = 0; x < width; ++x)
+      {
+        for (size_t c = 0; c < depth; ++c)
+        {
+          row[x * depth + c] = (eT) BilinearSample(buffer.memptr() + c, width,
+              height, depth, xOffset + x * xScale, yOffset + y * yScale);
+        }
+      }
+    }
+  }
+
+  //! Get the width of the cropped window.
+  size_t CropWidth() const { return cropWidth; }
+  //! Get the height of the cropped window.
+  size_t CropHeight() const { return cropHeight; }
+
+ private:
+  //! Locally stored width of the cropped window.
+  size_t cropWidth;
+
+  //! Locally stored height of the cropped window.
+  size_t cropHeight;
+};
+
+/**
+ * Rotates a data point around its centre by a random angle. Pixels that are
+ * rotated in from outside of the data point are set to zero.
+ */
+class RotationAugmentation
+{
+ public:
+  /**
+   * Create the rotation operation.
+   *
+   * @param maxDegrees The angle is drawn uniformly from
+   *     [-maxDegrees, maxDegrees].
+   */
+  RotationAugmentation(const double maxDegrees) : maxDegrees(maxDegrees)
+  {
+    // Nothing to do here.
+  }
+
+  /**
+   * Rotate a single data point in place.
+   *
+   * @param point Pointer to the data point.
+   * @param width Width of the data point.
+   * @param height Height of the data point.
+   * @param depth Depth of the data point.
+   * @param generator Random number generator of the calling thread.
+   * @param buffer Scratch memory of the calling thread.
+   */
+  template<typename eT, typename GeneratorType>
+  void Transform(eT* point,
+                 const size_t width,
+                 const size_t height,
+                 const size_t depth,
+                 GeneratorType& generator,
+                 arma::Col<eT>& buffer) const
+  {
+    std::uniform_real_distribution<double> distribution(-maxDegrees,
+        maxDegrees);
+    const double angle = distribution(generator) * M_PI / 180.0;
+    const double cosAngle = std::cos(angle);
+    const double sinAngle = std::sin(angle);
+    const double xCentre = (width - 1) / 2.0;
+    const double yCentre = (height - 1) / 2.0;
+
+    buffer.set_size(width * height * depth);
+    std::copy(point, point + buffer.n_elem, buffer.memptr());
+    for (size_t y = 0; y < height; ++y)
+    {
+      eT* row = point + y * width * depth;
+      for (size_t x = 0; x < width; ++x)
+      {
+        // Find the source position by rotating the output position back.
+        const double xSource = cosAngle * (x - xCentre) +
+            sinAngle * (y - yCentre) + xCentre;
+        const double ySource = -sinAngle * (x - xCentre) +
+            cosAngle * (y - yCentre) + yCentre;
+        for (size_t c = 0; c < depth; ++c)
+        {
+          row[x * depth + c] = (eT) BilinearSample(buffer.memptr() + c, width,
+              height, depth, xSource, ySource);
+        }
+      }
+    }
+  }
+
+ private:
+  //! Locally stored maximum rotation angle in degrees.
+  double maxDegrees;
+};
+
+/**
+ * Scales the intensity of a data point by a random factor drawn uniformly
+ * from [1 - delta, 1 + delta].
+ */
+class BrightnessAugmentation
+{
+ public:
+  /**
+   * Create the brightness jitter operation.
+   *
+   * @param delta Maximum relative change in brightness.
+   */
+  BrightnessAugmentation(const double delta) : delta(delta)
+  {
+    // Nothing to do here.
+  }
+
+  /**
+   * Change the brightness of a single data point in place.
+   *
+   * @param point Pointer to the data point.
+   * @param width Width of the data point.
+   * @param height Height of the data point.
+   * @param depth Depth of the data point.
+   * @param generator Random number generator of the calling thread.
+   * @param buffer Scratch memory of the calling thread.
+   */
+  template<typename eT, typename GeneratorType>
+  void Transform(eT* point,
+                 const size_t width,
+                 const size_t height,
+                 const size_t depth,
+                 GeneratorType& generator,
+                 arma::Col<eT>& /* buffer */) const
+  {
+    std::uniform_real_distribution<double> distribution(1.0 - delta,
+        1.0 + delta);
+    const double factor = distribution(generator);
+    for (size_t i = 0; i < width * height * depth; ++i)
+      point[i] = (eT) (point[i] * factor);
+  }
+
+ private:
+  //! Locally stored maximum relative change in brightness.
+  double delta;
+};
+
+/**
+ * Scales the distance of every value of a data point from the mean of its
+ * channel by a random factor drawn uniformly from [1 - delta, 1 + delta], the
+ * same factor for every channel.
+ */
+class ContrastAugmentation
+{
+ public:
+  /**
+   * Create the contrast jitter operation.
+   *
+   * @param delta Maximum relative change in contrast.
+   */
+  ContrastAugmentation(const double delta) : delta(delta)
+  {
+    // Nothing to do here.
+  }
+
+  /**
+   * Change the contrast of a single data point in place.
+   *
+   * @param point Pointer to the data point.
+   * @param width Width of the data point.
+   * @param height Height of the data point.
+   * @param depth Depth of the data point.
+   * @param generator Random number generator of the calling thread.
+   * @param buffer Scratch memory of the calling thread.
+   */
+  template<typename eT, typename GeneratorType>
+  void Transform(eT* point,
+                 const size_t width,
+                 const size_t height,
+                 const size_t depth,
+                 GeneratorType& generator,
+                 arma::Col<eT>& /* buffer */) const
+  {
+    std::uniform_real_distribution<double> distribution(1.0 - delta,
+        1.0 + delta);
+    const double factor = distribution(generator);
+    const size_t pixels = width * height;
+    if (pixels == 0)
+      return;
+
+    // The channels of a pixel are interleaved.
+    for (size_t c = 0; c < depth; ++c)
+    {
+      double mean = 0.0;
+      for (size_t i = 0; i < pixels; ++i)
+        mean += point[i * depth + c];
+      mean /= pixels;
+
+      for (size_t i = 0; i < pixels; ++i)
+      {
+        eT& value = point[i * depth + c];
+        value = (eT) ((value - mean) * factor + mean);
+      }
+    }
+  }
+
+ private:
+  //! Locally stored maximum relative change in contrast.
+  double delta;
+};
+
+//! Any of the supported random augmentations that are applied per data point.
+typedef std::variant<
+    HorizontalFlipAugmentation,
+    VerticalFlipAugmentation,
+    RandomCropAugmentation,
+    RotationAugmentation,
+    BrightnessAugmentation,
+    ContrastAugmentation
+> AugmentationOperation;
+
+} // namespace models
+} // namespace mlpack
+
+#endif
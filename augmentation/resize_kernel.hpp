@@ -0,0 +1,151 @@
+/**
+ * @file resize_kernel.hpp
+ * @author Kartik Dutt
+ *
+ * Definition of the bilinear resize kernel used to resize batches of images.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_AUGMENTATION_RESIZE_KERNEL_HPP
+#define MODELS_AUGMENTATION_RESIZE_KERNEL_HPP
+
+#include <mlpack.hpp>
+#include <array>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+
+namespace mlpack {
+namespace models {
+
+/**
+ * Bilinear resize of column-major image batches. Each column of the batch is
+ * a data point made of `depth` channels, each channel a width x height
+ * column-major matrix, i.e. width is the fast axis. Interleaved data points,
+ * where the channels of each pixel are stored next to each other as decoded
+ * images are, are supported as well.
+ *
+ * The resize is separable. Every output row is first interpolated along the
+ * height into a scratch row of the input width and then gathered along the
+ * width, both with SIMD friendly inner loops. Data points are resized in
+ * parallel, every thread only needs a single scratch row, so the memory used
+ * apart from the output does not depend on the number of data points.
+ *
+ * The source index and weight tables only depend on the input and output
+ * shape, they are computed once per shape and cached, so resizing many
+ * batches of the same shape does no per-call setup.
+ *
+ * Floating point data is interpolated in its own precision, integral data
+ * such as uint8 images is interpolated in single precision and rounded back
+ * to the nearest representable value.
+ *
+ * @code
+ * BilinearResizeKernel kernel;
+ * arma::Mat<unsigned char> images(64 * 48 * 3, 32), resized;
+ * kernel.Resize(images, resized, 64, 48, 3, 32, 24);
+ * @endcode
+ */
+class BilinearResizeKernel
+{
+ public:
+  //! Create the resize kernel with an empty table cache.
+  BilinearResizeKernel() { /* Nothing to do here. */ }
+
+  /**
+   * Resize every data point of the input.
+   *
+   * @param input Batch to resize, each column is a data point.
+   * @param output Matrix where the resized batch will be stored.
+   * @param inputWidth Width of a single input data point.
+   * @param inputHeight Height of a single input data point.
+   * @param depth Number of channels of a single data point.
+   * @param outputWidth Width of a single output data point.
+   * @param outputHeight Height of a single output data point.
+   * @param interleaved If true, the channels of each pixel are stored next
+   *                    to each other instead of one channel after another.
+   */
+  template<typename eT>
+  void Resize(const arma::Mat<eT>& input,
+              arma::Mat<eT>& output,
+              const size_t inputWidth,
+              const size_t inputHeight,
+              const size_t depth,
+              const size_t outputWidth,
+              const size_t outputHeight,
+              const bool interleaved = false) const;
+
+  //! Get the number of shapes whose tables are cached.
+  size_t CachedShapes() const
+  {
+    std::lock_guard<std::mutex> lock(tablesMutex);
+    return tables.size();
+  }
+
+ private:
+  //! Source indices and weights along one axis of the output.
+  struct AxisTable
+  {
+    //! First source index of each output position.
+    std::vector<size_t> lower;
+    //! Second source index of each output position.
+    std::vector<size_t> upper;
+    //! Weight of the second source index in double precision.
+    std::vector<double> weights;
+    //! Weight of the second source index in single precision.
+    std::vector<float> weightsFloat;
+  };
+
+  //! Tables for both axes of one (input, output) shape.
+  struct ResizeTable
+  {
+    AxisTable width;
+    AxisTable height;
+  };
+
+  /**
+   * Compute the table along one axis. Output position i samples the input at
+   * i * in / out, the same mapping that mlpack's BilinearInterpolation layer
+   * uses.
+   *
+   * @param in Length of the input axis.
+   * @param out Length of the output axis.
+   */
+  static AxisTable ComputeAxis(const size_t in, const size_t out);
+
+  //! Get the table for the given shape, computing it if needed.
+  std::shared_ptr<const ResizeTable> Table(const size_t inputWidth,
+                                           const size_t inputHeight,
+                                           const size_t outputWidth,
+                                           const size_t outputHeight) const;
+
+  //! Get the weights of the given axis in the given precision.
+  static const std::vector<double>& Weights(const AxisTable& table,
+                                            const double /* tag */)
+  {
+    return table.weights;
+  }
+
+  static const std::vector<float>& Weights(const AxisTable& table,
+                                           const float /* tag */)
+  {
+    return table.weightsFloat;
+  }
+
+  //! Locally stored tables, indexed by (inW, inH, outW, outH).
+  mutable std::map<std::array<size_t, 4>,
+      std::shared_ptr<const ResizeTable>> tables;
+
+  //! Mutex guarding the table cache.
+  mutable std::mutex tablesMutex;
+};
+
+} // namespace models
+} // namespace mlpack
+
+#include "resize_kernel_impl.hpp" // Include implementation.
+
+#endif
@@ -0,0 +1,188 @@
+/**
+ * @file resize_kernel_impl.hpp
+ * @author Kartik Dutt
+ *
+ * Implementation of the bilinear resize kernel.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_AUGMENTATION_RESIZE_KERNEL_IMPL_HPP
+#define MODELS_AUGMENTATION_RESIZE_KERNEL_IMPL_HPP
+
+// Incase it has not been included already.
+#include "resize_kernel.hpp"
+
+namespace mlpack {
+namespace models {
+
+inline BilinearResizeKernel::AxisTable BilinearResizeKernel::ComputeAxis(
+    const size_t in,
+    const size_t out)
+{
+  AxisTable table;
+  table.lower.resize(out);
+  table.upper.resize(out);
+  table.weights.resize(out);
+  table.weightsFloat.resize(out);
+
+  const double scale = (double) in / (double) out;
+  for (size_t i = 0; i < out; ++i)
+  {
+    const double position = i * scale;
+    const size_t lower = std::min((size_t) std::floor(position),
+        in > 1 ? in - 2 : 0);
+
+    table.lower[i] = lower;
+    table.upper[i] = std::min(lower + 1, in - 1);
+    table.weights[i] = (in > 1) ? std::min(std::max(position - lower, 0.0),
+        1.0) : 0.0;
+    table.weightsFloat[i] = table.weights[i];
+  }
+
+  return table;
+}
+
+inline std::shared_ptr<const BilinearResizeKernel::ResizeTable>
+BilinearResizeKernel::Table(const size_t inputWidth,
+                            const size_t inputHeight,
+                            const size_t outputWidth,
+                            const size_t outputHeight) const
+{
+  const std::array<size_t, 4> shape = {inputWidth, inputHeight, outputWidth,
+      outputHeight};
+
+  std::lock_guard<std::mutex> lock(tablesMutex);
+  std::shared_ptr<const ResizeTable>& table = tables[shape];
+  if (!table)
+  {
+    std::shared_ptr<ResizeTable> newTable = std::make_shared<ResizeTable>();
+    newTable->width = ComputeAxis(inputWidth, outputWidth);
+    newTable->height = ComputeAxis(inputHeight, outputHeight);
+    table = newTable;
+  }
+
+  return table;
+}
+
+template<typename eT>
+void BilinearResizeKernel::Resize(const arma::Mat<eT>& input,
+                                  arma::Mat<eT>& output,
+                                  const size_t inputWidth,
+                                  const size_t inputHeight,
+                                  const size_t depth,
+                                  const size_t outputWidth,
+                                  const size_t outputHeight,
+                                  const bool interleaved) const
+{
+  if (input.n_rows != inputWidth * inputHeight * depth)
+  {
+    mlpack::Log::Fatal << "Input has " << input.n_rows << " rows, expected "
+        << inputWidth << " x " << inputHeight << " x " << depth << "."
+        << std::endl;
+  }
+
+  if (outputWidth == 0 || outputHeight == 0)
+  {
+    mlpack::Log::Fatal << "Output width and height must be positive."
+        << std::endl;
+  }
+
+  // Double precision data is interpolated in double precision, everything
+  // else in single precision.
+  typedef typename std::conditional<std::is_same<eT, double>::value,
+      double, float>::type AccumulatorType;
+
+  const std::shared_ptr<const ResizeTable> table = Table(inputWidth,
+      inputHeight, outputWidth, outputHeight);
+  const size_t* xLower = table->width.lower.data();
+  const size_t* xUpper = table->width.upper.data();
+  const AccumulatorType* xWeights = Weights(table->width,
+      AccumulatorType()).data();
+  const size_t* yLower = table->height.lower.data();
+  const size_t* yUpper = table->height.upper.data();
+  const AccumulatorType* yWeights = Weights(table->height,
+      AccumulatorType()).data();
+
+  // A planar data point is resized one channel at a time. An interleaved data
+  // point is resized as a single channel whose pixels hold `depth` values.
+  const size_t planes = interleaved ? 1 : depth;
+  const size_t pixelSize = interleaved ? depth : 1;
+  const size_t inputRowSize = inputWidth * pixelSize;
+  const size_t outputRowSize = outputWidth * pixelSize;
+  const size_t inputSize = inputRowSize * inputHeight;
+  const size_t outputSize = outputRowSize * outputHeight;
+  output.set_size(outputSize * planes, input.n_cols);
+
+  const AccumulatorType minValue = std::is_integral<eT>::value ?
+      (AccumulatorType) std::numeric_limits<eT>::min() : 0;
+  const AccumulatorType maxValue = std::is_integral<eT>::value ?
+      (AccumulatorType) std::numeric_limits<eT>::max() : 0;
+
+  #pragma omp parallel
+  {
+    // Input row interpolated along the height.
+    std::vector<AccumulatorType> scratch(inputRowSize);
+    AccumulatorType* row = scratch.data();
+
+    #pragma omp for schedule(static)
+    for (omp_size_t col = 0; col < (omp_size_t) input.n_cols; ++col)
+    {
+      for (size_t c = 0; c < planes; ++c)
+      {
+        const eT* in = input.colptr(col) + c * inputSize;
+        eT* out = output.colptr(col) + c * outputSize;
+
+        for (size_t y = 0; y < outputHeight; ++y)
+        {
+          const eT* top = in + yLower[y] * inputRowSize;
+          const eT* bottom = in + yUpper[y] * inputRowSize;
+          const AccumulatorType dy = yWeights[y];
+
+          #pragma omp simd
+          for (size_t x = 0; x < inputRowSize; ++x)
+          {
+            row[x] = (AccumulatorType) top[x] + dy *
+                ((AccumulatorType) bottom[x] - (AccumulatorType) top[x]);
+          }
+
+          eT* outRow = out + y * outputRowSize;
+          for (size_t p = 0; p < pixelSize; ++p)
+          {
+            if (std::is_integral<eT>::value)
+            {
+              #pragma omp simd
+              for (size_t x = 0; x < outputWidth; ++x)
+              {
+                const AccumulatorType left = row[xLower[x] * pixelSize + p];
+                const AccumulatorType right = row[xUpper[x] * pixelSize + p];
+                const AccumulatorType value = left + xWeights[x] *
+                    (right - left) + (AccumulatorType) 0.5;
+                outRow[x * pixelSize + p] = (eT) std::min(std::max(value,
+                    minValue), maxValue);
+              }
+            }
+            else
+            {
+              #pragma omp simd
+              for (size_t x = 0; x < outputWidth; ++x)
+              {
+                const AccumulatorType left = row[xLower[x] * pixelSize + p];
+                const AccumulatorType right = row[xUpper[x] * pixelSize + p];
+                outRow[x * pixelSize + p] = (eT) (left + xWeights[x] *
+                    (right - left));
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+} // namespace models
+} // namespace mlpack
+
+#endif
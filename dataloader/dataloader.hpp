@@ -16,7 +16,9 @@
 #include <boost/property_tree/xml_parser.hpp>
 #include <boost/property_tree/ptree.hpp>
 #include <augmentation/augmentation.hpp>
+#include <augmentation/box_augmentation.hpp>
 #include <dataloader/datasets.hpp>
+#include <dataloader/image_decoder.hpp>
 #include <boost/foreach.hpp>
 #include <utils/utils.hpp>
 #include <set>
@@ -189,9 +191,10 @@ class DataLoader
    * @param imageHeight Height of images in dataset.
    * @param imageDepth Depth of images in dataset.
    * @param label Label which will be assigned to image.
-   * @param augmentation Vector strings of augmentations supported by mlpack.
-   * @param augmentationProbability Probability of applying augmentation
-   *                                to a particular image.
+   * @param outputWidth If non-zero, images are resized to this width while
+   *                    they are decoded.
+   * @param outputHeight If non-zero, images are resized to this height while
+   *                     they are decoded.
    */
   void LoadAllImagesFromDirectory(const std::string& imagesPath,
                                   DatasetX& dataset,
@@ -199,7 +202,9 @@ class DataLoader
                                   const size_t imageWidth,
                                   const size_t imageHeight,
                                   const size_t imageDepth,
-                                  const size_t label = 0);
+                                  const size_t label = 0,
+                                  const size_t outputWidth = 0,
+                                  const size_t outputHeight = 0);
 
   /**
    * Load all images from directory.
@@ -276,6 +281,41 @@ class DataLoader
     return std::tuple<DatasetX, DatasetY>(testFeatures, testLabels);
   }
 
+  /**
+   * Get a minibatch of the training set with the random augmentations applied
+   * on the fly. The stored training set is never modified, so every call
+   * draws new augmentations for the same data points. For object detection
+   * datasets the bounding boxes in the labels are updated with the images.
+   *
+   * @code
+   * for (size_t i = 0; i < dataloader.TrainFeatures().n_cols; i += batchSize)
+   * {
+   *   dataloader.TrainBatch(i, batchSize, batchFeatures, batchLabels);
+   *   model.Train(batchFeatures, batchLabels, optimizer);
+   * }
+   * @endcode
+   *
+   * @param begin Index of the first data point of the minibatch.
+   * @param batchSize Number of data points in the minibatch. The last
+   *                  minibatch may be smaller.
+   * @param features Matrix where the augmented features will be stored.
+   * @param labels Matrix where the corresponding labels will be stored.
+   */
+  void TrainBatch(const size_t begin,
+                  const size_t batchSize,
+                  DatasetX& features,
+                  DatasetY& labels);
+
+  //! Get the augmentation applied to training minibatches.
+  const Augmentation& Augmentations() const { return augmentation; }
+  //! Modify the augmentation applied to training minibatches.
+  Augmentation& Augmentations() { return augmentation; }
+
+  //! Get the augmentation applied to object detection minibatches.
+  const BoxAugmentation& BoxAugmentations() const { return boxAugmentation; }
+  //! Modify the augmentation applied to object detection minibatches.
+  BoxAugmentation& BoxAugmentations() { return boxAugmentation; }
+
   //! Get the Scaler.
   ScalerType Scaler() const { return scaler; }
   //! Modify the Scaler.
@@ -402,7 +442,7 @@ class DataLoader
       // Field type has fixed size so we can't use span and assignment
       // operator.
       for (size_t i = 0; i < trainSize; i++)
-        trainLabels(0, i) = labels[i];
+        trainLabels(0, i) = labels[order(i)];
     }
 
     if (validSize <= dataset.n_cols)
@@ -411,7 +451,7 @@ class DataLoader
           dataset.n_cols - 1));
       validLabels.set_size(1, validSize);
       for (size_t i = trainSize; i < dataset.n_cols; i++)
-        validLabels(0, i - trainSize) = labels[i];
+        validLabels(0, i - trainSize) = labels[order(i)];
     }
     return;
   }
@@ -491,11 +531,21 @@ class DataLoader
   //! Locally stored ratio for train-test split.
   double ratio;
 
-  //! Locally stored augmentation.
-  std::vector<std::string> augmentation;
+  //! Locally stored augmentation applied to each training minibatch.
+  Augmentation augmentation;
+
+  //! Locally stored bounding box aware augmentation applied to each training
+  //! minibatch of object detection datasets.
+  BoxAugmentation boxAugmentation;
+
+  //! Locally stored width of a single training data point.
+  size_t datapointWidth;
+
+  //! Locally stored height of a single training data point.
+  size_t datapointHeight;
 
-  //! Locally stored augmentation probability.
-  double augmentationProbability;
+  //! Locally stored depth of a single training data point.
+  size_t datapointDepth;
 };
 
 } // namespace models
@@ -26,7 +26,10 @@ template<
   class ScalerType
 >DataLoader<
     DatasetX, DatasetY, ScalerType
->::DataLoader()
+>::DataLoader() :
+    datapointWidth(0),
+    datapointHeight(0),
+    datapointDepth(0)
 {
   // Nothing to do here.
 }
@@ -42,7 +45,10 @@ template<
               const double validRatio,
               const bool useScaler,
               const std::vector<std::string> augmentation,
-              const double augmentationProbability)
+              const double augmentationProbability) :
+    datapointWidth(0),
+    datapointHeight(0),
+    datapointDepth(0)
 {
   InitializeDatasets();
   if (datasetMap.count(dataset))
@@ -168,8 +174,13 @@ template<
       scaler.Transform(validFeatures, validFeatures);
     }
 
-    Augmentation augmentations(augmentation, augmentationProbability);
-    augmentations.Transform(trainFeatures, 1, dataset.n_rows, 1);
+    // Each data point is a single column, the random augmentations are
+    // applied to it when a minibatch is drawn.
+    this->augmentation = Augmentation(augmentation, augmentationProbability);
+    this->augmentation.ResizeTransform(trainFeatures, 1, trainFeatures.n_rows);
+    datapointWidth = 1;
+    datapointHeight = trainFeatures.n_rows;
+    datapointDepth = 1;
 
     mlpack::Log::Info << "Training Dataset Loaded." << std::endl;
   }
@@ -212,7 +223,17 @@ template<
                               const std::string& x2XMLTag,
                               const std::string& y2XMLTag)
 {
-  Augmentation augmentation(augmentations, augmentationProbability);
+  // Augmentations that move pixels must move the boxes as well, so all of
+  // them are applied by the bounding box aware augmentation.
+  this->augmentation = Augmentation();
+  this->boxAugmentation = BoxAugmentation(augmentations,
+      augmentationProbability);
+
+  // Images are resized while they are decoded, so full resolution images are
+  // never held in memory.
+  const ImageDecoder decoder = this->boxAugmentation.HasResize() ?
+      ImageDecoder(this->boxAugmentation.Resize().OutputWidth(),
+      this->boxAugmentation.Resize().OutputHeight()) : ImageDecoder();
 
   std::vector<boost::filesystem::path> annotationsDirectory;
 
@@ -279,28 +300,23 @@ template<
     imageWidth = std::stoi(sizeInfo.get_child("width").data());
     imageHeight = std::stoi(sizeInfo.get_child("height").data());
     imageDepth = std::stoi(sizeInfo.get_child("depth").data());
-    mlpack::data::ImageInfo imageInfo(imageWidth, imageHeight, imageDepth);
 
     // Load the image.
     // The image loaded here will be in column format i.e. Output will
     // be matrix with the following shape {1, cols * rows * slices} in
-    // column major format.
+    // column major format. The width and height are set to the size of
+    // the image file.
     DatasetX image;
-    mlpack::data::Load(pathToImages + imgName, image, imageInfo);
+    decoder.Load(pathToImages + imgName, image, imageWidth, imageHeight,
+        imageDepth);
 
     double horizontalScale = 1.0, verticalScale = 1.0;
-    if (augmentation.HasResizeParam())
+    if (decoder.Resizes())
     {
-      augmentation.ResizeTransform(image, imageWidth, imageHeight, imageDepth,
-          augmentation.augmentations[0]);
-
-      size_t outputWidth = 0, outputHeight = 0;
-      augmentation.GetResizeParam(outputWidth, outputHeight,
-          augmentation.augmentations[0]);
-      horizontalScale = 1.0 * outputWidth / imageWidth;
-      verticalScale = 1.0 * outputHeight / imageHeight;
-      imageWidth = outputWidth;
-      imageHeight = outputHeight;
+      horizontalScale = 1.0 * decoder.OutputWidth() / imageWidth;
+      verticalScale = 1.0 * decoder.OutputHeight() / imageHeight;
+      imageWidth = decoder.OutputWidth();
+      imageHeight = decoder.OutputHeight();
     }
 
     // Iterate over all object in annotation.
@@ -352,9 +368,10 @@ template<
   TrainTestSplit(dataset, labels, this->trainFeatures, this->trainLabels,
       this->validFeatures, this->validLabels, validRatio, shuffle);
 
-  // Augment the training data.
-  augmentation.Transform(this->trainFeatures, imageWidth, imageHeight,
-      imageDepth);
+  // The training data is augmented when a minibatch is drawn.
+  datapointWidth = imageWidth;
+  datapointHeight = imageHeight;
+  datapointDepth = imageDepth;
 }
 
 template<
@@ -369,8 +386,12 @@ template<
                               const size_t imageWidth,
                               const size_t imageHeight,
                               const size_t imageDepth,
-                              const size_t label)
+                              const size_t label,
+                              const size_t outputWidth,
+                              const size_t outputHeight)
 {
+  const ImageDecoder decoder(outputWidth, outputHeight);
+
   // Get all files in given directory.
   std::vector<boost::filesystem::path> imagesDirectory;
   Utils::ListDir(imagesPath, imagesDirectory);
@@ -392,14 +413,14 @@ template<
     {
       continue;
     }
-    mlpack::data::ImageInfo imageInfo(imageWidth, imageHeight, imageDepth);
 
     // Load the image.
     // The image loaded here will be in column format i.e. Output will
     // be matrix with the following shape {1, cols * rows * slices} in
     // column major format.
     DatasetX image;
-    mlpack::data::Load(imageName.string(), image, imageInfo);
+    size_t width = imageWidth, height = imageHeight;
+    decoder.Load(imageName.string(), image, width, height, imageDepth);
 
     // Add object to training set.
     if (image.n_rows == dataset.n_rows || dataset.n_elem == 0)
@@ -429,8 +450,17 @@ template<
                                  const std::vector<std::string>& augmentation,
                                  const double augmentationProbability)
 {
-  Augmentation augmentations(augmentation, augmentationProbability);
+  this->augmentation = Augmentation(augmentation, augmentationProbability);
   size_t totalClasses = 0;
+
+  // Images are resized while they are decoded, so full resolution images are
+  // never held in memory.
+  size_t outputWidth = 0, outputHeight = 0;
+  if (this->augmentation.HasResize())
+  {
+    outputWidth = this->augmentation.Resize().OutputWidth();
+    outputHeight = this->augmentation.Resize().OutputHeight();
+  }
   std::map<std::string, size_t> classMap;
 
   // Fill classes in the vector.
@@ -447,7 +477,7 @@ template<
     {
       LoadAllImagesFromDirectory(className.string() +
         "/", dataset, labels, imageWidth, imageHeight, imageDepth,
-        totalClasses);
+        totalClasses, outputWidth, outputHeight);
       classMap[className.string()] = totalClasses;
       totalClasses++;
     }
@@ -457,14 +487,6 @@ template<
   {
     testFeatures = std::move(dataset);
     testLabels = std::move(labels);
-
-    // Only resize augmentation will be applied on test set.
-    if (augmentations.HasResizeParam())
-    {
-      augmentations.ResizeTransform(testFeatures, imageWidth, imageHeight,
-          imageDepth, augmentations.augmentations[0]);
-    }
-
     return;
   }
 
@@ -482,8 +504,12 @@ template<
   validLabels = validationData.rows(validationData.n_rows - 1,
       validationData.n_rows - 1);
 
-  augmentations.Transform(trainFeatures, imageWidth, imageHeight, imageDepth);
-  augmentations.Transform(validFeatures, imageWidth, imageHeight, imageDepth);
+  // The random augmentations are applied to the training set when a
+  // minibatch is drawn.
+  datapointWidth = this->augmentation.HasResize() ? outputWidth : imageWidth;
+  datapointHeight = this->augmentation.HasResize() ? outputHeight :
+      imageHeight;
+  datapointDepth = imageDepth;
 
   mlpack::Log::Info << "Found " << totalClasses << " classes." << std::endl;
 
@@ -495,6 +521,35 @@ template<
   }
 }
 
+template<
+  typename DatasetX,
+  typename DatasetY,
+  class ScalerType
+>void DataLoader<
+    DatasetX, DatasetY, ScalerType
+>::TrainBatch(const size_t begin,
+              const size_t batchSize,
+              DatasetX& features,
+              DatasetY& labels)
+{
+  if (begin >= trainFeatures.n_cols || batchSize == 0)
+  {
+    mlpack::Log::Fatal << "Invalid minibatch: begin (" << begin << ") must be"
+        << " less than the number of training points (" << trainFeatures.n_cols
+        << ") and batchSize must be positive." << std::endl;
+  }
+
+  const size_t end = std::min(begin + batchSize, (size_t) trainFeatures.n_cols)
+      - 1;
+  features = trainFeatures.cols(begin, end);
+  labels = trainLabels.cols(begin, end);
+
+  augmentation.Transform(features, datapointWidth, datapointHeight,
+      datapointDepth);
+  boxAugmentation.Transform(features, labels, datapointWidth, datapointHeight,
+      datapointDepth);
+}
+
 } // namespace models
 } // namespace mlpack
 
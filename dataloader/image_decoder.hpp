@@ -0,0 +1,242 @@
+/**
+ * @file image_decoder.hpp
+ * @author Kartik Dutt
+ *
+ * Definition of ImageDecoder class which resizes images while decoding them.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_DATALOADER_IMAGE_DECODER_HPP
+#define MODELS_DATALOADER_IMAGE_DECODER_HPP
+
+#include <mlpack.hpp>
+#include <augmentation/resize_kernel.hpp>
+
+#ifdef MODELS_HAS_LIBJPEG
+  #include <csetjmp>
+  #include <cstdio>
+  #include <jpeglib.h>
+#endif
+
+namespace mlpack {
+namespace models {
+
+/**
+ * Decodes images one at a time and resizes them to a fixed size as part of
+ * decoding, so a dataset never holds full resolution images.
+ *
+ * When the models are built with libjpeg (MODELS_HAS_LIBJPEG), JPEG images
+ * are decoded with the largest DCT downscaling (1/2, 1/4 or 1/8) that keeps
+ * the image at least as large as the output. Decoding at a reduced scale
+ * skips most of the inverse DCT work and only ever allocates the reduced
+ * image, which is then resized to the exact output size. Every other image,
+ * or a JPEG that libjpeg can't handle, is decoded with mlpack::data::Load and
+ * resized right away.
+ *
+ * The decoded image has the layout mlpack::data::Load produces, i.e. a single
+ * column with the channels of each pixel stored next to each other and rows
+ * of pixels stored one after another.
+ *
+ * @code
+ * ImageDecoder decoder(224, 224);
+ * arma::mat image;
+ * size_t width = 0, height = 0;
+ * decoder.Load("dog.jpg", image, width, height, 3);
+ * // image.n_rows == 224 * 224 * 3, width and height hold the original size.
+ * @endcode
+ */
+class ImageDecoder
+{
+ public:
+  /**
+   * Create the decoder.
+   *
+   * @param outputWidth Width of the decoded images. If either the width or
+   *                    the height is 0, images keep their original size.
+   * @param outputHeight Height of the decoded images.
+   */
+  ImageDecoder(const size_t outputWidth = 0, const size_t outputHeight = 0) :
+      outputWidth(outputWidth),
+      outputHeight(outputHeight),
+      kernel(std::make_shared<BilinearResizeKernel>())
+  {
+    // Nothing to do here.
+  }
+
+  /**
+   * Decode a single image and resize it to the output size.
+   *
+   * @param path Path to the image.
+   * @param image Matrix where the decoded image will be stored.
+   * @param width Width of the image in the file. Used as a hint for formats
+   *              that need it and set to the actual width of the file.
+   * @param height Height of the image in the file. Used as a hint for
+   *               formats that need it and set to the actual height of the
+   *               file.
+   * @param depth Number of channels to decode.
+   */
+  template<typename eT>
+  void Load(const std::string& path,
+            arma::Mat<eT>& image,
+            size_t& width,
+            size_t& height,
+            const size_t depth) const
+  {
+    #ifdef MODELS_HAS_LIBJPEG
+    if (IsJPEG(path) && (depth == 1 || depth == 3))
+    {
+      arma::Mat<unsigned char> pixels;
+      size_t scaledWidth, scaledHeight;
+      if (DecodeJPEG(path, pixels, width, height, scaledWidth, scaledHeight,
+          depth))
+      {
+        if (Resizes() && (scaledWidth != outputWidth ||
+            scaledHeight != outputHeight))
+        {
+          arma::Mat<unsigned char> resized;
+          kernel->Resize(pixels, resized, scaledWidth, scaledHeight, depth,
+              outputWidth, outputHeight, true);
+          pixels = std::move(resized);
+        }
+
+        image = arma::conv_to<arma::Mat<eT>>::from(pixels);
+        return;
+      }
+
+      mlpack::Log::Warn << "Unable to decode " << path << " with libjpeg, "
+          << "falling back to mlpack::data::Load()." << std::endl;
+    }
+    #endif
+
+    mlpack::data::ImageInfo imageInfo(width, height, depth);
+    mlpack::data::Load(path, image, imageInfo);
+    width = imageInfo.Width();
+    height = imageInfo.Height();
+
+    if (Resizes() && (width != outputWidth || height != outputHeight))
+    {
+      arma::Mat<eT> resized;
+      kernel->Resize(image, resized, width, height, depth, outputWidth,
+          outputHeight, true);
+      image = std::move(resized);
+    }
+  }
+
+  //! Determine whether images are resized while decoding.
+  bool Resizes() const { return outputWidth > 0 && outputHeight > 0; }
+
+  //! Get the output width.
+  size_t OutputWidth() const { return outputWidth; }
+  //! Get the output height.
+  size_t OutputHeight() const { return outputHeight; }
+
+ private:
+  #ifdef MODELS_HAS_LIBJPEG
+  //! libjpeg error manager that returns control to the decoder.
+  struct JPEGErrorManager
+  {
+    jpeg_error_mgr manager;
+    std::jmp_buf jump;
+  };
+
+  //! Called by libjpeg on fatal errors instead of exiting.
+  static void JPEGErrorExit(j_common_ptr info)
+  {
+    std::longjmp(reinterpret_cast<JPEGErrorManager*>(info->err)->jump, 1);
+  }
+
+  //! Determine whether the file is a JPEG from its extension.
+  static bool IsJPEG(const std::string& path)
+  {
+    const size_t dot = path.rfind('.');
+    if (dot == std::string::npos)
+      return false;
+
+    const std::string extension = mlpack::util::ToLower(path.substr(dot));
+    return extension == ".jpg" || extension == ".jpeg";
+  }
+
+  /**
+   * Decode a JPEG at the smallest DCT scale that is still at least as large
+   * as the output. Returns false if libjpeg can't decode the file.
+   */
+  bool DecodeJPEG(const std::string& path,
+                  arma::Mat<unsigned char>& pixels,
+                  size_t& width,
+                  size_t& height,
+                  size_t& scaledWidth,
+                  size_t& scaledHeight,
+                  const size_t depth) const
+  {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (file == NULL)
+      return false;
+
+    jpeg_decompress_struct info;
+    JPEGErrorManager error;
+    info.err = jpeg_std_error(&error.manager);
+    error.manager.error_exit = JPEGErrorExit;
+    if (setjmp(error.jump))
+    {
+      jpeg_destroy_decompress(&info);
+      std::fclose(file);
+      return false;
+    }
+
+    jpeg_create_decompress(&info);
+    jpeg_stdio_src(&info, file);
+    jpeg_read_header(&info, TRUE);
+
+    width = info.image_width;
+    height = info.image_height;
+    info.out_color_space = (depth == 1) ? JCS_GRAYSCALE : JCS_RGB;
+    info.scale_num = 1;
+    info.scale_denom = 1;
+    if (Resizes())
+    {
+      for (unsigned int denom = 8; denom > 1; denom /= 2)
+      {
+        if ((width + denom - 1) / denom >= outputWidth &&
+            (height + denom - 1) / denom >= outputHeight)
+        {
+          info.scale_denom = denom;
+          break;
+        }
+      }
+    }
+
+    jpeg_start_decompress(&info);
+    scaledWidth = info.output_width;
+    scaledHeight = info.output_height;
+    pixels.set_size(scaledWidth * scaledHeight * depth, 1);
+    while (info.output_scanline < info.output_height)
+    {
+      JSAMPROW row = pixels.memptr() + info.output_scanline * scaledWidth *
+          depth;
+      jpeg_read_scanlines(&info, &row, 1);
+    }
+
+    jpeg_finish_decompress(&info);
+    jpeg_destroy_decompress(&info);
+    std::fclose(file);
+    return true;
+  }
+  #endif
+
+  //! Locally stored width of the decoded images.
+  size_t outputWidth;
+
+  //! Locally stored height of the decoded images.
+  size_t outputHeight;
+
+  //! Locally stored resize kernel, shared between copies.
+  std::shared_ptr<BilinearResizeKernel> kernel;
+};
+
+} // namespace models
+} // namespace mlpack
+
+#endif
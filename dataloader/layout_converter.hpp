@@ -0,0 +1,255 @@
+/**
+ * @file layout_converter.hpp
+ * @author Kartik Dutt
+ *
+ * Definition of LayoutConverter class which converts images between the
+ * channel last and channel first layouts.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_DATALOADER_LAYOUT_CONVERTER_HPP
+#define MODELS_DATALOADER_LAYOUT_CONVERTER_HPP
+
+#include <mlpack.hpp>
+
+namespace mlpack {
+namespace models {
+
+/**
+ * Converts batches of images between the channel last (HWC) layout, where the
+ * channels of each pixel are stored next to each other as decoded images are,
+ * and the channel first (CHW) layout, where each channel is stored as a
+ * contiguous height x width plane as the convolution layers expect. Each
+ * column of the batch is an image and width is the fastest moving spatial
+ * axis in both layouts.
+ *
+ * The conversion optionally applies out = (in * scale - mean[c]) / std[c] to
+ * every value of channel c while it is moved, so ImageNet style preprocessing
+ * reads and writes each image once. Pixels are processed in blocks that fit
+ * in the L1 cache, channels within a block are written with SIMD friendly
+ * loops and images are converted in parallel.
+ *
+ * @code
+ * // ToTensor() followed by the usual ImageNet normalization.
+ * LayoutConverter converter(1.0 / 255.0, {0.485, 0.456, 0.406},
+ *     {0.229, 0.224, 0.225});
+ * converter.ToChannelFirst(images, 224, 224, 3);
+ * @endcode
+ */
+class LayoutConverter
+{
+ public:
+  /**
+   * Create the converter.
+   *
+   * @param scale Scale applied to every value before normalization.
+   * @param mean Mean of each channel, subtracted after scaling. Either empty,
+   *             a single value for all channels or one value per channel.
+   * @param stdDev Standard deviation of each channel, divides the values
+   *               after the mean is subtracted. Either empty, a single value
+   *               for all channels or one value per channel.
+   */
+  LayoutConverter(const double scale = 1.0,
+                  const std::vector<double>& mean = std::vector<double>(),
+                  const std::vector<double>& stdDev = std::vector<double>()) :
+      scale(scale),
+      mean(mean),
+      stdDev(stdDev)
+  {
+    for (const double deviation : stdDev)
+    {
+      if (deviation == 0.0)
+      {
+        mlpack::Log::Fatal << "Standard deviation of a channel must be "
+            << "non-zero." << std::endl;
+      }
+    }
+  }
+
+  /**
+   * Convert channel last images to channel first.
+   *
+   * @param input Channel last images, each column is an image.
+   * @param output Matrix where the channel first images will be stored. It is
+   *               only reallocated if it doesn't have the right size.
+   * @param width Width of each image.
+   * @param height Height of each image.
+   * @param depth Number of channels of each image.
+   */
+  template<typename eT>
+  void ToChannelFirst(const arma::Mat<eT>& input,
+                      arma::Mat<eT>& output,
+                      const size_t width,
+                      const size_t height,
+                      const size_t depth) const
+  {
+    Convert(input, output, width * height, depth, true);
+  }
+
+  /**
+   * Convert channel last images to channel first in place.
+   *
+   * @param images Images, each column is an image.
+   * @param width Width of each image.
+   * @param height Height of each image.
+   * @param depth Number of channels of each image.
+   */
+  template<typename eT>
+  void ToChannelFirst(arma::Mat<eT>& images,
+                      const size_t width,
+                      const size_t height,
+                      const size_t depth) const
+  {
+    Convert(images, images, width * height, depth, true);
+  }
+
+  /**
+   * Convert channel first images to channel last.
+   *
+   * @param input Channel first images, each column is an image.
+   * @param output Matrix where the channel last images will be stored. It is
+   *               only reallocated if it doesn't have the right size.
+   * @param width Width of each image.
+   * @param height Height of each image.
+   * @param depth Number of channels of each image.
+   */
+  template<typename eT>
+  void ToChannelLast(const arma::Mat<eT>& input,
+                     arma::Mat<eT>& output,
+                     const size_t width,
+                     const size_t height,
+                     const size_t depth) const
+  {
+    Convert(input, output, width * height, depth, false);
+  }
+
+  /**
+   * Convert channel first images to channel last in place.
+   *
+   * @param images Images, each column is an image.
+   * @param width Width of each image.
+   * @param height Height of each image.
+   * @param depth Number of channels of each image.
+   */
+  template<typename eT>
+  void ToChannelLast(arma::Mat<eT>& images,
+                     const size_t width,
+                     const size_t height,
+                     const size_t depth) const
+  {
+    Convert(images, images, width * height, depth, false);
+  }
+
+ private:
+  //! Number of pixels converted at a time, small enough to stay in L1.
+  static constexpr size_t blockSize = 256;
+
+  /**
+   * Convert between the layouts. The input and output may be the same
+   * matrix, every thread then converts into a scratch image of its own and
+   * copies it back.
+   *
+   * @param input Images to convert.
+   * @param output Matrix where the converted images will be stored.
+   * @param pixels Number of pixels of each image.
+   * @param depth Number of channels of each image.
+   * @param channelFirst If true convert HWC to CHW, otherwise CHW to HWC.
+   */
+  template<typename eT>
+  void Convert(const arma::Mat<eT>& input,
+               arma::Mat<eT>& output,
+               const size_t pixels,
+               const size_t depth,
+               const bool channelFirst) const
+  {
+    static_assert(std::is_floating_point<eT>::value, "LayoutConverter "
+        "requires floating point images.");
+
+    if (input.n_rows != pixels * depth)
+    {
+      mlpack::Log::Fatal << "Images have " << input.n_rows << " rows, "
+          << "expected " << pixels << " pixels x " << depth << " channels."
+          << std::endl;
+    }
+
+    if ((mean.size() > 1 && mean.size() != depth) ||
+        (stdDev.size() > 1 && stdDev.size() != depth))
+    {
+      mlpack::Log::Fatal << "Number of means and standard deviations must "
+          << "match the number of channels (" << depth << ")." << std::endl;
+    }
+
+    // Fold the scale and normalization into out = in * multiplier + bias.
+    std::vector<eT> multiplier(depth), bias(depth);
+    for (size_t c = 0; c < depth; ++c)
+    {
+      const double m = mean.empty() ? 0.0 : mean[mean.size() > 1 ? c : 0];
+      const double s = stdDev.empty() ? 1.0 :
+          stdDev[stdDev.size() > 1 ? c : 0];
+      multiplier[c] = (eT) (scale / s);
+      bias[c] = (eT) (-m / s);
+    }
+
+    const bool inPlace = (&input == &output);
+    if (!inPlace)
+      output.set_size(input.n_rows, input.n_cols);
+
+    #pragma omp parallel
+    {
+      arma::Col<eT> scratch;
+      if (inPlace)
+        scratch.set_size(input.n_rows);
+
+      #pragma omp for schedule(static)
+      for (omp_size_t i = 0; i < (omp_size_t) input.n_cols; ++i)
+      {
+        const eT* in = input.colptr(i);
+        eT* out = inPlace ? scratch.memptr() : output.colptr(i);
+
+        for (size_t begin = 0; begin < pixels; begin += blockSize)
+        {
+          const size_t end = std::min(begin + blockSize, pixels);
+          for (size_t c = 0; c < depth; ++c)
+          {
+            const eT a = multiplier[c];
+            const eT b = bias[c];
+            if (channelFirst)
+            {
+              eT* plane = out + c * pixels;
+              #pragma omp simd
+              for (size_t p = begin; p < end; ++p)
+                plane[p] = in[p * depth + c] * a + b;
+            }
+            else
+            {
+              const eT* plane = in + c * pixels;
+              #pragma omp simd
+              for (size_t p = begin; p < end; ++p)
+                out[p * depth + c] = plane[p] * a + b;
+            }
+          }
+        }
+
+        if (inPlace)
+          std::copy(scratch.begin(), scratch.end(), output.colptr(i));
+      }
+    }
+  }
+
+  //! Locally stored scale.
+  double scale;
+
+  //! Locally stored mean of each channel.
+  std::vector<double> mean;
+
+  //! Locally stored standard deviation of each channel.
+  std::vector<double> stdDev;
+};
+
+} // namespace models
+} // namespace mlpack
+
+#endif
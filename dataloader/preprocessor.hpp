@@ -14,6 +14,7 @@
 #define MODELS_DATALOADER_PREPROCESSOR_HPP
 
 #include <mlpack.hpp>
+#include "layout_converter.hpp"
 
 namespace mlpack {
 namespace models {
@@ -61,12 +62,14 @@ class PreProcessor
 
   /**
    * Converts image to channel first format used in PyTorch. Performs the same function
-   * as torch.transforms.ToTensor().
+   * as torch.transforms.ToTensor(). Each channel of the converted image is a
+   * contiguous height x width plane.
    *
    * @param trainFeatures Input features that will be converted into channel first format.
    * @param imageWidth Width of the image in dataset.
    * @param imageHeight Height of the image in dataset.
    * @param imageDepth Depth / Number of channels of the image in dataset.
+   * @param normalize If true, values are scaled from [0, 255] to [0, 1].
    */
   static void ChannelFirstImages(DatasetX& trainFeatures,
       const size_t imageWidth,
@@ -74,27 +77,9 @@ class PreProcessor
       const size_t imageDepth,
       bool normalize = true)
   {
-    for (size_t idx = 0; idx < trainFeatures.n_cols; idx++)
-    {
-        // Create a copy of the current image so that the image isn't affected.
-        arma::cube inputTemp(trainFeatures.col(idx).memptr(), 3, 224, 224);
-
-        size_t currentOffset = 0;
-        for (size_t i = 0; i < inputTemp.n_slices; i++)
-        {
-          trainFeatures.col(idx)(arma::span(currentOffset, currentOffset +
-              inputTemp.slice(i).n_elem - 1), arma::span()) =
-              arma::vectorise(inputTemp.slice(i).t());
-          currentOffset += inputTemp.slice(i).n_elem;
-        }
-    }
-
-    if (normalize)
-    {
-      // Convert each element to uint8 first and then divide by 255.
-      for (size_t i = 0; i < trainFeatures.n_elem; i++)
-          trainFeatures(i) = ((uint8_t)(trainFeatures(i)) / 255.0);
-    }
+    LayoutConverter converter(normalize ? 1.0 / 255.0 : 1.0);
+    converter.ToChannelFirst(trainFeatures, imageWidth, imageHeight,
+        imageDepth);
   }
 
   /**
@@ -102,6 +87,11 @@ class PreProcessor
    * arma::mat type for training YOLO model. Each column in target matrix has
    * the size : gridWidth * gridHeight * (5 * numBoxes + classes).
    *
+   * The boxes of the whole batch are first assigned to grid cells in flat
+   * arrays, then every target column is written directly. Both steps run in
+   * parallel over the images and the output is only reallocated if its size
+   * changes, so the targets can be computed for every minibatch.
+   *
    * @param annotations Field object created using model's dataloader containing
    *     annotation for images.
    * @param output Output matrix where output will be stored.
@@ -135,7 +125,7 @@ class PreProcessor
     mlpack::Log::Assert(typeid(annotations) == typeid(arma::field<arma::vec>),
         "Use Field type to represent annotations.");
 
-    size_t batchSize = annotations.n_cols;
+    const size_t batchSize = annotations.n_cols;
     size_t numPredictions = 5 * numBoxes + numClasses;
     if (version > 1)
     {
@@ -143,122 +133,235 @@ class PreProcessor
       numPredictions = numBoxes * (5 + numClasses);
     }
 
-    double cellSizeHeight = (double) 1.0 / gridHeight;
-    double cellSizeWidth = (double) 1.0 / gridWidth;
+    std::vector<size_t> offsets, cells, slots, classes;
+    arma::Mat<eT> coordinates;
+    YOLOAssignBoxes(annotations, imageWidth, imageHeight, gridWidth,
+        gridHeight, normalize, offsets, cells, slots, coordinates, classes);
 
-    // Set size of output and use cubes convenience.
-    output.set_size(gridWidth * gridHeight * numPredictions, batchSize);
-    output.zeros();
+    // Set size of output, every column is zeroed by the thread that fills it.
+    const size_t gridSize = gridWidth * gridHeight;
+    output.set_size(gridSize * numPredictions, batchSize);
 
-    // Use offset to create a cube for a particular column / batch.
-    size_t offset = 0;
-    for (size_t boxIdx = 0; boxIdx < batchSize; boxIdx++)
+    #pragma omp parallel for schedule(static)
+    for (omp_size_t image = 0; image < (omp_size_t) batchSize; ++image)
     {
-      arma::cube outputTemp(const_cast<arma::Mat<eT> &>(output).memptr() +
-          offset, gridHeight, gridWidth, numPredictions, false, false);
-      offset += gridWidth * gridHeight * numPredictions;
-
-      // Get the bounding box and labels corresponding to current image.
-      arma::mat labels(1, annotations(0, boxIdx).n_elem / 5);
-      arma::mat boundingBoxes(4, annotations(0, boxIdx).n_elem / 5);
-      for (size_t i = 0; i < boundingBoxes.n_cols; i++)
+      eT* target = output.colptr(image);
+      std::fill(target, target + output.n_rows, eT(0));
+
+      for (size_t i = offsets[image]; i < offsets[image + 1]; ++i)
       {
-        labels.col(i)(0) = annotations(0, boxIdx)(i * 5);
-        boundingBoxes.col(i) = annotations(0, boxIdx)(arma::span(i * 5 + 1,
-            (i + 1) * 5 - 1));
+        // Element s of the cell is at cell + s * gridSize.
+        eT* cell = target + cells[i];
+        const eT* box = coordinates.colptr(i);
+        if (version == 1)
+        {
+          // Fill elements in the grid.
+          for (size_t k = 0; k < numBoxes; k++)
+          {
+            for (size_t j = 0; j < 4; ++j)
+              cell[(5 * k + j) * gridSize] = box[j];
+            cell[(5 * k + 4) * gridSize] = 1;
+          }
+          cell[(5 * numBoxes + classes[i]) * gridSize] = 1;
+        }
+        else if (slots[i] < numBoxes)
+        {
+          const size_t bBoxOffset = (5 + numClasses) * slots[i];
+          for (size_t j = 0; j < 4; ++j)
+            cell[(bBoxOffset + j) * gridSize] = box[j];
+          cell[(bBoxOffset + 4) * gridSize] = 1;
+          cell[(bBoxOffset + 5 + classes[i]) * gridSize] = 1;
+        }
       }
+    }
+  }
+
+  /**
+   * Sparse PreProcessor for YOLO model. Instead of the dense grid of
+   * YOLOPreProcessor, each column of the target matrix only lists the
+   * occupied cells of an image, so the targets grow with the number of
+   * objects rather than with the grid. Each column holds
+   *
+   *   numObjects, (cell, slot, x, y, width, height, class) * numObjects
+   *
+   * padded with zeros to the largest number of objects in the batch. The
+   * cell, slot and coordinates are those of the dense format, i.e. the entry
+   * of an object sits at the same place the dense target would store it.
+   * Like in the dense format, boxes that don't get a slot in their cell are
+   * dropped; for YOLO v1 a cell holds a single object. The targets are meant
+   * to be used with SparseYOLOLoss.
+   *
+   * @param annotations Field object created using model's dataloader containing
+   *     annotation for images.
+   * @param output Output matrix where output will be stored.
+   * @param version Version of YOLO.
+   * @param imageWidth Width of image used for training YOLO model.
+   * @param imageHeight Height of image used for training YOLO model.
+   * @param gridWidth Width of output feature map of YOLO model.
+   * @param gridHeight Height of output feature map of YOLO model.
+   * @param numBoxes Number of bounding boxes per grid.
+   * @param normalize Boolean to determine whether coordinates are to
+   *    to be normalized or not. Defaults to true.
+   */
+  template<typename eT>
+  static void YOLOSparsePreProcessor(const DatasetY& annotations,
+                                     arma::Mat<eT>& output,
+                                     const size_t version = 1,
+                                     const size_t imageWidth = 224,
+                                     const size_t imageHeight = 224,
+                                     const size_t gridWidth = 7,
+                                     const size_t gridHeight = 7,
+                                     const size_t numBoxes = 2,
+                                     const bool normalize = true)
+  {
+    mlpack::Log::Assert(version >= 1 && version <= 3, "Supported YOLO versions \
+        are version 1 to version 3.");
 
-      // For YOLOv2 or higher, each bounding box can represent a class
-      // so we don't repeat labels as done for YOLOv1. We will use map
-      // to store last inserted bounding box.
-      std::map<std::pair<size_t, size_t>, size_t> boundingBoxOffset;
+    mlpack::Log::Assert(typeid(annotations) == typeid(arma::field<arma::vec>),
+        "Use Field type to represent annotations.");
+
+    std::vector<size_t> offsets, cells, slots, classes;
+    arma::Mat<eT> coordinates;
+    YOLOAssignBoxes(annotations, imageWidth, imageHeight, gridWidth,
+        gridHeight, normalize, offsets, cells, slots, coordinates, classes);
 
-      // Normalize the coordinates.
-      boundingBoxes.row(0) /= imageWidth;
-      boundingBoxes.row(2) /= imageWidth;
-      boundingBoxes.row(1) /= imageHeight;
-      boundingBoxes.row(3) /= imageHeight;
+    // Only the first object of a cell is kept for YOLO v1.
+    const size_t numSlots = (version == 1) ? 1 : numBoxes;
+    const size_t batchSize = annotations.n_cols;
+    std::vector<size_t> numObjects(batchSize, 0);
+    for (size_t image = 0; image < batchSize; ++image)
+    {
+      for (size_t i = offsets[image]; i < offsets[image + 1]; ++i)
+        numObjects[image] += (slots[i] < numSlots);
+    }
 
-      // Get width and height as well as centres for the bounding box.
-      arma::mat widthAndHeight(2, boundingBoxes.n_cols);
-      widthAndHeight.row(0) = (boundingBoxes.row(2) - boundingBoxes.row(0));
-      widthAndHeight.row(1) = (boundingBoxes.row(3) - boundingBoxes.row(1));
+    const size_t maxObjects = batchSize == 0 ? 0 :
+        *std::max_element(numObjects.begin(), numObjects.end());
+    output.zeros(1 + 7 * maxObjects, batchSize);
 
-      arma::mat centres(2, boundingBoxes.n_cols);
-      centres.row(0) = (boundingBoxes.row(2) + boundingBoxes.row(0)) / 2.0;
-      centres.row(1) = (boundingBoxes.row(3) + boundingBoxes.row(1)) / 2.0;
+    #pragma omp parallel for schedule(static)
+    for (omp_size_t image = 0; image < (omp_size_t) batchSize; ++image)
+    {
+      eT* target = output.colptr(image);
+      target[0] = numObjects[image];
 
-      // Assign bounding boxes to the grid.
-      for (size_t i = 0; i < boundingBoxes.n_cols; i++)
+      eT* object = target + 1;
+      for (size_t i = offsets[image]; i < offsets[image + 1]; ++i)
       {
-        // Index for representing bounding box on grid.
-        arma::vec gridCoordinates = centres.col(i);
-        arma::vec centreCoordinates = centres.col(i);
+        if (slots[i] >= numSlots)
+          continue;
+
+        object[0] = cells[i];
+        object[1] = slots[i];
+        std::copy(coordinates.colptr(i), coordinates.colptr(i) + 4,
+            object + 2);
+        object[6] = classes[i];
+        object += 7;
+      }
+    }
+  }
+
+  /**
+   * Assign every bounding box of a batch of annotations to the grid cell that
+   * contains its centre. The results are stored in flat arrays, the boxes of
+   * image i are the entries offsets[i] to offsets[i + 1] - 1.
+   *
+   * Cells are indexed as gridX + gridY * gridHeight, the order the target
+   * cubes of YOLOPreProcessor use. Each column of coordinates holds the centre
+   * relative to the cell (or to the image if normalize is false) followed by
+   * the width and height relative to the image. The slot of a box is the
+   * number of boxes of the same image assigned to its cell before it.
+   *
+   * @param annotations Field object created using model's dataloader
+   *     containing annotation for images.
+   * @param imageWidth Width of image used for training YOLO model.
+   * @param imageHeight Height of image used for training YOLO model.
+   * @param gridWidth Width of output feature map of YOLO model.
+   * @param gridHeight Height of output feature map of YOLO model.
+   * @param normalize Whether the centre is relative to the cell.
+   * @param offsets Set to the index of the first box of each image.
+   * @param cells Set to the cell of each box.
+   * @param slots Set to the slot of each box within its cell.
+   * @param coordinates Set to the coordinates of each box.
+   * @param classes Set to the class of each box.
+   */
+  template<typename eT>
+  static void YOLOAssignBoxes(const DatasetY& annotations,
+                              const size_t imageWidth,
+                              const size_t imageHeight,
+                              const size_t gridWidth,
+                              const size_t gridHeight,
+                              const bool normalize,
+                              std::vector<size_t>& offsets,
+                              std::vector<size_t>& cells,
+                              std::vector<size_t>& slots,
+                              arma::Mat<eT>& coordinates,
+                              std::vector<size_t>& classes)
+  {
+    const size_t batchSize = annotations.n_cols;
+    offsets.resize(batchSize + 1);
+    offsets[0] = 0;
+    for (size_t image = 0; image < batchSize; ++image)
+      offsets[image + 1] = offsets[image] + annotations(0, image).n_elem / 5;
 
+    const size_t totalBoxes = offsets[batchSize];
+    cells.resize(totalBoxes);
+    slots.resize(totalBoxes);
+    classes.resize(totalBoxes);
+    coordinates.set_size(4, totalBoxes);
+
+    const double cellSizeHeight = (double) 1.0 / gridHeight;
+    const double cellSizeWidth = (double) 1.0 / gridWidth;
+
+    #pragma omp parallel for schedule(static)
+    for (omp_size_t image = 0; image < (omp_size_t) batchSize; ++image)
+    {
+      const arma::vec& boxes = annotations(0, image);
+      for (size_t i = offsets[image]; i < offsets[image + 1]; ++i)
+      {
+        const double* box = boxes.memptr() + 5 * (i - offsets[image]);
+
+        // Normalize the coordinates.
+        const double x1 = box[1] / imageWidth;
+        const double y1 = box[2] / imageHeight;
+        const double x2 = box[3] / imageWidth;
+        const double y2 = box[4] / imageHeight;
+        const double centreX = (x1 + x2) / 2.0;
+        const double centreY = (y1 + y2) / 2.0;
+
+        // Index for representing bounding box on grid. Centres on the left
+        // or top border belong to the first cell.
+        const double cellX = std::ceil(centreX / cellSizeWidth) - 1;
+        const double cellY = std::ceil(centreY / cellSizeHeight) - 1;
+        const size_t gridX = (size_t) std::min(std::max(cellX, 0.0),
+            (double) gridWidth - 1);
+        const size_t gridY = (size_t) std::min(std::max(cellY, 0.0),
+            (double) gridHeight - 1);
+
+        eT* coordinate = coordinates.colptr(i);
         if (normalize)
         {
-          gridCoordinates(0) = std::ceil(gridCoordinates(0) /
-              cellSizeWidth) - 1;
-          gridCoordinates(1) = std::ceil(gridCoordinates(1) /
-              cellSizeHeight) - 1;
+          coordinate[0] = (centreX - gridX * cellSizeWidth) / cellSizeWidth;
+          coordinate[1] = (centreY - gridY * cellSizeHeight) /
+              cellSizeHeight;
         }
         else
         {
-          gridCoordinates(0) = std::ceil((gridCoordinates(0) /
-              imageWidth) / cellSizeWidth) - 1;
-          gridCoordinates(1) = std::ceil((gridCoordinates(1) /
-              imageHeight) / cellSizeHeight) - 1;
+          coordinate[0] = centreX;
+          coordinate[1] = centreY;
         }
+        coordinate[2] = x2 - x1;
+        coordinate[3] = y2 - y1;
 
-        size_t gridX = gridCoordinates(0);
-        size_t gridY = gridCoordinates(1);
-        gridCoordinates(0) = gridCoordinates(0) * cellSizeWidth;
-        gridCoordinates(1) = gridCoordinates(1) * cellSizeHeight;
-
-        // Normalize to 1.0.
-        gridCoordinates = centres.col(i) - gridCoordinates;
-        gridCoordinates(0) /= cellSizeWidth;
-        gridCoordinates(1) /= cellSizeHeight;
-
-        if (normalize)
-          centreCoordinates = gridCoordinates;
+        cells[i] = gridX + gridY * gridHeight;
+        classes[i] = (size_t) box[0];
 
-        if (version == 1)
-        {
-          // Fill elements in the grid.
-          for (size_t k = 0; k < numBoxes; k++)
-          {
-            size_t s = 5 * k;
-            outputTemp(arma::span(gridX), arma::span(gridY),
-                arma::span(s, s + 1)) = centreCoordinates;
-            outputTemp(arma::span(gridX), arma::span(gridY),
-                arma::span(s + 2, s + 3)) = widthAndHeight.col(i);
-            outputTemp(gridX, gridY, s + 4) = 1.0;
-          }
-          outputTemp(gridX, gridY, 5 * numBoxes + labels.col(i)(0)) = 1;
-        }
-        else
+        // Boxes in the same cell take the next free slot.
+        slots[i] = 0;
+        for (size_t j = offsets[image]; j < i; ++j)
         {
-          size_t s = 0;
-          if (boundingBoxOffset.count({gridX, gridY}))
-          {
-            s = boundingBoxOffset[{gridX, gridY}] + 1;
-            boundingBoxOffset[{gridX, gridY}]++;
-          }
-          else
-            boundingBoxOffset.insert({{gridX, gridY}, s});
-
-          if (s > numBoxes)
-            continue;
-
-          size_t bBoxOffset = (5 + numClasses) * s;
-          outputTemp(arma::span(gridX), arma::span(gridY),
-              arma::span(bBoxOffset, bBoxOffset + 1)) = centreCoordinates;
-          outputTemp(arma::span(gridX), arma::span(gridY),
-              arma::span(bBoxOffset + 2,
-                  bBoxOffset + 3)) = widthAndHeight.col(i);
-          outputTemp(gridX, gridY, bBoxOffset + 4) = 1.0;
-          outputTemp(gridX, gridY, bBoxOffset + 5 + labels.col(i)(0)) = 1;
+          if (cells[j] == cells[i])
+            slots[i]++;
         }
       }
     }
@@ -0,0 +1,233 @@
+/**
+ * @file conv_bn_leaky_relu.hpp
+ * @author Kartik Dutt
+ *
+ * Definition of ConvBNLeakyReLU layer, a convolution followed by batch
+ * normalization and a leaky ReLU computed by a single layer.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_LAYERS_CONV_BN_LEAKY_RELU_HPP
+#define MODELS_LAYERS_CONV_BN_LEAKY_RELU_HPP
+
+#define MLPACK_ENABLE_ANN_SERIALIZATION
+#include <mlpack.hpp>
+#include "serialization.hpp"
+#include "fast_convolution.hpp"
+
+namespace mlpack {
+namespace models {
+
+/**
+ * A convolution without bias, followed by batch normalization over each
+ * output map and a leaky ReLU, as used by the convolution blocks of DarkNet
+ * and YOLO. The layer computes the same function as the three layers
+ *
+ * @code
+ * Convolution(maps, kernelWidth, kernelHeight, strideWidth, strideHeight,
+ *     padW, padH, "none", false);
+ * BatchNorm(2, 2, eps, false, momentum);
+ * LeakyReLU(negativeSlope);
+ * @endcode
+ *
+ * but the normalization and the activation are applied in a single pass over
+ * the output of the convolution, which is normalized in place. The backward
+ * pass computes the gradient of both in a single buffer as well, so the
+ * layer keeps two activation sized buffers instead of six.
+ *
+ * The parameters of the layer are the convolution weights followed by the
+ * scale and the shift of the normalization. The convolution has no bias as
+ * the shift of the normalization takes its place.
+ *
+ * @tparam MatType Matrix representation to accept as input and use for
+ *    computation.
+ */
+template<typename MatType = arma::mat>
+class ConvBNLeakyReLUType : public Layer<MatType>
+{
+ public:
+  //! Create an empty ConvBNLeakyReLUType layer.
+  ConvBNLeakyReLUType();
+
+  /**
+   * Create the ConvBNLeakyReLUType layer.
+   *
+   * @param maps Number of output maps.
+   * @param kernelWidth Width of the filter/kernel.
+   * @param kernelHeight Height of the filter/kernel.
+   * @param strideWidth Stride of filter application in the x direction.
+   * @param strideHeight Stride of filter application in the y direction.
+   * @param padW Padding width of the input.
+   * @param padH Padding height of the input.
+   * @param eps The epsilon added to the variance to ensure numerical
+   *     stability.
+   * @param momentum Momentum of the running mean and variance.
+   * @param negativeSlope Negative slope of the leaky ReLU.
+   */
+  ConvBNLeakyReLUType(const size_t maps,
+                      const size_t kernelWidth,
+                      const size_t kernelHeight,
+                      const size_t strideWidth = 1,
+                      const size_t strideHeight = 1,
+                      const size_t padW = 0,
+                      const size_t padH = 0,
+                      const double eps = 1e-5,
+                      const double momentum = 0.1,
+                      const double negativeSlope = 0.1);
+
+  //! Clone the ConvBNLeakyReLUType object.
+  ConvBNLeakyReLUType* Clone() const { return new ConvBNLeakyReLUType(*this); }
+
+  //! Virtual destructor.
+  virtual ~ConvBNLeakyReLUType() { /* Nothing to do here. */ }
+
+  /**
+   * Compute the convolution, normalize its output and apply the activation.
+   * In training mode the batch statistics are used and the running
+   * statistics are updated, otherwise the running statistics are used.
+   *
+   * @param input Input data for the layer.
+   * @param output Resulting output activations.
+   */
+  void Forward(const MatType& input, MatType& output);
+
+  /**
+   * Backpropagate the error through the activation, the normalization and
+   * the convolution.
+   *
+   * @param input The propagated input activation.
+   * @param gy The backpropagated error.
+   * @param g The calculated gradient.
+   */
+  void Backward(const MatType& input, const MatType& gy, MatType& g);
+
+  /**
+   * Calculate the gradient of the parameters, using the error computed by
+   * Backward().
+   *
+   * @param input The input of the layer.
+   * @param error The backpropagated error.
+   * @param gradient The calculated gradient.
+   */
+  void Gradient(const MatType& input,
+                const MatType& error,
+                MatType& gradient);
+
+  //! Set the weights of the layer to the given memory.
+  void SetWeights(typename MatType::elem_type* weightsPtr);
+
+  //! Initialize the scale of the normalization to one and the shift to zero.
+  void CustomInitialize(MatType& W, const size_t elements);
+
+  //! Get the size of the weights.
+  size_t WeightSize() const { return convolution.WeightSize() + 2 * maps; }
+
+  //! Compute the output dimensions of the layer.
+  void ComputeOutputDimensions();
+
+  //! Get the number of output maps.
+  size_t Maps() const { return maps; }
+
+  //! Get the width of the kernel.
+  size_t KernelWidth() const { return convolution.KernelWidth(); }
+
+  //! Get the height of the kernel.
+  size_t KernelHeight() const { return convolution.KernelHeight(); }
+
+  //! Get the stride in the x direction.
+  size_t StrideWidth() const { return convolution.StrideWidth(); }
+
+  //! Get the stride in the y direction.
+  size_t StrideHeight() const { return convolution.StrideHeight(); }
+
+  //! Get the padding width of the input.
+  size_t PadW() const { return convolution.PadWLeft(); }
+
+  //! Get the padding height of the input.
+  size_t PadH() const { return convolution.PadHTop(); }
+
+  //! Get the epsilon of the normalization.
+  double Epsilon() const { return eps; }
+
+  //! Get the momentum of the running statistics.
+  double Momentum() const { return momentum; }
+
+  //! Get the negative slope of the leaky ReLU.
+  double NegativeSlope() const { return negativeSlope; }
+
+  //! Get the running mean of each map.
+  const MatType& TrainingMean() const { return runningMean; }
+  //! Modify the running mean of each map.
+  MatType& TrainingMean() { return runningMean; }
+
+  //! Get the running variance of each map.
+  const MatType& TrainingVariance() const { return runningVariance; }
+  //! Modify the running variance of each map.
+  MatType& TrainingVariance() { return runningVariance; }
+
+  //! Serialize the layer.
+  template<typename Archive>
+  void serialize(Archive& ar, const uint32_t /* version */);
+
+ private:
+  //! The type of the convolution, see FastConvolutionType.
+  typedef FastConvolutionType<MatType> ConvolutionLayerType;
+
+  //! Locally stored convolution, without bias.
+  ConvolutionLayerType convolution;
+
+  //! Locally stored number of output maps.
+  size_t maps;
+
+  //! Locally stored epsilon of the normalization.
+  double eps;
+
+  //! Locally stored momentum of the running statistics.
+  double momentum;
+
+  //! Locally stored negative slope of the leaky ReLU.
+  double negativeSlope;
+
+  //! Locally stored number of elements of each output map.
+  size_t mapSize;
+
+  //! Locally stored scale of the normalization, an alias of the weights.
+  MatType gamma;
+
+  //! Locally stored shift of the normalization, an alias of the weights.
+  MatType beta;
+
+  //! Locally stored running mean of each map.
+  MatType runningMean;
+
+  //! Locally stored running variance of each map.
+  MatType runningVariance;
+
+  //! Locally stored inverse standard deviation used by the last forward pass.
+  MatType inverseDeviation;
+
+  //! Locally stored normalized output of the convolution.
+  MatType normalized;
+
+  //! Locally stored error with respect to the output of the convolution.
+  MatType delta;
+
+  //! Locally stored gradient of the scale and the shift.
+  MatType normGradient;
+}; // class ConvBNLeakyReLUType
+
+// Convenience typedef.
+typedef ConvBNLeakyReLUType<arma::mat> ConvBNLeakyReLU;
+
+} // namespace models
+} // namespace mlpack
+
+CEREAL_REGISTER_TYPE(mlpack::models::ConvBNLeakyReLUType<arma::mat>);
+CEREAL_REGISTER_TYPE(mlpack::models::ConvBNLeakyReLUType<arma::fmat>);
+
+#include "conv_bn_leaky_relu_impl.hpp"
+
+#endif
@@ -0,0 +1,267 @@
+/**
+ * @file conv_bn_leaky_relu_impl.hpp
+ * @author Kartik Dutt
+ *
+ * Implementation of ConvBNLeakyReLU layer.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_LAYERS_CONV_BN_LEAKY_RELU_IMPL_HPP
+#define MODELS_LAYERS_CONV_BN_LEAKY_RELU_IMPL_HPP
+
+// Incase it has not been included already.
+#include "conv_bn_leaky_relu.hpp"
+
+namespace mlpack {
+namespace models {
+
+template<typename MatType>
+ConvBNLeakyReLUType<MatType>::ConvBNLeakyReLUType() :
+    Layer<MatType>(),
+    maps(0),
+    eps(1e-5),
+    momentum(0.1),
+    negativeSlope(0.1),
+    mapSize(0)
+{
+  // Nothing to do here.
+}
+
+template<typename MatType>
+ConvBNLeakyReLUType<MatType>::ConvBNLeakyReLUType(
+    const size_t maps,
+    const size_t kernelWidth,
+    const size_t kernelHeight,
+    const size_t strideWidth,
+    const size_t strideHeight,
+    const size_t padW,
+    const size_t padH,
+    const double eps,
+    const double momentum,
+    const double negativeSlope) :
+    Layer<MatType>(),
+    convolution(maps, kernelWidth, kernelHeight, strideWidth, strideHeight,
+        padW, padH, "none", false),
+    maps(maps),
+    eps(eps),
+    momentum(momentum),
+    negativeSlope(negativeSlope),
+    mapSize(0)
+{
+  if (negativeSlope < 0.0)
+  {
+    mlpack::Log::Fatal << "ConvBNLeakyReLU requires a non-negative slope, "
+        << "found " << negativeSlope << "." << std::endl;
+  }
+}
+
+template<typename MatType>
+void ConvBNLeakyReLUType<MatType>::ComputeOutputDimensions()
+{
+  size_t higherDimensions = 1;
+  for (size_t i = 3; i < this->inputDimensions.size(); ++i)
+    higherDimensions *= this->inputDimensions[i];
+
+  if (higherDimensions != 1)
+  {
+    mlpack::Log::Fatal << "ConvBNLeakyReLU only supports three dimensional "
+        << "inputs." << std::endl;
+  }
+
+  convolution.InputDimensions() = this->inputDimensions;
+  convolution.ComputeOutputDimensions();
+  this->outputDimensions = convolution.OutputDimensions();
+  mapSize = this->outputDimensions[0] * this->outputDimensions[1];
+
+  if (runningMean.n_elem != maps)
+  {
+    runningMean.zeros(maps, 1);
+    runningVariance.ones(maps, 1);
+  }
+}
+
+template<typename MatType>
+void ConvBNLeakyReLUType<MatType>::SetWeights(
+    typename MatType::elem_type* weightsPtr)
+{
+  const size_t convolutionSize = convolution.WeightSize();
+  convolution.SetWeights(weightsPtr);
+  MakeAlias(gamma, weightsPtr + convolutionSize, maps, 1);
+  MakeAlias(beta, weightsPtr + convolutionSize + maps, maps, 1);
+}
+
+template<typename MatType>
+void ConvBNLeakyReLUType<MatType>::CustomInitialize(
+    MatType& W,
+    const size_t /* elements */)
+{
+  const size_t convolutionSize = convolution.WeightSize();
+  W.rows(convolutionSize, convolutionSize + maps - 1).ones();
+  W.rows(convolutionSize + maps, convolutionSize + 2 * maps - 1).zeros();
+}
+
+template<typename MatType>
+void ConvBNLeakyReLUType<MatType>::Forward(const MatType& input,
+                                           MatType& output)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  // The convolution keeps its transformed kernels only outside of training.
+  convolution.Training() = this->training;
+  normalized.set_size(mapSize * maps, input.n_cols);
+  convolution.Forward(input, normalized);
+  inverseDeviation.set_size(maps, 1);
+
+  const size_t batchSize = input.n_cols;
+  const double n = (double) mapSize * batchSize;
+  const bool training = this->training;
+  const ElemType slope = (ElemType) negativeSlope;
+
+  #pragma omp parallel for schedule(static)
+  for (omp_size_t m = 0; m < (omp_size_t) maps; ++m)
+  {
+    double mean = runningMean[m];
+    double variance = runningVariance[m];
+    if (training)
+    {
+      double sum = 0.0, squaredSum = 0.0;
+      for (size_t i = 0; i < batchSize; ++i)
+      {
+        const ElemType* x = normalized.colptr(i) + m * mapSize;
+        #pragma omp simd reduction(+:sum, squaredSum)
+        for (size_t p = 0; p < mapSize; ++p)
+        {
+          sum += x[p];
+          squaredSum += (double) x[p] * x[p];
+        }
+      }
+
+      mean = sum / n;
+      variance = std::max(squaredSum / n - mean * mean, 0.0);
+
+      // The running variance is the unbiased estimate, as in BatchNorm.
+      const double correction = (n > 1) ? n / (n - 1) : 1.0;
+      runningMean[m] = (1 - momentum) * runningMean[m] + momentum * mean;
+      runningVariance[m] = (1 - momentum) * runningVariance[m] +
+          momentum * variance * correction;
+    }
+
+    // Normalize the output of the convolution in place and activate it.
+    const ElemType inverse = (ElemType) (1.0 / std::sqrt(variance + eps));
+    const ElemType shift = (ElemType) mean;
+    const ElemType scale = gamma[m];
+    const ElemType offset = beta[m];
+    inverseDeviation[m] = inverse;
+    for (size_t i = 0; i < batchSize; ++i)
+    {
+      ElemType* x = normalized.colptr(i) + m * mapSize;
+      ElemType* y = output.colptr(i) + m * mapSize;
+      #pragma omp simd
+      for (size_t p = 0; p < mapSize; ++p)
+      {
+        const ElemType xHat = (x[p] - shift) * inverse;
+        const ElemType z = scale * xHat + offset;
+        x[p] = xHat;
+        y[p] = (z > 0) ? z : slope * z;
+      }
+    }
+  }
+}
+
+template<typename MatType>
+void ConvBNLeakyReLUType<MatType>::Backward(const MatType& input,
+                                            const MatType& gy,
+                                            MatType& g)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  const size_t batchSize = gy.n_cols;
+  const ElemType n = (ElemType) (mapSize * batchSize);
+  const bool training = this->training;
+  const ElemType slope = (ElemType) negativeSlope;
+  delta.set_size(gy.n_rows, batchSize);
+  normGradient.set_size(2 * maps, 1);
+
+  #pragma omp parallel for schedule(static)
+  for (omp_size_t m = 0; m < (omp_size_t) maps; ++m)
+  {
+    const ElemType scale = gamma[m];
+    const ElemType offset = beta[m];
+
+    // Error before the activation, and the gradient of the scale and shift.
+    ElemType scaleGradient = 0, shiftGradient = 0;
+    for (size_t i = 0; i < batchSize; ++i)
+    {
+      const ElemType* xHat = normalized.colptr(i) + m * mapSize;
+      const ElemType* error = gy.colptr(i) + m * mapSize;
+      ElemType* d = delta.colptr(i) + m * mapSize;
+      #pragma omp simd reduction(+:scaleGradient, shiftGradient)
+      for (size_t p = 0; p < mapSize; ++p)
+      {
+        const ElemType dz = (scale * xHat[p] + offset > 0) ? error[p] :
+            slope * error[p];
+        d[p] = dz;
+        scaleGradient += dz * xHat[p];
+        shiftGradient += dz;
+      }
+    }
+
+    normGradient[m] = scaleGradient;
+    normGradient[maps + m] = shiftGradient;
+
+    // Error before the normalization. With batch statistics the mean and the
+    // variance depend on the input as well.
+    const ElemType factor = scale * inverseDeviation[m];
+    const ElemType meanShift = training ? shiftGradient / n : 0;
+    const ElemType meanScale = training ? scaleGradient / n : 0;
+    for (size_t i = 0; i < batchSize; ++i)
+    {
+      const ElemType* xHat = normalized.colptr(i) + m * mapSize;
+      ElemType* d = delta.colptr(i) + m * mapSize;
+      #pragma omp simd
+      for (size_t p = 0; p < mapSize; ++p)
+        d[p] = factor * (d[p] - meanShift - xHat[p] * meanScale);
+    }
+  }
+
+  convolution.Backward(input, delta, g);
+}
+
+template<typename MatType>
+void ConvBNLeakyReLUType<MatType>::Gradient(const MatType& input,
+                                            const MatType& /* error */,
+                                            MatType& gradient)
+{
+  const size_t convolutionSize = convolution.WeightSize();
+  MatType convolutionGradient;
+  MakeAlias(convolutionGradient, gradient.memptr(), convolutionSize, 1);
+  convolution.Gradient(input, delta, convolutionGradient);
+
+  gradient.rows(convolutionSize, convolutionSize + 2 * maps - 1) =
+      normGradient;
+}
+
+template<typename MatType>
+template<typename Archive>
+void ConvBNLeakyReLUType<MatType>::serialize(
+    Archive& ar, const uint32_t /* version */)
+{
+  ar(cereal::base_class<Layer<MatType>>(this));
+
+  ar(CEREAL_NVP(convolution));
+  ar(CEREAL_NVP(maps));
+  ar(CEREAL_NVP(eps));
+  ar(CEREAL_NVP(momentum));
+  ar(CEREAL_NVP(negativeSlope));
+  ar(CEREAL_NVP(mapSize));
+  ar(CEREAL_NVP(runningMean));
+  ar(CEREAL_NVP(runningVariance));
+}
+
+} // namespace models
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,195 @@
+/**
+ * @file depthwise_convolution.hpp
+ * @author Kartik Dutt
+ *
+ * Definition of DepthwiseConvolution layer, a grouped convolution with a
+ * specialized kernel for 3x3 depthwise convolutions.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_LAYERS_DEPTHWISE_CONVOLUTION_HPP
+#define MODELS_LAYERS_DEPTHWISE_CONVOLUTION_HPP
+
+#define MLPACK_ENABLE_ANN_SERIALIZATION
+#include <mlpack.hpp>
+#include "serialization.hpp"
+
+namespace mlpack {
+namespace models {
+
+/**
+ * A grouped convolution with the same parameters, weight layout and results
+ * as the GroupedConvolution layer, with a specialized kernel for depthwise
+ * convolutions, i.e. one input map for each group, with 3x3 kernels and a
+ * stride of 1 or 2 along both axes. The padding is the one of the layer, so
+ * "same" and "valid" padding are supported.
+ *
+ * Each output map only reads its own input map, so the maps are computed in
+ * parallel and every kernel element is applied to a row of the output at
+ * once, which is vectorized along the row. The backward pass and the
+ * gradient are computed the same way.
+ *
+ * Other grouped convolutions are computed by the GroupedConvolution layer.
+ * Since the layer is a GroupedConvolution, the Quantizer handles it as one.
+ *
+ * @tparam MatType Matrix representation to accept as input and use for
+ *    computation.
+ */
+template<typename MatType = arma::mat>
+class DepthwiseConvolutionType : public GroupedConvolutionType<
+    NaiveConvolution<ValidConvolution>,
+    NaiveConvolution<FullConvolution>,
+    NaiveConvolution<ValidConvolution>,
+    MatType
+>
+{
+ public:
+  //! The grouped convolution the layer extends.
+  typedef GroupedConvolutionType<
+      NaiveConvolution<ValidConvolution>,
+      NaiveConvolution<FullConvolution>,
+      NaiveConvolution<ValidConvolution>,
+      MatType
+  > GroupedConvolutionLayerType;
+
+  //! Create an empty DepthwiseConvolutionType layer.
+  DepthwiseConvolutionType();
+
+  /**
+   * Create the DepthwiseConvolutionType layer.
+   *
+   * @param maps Number of output maps.
+   * @param kernelWidth Width of the filter/kernel.
+   * @param kernelHeight Height of the filter/kernel.
+   * @param groups Number of groups, the number of input maps for a depthwise
+   *     convolution.
+   * @param strideWidth Stride of filter application in the x direction.
+   * @param strideHeight Stride of filter application in the y direction.
+   * @param padW Padding width of the input.
+   * @param padH Padding height of the input.
+   * @param paddingType The type of padding ("valid", "same" or "none").
+   * @param useBias Whether or not to use a bias with the convolution.
+   */
+  DepthwiseConvolutionType(const size_t maps,
+                           const size_t kernelWidth,
+                           const size_t kernelHeight,
+                           const size_t groups,
+                           const size_t strideWidth = 1,
+                           const size_t strideHeight = 1,
+                           const size_t padW = 0,
+                           const size_t padH = 0,
+                           const std::string& paddingType = "none",
+                           const bool useBias = true);
+
+  //! Clone the DepthwiseConvolutionType object.
+  DepthwiseConvolutionType* Clone() const
+  {
+    return new DepthwiseConvolutionType(*this);
+  }
+
+  //! Virtual destructor.
+  virtual ~DepthwiseConvolutionType() { /* Nothing to do here. */ }
+
+  /**
+   * Compute the convolution of the input.
+   *
+   * @param input Input data for the layer.
+   * @param output Resulting output activations.
+   */
+  void Forward(const MatType& input, MatType& output);
+
+  /**
+   * Backpropagate the error through the convolution.
+   *
+   * @param input The propagated input activation.
+   * @param gy The backpropagated error.
+   * @param g The calculated gradient.
+   */
+  void Backward(const MatType& input, const MatType& gy, MatType& g);
+
+  /**
+   * Calculate the gradient of the weights and the bias.
+   *
+   * @param input The input of the layer.
+   * @param error The backpropagated error.
+   * @param gradient The calculated gradient.
+   */
+  void Gradient(const MatType& input,
+                const MatType& error,
+                MatType& gradient);
+
+  //! Set the weights of the layer to the given memory.
+  void SetWeights(typename MatType::elem_type* weightsPtr);
+
+  //! Compute the output dimensions of the layer.
+  void ComputeOutputDimensions();
+
+  //! Get whether the specialized depthwise kernel is used.
+  bool Depthwise() const { return depthwise; }
+
+  //! Serialize the layer.
+  template<typename Archive>
+  void serialize(Archive& ar, const uint32_t /* version */);
+
+ private:
+  /**
+   * Get the range of outputs along an axis for which the given kernel element
+   * reads the input rather than the padding.
+   *
+   * @param k Index of the kernel element along the axis.
+   * @param pad Padding before the input.
+   * @param inSize Size of the input along the axis.
+   * @param outSize Size of the output along the axis.
+   * @param begin First output.
+   * @param end One past the last output.
+   */
+  void Range(const size_t k,
+             const size_t pad,
+             const size_t inSize,
+             const size_t outSize,
+             size_t& begin,
+             size_t& end) const;
+
+  //! Locally stored whether the specialized depthwise kernel is used.
+  bool depthwise;
+
+  //! Locally stored stride along both axes.
+  size_t stride;
+
+  //! Locally stored number of output maps of each input map.
+  size_t multiplier;
+
+  //! Locally stored width of the input.
+  size_t inputWidth;
+
+  //! Locally stored height of the input.
+  size_t inputHeight;
+
+  //! Locally stored number of input maps.
+  size_t inMaps;
+
+  //! Locally stored width of the output.
+  size_t outputWidth;
+
+  //! Locally stored height of the output.
+  size_t outputHeight;
+
+  //! Locally stored weights and bias, an alias of the parameters.
+  MatType weights;
+}; // class DepthwiseConvolutionType
+
+// Convenience typedef.
+typedef DepthwiseConvolutionType<arma::mat> DepthwiseConvolution;
+
+} // namespace models
+} // namespace mlpack
+
+CEREAL_REGISTER_TYPE(mlpack::models::DepthwiseConvolutionType<arma::mat>);
+CEREAL_REGISTER_TYPE(mlpack::models::DepthwiseConvolutionType<arma::fmat>);
+
+#include "depthwise_convolution_impl.hpp"
+
+#endif
@@ -0,0 +1,335 @@
+/**
+ * @file depthwise_convolution_impl.hpp
+ * @author Kartik Dutt
+ *
+ * Implementation of DepthwiseConvolution layer.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_LAYERS_DEPTHWISE_CONVOLUTION_IMPL_HPP
+#define MODELS_LAYERS_DEPTHWISE_CONVOLUTION_IMPL_HPP
+
+// Incase it has not been included already.
+#include "depthwise_convolution.hpp"
+
+namespace mlpack {
+namespace models {
+
+template<typename MatType>
+DepthwiseConvolutionType<MatType>::DepthwiseConvolutionType() :
+    GroupedConvolutionLayerType(),
+    depthwise(false),
+    stride(1),
+    multiplier(1),
+    inputWidth(0),
+    inputHeight(0),
+    inMaps(0),
+    outputWidth(0),
+    outputHeight(0)
+{
+  // Nothing to do here.
+}
+
+template<typename MatType>
+DepthwiseConvolutionType<MatType>::DepthwiseConvolutionType(
+    const size_t maps,
+    const size_t kernelWidth,
+    const size_t kernelHeight,
+    const size_t groups,
+    const size_t strideWidth,
+    const size_t strideHeight,
+    const size_t padW,
+    const size_t padH,
+    const std::string& paddingType,
+    const bool useBias) :
+    GroupedConvolutionLayerType(maps, kernelWidth, kernelHeight, groups,
+        strideWidth, strideHeight, padW, padH, paddingType, useBias),
+    depthwise(false),
+    stride(1),
+    multiplier(1),
+    inputWidth(0),
+    inputHeight(0),
+    inMaps(0),
+    outputWidth(0),
+    outputHeight(0)
+{
+  // Nothing to do here.
+}
+
+template<typename MatType>
+void DepthwiseConvolutionType<MatType>::ComputeOutputDimensions()
+{
+  GroupedConvolutionLayerType::ComputeOutputDimensions();
+
+  inputWidth = this->inputDimensions[0];
+  inputHeight = this->inputDimensions[1];
+  inMaps = 1;
+  for (size_t i = 2; i < this->inputDimensions.size(); ++i)
+    inMaps *= this->inputDimensions[i];
+
+  outputWidth = this->outputDimensions[0];
+  outputHeight = this->outputDimensions[1];
+  multiplier = this->Maps() / inMaps;
+  stride = this->StrideWidth();
+
+  depthwise = (this->Groups() == inMaps && this->KernelWidth() == 3 &&
+      this->KernelHeight() == 3 && this->StrideHeight() == stride &&
+      (stride == 1 || stride == 2));
+}
+
+template<typename MatType>
+void DepthwiseConvolutionType<MatType>::SetWeights(
+    typename MatType::elem_type* weightsPtr)
+{
+  GroupedConvolutionLayerType::SetWeights(weightsPtr);
+  MakeAlias(weights, weightsPtr, this->WeightSize(), 1);
+}
+
+template<typename MatType>
+void DepthwiseConvolutionType<MatType>::Forward(const MatType& input,
+                                                MatType& output)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  if (!depthwise)
+  {
+    GroupedConvolutionLayerType::Forward(input, output);
+    return;
+  }
+
+  const size_t maps = this->Maps();
+  const size_t inputSize = inputWidth * inputHeight;
+  const size_t outputSize = outputWidth * outputHeight;
+  const size_t padLeft = this->PadWLeft();
+  const size_t padTop = this->PadHTop();
+  const bool hasBias = (this->WeightSize() == 10 * maps);
+
+  size_t columnBegin[3], columnEnd[3];
+  for (size_t k = 0; k < 3; ++k)
+  {
+    Range(k, padLeft, inputWidth, outputWidth, columnBegin[k],
+        columnEnd[k]);
+  }
+
+  // The weights of output map o are slice o, followed by the bias.
+  #pragma omp parallel for schedule(static)
+  for (omp_size_t m = 0; m < (omp_size_t) (input.n_cols * maps); ++m)
+  {
+    const size_t s = m / maps;
+    const size_t o = m % maps;
+    const ElemType* in = input.colptr(s) + (o / multiplier) * inputSize;
+    const ElemType* kernel = weights.memptr() + 9 * o;
+    ElemType* out = output.colptr(s) + o * outputSize;
+
+    const ElemType bias = hasBias ? weights[9 * maps + o] : ElemType(0);
+    for (size_t p = 0; p < outputSize; ++p)
+      out[p] = bias;
+
+    for (size_t y = 0; y < outputHeight; ++y)
+    {
+      ElemType* outRow = out + y * outputWidth;
+      for (size_t kj = 0; kj < 3; ++kj)
+      {
+        const size_t row = y * stride + kj;
+        if (row < padTop || row - padTop >= inputHeight)
+          continue;
+
+        const ElemType* inRow = in + (row - padTop) * inputWidth;
+        for (size_t ki = 0; ki < 3; ++ki)
+        {
+          const ElemType w = kernel[ki + 3 * kj];
+          const size_t begin = columnBegin[ki];
+          const size_t n = (columnEnd[ki] > begin) ? columnEnd[ki] - begin : 0;
+          const ElemType* x = inRow + (begin * stride + ki - padLeft);
+          ElemType* z = outRow + begin;
+          #pragma omp simd
+          for (size_t i = 0; i < n; ++i)
+            z[i] += w * x[i * stride];
+        }
+      }
+    }
+  }
+}
+
+template<typename MatType>
+void DepthwiseConvolutionType<MatType>::Backward(const MatType& input,
+                                                 const MatType& gy,
+                                                 MatType& g)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  if (!depthwise)
+  {
+    GroupedConvolutionLayerType::Backward(input, gy, g);
+    return;
+  }
+
+  const size_t maps = this->Maps();
+  const size_t inputSize = inputWidth * inputHeight;
+  const size_t outputSize = outputWidth * outputHeight;
+  const size_t padLeft = this->PadWLeft();
+  const size_t padTop = this->PadHTop();
+
+  size_t columnBegin[3], columnEnd[3];
+  for (size_t k = 0; k < 3; ++k)
+  {
+    Range(k, padLeft, inputWidth, outputWidth, columnBegin[k],
+        columnEnd[k]);
+  }
+
+  // Each input map receives the error of its own output maps, so the input
+  // maps are computed in parallel.
+  #pragma omp parallel for schedule(static)
+  for (omp_size_t m = 0; m < (omp_size_t) (gy.n_cols * inMaps); ++m)
+  {
+    const size_t s = m / inMaps;
+    const size_t c = m % inMaps;
+    ElemType* delta = g.colptr(s) + c * inputSize;
+    for (size_t p = 0; p < inputSize; ++p)
+      delta[p] = 0;
+
+    for (size_t o = c * multiplier; o < (c + 1) * multiplier; ++o)
+    {
+      const ElemType* error = gy.colptr(s) + o * outputSize;
+      const ElemType* kernel = weights.memptr() + 9 * o;
+      for (size_t y = 0; y < outputHeight; ++y)
+      {
+        const ElemType* errorRow = error + y * outputWidth;
+        for (size_t kj = 0; kj < 3; ++kj)
+        {
+          const size_t row = y * stride + kj;
+          if (row < padTop || row - padTop >= inputHeight)
+            continue;
+
+          ElemType* deltaRow = delta + (row - padTop) * inputWidth;
+          for (size_t ki = 0; ki < 3; ++ki)
+          {
+            const ElemType w = kernel[ki + 3 * kj];
+            const size_t begin = columnBegin[ki];
+            const size_t n = (columnEnd[ki] > begin) ?
+                columnEnd[ki] - begin : 0;
+            ElemType* x = deltaRow + (begin * stride + ki - padLeft);
+            const ElemType* z = errorRow + begin;
+            #pragma omp simd
+            for (size_t i = 0; i < n; ++i)
+              x[i * stride] += w * z[i];
+          }
+        }
+      }
+    }
+  }
+}
+
+template<typename MatType>
+void DepthwiseConvolutionType<MatType>::Gradient(const MatType& input,
+                                                 const MatType& error,
+                                                 MatType& gradient)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  if (!depthwise)
+  {
+    GroupedConvolutionLayerType::Gradient(input, error, gradient);
+    return;
+  }
+
+  const size_t maps = this->Maps();
+  const size_t inputSize = inputWidth * inputHeight;
+  const size_t outputSize = outputWidth * outputHeight;
+  const size_t padLeft = this->PadWLeft();
+  const size_t padTop = this->PadHTop();
+  const bool hasBias = (this->WeightSize() == 10 * maps);
+
+  size_t columnBegin[3], columnEnd[3];
+  for (size_t k = 0; k < 3; ++k)
+  {
+    Range(k, padLeft, inputWidth, outputWidth, columnBegin[k],
+        columnEnd[k]);
+  }
+
+  #pragma omp parallel for schedule(static)
+  for (omp_size_t o = 0; o < (omp_size_t) maps; ++o)
+  {
+    ElemType sums[9] = { 0 };
+    ElemType biasSum = 0;
+    for (size_t s = 0; s < input.n_cols; ++s)
+    {
+      const ElemType* in = input.colptr(s) + (o / multiplier) * inputSize;
+      const ElemType* err = error.colptr(s) + o * outputSize;
+      for (size_t y = 0; y < outputHeight; ++y)
+      {
+        const ElemType* errorRow = err + y * outputWidth;
+        for (size_t kj = 0; kj < 3; ++kj)
+        {
+          const size_t row = y * stride + kj;
+          if (row < padTop || row - padTop >= inputHeight)
+            continue;
+
+          const ElemType* inRow = in + (row - padTop) * inputWidth;
+          for (size_t ki = 0; ki < 3; ++ki)
+          {
+            const size_t begin = columnBegin[ki];
+            const size_t n = (columnEnd[ki] > begin) ?
+                columnEnd[ki] - begin : 0;
+            const ElemType* x = inRow + (begin * stride + ki - padLeft);
+            const ElemType* z = errorRow + begin;
+            ElemType sum = 0;
+            #pragma omp simd reduction(+:sum)
+            for (size_t i = 0; i < n; ++i)
+              sum += z[i] * x[i * stride];
+
+            sums[ki + 3 * kj] += sum;
+          }
+        }
+      }
+
+      #pragma omp simd reduction(+:biasSum)
+      for (size_t p = 0; p < outputSize; ++p)
+        biasSum += err[p];
+    }
+
+    for (size_t k = 0; k < 9; ++k)
+      gradient[9 * o + k] = sums[k];
+    if (hasBias)
+      gradient[9 * maps + o] = biasSum;
+  }
+}
+
+template<typename MatType>
+void DepthwiseConvolutionType<MatType>::Range(const size_t k,
+                                              const size_t pad,
+                                              const size_t inSize,
+                                              const size_t outSize,
+                                              size_t& begin,
+                                              size_t& end) const
+{
+  // Output i reads input i * stride + k - pad, which must be in the input.
+  begin = (pad > k) ? (pad - k + stride - 1) / stride : 0;
+  end = (inSize + pad > k) ?
+      std::min(outSize, (inSize + pad - k - 1) / stride + 1) : 0;
+}
+
+template<typename MatType>
+template<typename Archive>
+void DepthwiseConvolutionType<MatType>::serialize(
+    Archive& ar, const uint32_t /* version */)
+{
+  ar(cereal::base_class<GroupedConvolutionLayerType>(this));
+
+  ar(CEREAL_NVP(depthwise));
+  ar(CEREAL_NVP(stride));
+  ar(CEREAL_NVP(multiplier));
+  ar(CEREAL_NVP(inputWidth));
+  ar(CEREAL_NVP(inputHeight));
+  ar(CEREAL_NVP(inMaps));
+  ar(CEREAL_NVP(outputWidth));
+  ar(CEREAL_NVP(outputHeight));
+}
+
+} // namespace models
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,139 @@
+/**
+ * @file downsample_pooling.hpp
+ * @author Kartik Dutt
+ *
+ * Definition of DownsamplePooling layer, which halves the width and height of
+ * its input with max or mean pooling.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_LAYERS_DOWNSAMPLE_POOLING_HPP
+#define MODELS_LAYERS_DOWNSAMPLE_POOLING_HPP
+
+#define MLPACK_ENABLE_ANN_SERIALIZATION
+#include <mlpack.hpp>
+#include "serialization.hpp"
+
+namespace mlpack {
+namespace models {
+
+/**
+ * Pooling layer which reduces an input of width w and height h to
+ * ceil(w / 2) x ceil(h / 2), computing the same windows as the adaptive
+ * pooling layers with that output size. An even axis is pooled with windows
+ * of 2 and a stride of 2, which is computed by a specialized kernel. An odd
+ * axis is pooled with a stride of 1 and windows of ceil(n / 2) elements, as
+ * the adaptive pooling layers do.
+ *
+ * @tparam MatType Matrix representation to accept as input and use for
+ *    computation.
+ */
+template<typename MatType = arma::mat>
+class DownsamplePoolingType : public Layer<MatType>
+{
+ public:
+  /**
+   * Create the DownsamplePoolingType layer.
+   *
+   * @param maxPooling If true the maximum of each window is computed,
+   *     otherwise its mean.
+   */
+  DownsamplePoolingType(const bool maxPooling = true);
+
+  //! Clone the DownsamplePoolingType object.
+  DownsamplePoolingType* Clone() const
+  {
+    return new DownsamplePoolingType(*this);
+  }
+
+  //! Virtual destructor.
+  virtual ~DownsamplePoolingType() { /* Nothing to do here. */ }
+
+  /**
+   * Pool each map of the input.
+   *
+   * @param input Input data for the layer.
+   * @param output Resulting output activations.
+   */
+  void Forward(const MatType& input, MatType& output);
+
+  /**
+   * Backpropagate the error to the input of the last forward pass.
+   *
+   * @param input The propagated input activation.
+   * @param gy The backpropagated error.
+   * @param g The calculated gradient.
+   */
+  void Backward(const MatType& input, const MatType& gy, MatType& g);
+
+  //! Compute the output dimensions of the layer.
+  void ComputeOutputDimensions();
+
+  //! Get whether max pooling is used.
+  bool MaxPooling() const { return maxPooling; }
+
+  //! Serialize the layer.
+  template<typename Archive>
+  void serialize(Archive& ar, const uint32_t /* version */);
+
+ private:
+  /**
+   * Pool a single map with windows of 2 and a stride of 2 along both axes.
+   *
+   * @param input Map to pool.
+   * @param output Pooled map.
+   * @param indices Index of the maximum of each window, only set for max
+   *     pooling.
+   */
+  template<bool Max, typename eT>
+  void PoolEven(const eT* input, eT* output, size_t* indices) const;
+
+  /**
+   * Pool a single map with the window and stride of each axis.
+   *
+   * @param input Map to pool.
+   * @param output Pooled map.
+   * @param indices Index of the maximum of each window, only set for max
+   *     pooling.
+   */
+  template<bool Max, typename eT>
+  void PoolGeneric(const eT* input, eT* output, size_t* indices) const;
+
+  //! Locally stored pooling type.
+  bool maxPooling;
+
+  //! Locally stored width and height of the input.
+  size_t inputWidth, inputHeight;
+
+  //! Locally stored width and height of the output.
+  size_t outputWidth, outputHeight;
+
+  //! Locally stored window width and height.
+  size_t poolWidth, poolHeight;
+
+  //! Locally stored stride along the width and height.
+  size_t strideWidth, strideHeight;
+
+  //! Locally stored number of maps of each input.
+  size_t maps;
+
+  //! Locally stored index of the maximum of each window of the last forward
+  //! pass, relative to the map it belongs to.
+  std::vector<size_t> maxIndices;
+}; // class DownsamplePoolingType
+
+// Convenience typedef.
+typedef DownsamplePoolingType<arma::mat> DownsamplePooling;
+
+} // namespace models
+} // namespace mlpack
+
+CEREAL_REGISTER_TYPE(mlpack::models::DownsamplePoolingType<arma::mat>);
+CEREAL_REGISTER_TYPE(mlpack::models::DownsamplePoolingType<arma::fmat>);
+
+#include "downsample_pooling_impl.hpp"
+
+#endif
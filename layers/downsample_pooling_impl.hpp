@@ -0,0 +1,251 @@
+/**
+ * @file downsample_pooling_impl.hpp
+ * @author Kartik Dutt
+ *
+ * Implementation of DownsamplePooling layer.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_LAYERS_DOWNSAMPLE_POOLING_IMPL_HPP
+#define MODELS_LAYERS_DOWNSAMPLE_POOLING_IMPL_HPP
+
+// Incase it has not been included already.
+#include "downsample_pooling.hpp"
+
+namespace mlpack {
+namespace models {
+
+template<typename MatType>
+DownsamplePoolingType<MatType>::DownsamplePoolingType(
+    const bool maxPooling) :
+    Layer<MatType>(),
+    maxPooling(maxPooling),
+    inputWidth(0),
+    inputHeight(0),
+    outputWidth(0),
+    outputHeight(0),
+    poolWidth(0),
+    poolHeight(0),
+    strideWidth(0),
+    strideHeight(0),
+    maps(0)
+{
+  // Nothing to do here.
+}
+
+template<typename MatType>
+void DownsamplePoolingType<MatType>::ComputeOutputDimensions()
+{
+  if (this->inputDimensions.size() < 2)
+  {
+    mlpack::Log::Fatal << "DownsamplePooling requires at least two input "
+        << "dimensions." << std::endl;
+  }
+
+  inputWidth = this->inputDimensions[0];
+  inputHeight = this->inputDimensions[1];
+  outputWidth = (inputWidth + 1) / 2;
+  outputHeight = (inputHeight + 1) / 2;
+
+  // The windows of the adaptive pooling layers.
+  strideWidth = inputWidth / outputWidth;
+  strideHeight = inputHeight / outputHeight;
+  poolWidth = inputWidth - (outputWidth - 1) * strideWidth;
+  poolHeight = inputHeight - (outputHeight - 1) * strideHeight;
+
+  maps = 1;
+  for (size_t i = 2; i < this->inputDimensions.size(); ++i)
+    maps *= this->inputDimensions[i];
+
+  this->outputDimensions = this->inputDimensions;
+  this->outputDimensions[0] = outputWidth;
+  this->outputDimensions[1] = outputHeight;
+}
+
+template<typename MatType>
+void DownsamplePoolingType<MatType>::Forward(const MatType& input,
+                                             MatType& output)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  const size_t inputSize = inputWidth * inputHeight;
+  const size_t outputSize = outputWidth * outputHeight;
+  const bool even = (poolWidth == 2 && poolHeight == 2 && strideWidth == 2 &&
+      strideHeight == 2);
+  if (maxPooling)
+    maxIndices.resize(output.n_elem);
+
+  #pragma omp parallel for schedule(static)
+  for (omp_size_t s = 0; s < (omp_size_t) (input.n_cols * maps); ++s)
+  {
+    const size_t i = s / maps;
+    const size_t m = s % maps;
+    const ElemType* in = input.colptr(i) + m * inputSize;
+    ElemType* out = output.colptr(i) + m * outputSize;
+    size_t* indices = maxPooling ? maxIndices.data() + s * outputSize : NULL;
+
+    if (even && maxPooling)
+      PoolEven<true>(in, out, indices);
+    else if (even)
+      PoolEven<false>(in, out, indices);
+    else if (maxPooling)
+      PoolGeneric<true>(in, out, indices);
+    else
+      PoolGeneric<false>(in, out, indices);
+  }
+}
+
+template<typename MatType>
+template<bool Max, typename eT>
+void DownsamplePoolingType<MatType>::PoolEven(const eT* input,
+                                              eT* output,
+                                              size_t* indices) const
+{
+  for (size_t y = 0; y < outputHeight; ++y)
+  {
+    const size_t base = 2 * y * inputWidth;
+    const eT* top = input + base;
+    const eT* bottom = top + inputWidth;
+    eT* row = output + y * outputWidth;
+
+    if constexpr (Max)
+    {
+      size_t* rowIndices = indices + y * outputWidth;
+      #pragma omp simd
+      for (size_t x = 0; x < outputWidth; ++x)
+      {
+        const eT a = top[2 * x], b = top[2 * x + 1];
+        const eT c = bottom[2 * x], d = bottom[2 * x + 1];
+        const eT topMax = (b > a) ? b : a;
+        const eT bottomMax = (d > c) ? d : c;
+        const size_t topIndex = (b > a) ? 2 * x + 1 : 2 * x;
+        const size_t bottomIndex = inputWidth + ((d > c) ? 2 * x + 1 : 2 * x);
+        row[x] = (bottomMax > topMax) ? bottomMax : topMax;
+        rowIndices[x] = base + ((bottomMax > topMax) ? bottomIndex : topIndex);
+      }
+    }
+    else
+    {
+      #pragma omp simd
+      for (size_t x = 0; x < outputWidth; ++x)
+      {
+        row[x] = (top[2 * x] + top[2 * x + 1] + bottom[2 * x] +
+            bottom[2 * x + 1]) * eT(0.25);
+      }
+    }
+  }
+}
+
+template<typename MatType>
+template<bool Max, typename eT>
+void DownsamplePoolingType<MatType>::PoolGeneric(const eT* input,
+                                                 eT* output,
+                                                 size_t* indices) const
+{
+  const eT scale = eT(1) / eT(poolWidth * poolHeight);
+  for (size_t y = 0; y < outputHeight; ++y)
+  {
+    for (size_t x = 0; x < outputWidth; ++x)
+    {
+      const size_t start = y * strideHeight * inputWidth + x * strideWidth;
+      size_t best = start;
+      eT sum = 0;
+      for (size_t dy = 0; dy < poolHeight; ++dy)
+      {
+        const size_t rowStart = start + dy * inputWidth;
+        for (size_t dx = 0; dx < poolWidth; ++dx)
+        {
+          if constexpr (Max)
+          {
+            if (input[rowStart + dx] > input[best])
+              best = rowStart + dx;
+          }
+          else
+          {
+            sum += input[rowStart + dx];
+          }
+        }
+      }
+
+      if constexpr (Max)
+      {
+        output[y * outputWidth + x] = input[best];
+        indices[y * outputWidth + x] = best;
+      }
+      else
+      {
+        output[y * outputWidth + x] = sum * scale;
+      }
+    }
+  }
+}
+
+template<typename MatType>
+void DownsamplePoolingType<MatType>::Backward(const MatType& /* input */,
+                                              const MatType& gy,
+                                              MatType& g)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  const size_t inputSize = inputWidth * inputHeight;
+  const size_t outputSize = outputWidth * outputHeight;
+  const ElemType scale = ElemType(1) / ElemType(poolWidth * poolHeight);
+  g.zeros(inputSize * maps, gy.n_cols);
+
+  #pragma omp parallel for schedule(static)
+  for (omp_size_t s = 0; s < (omp_size_t) (gy.n_cols * maps); ++s)
+  {
+    const size_t i = s / maps;
+    const size_t m = s % maps;
+    const ElemType* error = gy.colptr(i) + m * outputSize;
+    ElemType* delta = g.colptr(i) + m * inputSize;
+
+    if (maxPooling)
+    {
+      const size_t* indices = maxIndices.data() + s * outputSize;
+      for (size_t o = 0; o < outputSize; ++o)
+        delta[indices[o]] += error[o];
+      continue;
+    }
+
+    // Windows overlap along odd axes, so the error is accumulated.
+    for (size_t y = 0; y < outputHeight; ++y)
+    {
+      for (size_t x = 0; x < outputWidth; ++x)
+      {
+        const ElemType value = error[y * outputWidth + x] * scale;
+        const size_t start = y * strideHeight * inputWidth + x * strideWidth;
+        for (size_t dy = 0; dy < poolHeight; ++dy)
+          for (size_t dx = 0; dx < poolWidth; ++dx)
+            delta[start + dy * inputWidth + dx] += value;
+      }
+    }
+  }
+}
+
+template<typename MatType>
+template<typename Archive>
+void DownsamplePoolingType<MatType>::serialize(
+    Archive& ar, const uint32_t /* version */)
+{
+  ar(cereal::base_class<Layer<MatType>>(this));
+
+  ar(CEREAL_NVP(maxPooling));
+  ar(CEREAL_NVP(inputWidth));
+  ar(CEREAL_NVP(inputHeight));
+  ar(CEREAL_NVP(outputWidth));
+  ar(CEREAL_NVP(outputHeight));
+  ar(CEREAL_NVP(poolWidth));
+  ar(CEREAL_NVP(poolHeight));
+  ar(CEREAL_NVP(strideWidth));
+  ar(CEREAL_NVP(strideHeight));
+  ar(CEREAL_NVP(maps));
+}
+
+} // namespace models
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,319 @@
+/**
+ * @file fast_convolution.hpp
+ * @author Kartik Dutt
+ *
+ * Definition of FastConvolution layer, a convolution that picks the
+ * computation for the shape of its kernels.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_LAYERS_FAST_CONVOLUTION_HPP
+#define MODELS_LAYERS_FAST_CONVOLUTION_HPP
+
+#define MLPACK_ENABLE_ANN_SERIALIZATION
+#include <mlpack.hpp>
+#include "serialization.hpp"
+
+namespace mlpack {
+namespace models {
+
+/**
+ * A convolution with the same parameters, weight layout and results as the
+ * Convolution layer, which computes each shape of kernels with the fastest
+ * method available for it:
+ *
+ *  - 1x1 kernels without padding are a single matrix product for each
+ *    sample. A sample holds an input map in each column of a pixels x maps
+ *    matrix and the kernels form a maps x output maps matrix, so their
+ *    product is the output of the sample, with no patches to gather. With a
+ *    stride larger than 1, the strided pixels are gathered first.
+ *  - 3x3 kernels with stride 1 and a padding of at most 2 use the Winograd
+ *    F(2x2, 3x3) algorithm. The output is split into 2x2 tiles; each 4x4
+ *    input tile and each kernel are transformed, so that a tile costs 16
+ *    multiplications instead of 36. The products of all tiles are computed
+ *    as 16 matrix products, one for each element of the transformed tiles,
+ *    over the input maps. The error of the input is the Winograd convolution
+ *    of the error with the flipped kernels.
+ *  - Other kernels are computed by the Convolution layer.
+ *
+ * Outside of training, the transformed Winograd kernels are kept between
+ * forward passes until SetWeights() or Gradient() is called, since only then
+ * can the weights change; parameters modified in place after a forward pass
+ * need a call to SetWeights() (FFN::Reset() does it). In training mode the
+ * kernels are transformed on every pass.
+ *
+ * So the layer can replace every convolution of a model, and the models of
+ * the repository use it as their convolution type. Since it is a
+ * Convolution, the InferenceOptimizer and the Quantizer handle it as one.
+ *
+ * @tparam MatType Matrix representation to accept as input and use for
+ *    computation.
+ */
+template<typename MatType = arma::mat>
+class FastConvolutionType : public ConvolutionType<
+    NaiveConvolution<ValidConvolution>,
+    NaiveConvolution<FullConvolution>,
+    NaiveConvolution<ValidConvolution>,
+    MatType
+>
+{
+ public:
+  //! The convolution the layer extends.
+  typedef ConvolutionType<
+      NaiveConvolution<ValidConvolution>,
+      NaiveConvolution<FullConvolution>,
+      NaiveConvolution<ValidConvolution>,
+      MatType
+  > ConvolutionLayerType;
+
+  //! Create an empty FastConvolutionType layer.
+  FastConvolutionType();
+
+  /**
+   * Create the FastConvolutionType layer.
+   *
+   * @param maps Number of output maps.
+   * @param kernelWidth Width of the filter/kernel.
+   * @param kernelHeight Height of the filter/kernel.
+   * @param strideWidth Stride of filter application in the x direction.
+   * @param strideHeight Stride of filter application in the y direction.
+   * @param padW Padding width of the input.
+   * @param padH Padding height of the input.
+   * @param paddingType The type of padding ("valid", "same" or "none").
+   * @param useBias Whether or not to use a bias with the convolution.
+   */
+  FastConvolutionType(const size_t maps,
+                      const size_t kernelWidth,
+                      const size_t kernelHeight,
+                      const size_t strideWidth = 1,
+                      const size_t strideHeight = 1,
+                      const size_t padW = 0,
+                      const size_t padH = 0,
+                      const std::string& paddingType = "none",
+                      const bool useBias = true);
+
+  /**
+   * Create the FastConvolutionType layer with a padding for each side of the
+   * input.
+   *
+   * @param maps Number of output maps.
+   * @param kernelWidth Width of the filter/kernel.
+   * @param kernelHeight Height of the filter/kernel.
+   * @param strideWidth Stride of filter application in the x direction.
+   * @param strideHeight Stride of filter application in the y direction.
+   * @param padW Padding of the left and the right side of the input.
+   * @param padH Padding of the top and the bottom of the input.
+   * @param paddingType The type of padding ("valid", "same" or "none").
+   * @param useBias Whether or not to use a bias with the convolution.
+   */
+  FastConvolutionType(const size_t maps,
+                      const size_t kernelWidth,
+                      const size_t kernelHeight,
+                      const size_t strideWidth,
+                      const size_t strideHeight,
+                      const std::tuple<size_t, size_t>& padW,
+                      const std::tuple<size_t, size_t>& padH,
+                      const std::string& paddingType = "none",
+                      const bool useBias = true);
+
+  //! Clone the FastConvolutionType object.
+  FastConvolutionType* Clone() const
+  {
+    return new FastConvolutionType(*this);
+  }
+
+  //! Virtual destructor.
+  virtual ~FastConvolutionType() { /* Nothing to do here. */ }
+
+  /**
+   * Compute the convolution of the input.
+   *
+   * @param input Input data for the layer.
+   * @param output Resulting output activations.
+   */
+  void Forward(const MatType& input, MatType& output);
+
+  /**
+   * Backpropagate the error through the convolution.
+   *
+   * @param input The propagated input activation.
+   * @param gy The backpropagated error.
+   * @param g The calculated gradient.
+   */
+  void Backward(const MatType& input, const MatType& gy, MatType& g);
+
+  /**
+   * Calculate the gradient of the weights and the bias.
+   *
+   * @param input The input of the layer.
+   * @param error The backpropagated error.
+   * @param gradient The calculated gradient.
+   */
+  void Gradient(const MatType& input,
+                const MatType& error,
+                MatType& gradient);
+
+  //! Set the weights of the layer to the given memory.
+  void SetWeights(typename MatType::elem_type* weightsPtr);
+
+  //! Compute the output dimensions of the layer.
+  void ComputeOutputDimensions();
+
+  //! Get whether the kernels are computed as a matrix product.
+  bool Pointwise() const
+  {
+    return this->KernelWidth() == 1 && this->KernelHeight() == 1 &&
+        this->PadWLeft() == 0 && this->PadWRight() == 0 &&
+        this->PadHTop() == 0 && this->PadHBottom() == 0;
+  }
+
+  //! Get whether the kernels are computed with the Winograd algorithm; the
+  //! padding of the backward pass is 2 minus the padding of the input.
+  bool Winograd() const
+  {
+    return this->KernelWidth() == 3 && this->KernelHeight() == 3 &&
+        this->StrideWidth() == 1 && this->StrideHeight() == 1 &&
+        this->PadWLeft() <= 2 && this->PadWRight() <= 2 &&
+        this->PadHTop() <= 2 && this->PadHBottom() <= 2;
+  }
+
+  //! Serialize the layer.
+  template<typename Archive>
+  void serialize(Archive& ar, const uint32_t /* version */);
+
+ private:
+  //! Get the width of the input.
+  size_t InputWidth() const { return this->inputDimensions[0]; }
+
+  //! Get the height of the input.
+  size_t InputHeight() const { return this->inputDimensions[1]; }
+
+  //! Get the number of input maps, the product of the higher dimensions.
+  size_t InputMaps() const
+  {
+    size_t inMaps = 1;
+    for (size_t i = 2; i < this->inputDimensions.size(); ++i)
+      inMaps *= this->inputDimensions[i];
+    return inMaps;
+  }
+
+  //! Get the width of the output.
+  size_t OutputWidth() const { return this->outputDimensions[0]; }
+
+  //! Get the height of the output.
+  size_t OutputHeight() const { return this->outputDimensions[1]; }
+
+  //! Compute the convolution of 1x1 kernels, see Forward().
+  void PointwiseForward(const MatType& input, MatType& output);
+
+  //! Backpropagate the error through 1x1 kernels, see Backward().
+  void PointwiseBackward(const MatType& gy, MatType& g);
+
+  //! Calculate the gradient of 1x1 kernels, see Gradient().
+  void PointwiseGradient(const MatType& input,
+                         const MatType& error,
+                         MatType& gradient);
+
+  //! Compute the convolution of 3x3 kernels, see Forward().
+  void WinogradForward(const MatType& input, MatType& output);
+
+  //! Backpropagate the error through 3x3 kernels, see Backward().
+  void WinogradBackward(const MatType& gy, MatType& g);
+
+  //! Calculate the gradient of 3x3 kernels, see Gradient().
+  void WinogradGradient(const MatType& input,
+                        const MatType& error,
+                        MatType& gradient);
+
+  /**
+   * Gather the pixels of a sample read by the strided 1x1 kernels, an input
+   * map in each column.
+   *
+   * @param sample The sample to gather the pixels of.
+   */
+  void Gather(const typename MatType::elem_type* sample);
+
+  /**
+   * Transform the 3x3 kernels into a matrix whose block e of columns holds
+   * element e of the transformed kernels of all pairs of maps, an output map
+   * in each row.
+   *
+   * @param flip Transform the flipped kernels from the output maps to the
+   *     input maps, used to backpropagate the error.
+   * @param kernels Matrix to store the transformed kernels in.
+   */
+  void TransformKernels(const bool flip, MatType& kernels);
+
+  /**
+   * Compute the Winograd convolution of the given maps with the transformed
+   * kernels.
+   *
+   * @param kernels The transformed kernels, see TransformKernels().
+   * @param input Input maps, a sample in each column.
+   * @param width Width of the input maps.
+   * @param height Height of the input maps.
+   * @param inputMaps Number of input maps.
+   * @param outputMaps Number of output maps.
+   * @param padLeft Padding of the left side of the input.
+   * @param padRight Padding of the right side of the input.
+   * @param padTop Padding of the top of the input.
+   * @param padBottom Padding of the bottom of the input.
+   * @param output Output maps.
+   */
+  void Convolve(const MatType& kernels,
+                const MatType& input,
+                const size_t width,
+                const size_t height,
+                const size_t inputMaps,
+                const size_t outputMaps,
+                const size_t padLeft,
+                const size_t padRight,
+                const size_t padTop,
+                const size_t padBottom,
+                MatType& output);
+
+  //! Add the bias of each output map to the output, if the layer has one.
+  void AddBias(MatType& output);
+
+  //! Add the sum of the error of each output map to the gradient, if the
+  //! layer has a bias.
+  void BiasGradient(const MatType& error, MatType& gradient);
+
+  //! Locally stored pixels of a sample read by the strided 1x1 kernels.
+  MatType strided;
+
+  //! Locally stored transformed kernels of the forward pass.
+  MatType transformedKernels;
+
+  //! Whether transformedKernels holds the transform of the current weights.
+  bool kernelsTransformed;
+
+  //! Locally stored transformed flipped kernels of the backward pass.
+  MatType flippedKernels;
+
+  //! Locally stored transformed input tiles, a tile in each column of a
+  //! block, an input map in each row.
+  MatType transformedInput;
+
+  //! Locally stored products of the transformed kernels and input tiles.
+  MatType products;
+
+  //! Locally stored input patch of each output position of a sample.
+  MatType patches;
+}; // class FastConvolutionType
+
+// Convenience typedef.
+typedef FastConvolutionType<arma::mat> FastConvolution;
+
+} // namespace models
+} // namespace mlpack
+
+CEREAL_REGISTER_TYPE(mlpack::models::FastConvolutionType<arma::mat>);
+CEREAL_REGISTER_TYPE(mlpack::models::FastConvolutionType<arma::fmat>);
+
+#include "fast_convolution_impl.hpp"
+
+#endif
@@ -0,0 +1,602 @@
+/**
+ * @file fast_convolution_impl.hpp
+ * @author Kartik Dutt
+ *
+ * Implementation of FastConvolution layer.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_LAYERS_FAST_CONVOLUTION_IMPL_HPP
+#define MODELS_LAYERS_FAST_CONVOLUTION_IMPL_HPP
+
+// Incase it has not been included already.
+#include "fast_convolution.hpp"
+
+namespace mlpack {
+namespace models {
+
+template<typename MatType>
+FastConvolutionType<MatType>::FastConvolutionType() :
+    ConvolutionLayerType(),
+    kernelsTransformed(false)
+{
+  // Nothing to do here.
+}
+
+template<typename MatType>
+FastConvolutionType<MatType>::FastConvolutionType(
+    const size_t maps,
+    const size_t kernelWidth,
+    const size_t kernelHeight,
+    const size_t strideWidth,
+    const size_t strideHeight,
+    const size_t padW,
+    const size_t padH,
+    const std::string& paddingType,
+    const bool useBias) :
+    ConvolutionLayerType(maps, kernelWidth, kernelHeight, strideWidth,
+        strideHeight, padW, padH, paddingType, useBias),
+    kernelsTransformed(false)
+{
+  // Nothing to do here.
+}
+
+template<typename MatType>
+FastConvolutionType<MatType>::FastConvolutionType(
+    const size_t maps,
+    const size_t kernelWidth,
+    const size_t kernelHeight,
+    const size_t strideWidth,
+    const size_t strideHeight,
+    const std::tuple<size_t, size_t>& padW,
+    const std::tuple<size_t, size_t>& padH,
+    const std::string& paddingType,
+    const bool useBias) :
+    ConvolutionLayerType(maps, kernelWidth, kernelHeight, strideWidth,
+        strideHeight, padW, padH, paddingType, useBias),
+    kernelsTransformed(false)
+{
+  // Nothing to do here.
+}
+
+template<typename MatType>
+void FastConvolutionType<MatType>::SetWeights(
+    typename MatType::elem_type* weightsPtr)
+{
+  ConvolutionLayerType::SetWeights(weightsPtr);
+  kernelsTransformed = false;
+}
+
+template<typename MatType>
+void FastConvolutionType<MatType>::ComputeOutputDimensions()
+{
+  ConvolutionLayerType::ComputeOutputDimensions();
+  kernelsTransformed = false;
+}
+
+template<typename MatType>
+void FastConvolutionType<MatType>::Forward(const MatType& input,
+                                           MatType& output)
+{
+  if (Pointwise())
+    PointwiseForward(input, output);
+  else if (Winograd())
+    WinogradForward(input, output);
+  else
+    ConvolutionLayerType::Forward(input, output);
+}
+
+template<typename MatType>
+void FastConvolutionType<MatType>::Backward(const MatType& input,
+                                            const MatType& gy,
+                                            MatType& g)
+{
+  if (Pointwise())
+    PointwiseBackward(gy, g);
+  else if (Winograd())
+    WinogradBackward(gy, g);
+  else
+    ConvolutionLayerType::Backward(input, gy, g);
+}
+
+template<typename MatType>
+void FastConvolutionType<MatType>::Gradient(const MatType& input,
+                                            const MatType& error,
+                                            MatType& gradient)
+{
+  // The optimizer updates the weights with the gradient.
+  kernelsTransformed = false;
+
+  if (Pointwise())
+    PointwiseGradient(input, error, gradient);
+  else if (Winograd())
+    WinogradGradient(input, error, gradient);
+  else
+    ConvolutionLayerType::Gradient(input, error, gradient);
+}
+
+template<typename MatType>
+void FastConvolutionType<MatType>::PointwiseForward(const MatType& input,
+                                                    MatType& output)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  const size_t maps = this->Maps();
+  const size_t inMaps = InputMaps();
+  const size_t inputSize = InputWidth() * InputHeight();
+  const size_t outputSize = OutputWidth() * OutputHeight();
+
+  // The kernel of output map o and input map c is weight o * inMaps + c, so
+  // the kernels are an inMaps x maps matrix.
+  MatType kernels;
+  MakeAlias(kernels, this->Parameters().memptr(), inMaps, maps);
+
+  for (size_t s = 0; s < input.n_cols; ++s)
+  {
+    MatType sampleOutput;
+    MakeAlias(sampleOutput, output.colptr(s), outputSize, maps);
+
+    // Without a stride every pixel is read, so the sample is used in place.
+    if (inputSize == outputSize)
+    {
+      MatType sample;
+      MakeAlias(sample, const_cast<ElemType*>(input.colptr(s)), inputSize,
+          inMaps);
+      sampleOutput = sample * kernels;
+    }
+    else
+    {
+      Gather(input.colptr(s));
+      sampleOutput = strided * kernels;
+    }
+  }
+
+  AddBias(output);
+}
+
+template<typename MatType>
+void FastConvolutionType<MatType>::PointwiseBackward(const MatType& gy,
+                                                     MatType& g)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  const size_t maps = this->Maps();
+  const size_t inMaps = InputMaps();
+  const size_t inputWidth = InputWidth();
+  const size_t inputSize = inputWidth * InputHeight();
+  const size_t outputWidth = OutputWidth();
+  const size_t outputHeight = OutputHeight();
+  const size_t outputSize = outputWidth * outputHeight;
+  const size_t strideWidth = this->StrideWidth();
+  const size_t strideHeight = this->StrideHeight();
+
+  MatType kernels;
+  MakeAlias(kernels, this->Parameters().memptr(), inMaps, maps);
+
+  for (size_t s = 0; s < gy.n_cols; ++s)
+  {
+    MatType sampleError;
+    MakeAlias(sampleError, const_cast<ElemType*>(gy.colptr(s)), outputSize,
+        maps);
+    if (inputSize == outputSize)
+    {
+      MatType delta;
+      MakeAlias(delta, g.colptr(s), inputSize, inMaps);
+      delta = sampleError * kernels.t();
+      continue;
+    }
+
+    // Only the strided pixels receive an error.
+    strided = sampleError * kernels.t();
+    ElemType* delta = g.colptr(s);
+    std::fill(delta, delta + inputSize * inMaps, ElemType(0));
+    #pragma omp parallel for schedule(static)
+    for (omp_size_t c = 0; c < (omp_size_t) inMaps; ++c)
+    {
+      const ElemType* pixels = strided.colptr(c);
+      ElemType* map = delta + c * inputSize;
+      for (size_t j = 0; j < outputHeight; ++j)
+      {
+        ElemType* row = map + j * strideHeight * inputWidth;
+        for (size_t i = 0; i < outputWidth; ++i)
+          row[i * strideWidth] = pixels[i + j * outputWidth];
+      }
+    }
+  }
+}
+
+template<typename MatType>
+void FastConvolutionType<MatType>::PointwiseGradient(const MatType& input,
+                                                     const MatType& error,
+                                                     MatType& gradient)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  const size_t maps = this->Maps();
+  const size_t inMaps = InputMaps();
+  const size_t inputSize = InputWidth() * InputHeight();
+  const size_t outputSize = OutputWidth() * OutputHeight();
+
+  // The gradient of the kernels is ordered like the kernels.
+  MatType weightGradient;
+  MakeAlias(weightGradient, gradient.memptr(), inMaps, maps);
+  weightGradient.zeros();
+
+  for (size_t s = 0; s < input.n_cols; ++s)
+  {
+    MatType sampleError;
+    MakeAlias(sampleError, const_cast<ElemType*>(error.colptr(s)), outputSize,
+        maps);
+    if (inputSize == outputSize)
+    {
+      MatType sample;
+      MakeAlias(sample, const_cast<ElemType*>(input.colptr(s)), inputSize,
+          inMaps);
+      weightGradient += sample.t() * sampleError;
+    }
+    else
+    {
+      Gather(input.colptr(s));
+      weightGradient += strided.t() * sampleError;
+    }
+  }
+
+  BiasGradient(error, gradient);
+}
+
+template<typename MatType>
+void FastConvolutionType<MatType>::WinogradForward(const MatType& input,
+                                                   MatType& output)
+{
+  // The weights may change after every pass in training mode.
+  if (!kernelsTransformed || this->training)
+  {
+    TransformKernels(false, transformedKernels);
+    kernelsTransformed = !this->training;
+  }
+
+  Convolve(transformedKernels, input, InputWidth(), InputHeight(),
+      InputMaps(), this->Maps(), this->PadWLeft(), this->PadWRight(),
+      this->PadHTop(), this->PadHBottom(), output);
+  AddBias(output);
+}
+
+template<typename MatType>
+void FastConvolutionType<MatType>::WinogradBackward(const MatType& gy,
+                                                    MatType& g)
+{
+  // The error of an input element is the correlation of the error around it
+  // with the flipped kernels, i.e. a 3x3 convolution of the error.
+  TransformKernels(true, flippedKernels);
+  Convolve(flippedKernels, gy, OutputWidth(), OutputHeight(), this->Maps(),
+      InputMaps(), 2 - this->PadWLeft(), 2 - this->PadWRight(),
+      2 - this->PadHTop(), 2 - this->PadHBottom(), g);
+}
+
+template<typename MatType>
+void FastConvolutionType<MatType>::WinogradGradient(const MatType& input,
+                                                    const MatType& error,
+                                                    MatType& gradient)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  const size_t maps = this->Maps();
+  const size_t inputWidth = InputWidth();
+  const size_t inputHeight = InputHeight();
+  const size_t inMaps = InputMaps();
+  const size_t outputWidth = OutputWidth();
+  const size_t inputSize = inputWidth * inputHeight;
+  const size_t outputSize = outputWidth * OutputHeight();
+  const size_t patchSize = 9 * inMaps;
+  const size_t padLeft = this->PadWLeft();
+  const size_t padTop = this->PadHTop();
+
+  // The gradient of the kernels of an output map is a column, ordered like
+  // the weights.
+  MatType weightGradient;
+  MakeAlias(weightGradient, gradient.memptr(), patchSize, maps);
+  weightGradient.zeros();
+  patches.set_size(patchSize, outputSize);
+
+  for (size_t s = 0; s < input.n_cols; ++s)
+  {
+    // Gather the input patch of each output position.
+    const ElemType* sample = input.colptr(s);
+    #pragma omp parallel for schedule(static)
+    for (omp_size_t p = 0; p < (omp_size_t) outputSize; ++p)
+    {
+      const size_t i = p % outputWidth;
+      const size_t j = p / outputWidth;
+      ElemType* patch = patches.colptr(p);
+      for (size_t c = 0; c < inMaps; ++c)
+      {
+        const ElemType* map = sample + c * inputSize;
+        for (size_t kj = 0; kj < 3; ++kj)
+        {
+          const size_t y = j + kj;
+          const bool rowInside = (y >= padTop && y - padTop < inputHeight);
+          for (size_t ki = 0; ki < 3; ++ki, ++patch)
+          {
+            const size_t x = i + ki;
+            *patch = (rowInside && x >= padLeft && x - padLeft < inputWidth) ?
+                map[(x - padLeft) + (y - padTop) * inputWidth] : 0;
+          }
+        }
+      }
+    }
+
+    // The error of the sample holds an output map in each column.
+    MatType sampleError;
+    MakeAlias(sampleError, const_cast<ElemType*>(error.colptr(s)), outputSize,
+        maps);
+    weightGradient += patches * sampleError;
+  }
+
+  BiasGradient(error, gradient);
+}
+
+template<typename MatType>
+void FastConvolutionType<MatType>::Gather(
+    const typename MatType::elem_type* sample)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  const size_t inputWidth = InputWidth();
+  const size_t inMaps = InputMaps();
+  const size_t outputWidth = OutputWidth();
+  const size_t outputHeight = OutputHeight();
+  const size_t inputSize = inputWidth * InputHeight();
+  const size_t strideWidth = this->StrideWidth();
+  const size_t strideHeight = this->StrideHeight();
+
+  strided.set_size(outputWidth * outputHeight, inMaps);
+  #pragma omp parallel for schedule(static)
+  for (omp_size_t c = 0; c < (omp_size_t) inMaps; ++c)
+  {
+    const ElemType* map = sample + c * inputSize;
+    ElemType* pixels = strided.colptr(c);
+    for (size_t j = 0; j < outputHeight; ++j)
+    {
+      const ElemType* row = map + j * strideHeight * inputWidth;
+      for (size_t i = 0; i < outputWidth; ++i)
+        pixels[i + j * outputWidth] = row[i * strideWidth];
+    }
+  }
+}
+
+template<typename MatType>
+void FastConvolutionType<MatType>::TransformKernels(const bool flip,
+                                                    MatType& kernels)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  const size_t maps = this->Maps();
+  const size_t inMaps = InputMaps();
+  const ElemType* weights = this->Parameters().memptr();
+  const size_t rows = flip ? inMaps : maps;
+  const size_t cols = flip ? maps : inMaps;
+  kernels.set_size(rows, 16 * cols);
+
+  #pragma omp parallel for schedule(static)
+  for (omp_size_t k = 0; k < (omp_size_t) (maps * inMaps); ++k)
+  {
+    // The kernel of output map o and input map c is slice o * inMaps + c.
+    const size_t o = k / inMaps;
+    const size_t c = k % inMaps;
+    const ElemType* kernel = weights + 9 * k;
+    ElemType g[9];
+    for (size_t i = 0; i < 9; ++i)
+      g[i] = flip ? kernel[8 - i] : kernel[i];
+
+    // G g G^T, with G = [1 0 0; 1/2 1/2 1/2; 1/2 -1/2 1/2; 0 0 1], first
+    // along x then along y.
+    ElemType t[12];
+    for (size_t j = 0; j < 3; ++j)
+    {
+      const ElemType* column = g + 3 * j;
+      t[4 * j] = column[0];
+      t[4 * j + 1] = (column[0] + column[1] + column[2]) / 2;
+      t[4 * j + 2] = (column[0] - column[1] + column[2]) / 2;
+      t[4 * j + 3] = column[2];
+    }
+
+    const size_t row = flip ? c : o;
+    const size_t col = flip ? o : c;
+    for (size_t i = 0; i < 4; ++i)
+    {
+      const ElemType u[4] = { t[i], (t[i] + t[4 + i] + t[8 + i]) / 2,
+          (t[i] - t[4 + i] + t[8 + i]) / 2, t[8 + i] };
+      for (size_t j = 0; j < 4; ++j)
+        kernels(row, (i + 4 * j) * cols + col) = u[j];
+    }
+  }
+}
+
+template<typename MatType>
+void FastConvolutionType<MatType>::Convolve(const MatType& kernels,
+                                            const MatType& input,
+                                            const size_t width,
+                                            const size_t height,
+                                            const size_t inputMaps,
+                                            const size_t outputMaps,
+                                            const size_t padLeft,
+                                            const size_t padRight,
+                                            const size_t padTop,
+                                            const size_t padBottom,
+                                            MatType& output)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  const size_t outWidth = width + padLeft + padRight - 2;
+  const size_t outHeight = height + padTop + padBottom - 2;
+  const size_t tilesWidth = (outWidth + 1) / 2;
+  const size_t tilesHeight = (outHeight + 1) / 2;
+  const size_t sampleTiles = tilesWidth * tilesHeight;
+  const size_t tiles = sampleTiles * input.n_cols;
+  const size_t inputSize = width * height;
+  const size_t outputSize = outWidth * outHeight;
+
+  // B^T d B of each 4x4 input tile d, with
+  // B^T = [1 0 -1 0; 0 1 1 0; 0 -1 1 0; 0 1 0 -1].
+  transformedInput.set_size(inputMaps, 16 * tiles);
+  #pragma omp parallel for schedule(static)
+  for (omp_size_t tile = 0; tile < (omp_size_t) tiles; ++tile)
+  {
+    const size_t s = tile / sampleTiles;
+    const size_t x0 = 2 * ((tile % sampleTiles) % tilesWidth);
+    const size_t y0 = 2 * ((tile % sampleTiles) / tilesWidth);
+    for (size_t c = 0; c < inputMaps; ++c)
+    {
+      const ElemType* map = input.colptr(s) + c * inputSize;
+      ElemType d[16];
+      for (size_t j = 0; j < 4; ++j)
+      {
+        const size_t y = y0 + j;
+        const bool rowInside = (y >= padTop && y - padTop < height);
+        for (size_t i = 0; i < 4; ++i)
+        {
+          const size_t x = x0 + i;
+          d[i + 4 * j] = (rowInside && x >= padLeft && x - padLeft < width) ?
+              map[(x - padLeft) + (y - padTop) * width] : 0;
+        }
+      }
+
+      ElemType t[16];
+      for (size_t j = 0; j < 4; ++j)
+      {
+        const ElemType* column = d + 4 * j;
+        t[4 * j] = column[0] - column[2];
+        t[4 * j + 1] = column[1] + column[2];
+        t[4 * j + 2] = column[2] - column[1];
+        t[4 * j + 3] = column[1] - column[3];
+      }
+
+      for (size_t i = 0; i < 4; ++i)
+      {
+        const ElemType v[4] = { t[i] - t[8 + i], t[4 + i] + t[8 + i],
+            t[8 + i] - t[4 + i], t[4 + i] - t[12 + i] };
+        for (size_t j = 0; j < 4; ++j)
+          transformedInput(c, (i + 4 * j) * tiles + tile) = v[j];
+      }
+    }
+  }
+
+  // Each element of the transformed tiles is a product over the input maps.
+  products.set_size(outputMaps, 16 * tiles);
+  for (size_t e = 0; e < 16; ++e)
+  {
+    MatType tileKernels, tileInputs, tileProducts;
+    MakeAlias(tileKernels, const_cast<ElemType*>(kernels.colptr(e *
+        inputMaps)), outputMaps, inputMaps);
+    MakeAlias(tileInputs, transformedInput.colptr(e * tiles), inputMaps,
+        tiles);
+    MakeAlias(tileProducts, products.colptr(e * tiles), outputMaps, tiles);
+    tileProducts = tileKernels * tileInputs;
+  }
+
+  // A^T m A of each tile, with A^T = [1 1 1 0; 0 1 -1 -1], cropped to the
+  // output.
+  #pragma omp parallel for schedule(static)
+  for (omp_size_t tile = 0; tile < (omp_size_t) tiles; ++tile)
+  {
+    const size_t s = tile / sampleTiles;
+    const size_t x0 = 2 * ((tile % sampleTiles) % tilesWidth);
+    const size_t y0 = 2 * ((tile % sampleTiles) / tilesWidth);
+    for (size_t o = 0; o < outputMaps; ++o)
+    {
+      ElemType a[8];
+      for (size_t j = 0; j < 4; ++j)
+      {
+        const ElemType m0 = products(o, (4 * j) * tiles + tile);
+        const ElemType m1 = products(o, (1 + 4 * j) * tiles + tile);
+        const ElemType m2 = products(o, (2 + 4 * j) * tiles + tile);
+        const ElemType m3 = products(o, (3 + 4 * j) * tiles + tile);
+        a[j] = m0 + m1 + m2;
+        a[4 + j] = m1 - m2 - m3;
+      }
+
+      ElemType* out = output.colptr(s) + o * outputSize;
+      for (size_t i = 0; i < 2 && x0 + i < outWidth; ++i)
+      {
+        const ElemType* row = a + 4 * i;
+        out[x0 + i + y0 * outWidth] = row[0] + row[1] + row[2];
+        if (y0 + 1 < outHeight)
+          out[x0 + i + (y0 + 1) * outWidth] = row[1] - row[2] - row[3];
+      }
+    }
+  }
+}
+
+template<typename MatType>
+void FastConvolutionType<MatType>::AddBias(MatType& output)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  // The bias follows the weights.
+  const size_t maps = this->Maps();
+  const size_t weightSize = this->KernelWidth() * this->KernelHeight() *
+      InputMaps() * maps;
+  if (this->WeightSize() == weightSize)
+    return;
+
+  const size_t outputSize = OutputWidth() * OutputHeight();
+  const ElemType* bias = this->Parameters().memptr() + weightSize;
+  #pragma omp parallel for schedule(static)
+  for (omp_size_t s = 0; s < (omp_size_t) output.n_cols; ++s)
+  {
+    for (size_t o = 0; o < maps; ++o)
+    {
+      ElemType* out = output.colptr(s) + o * outputSize;
+      #pragma omp simd
+      for (size_t p = 0; p < outputSize; ++p)
+        out[p] += bias[o];
+    }
+  }
+}
+
+template<typename MatType>
+void FastConvolutionType<MatType>::BiasGradient(const MatType& error,
+                                                MatType& gradient)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  const size_t maps = this->Maps();
+  const size_t weightSize = this->KernelWidth() * this->KernelHeight() *
+      InputMaps() * maps;
+  if (this->WeightSize() == weightSize)
+    return;
+
+  const size_t outputSize = OutputWidth() * OutputHeight();
+  for (size_t o = 0; o < maps; ++o)
+  {
+    ElemType sum = 0;
+    for (size_t s = 0; s < error.n_cols; ++s)
+    {
+      const ElemType* e = error.colptr(s) + o * outputSize;
+      #pragma omp simd reduction(+:sum)
+      for (size_t p = 0; p < outputSize; ++p)
+        sum += e[p];
+    }
+
+    gradient[weightSize + o] = sum;
+  }
+}
+
+template<typename MatType>
+template<typename Archive>
+void FastConvolutionType<MatType>::serialize(
+    Archive& ar, const uint32_t /* version */)
+{
+  ar(cereal::base_class<ConvolutionLayerType>(this));
+
+  if (cereal::is_loading<Archive>())
+    kernelsTransformed = false;
+}
+
+} // namespace models
+} // namespace mlpack
+
+#endif
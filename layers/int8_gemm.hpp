@@ -0,0 +1,99 @@
+/**
+ * @file int8_gemm.hpp
+ * @author Kartik Dutt
+ *
+ * Kernels for the int8 layers: symmetric quantization of values and the
+ * matrix product of int8 matrices with int32 accumulation.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_LAYERS_INT8_GEMM_HPP
+#define MODELS_LAYERS_INT8_GEMM_HPP
+
+#include <mlpack.hpp>
+
+namespace mlpack {
+namespace models {
+
+//! Largest magnitude of a quantized value, the range is symmetric.
+static const int Int8Range = 127;
+
+/**
+ * Quantize the given values with the given scale, i.e. round value / scale
+ * to the nearest integer in [-127, 127].
+ *
+ * @param values Values to quantize.
+ * @param n Number of values.
+ * @param scale Scale of the quantized values.
+ * @param quantized Quantized values.
+ */
+template<typename ElemType>
+inline void QuantizeInt8(const ElemType* values,
+                         const size_t n,
+                         const ElemType scale,
+                         int8_t* quantized)
+{
+  const ElemType inverse = (scale > 0) ? ElemType(1) / scale : ElemType(0);
+  #pragma omp simd
+  for (size_t i = 0; i < n; ++i)
+  {
+    const ElemType v = std::round(values[i] * inverse);
+    quantized[i] = (int8_t) std::min(std::max(v, ElemType(-Int8Range)),
+        ElemType(Int8Range));
+  }
+}
+
+/**
+ * Compute the product of two int8 matrices whose rows have the same length,
+ * c(m, n) = sum_k a(m, k) * b(n, k), accumulated in int32. Both matrices are
+ * stored row by row, so every product is a dot product of two contiguous
+ * rows; the result is stored row by row as well, i.e. c(m, n) is at
+ * c[m * N + n].
+ *
+ * The rows of b are processed in blocks that stay in cache while every row
+ * of a is applied to them. The blocks are distributed over the threads.
+ *
+ * @param a First matrix, M rows of K values.
+ * @param b Second matrix, N rows of K values.
+ * @param c Result, M rows of N values.
+ */
+inline void Int8Gemm(const int8_t* a,
+                     const int8_t* b,
+                     int32_t* c,
+                     const size_t M,
+                     const size_t N,
+                     const size_t K)
+{
+  const size_t blockSize = 64;
+  const size_t numBlocks = (N + blockSize - 1) / blockSize;
+
+  #pragma omp parallel for schedule(static)
+  for (omp_size_t block = 0; block < (omp_size_t) numBlocks; ++block)
+  {
+    const size_t begin = block * blockSize;
+    const size_t end = std::min(begin + blockSize, N);
+    for (size_t m = 0; m < M; ++m)
+    {
+      const int8_t* row = a + m * K;
+      int32_t* result = c + m * N;
+      for (size_t n = begin; n < end; ++n)
+      {
+        const int8_t* column = b + n * K;
+        int32_t sum = 0;
+        #pragma omp simd reduction(+:sum)
+        for (size_t k = 0; k < K; ++k)
+          sum += int32_t(row[k]) * int32_t(column[k]);
+
+        result[n] = sum;
+      }
+    }
+  }
+}
+
+} // namespace models
+} // namespace mlpack
+
+#endif
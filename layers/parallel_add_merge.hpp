@@ -0,0 +1,119 @@
+/**
+ * @file parallel_add_merge.hpp
+ * @author Kartik Dutt
+ *
+ * Definition of ParallelAddMerge layer, an AddMerge that can run its branches
+ * concurrently.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_LAYERS_PARALLEL_ADD_MERGE_HPP
+#define MODELS_LAYERS_PARALLEL_ADD_MERGE_HPP
+
+#define MLPACK_ENABLE_ANN_SERIALIZATION
+#include <mlpack.hpp>
+#include "serialization.hpp"
+
+namespace mlpack {
+namespace models {
+
+/**
+ * An AddMerge layer with the same branches, parameters and results as the
+ * AddMerge layer, which can run its branches concurrently, each branch on a
+ * thread of the OpenMP thread pool. Every branch writes its own output and
+ * error, which are then summed in the order of the branches, so the results
+ * don't depend on the order in which the branches finish and are the ones of
+ * the AddMerge layer.
+ *
+ * The branches of a residual block are often too small to use every core at
+ * batch size 1, so running them side by side lowers the latency of a request.
+ * The layers of a branch then run on a single thread, unless nested
+ * parallelism is enabled, so for large batches the branches are better run
+ * one after another, which is the default.
+ *
+ * @tparam MatType Matrix representation to accept as input and use for
+ *    computation.
+ */
+template<typename MatType = arma::mat>
+class ParallelAddMergeType : public AddMergeType<MatType>
+{
+ public:
+  /**
+   * Create the ParallelAddMergeType layer.
+   *
+   * @param concurrent Whether to run the branches concurrently.
+   */
+  ParallelAddMergeType(const bool concurrent = false);
+
+  //! Clone the ParallelAddMergeType object.
+  ParallelAddMergeType* Clone() const
+  {
+    return new ParallelAddMergeType(*this);
+  }
+
+  //! Virtual destructor.
+  virtual ~ParallelAddMergeType() { /* Nothing to do here. */ }
+
+  /**
+   * Compute the output of each branch and sum the outputs.
+   *
+   * @param input Input data for the layer.
+   * @param output Resulting output activations.
+   */
+  void Forward(const MatType& input, MatType& output);
+
+  /**
+   * Backpropagate the error through each branch and sum the errors.
+   *
+   * @param input The propagated input activation.
+   * @param gy The backpropagated error.
+   * @param g The calculated gradient.
+   */
+  void Backward(const MatType& input, const MatType& gy, MatType& g);
+
+  /**
+   * Calculate the gradient of each branch.
+   *
+   * @param input The input of the layer.
+   * @param error The backpropagated error.
+   * @param gradient The calculated gradient.
+   */
+  void Gradient(const MatType& input,
+                const MatType& error,
+                MatType& gradient);
+
+  //! Get whether the branches run concurrently.
+  bool Concurrent() const { return concurrent; }
+  //! Modify whether the branches run concurrently.
+  bool& Concurrent() { return concurrent; }
+
+  //! Serialize the layer.
+  template<typename Archive>
+  void serialize(Archive& ar, const uint32_t /* version */);
+
+ private:
+  //! Locally stored whether the branches run concurrently.
+  bool concurrent;
+
+  //! Locally stored output of each branch, kept for the backward pass.
+  std::vector<MatType> branchOutputs;
+
+  //! Locally stored error of each branch but the first.
+  std::vector<MatType> deltas;
+}; // class ParallelAddMergeType
+
+// Convenience typedef.
+typedef ParallelAddMergeType<arma::mat> ParallelAddMerge;
+
+} // namespace models
+} // namespace mlpack
+
+CEREAL_REGISTER_TYPE(mlpack::models::ParallelAddMergeType<arma::mat>);
+CEREAL_REGISTER_TYPE(mlpack::models::ParallelAddMergeType<arma::fmat>);
+
+#include "parallel_add_merge_impl.hpp"
+
+#endif
@@ -0,0 +1,125 @@
+/**
+ * @file parallel_add_merge_impl.hpp
+ * @author Kartik Dutt
+ *
+ * Implementation of ParallelAddMerge layer.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_LAYERS_PARALLEL_ADD_MERGE_IMPL_HPP
+#define MODELS_LAYERS_PARALLEL_ADD_MERGE_IMPL_HPP
+
+// Incase it has not been included already.
+#include "parallel_add_merge.hpp"
+
+namespace mlpack {
+namespace models {
+
+template<typename MatType>
+ParallelAddMergeType<MatType>::ParallelAddMergeType(const bool concurrent) :
+    AddMergeType<MatType>(),
+    concurrent(concurrent)
+{
+  // Nothing to do here.
+}
+
+template<typename MatType>
+void ParallelAddMergeType<MatType>::Forward(const MatType& input,
+                                            MatType& output)
+{
+  const size_t branches = this->network.size();
+  if (!concurrent || branches < 2)
+  {
+    AddMergeType<MatType>::Forward(input, output);
+    return;
+  }
+
+  // Every branch writes its own output, which Backward() passes back to the
+  // branch; the outputs are added in the order of the branches.
+  branchOutputs.resize(branches);
+  for (size_t i = 0; i < branches; ++i)
+    branchOutputs[i].set_size(output.n_rows, output.n_cols);
+
+  #pragma omp parallel for schedule(dynamic, 1)
+  for (omp_size_t i = 0; i < (omp_size_t) branches; ++i)
+    this->network[i]->Forward(input, branchOutputs[i]);
+
+  output = branchOutputs[0];
+  for (size_t i = 1; i < branches; ++i)
+    output += branchOutputs[i];
+}
+
+template<typename MatType>
+void ParallelAddMergeType<MatType>::Backward(const MatType& input,
+                                             const MatType& gy,
+                                             MatType& g)
+{
+  const size_t branches = this->network.size();
+  if (!concurrent || branches < 2)
+  {
+    AddMergeType<MatType>::Backward(input, gy, g);
+    return;
+  }
+
+  // The first branch writes into the error of the layer, the errors of the
+  // others are added in the order of the branches.
+  deltas.resize(branches);
+  for (size_t i = 1; i < branches; ++i)
+    deltas[i].set_size(g.n_rows, g.n_cols);
+
+  #pragma omp parallel for schedule(dynamic, 1)
+  for (omp_size_t i = 0; i < (omp_size_t) branches; ++i)
+  {
+    this->network[i]->Backward(branchOutputs[i], gy,
+        (i == 0) ? g : deltas[i]);
+  }
+
+  for (size_t i = 1; i < branches; ++i)
+    g += deltas[i];
+}
+
+template<typename MatType>
+void ParallelAddMergeType<MatType>::Gradient(const MatType& input,
+                                             const MatType& error,
+                                             MatType& gradient)
+{
+  const size_t branches = this->network.size();
+  if (!concurrent || branches < 2)
+  {
+    AddMergeType<MatType>::Gradient(input, error, gradient);
+    return;
+  }
+
+  // The gradient of each branch is a block of the gradient, so the branches
+  // write disjoint memory.
+  std::vector<size_t> offsets(branches, 0);
+  for (size_t i = 1; i < branches; ++i)
+    offsets[i] = offsets[i - 1] + this->network[i - 1]->WeightSize();
+
+  #pragma omp parallel for schedule(dynamic, 1)
+  for (omp_size_t i = 0; i < (omp_size_t) branches; ++i)
+  {
+    MatType branchGradient;
+    MakeAlias(branchGradient, gradient.memptr() + offsets[i],
+        this->network[i]->WeightSize(), 1);
+    this->network[i]->Gradient(input, error, branchGradient);
+  }
+}
+
+template<typename MatType>
+template<typename Archive>
+void ParallelAddMergeType<MatType>::serialize(
+    Archive& ar, const uint32_t /* version */)
+{
+  ar(cereal::base_class<AddMergeType<MatType>>(this));
+
+  ar(CEREAL_NVP(concurrent));
+}
+
+} // namespace models
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,187 @@
+/**
+ * @file quantized_convolution.hpp
+ * @author Kartik Dutt
+ *
+ * Definition of QuantizedConvolution layer, an inference only convolution
+ * computed with int8 weights and inputs.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_LAYERS_QUANTIZED_CONVOLUTION_HPP
+#define MODELS_LAYERS_QUANTIZED_CONVOLUTION_HPP
+
+#define MLPACK_ENABLE_ANN_SERIALIZATION
+#include <mlpack.hpp>
+#include "serialization.hpp"
+#include "int8_gemm.hpp"
+
+namespace mlpack {
+namespace models {
+
+/**
+ * Inference only convolution with int8 weights. The weights of each output
+ * map are quantized with their own scale (per channel quantization), the
+ * input is quantized with a single scale that is found by calibration. The
+ * convolution is computed as an int8 matrix product of the weights and the
+ * patches of the quantized input, accumulated in int32, and the result is
+ * scaled back and shifted by the bias.
+ *
+ * Until the input scale is set the layer quantizes each input with the scale
+ * of its largest value, and records the largest value it has seen; this is
+ * how the layer is calibrated, see Quantizer.
+ *
+ * The layer has no trainable parameters, so it can only be used for
+ * inference.
+ *
+ * @tparam MatType Matrix representation to accept as input and use for
+ *    computation.
+ */
+template<typename MatType = arma::mat>
+class QuantizedConvolutionType : public Layer<MatType>
+{
+ public:
+  //! Create an empty QuantizedConvolutionType layer.
+  QuantizedConvolutionType();
+
+  /**
+   * Create the QuantizedConvolutionType layer from the weights of a
+   * convolution.
+   *
+   * @param weights Weights of the convolution, column o holds the kernels of
+   *     output map o in the order of the weight slices of the convolution.
+   * @param bias Bias of each output map, may be empty.
+   * @param kernelWidth Width of the filter/kernel.
+   * @param kernelHeight Height of the filter/kernel.
+   * @param strideWidth Stride of filter application in the x direction.
+   * @param strideHeight Stride of filter application in the y direction.
+   * @param padWLeft Padding on the left of the input.
+   * @param padWRight Padding on the right of the input.
+   * @param padHTop Padding on the top of the input.
+   * @param padHBottom Padding on the bottom of the input.
+   * @param groups Number of groups the input and output maps are split into.
+   */
+  QuantizedConvolutionType(const MatType& weights,
+                           const MatType& bias,
+                           const size_t kernelWidth,
+                           const size_t kernelHeight,
+                           const size_t strideWidth = 1,
+                           const size_t strideHeight = 1,
+                           const size_t padWLeft = 0,
+                           const size_t padWRight = 0,
+                           const size_t padHTop = 0,
+                           const size_t padHBottom = 0,
+                           const size_t groups = 1);
+
+  //! Clone the QuantizedConvolutionType object.
+  QuantizedConvolutionType* Clone() const
+  {
+    return new QuantizedConvolutionType(*this);
+  }
+
+  //! Virtual destructor.
+  virtual ~QuantizedConvolutionType() { /* Nothing to do here. */ }
+
+  /**
+   * Compute the convolution of the quantized input.
+   *
+   * @param input Input data for the layer.
+   * @param output Resulting output activations.
+   */
+  void Forward(const MatType& input, MatType& output);
+
+  //! Compute the output dimensions of the layer.
+  void ComputeOutputDimensions();
+
+  //! Get the number of output maps.
+  size_t Maps() const { return maps; }
+
+  //! Get the number of groups.
+  size_t Groups() const { return groups; }
+
+  //! Get the quantized weights, the kernels of each output map in a row.
+  const std::vector<int8_t>& Weights() const { return weights; }
+
+  //! Get the scale of the weights of each output map.
+  const MatType& WeightScales() const { return weightScales; }
+
+  //! Get the scale of the input, zero until the layer is calibrated.
+  double InputScale() const { return inputScale; }
+  //! Modify the scale of the input.
+  double& InputScale() { return inputScale; }
+
+  //! Get the largest magnitude of the inputs seen while calibrating.
+  double InputRange() const { return inputRange; }
+  //! Modify the largest magnitude of the inputs seen while calibrating.
+  double& InputRange() { return inputRange; }
+
+  //! Serialize the layer.
+  template<typename Archive>
+  void serialize(Archive& ar, const uint32_t /* version */);
+
+ private:
+  //! Locally stored number of output maps.
+  size_t maps;
+
+  //! Locally stored filter width and height.
+  size_t kernelWidth, kernelHeight;
+
+  //! Locally stored stride along the width and height.
+  size_t strideWidth, strideHeight;
+
+  //! Locally stored padding on each side of the input.
+  size_t padWLeft, padWRight, padHTop, padHBottom;
+
+  //! Locally stored number of groups.
+  size_t groups;
+
+  //! Locally stored width and height of the input.
+  size_t inputWidth, inputHeight;
+
+  //! Locally stored number of input maps.
+  size_t inMaps;
+
+  //! Locally stored width and height of the output.
+  size_t outputWidth, outputHeight;
+
+  //! Locally stored quantized weights, the kernels of each output map in a
+  //! row.
+  std::vector<int8_t> weights;
+
+  //! Locally stored scale of the weights of each output map.
+  MatType weightScales;
+
+  //! Locally stored bias of each output map.
+  MatType bias;
+
+  //! Locally stored scale of the input, zero until calibrated.
+  double inputScale;
+
+  //! Locally stored largest magnitude of the inputs seen while calibrating.
+  double inputRange;
+
+  //! Locally stored quantized input of the sample being computed.
+  std::vector<int8_t> quantizedInput;
+
+  //! Locally stored patches of the quantized input, a row for each output
+  //! position.
+  std::vector<int8_t> patches;
+
+  //! Locally stored int32 result of the product of a group.
+  std::vector<int32_t> accumulators;
+}; // class QuantizedConvolutionType
+
+// Convenience typedef.
+typedef QuantizedConvolutionType<arma::mat> QuantizedConvolution;
+
+} // namespace models
+} // namespace mlpack
+
+CEREAL_REGISTER_TYPE(mlpack::models::QuantizedConvolutionType<arma::mat>);
+CEREAL_REGISTER_TYPE(mlpack::models::QuantizedConvolutionType<arma::fmat>);
+
+#include "quantized_convolution_impl.hpp"
+
+#endif
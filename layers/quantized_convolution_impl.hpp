@@ -0,0 +1,236 @@
+/**
+ * @file quantized_convolution_impl.hpp
+ * @author Kartik Dutt
+ *
+ * Implementation of QuantizedConvolution layer.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_LAYERS_QUANTIZED_CONVOLUTION_IMPL_HPP
+#define MODELS_LAYERS_QUANTIZED_CONVOLUTION_IMPL_HPP
+
+// Incase it has not been included already.
+#include "quantized_convolution.hpp"
+
+namespace mlpack {
+namespace models {
+
+template<typename MatType>
+QuantizedConvolutionType<MatType>::QuantizedConvolutionType() :
+    QuantizedConvolutionType(MatType(), MatType(), 0, 0)
+{
+  // Nothing to do here.
+}
+
+template<typename MatType>
+QuantizedConvolutionType<MatType>::QuantizedConvolutionType(
+    const MatType& weights,
+    const MatType& bias,
+    const size_t kernelWidth,
+    const size_t kernelHeight,
+    const size_t strideWidth,
+    const size_t strideHeight,
+    const size_t padWLeft,
+    const size_t padWRight,
+    const size_t padHTop,
+    const size_t padHBottom,
+    const size_t groups) :
+    Layer<MatType>(),
+    maps(weights.n_cols),
+    kernelWidth(kernelWidth),
+    kernelHeight(kernelHeight),
+    strideWidth(strideWidth),
+    strideHeight(strideHeight),
+    padWLeft(padWLeft),
+    padWRight(padWRight),
+    padHTop(padHTop),
+    padHBottom(padHBottom),
+    groups(groups),
+    inputWidth(0),
+    inputHeight(0),
+    inMaps(0),
+    outputWidth(0),
+    outputHeight(0),
+    inputScale(0),
+    inputRange(0)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  if (groups == 0 || maps % groups != 0)
+  {
+    mlpack::Log::Fatal << "QuantizedConvolution: the number of output maps "
+        << "must be a multiple of the number of groups." << std::endl;
+  }
+
+  if (bias.n_elem != 0 && bias.n_elem != maps)
+  {
+    mlpack::Log::Fatal << "QuantizedConvolution: " << bias.n_elem << " bias "
+        << "values were given for " << maps << " output maps." << std::endl;
+  }
+
+  // Each output map is quantized with the scale of its largest weight.
+  this->weights.resize(weights.n_elem);
+  weightScales.set_size(maps, 1);
+  for (size_t o = 0; o < maps; ++o)
+  {
+    const ElemType* column = weights.colptr(o);
+    ElemType range = 0;
+    for (size_t k = 0; k < weights.n_rows; ++k)
+      range = std::max(range, std::abs(column[k]));
+
+    weightScales[o] = range / Int8Range;
+    QuantizeInt8(column, weights.n_rows, weightScales[o],
+        this->weights.data() + o * weights.n_rows);
+  }
+
+  this->bias.zeros(maps, 1);
+  if (bias.n_elem == maps)
+    this->bias = arma::vectorise(bias);
+}
+
+template<typename MatType>
+void QuantizedConvolutionType<MatType>::ComputeOutputDimensions()
+{
+  if (this->inputDimensions.size() < 2)
+  {
+    mlpack::Log::Fatal << "QuantizedConvolution requires at least two input "
+        << "dimensions." << std::endl;
+  }
+
+  inputWidth = this->inputDimensions[0];
+  inputHeight = this->inputDimensions[1];
+  inMaps = 1;
+  for (size_t i = 2; i < this->inputDimensions.size(); ++i)
+    inMaps *= this->inputDimensions[i];
+
+  if (inMaps % groups != 0 ||
+      weights.size() != maps * kernelWidth * kernelHeight * inMaps / groups)
+  {
+    mlpack::Log::Fatal << "QuantizedConvolution: the weights don't match the "
+        << inMaps << " input maps." << std::endl;
+  }
+
+  outputWidth = (inputWidth + padWLeft + padWRight - kernelWidth) /
+      strideWidth + 1;
+  outputHeight = (inputHeight + padHTop + padHBottom - kernelHeight) /
+      strideHeight + 1;
+
+  this->outputDimensions = std::vector<size_t>({outputWidth, outputHeight,
+      maps});
+}
+
+template<typename MatType>
+void QuantizedConvolutionType<MatType>::Forward(const MatType& input,
+                                                MatType& output)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  // Until the layer is calibrated, the scale is the one of the largest
+  // input, which is recorded.
+  ElemType scale = (ElemType) inputScale;
+  if (inputScale == 0)
+  {
+    const double range = (double) arma::max(arma::abs(arma::vectorise(input)));
+    inputRange = std::max(inputRange, range);
+    scale = (ElemType) (range / Int8Range);
+  }
+
+  const size_t inputSize = inputWidth * inputHeight;
+  const size_t outputSize = outputWidth * outputHeight;
+  const size_t inGroupMaps = inMaps / groups;
+  const size_t outGroupMaps = maps / groups;
+  const size_t kernelSize = kernelWidth * kernelHeight;
+  const size_t patchSize = kernelSize * inGroupMaps;
+
+  quantizedInput.resize(input.n_rows);
+  patches.resize(outputSize * patchSize);
+  accumulators.resize(outGroupMaps * outputSize);
+
+  for (size_t s = 0; s < input.n_cols; ++s)
+  {
+    QuantizeInt8(input.colptr(s), input.n_rows, scale, quantizedInput.data());
+
+    for (size_t g = 0; g < groups; ++g)
+    {
+      // Gather the patch of each output position, zero is the quantized
+      // value of the padding.
+      const int8_t* groupInput = quantizedInput.data() +
+          g * inGroupMaps * inputSize;
+      #pragma omp parallel for schedule(static)
+      for (omp_size_t p = 0; p < (omp_size_t) outputSize; ++p)
+      {
+        const size_t i = p % outputWidth;
+        const size_t j = p / outputWidth;
+        int8_t* patch = patches.data() + p * patchSize;
+        for (size_t c = 0; c < inGroupMaps; ++c)
+        {
+          const int8_t* map = groupInput + c * inputSize;
+          for (size_t kj = 0; kj < kernelHeight; ++kj)
+          {
+            const size_t y = j * strideHeight + kj;
+            const bool rowInside = (y >= padHTop && y - padHTop < inputHeight);
+            for (size_t ki = 0; ki < kernelWidth; ++ki, ++patch)
+            {
+              const size_t x = i * strideWidth + ki;
+              *patch = (rowInside && x >= padWLeft &&
+                  x - padWLeft < inputWidth) ?
+                  map[(x - padWLeft) + (y - padHTop) * inputWidth] : 0;
+            }
+          }
+        }
+      }
+
+      Int8Gemm(weights.data() + g * outGroupMaps * patchSize, patches.data(),
+          accumulators.data(), outGroupMaps, outputSize, patchSize);
+
+      for (size_t m = 0; m < outGroupMaps; ++m)
+      {
+        const size_t o = g * outGroupMaps + m;
+        const ElemType factor = scale * weightScales[o];
+        const ElemType shift = bias[o];
+        const int32_t* result = accumulators.data() + m * outputSize;
+        ElemType* out = output.colptr(s) + o * outputSize;
+        #pragma omp simd
+        for (size_t p = 0; p < outputSize; ++p)
+          out[p] = factor * result[p] + shift;
+      }
+    }
+  }
+}
+
+template<typename MatType>
+template<typename Archive>
+void QuantizedConvolutionType<MatType>::serialize(
+    Archive& ar, const uint32_t /* version */)
+{
+  ar(cereal::base_class<Layer<MatType>>(this));
+
+  ar(CEREAL_NVP(maps));
+  ar(CEREAL_NVP(kernelWidth));
+  ar(CEREAL_NVP(kernelHeight));
+  ar(CEREAL_NVP(strideWidth));
+  ar(CEREAL_NVP(strideHeight));
+  ar(CEREAL_NVP(padWLeft));
+  ar(CEREAL_NVP(padWRight));
+  ar(CEREAL_NVP(padHTop));
+  ar(CEREAL_NVP(padHBottom));
+  ar(CEREAL_NVP(groups));
+  ar(CEREAL_NVP(inputWidth));
+  ar(CEREAL_NVP(inputHeight));
+  ar(CEREAL_NVP(inMaps));
+  ar(CEREAL_NVP(outputWidth));
+  ar(CEREAL_NVP(outputHeight));
+  ar(CEREAL_NVP(weights));
+  ar(CEREAL_NVP(weightScales));
+  ar(CEREAL_NVP(bias));
+  ar(CEREAL_NVP(inputScale));
+  ar(CEREAL_NVP(inputRange));
+}
+
+} // namespace models
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,129 @@
+/**
+ * @file quantized_linear.hpp
+ * @author Kartik Dutt
+ *
+ * Definition of QuantizedLinear layer, an inference only linear layer
+ * computed with int8 weights and inputs.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_LAYERS_QUANTIZED_LINEAR_HPP
+#define MODELS_LAYERS_QUANTIZED_LINEAR_HPP
+
+#define MLPACK_ENABLE_ANN_SERIALIZATION
+#include <mlpack.hpp>
+#include "serialization.hpp"
+#include "int8_gemm.hpp"
+
+namespace mlpack {
+namespace models {
+
+/**
+ * Inference only linear layer with int8 weights. The weights of each output
+ * are quantized with their own scale, the input is quantized with a single
+ * scale that is found by calibration, as for QuantizedConvolution. The
+ * product is computed by the int8 matrix product of the weights and the
+ * quantized inputs of the batch.
+ *
+ * @tparam MatType Matrix representation to accept as input and use for
+ *    computation.
+ */
+template<typename MatType = arma::mat>
+class QuantizedLinearType : public Layer<MatType>
+{
+ public:
+  //! Create an empty QuantizedLinearType layer.
+  QuantizedLinearType();
+
+  /**
+   * Create the QuantizedLinearType layer from the weights of a linear layer.
+   *
+   * @param weights Weights of the linear layer, one row for each output.
+   * @param bias Bias of each output, may be empty.
+   */
+  QuantizedLinearType(const MatType& weights, const MatType& bias);
+
+  //! Clone the QuantizedLinearType object.
+  QuantizedLinearType* Clone() const { return new QuantizedLinearType(*this); }
+
+  //! Virtual destructor.
+  virtual ~QuantizedLinearType() { /* Nothing to do here. */ }
+
+  /**
+   * Compute the product of the weights and the quantized input.
+   *
+   * @param input Input data for the layer.
+   * @param output Resulting output activations.
+   */
+  void Forward(const MatType& input, MatType& output);
+
+  //! Compute the output dimensions of the layer.
+  void ComputeOutputDimensions();
+
+  //! Get the number of outputs.
+  size_t OutputSize() const { return outSize; }
+
+  //! Get the quantized weights, the weights of each output in a row.
+  const std::vector<int8_t>& Weights() const { return weights; }
+
+  //! Get the scale of the weights of each output.
+  const MatType& WeightScales() const { return weightScales; }
+
+  //! Get the scale of the input, zero until the layer is calibrated.
+  double InputScale() const { return inputScale; }
+  //! Modify the scale of the input.
+  double& InputScale() { return inputScale; }
+
+  //! Get the largest magnitude of the inputs seen while calibrating.
+  double InputRange() const { return inputRange; }
+  //! Modify the largest magnitude of the inputs seen while calibrating.
+  double& InputRange() { return inputRange; }
+
+  //! Serialize the layer.
+  template<typename Archive>
+  void serialize(Archive& ar, const uint32_t /* version */);
+
+ private:
+  //! Locally stored number of inputs.
+  size_t inSize;
+
+  //! Locally stored number of outputs.
+  size_t outSize;
+
+  //! Locally stored quantized weights, the weights of each output in a row.
+  std::vector<int8_t> weights;
+
+  //! Locally stored scale of the weights of each output.
+  MatType weightScales;
+
+  //! Locally stored bias of each output.
+  MatType bias;
+
+  //! Locally stored scale of the input, zero until calibrated.
+  double inputScale;
+
+  //! Locally stored largest magnitude of the inputs seen while calibrating.
+  double inputRange;
+
+  //! Locally stored quantized input of the batch, a row for each sample.
+  std::vector<int8_t> quantizedInput;
+
+  //! Locally stored int32 result of the product.
+  std::vector<int32_t> accumulators;
+}; // class QuantizedLinearType
+
+// Convenience typedef.
+typedef QuantizedLinearType<arma::mat> QuantizedLinear;
+
+} // namespace models
+} // namespace mlpack
+
+CEREAL_REGISTER_TYPE(mlpack::models::QuantizedLinearType<arma::mat>);
+CEREAL_REGISTER_TYPE(mlpack::models::QuantizedLinearType<arma::fmat>);
+
+#include "quantized_linear_impl.hpp"
+
+#endif
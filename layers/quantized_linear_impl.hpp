@@ -0,0 +1,138 @@
+/**
+ * @file quantized_linear_impl.hpp
+ * @author Kartik Dutt
+ *
+ * Implementation of QuantizedLinear layer.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_LAYERS_QUANTIZED_LINEAR_IMPL_HPP
+#define MODELS_LAYERS_QUANTIZED_LINEAR_IMPL_HPP
+
+// Incase it has not been included already.
+#include "quantized_linear.hpp"
+
+namespace mlpack {
+namespace models {
+
+template<typename MatType>
+QuantizedLinearType<MatType>::QuantizedLinearType() :
+    QuantizedLinearType(MatType(), MatType())
+{
+  // Nothing to do here.
+}
+
+template<typename MatType>
+QuantizedLinearType<MatType>::QuantizedLinearType(const MatType& weights,
+                                                  const MatType& bias) :
+    Layer<MatType>(),
+    inSize(weights.n_cols),
+    outSize(weights.n_rows),
+    inputScale(0),
+    inputRange(0)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  if (bias.n_elem != 0 && bias.n_elem != outSize)
+  {
+    mlpack::Log::Fatal << "QuantizedLinear: " << bias.n_elem << " bias "
+        << "values were given for " << outSize << " outputs." << std::endl;
+  }
+
+  // The weights of each output are quantized with the scale of the largest
+  // one and stored in a row.
+  const MatType rows = weights.t();
+  this->weights.resize(weights.n_elem);
+  weightScales.set_size(outSize, 1);
+  for (size_t o = 0; o < outSize; ++o)
+  {
+    const ElemType* row = rows.colptr(o);
+    ElemType range = 0;
+    for (size_t k = 0; k < inSize; ++k)
+      range = std::max(range, std::abs(row[k]));
+
+    weightScales[o] = range / Int8Range;
+    QuantizeInt8(row, inSize, weightScales[o],
+        this->weights.data() + o * inSize);
+  }
+
+  this->bias.zeros(outSize, 1);
+  if (bias.n_elem == outSize)
+    this->bias = arma::vectorise(bias);
+}
+
+template<typename MatType>
+void QuantizedLinearType<MatType>::ComputeOutputDimensions()
+{
+  size_t inputSize = 1;
+  for (size_t i = 0; i < this->inputDimensions.size(); ++i)
+    inputSize *= this->inputDimensions[i];
+
+  if (inputSize != inSize)
+  {
+    mlpack::Log::Fatal << "QuantizedLinear: the weights have " << inSize
+        << " inputs, but the input has " << inputSize << " elements."
+        << std::endl;
+  }
+
+  this->outputDimensions = std::vector<size_t>({outSize});
+}
+
+template<typename MatType>
+void QuantizedLinearType<MatType>::Forward(const MatType& input,
+                                           MatType& output)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  ElemType scale = (ElemType) inputScale;
+  if (inputScale == 0)
+  {
+    const double range = (double) arma::max(arma::abs(arma::vectorise(input)));
+    inputRange = std::max(inputRange, range);
+    scale = (ElemType) (range / Int8Range);
+  }
+
+  // The columns of the input are contiguous, so each sample is a row of the
+  // quantized input.
+  quantizedInput.resize(input.n_elem);
+  accumulators.resize(outSize * input.n_cols);
+  QuantizeInt8(input.memptr(), input.n_elem, scale, quantizedInput.data());
+
+  Int8Gemm(weights.data(), quantizedInput.data(), accumulators.data(),
+      outSize, input.n_cols, inSize);
+
+  #pragma omp parallel for schedule(static)
+  for (omp_size_t s = 0; s < (omp_size_t) input.n_cols; ++s)
+  {
+    ElemType* out = output.colptr(s);
+    for (size_t o = 0; o < outSize; ++o)
+    {
+      out[o] = scale * weightScales[o] * accumulators[o * input.n_cols + s] +
+          bias[o];
+    }
+  }
+}
+
+template<typename MatType>
+template<typename Archive>
+void QuantizedLinearType<MatType>::serialize(
+    Archive& ar, const uint32_t /* version */)
+{
+  ar(cereal::base_class<Layer<MatType>>(this));
+
+  ar(CEREAL_NVP(inSize));
+  ar(CEREAL_NVP(outSize));
+  ar(CEREAL_NVP(weights));
+  ar(CEREAL_NVP(weightScales));
+  ar(CEREAL_NVP(bias));
+  ar(CEREAL_NVP(inputScale));
+  ar(CEREAL_NVP(inputRange));
+}
+
+} // namespace models
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,23 @@
+/**
+ * @file serialization.hpp
+ * @author Kartik Dutt
+ *
+ * Registration of the mlpack layers for single precision models.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_LAYERS_SERIALIZATION_HPP
+#define MODELS_LAYERS_SERIALIZATION_HPP
+
+#define MLPACK_ENABLE_ANN_SERIALIZATION
+#include <mlpack.hpp>
+
+// mlpack only registers its layers for arma::mat. Models that hold arma::fmat
+// layers are saved and loaded through pointers to Layer<arma::fmat>, so every
+// layer type they use has to be registered for arma::fmat as well.
+CEREAL_REGISTER_MLPACK_LAYERS(arma::fmat);
+
+#endif
@@ -0,0 +1,164 @@
+/**
+ * @file view_concat.hpp
+ * @author Kartik Dutt
+ *
+ * Definition of ViewConcat layer, a Concat whose branches write the output of
+ * a single sample into the output of the layer.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_LAYERS_VIEW_CONCAT_HPP
+#define MODELS_LAYERS_VIEW_CONCAT_HPP
+
+#define MLPACK_ENABLE_ANN_SERIALIZATION
+#include <mlpack.hpp>
+#include "serialization.hpp"
+
+namespace mlpack {
+namespace models {
+
+/**
+ * A Concat layer for the concatenation along the last axis, e.g. the maps,
+ * with the same branches, parameters and results as the Concat layer. The
+ * output of a sample holds the output of each branch in a contiguous block,
+ * so for a single sample each branch is given a view of its block of the
+ * output and writes its output in place, and the error of each branch is a
+ * view of the error of the layer. Only a batch size of 1 is computed in
+ * place: in a batch, the blocks of a branch are interleaved with the others,
+ * so each branch writes its own output, which is copied block by block, and
+ * its error is copied as well. The first branch still writes its error
+ * directly into the error of the layer.
+ *
+ * Like the ParallelAddMerge layer, the branches can run concurrently on the
+ * OpenMP thread pool; the errors of the branches are then summed in the order
+ * of the branches.
+ *
+ * Concatenations along other axes are computed by the Concat layer. Since the
+ * layer is a Concat, the InferenceOptimizer and the ActivationPlanner handle
+ * it as one.
+ *
+ * @tparam MatType Matrix representation to accept as input and use for
+ *    computation.
+ */
+template<typename MatType = arma::mat>
+class ViewConcatType : public ConcatType<MatType>
+{
+ public:
+  //! Create an empty ViewConcatType layer, concatenating along the last
+  //! axis.
+  ViewConcatType();
+
+  /**
+   * Create the ViewConcatType layer.
+   *
+   * @param axis Concatenation axis.
+   * @param concurrent Whether to run the branches concurrently.
+   */
+  ViewConcatType(const size_t axis, const bool concurrent = false);
+
+  //! Clone the ViewConcatType object.
+  ViewConcatType* Clone() const { return new ViewConcatType(*this); }
+
+  //! Virtual destructor.
+  virtual ~ViewConcatType() { /* Nothing to do here. */ }
+
+  /**
+   * Compute the output of each branch into its block of the output.
+   *
+   * @param input Input data for the layer.
+   * @param output Resulting output activations.
+   */
+  void Forward(const MatType& input, MatType& output);
+
+  /**
+   * Backpropagate the error of each branch and sum the errors.
+   *
+   * @param input The propagated input activation.
+   * @param gy The backpropagated error.
+   * @param g The calculated gradient.
+   */
+  void Backward(const MatType& input, const MatType& gy, MatType& g);
+
+  /**
+   * Calculate the gradient of each branch.
+   *
+   * @param input The input of the layer.
+   * @param error The backpropagated error.
+   * @param gradient The calculated gradient.
+   */
+  void Gradient(const MatType& input,
+                const MatType& error,
+                MatType& gradient);
+
+  //! Compute the output dimensions of the layer.
+  void ComputeOutputDimensions();
+
+  //! Get whether the outputs of a sample are contiguous blocks, so that a
+  //! single sample is computed in place; batches are always copied.
+  bool Contiguous() const { return contiguous; }
+
+  //! Get whether the branches run concurrently.
+  bool Concurrent() const { return concurrent; }
+  //! Modify whether the branches run concurrently.
+  bool& Concurrent() { return concurrent; }
+
+  //! Serialize the layer.
+  template<typename Archive>
+  void serialize(Archive& ar, const uint32_t /* version */);
+
+ private:
+  /**
+   * Get the error of a branch, a view of the error of the layer for a single
+   * sample, otherwise a copy of its blocks.
+   *
+   * @param error The error of the layer.
+   * @param branch The branch.
+   * @param branchError The error of the branch.
+   */
+  void BranchError(const MatType& error,
+                   const size_t branch,
+                   MatType& branchError);
+
+  //! Locally stored concatenation axis.
+  size_t axis;
+
+  //! Locally stored whether the axis was given, otherwise the last axis.
+  bool useAxis;
+
+  //! Locally stored whether the outputs of a sample are contiguous blocks.
+  bool contiguous;
+
+  //! Locally stored whether the branches run concurrently.
+  bool concurrent;
+
+  //! Locally stored offset of the block of each branch in a sample.
+  std::vector<size_t> offsets;
+
+  //! Locally stored size of the block of each branch in a sample.
+  std::vector<size_t> sizes;
+
+  //! Locally stored view of the output of each branch for a single sample.
+  std::vector<MatType> branchViews;
+
+  //! Locally stored output of each branch for a batch.
+  std::vector<MatType> branchOutputs;
+
+  //! Locally stored error of the input of each branch but the first.
+  std::vector<MatType> deltas;
+}; // class ViewConcatType
+
+// Convenience typedef.
+typedef ViewConcatType<arma::mat> ViewConcat;
+
+} // namespace models
+} // namespace mlpack
+
+CEREAL_REGISTER_TYPE(mlpack::models::ViewConcatType<arma::mat>);
+CEREAL_REGISTER_TYPE(mlpack::models::ViewConcatType<arma::fmat>);
+
+#include "view_concat_impl.hpp"
+
+#endif
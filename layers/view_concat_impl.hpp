@@ -0,0 +1,205 @@
+/**
+ * @file view_concat_impl.hpp
+ * @author Kartik Dutt
+ *
+ * Implementation of ViewConcat layer.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_LAYERS_VIEW_CONCAT_IMPL_HPP
+#define MODELS_LAYERS_VIEW_CONCAT_IMPL_HPP
+
+// Incase it has not been included already.
+#include "view_concat.hpp"
+
+namespace mlpack {
+namespace models {
+
+template<typename MatType>
+ViewConcatType<MatType>::ViewConcatType() :
+    ConcatType<MatType>(),
+    axis(0),
+    useAxis(false),
+    contiguous(false),
+    concurrent(false)
+{
+  // Nothing to do here.
+}
+
+template<typename MatType>
+ViewConcatType<MatType>::ViewConcatType(const size_t axis,
+                                        const bool concurrent) :
+    ConcatType<MatType>(axis),
+    axis(axis),
+    useAxis(true),
+    contiguous(false),
+    concurrent(concurrent)
+{
+  // Nothing to do here.
+}
+
+template<typename MatType>
+void ViewConcatType<MatType>::ComputeOutputDimensions()
+{
+  ConcatType<MatType>::ComputeOutputDimensions();
+
+  // The blocks of a sample are contiguous if no axis follows the
+  // concatenation axis.
+  const std::vector<size_t>& outputDimensions = this->outputDimensions;
+  const size_t concatAxis = useAxis ? axis : outputDimensions.size() - 1;
+  contiguous = true;
+  for (size_t i = concatAxis + 1; i < outputDimensions.size(); ++i)
+    contiguous &= (outputDimensions[i] == 1);
+
+  offsets.resize(this->network.size());
+  sizes.resize(this->network.size());
+  size_t offset = 0;
+  for (size_t i = 0; i < this->network.size(); ++i)
+  {
+    const std::vector<size_t>& branchDimensions =
+        this->network[i]->OutputDimensions();
+    sizes[i] = 1;
+    for (size_t d = 0; d < branchDimensions.size(); ++d)
+      sizes[i] *= branchDimensions[d];
+
+    offsets[i] = offset;
+    offset += sizes[i];
+  }
+}
+
+template<typename MatType>
+void ViewConcatType<MatType>::Forward(const MatType& input, MatType& output)
+{
+  if (!contiguous)
+  {
+    ConcatType<MatType>::Forward(input, output);
+    return;
+  }
+
+  // The outputs are kept for the backward pass. The branches write disjoint
+  // blocks of the output, in place only for a single sample.
+  branchViews.resize(this->network.size());
+  branchOutputs.resize(this->network.size());
+  #pragma omp parallel for schedule(dynamic, 1) if (concurrent)
+  for (omp_size_t i = 0; i < (omp_size_t) this->network.size(); ++i)
+  {
+    if (input.n_cols == 1)
+    {
+      MakeAlias(branchViews[i], output.memptr() + offsets[i], sizes[i], 1);
+      this->network[i]->Forward(input, branchViews[i]);
+      continue;
+    }
+
+    branchOutputs[i].set_size(sizes[i], input.n_cols);
+    this->network[i]->Forward(input, branchOutputs[i]);
+    for (size_t s = 0; s < input.n_cols; ++s)
+    {
+      std::copy(branchOutputs[i].colptr(s), branchOutputs[i].colptr(s) +
+          sizes[i], output.colptr(s) + offsets[i]);
+    }
+  }
+}
+
+template<typename MatType>
+void ViewConcatType<MatType>::Backward(const MatType& input,
+                                       const MatType& gy,
+                                       MatType& g)
+{
+  if (!contiguous)
+  {
+    ConcatType<MatType>::Backward(input, gy, g);
+    return;
+  }
+
+  // The first branch writes into the error of the layer, the errors of the
+  // others are added in the order of the branches.
+  std::vector<MatType>& outputs = (gy.n_cols == 1) ? branchViews :
+      branchOutputs;
+  deltas.resize(this->network.size());
+  for (size_t i = 1; i < this->network.size(); ++i)
+    deltas[i].set_size(g.n_rows, g.n_cols);
+
+  #pragma omp parallel for schedule(dynamic, 1) if (concurrent)
+  for (omp_size_t i = 0; i < (omp_size_t) this->network.size(); ++i)
+  {
+    MatType branchError;
+    BranchError(gy, i, branchError);
+    this->network[i]->Backward(outputs[i], branchError,
+        (i == 0) ? g : deltas[i]);
+  }
+
+  for (size_t i = 1; i < this->network.size(); ++i)
+    g += deltas[i];
+}
+
+template<typename MatType>
+void ViewConcatType<MatType>::Gradient(const MatType& input,
+                                       const MatType& error,
+                                       MatType& gradient)
+{
+  if (!contiguous)
+  {
+    ConcatType<MatType>::Gradient(input, error, gradient);
+    return;
+  }
+
+  // The gradient of each branch is a block of the gradient.
+  std::vector<size_t> starts(this->network.size(), 0);
+  for (size_t i = 1; i < this->network.size(); ++i)
+    starts[i] = starts[i - 1] + this->network[i - 1]->WeightSize();
+
+  #pragma omp parallel for schedule(dynamic, 1) if (concurrent)
+  for (omp_size_t i = 0; i < (omp_size_t) this->network.size(); ++i)
+  {
+    MatType branchError, branchGradient;
+    BranchError(error, i, branchError);
+    MakeAlias(branchGradient, gradient.memptr() + starts[i],
+        this->network[i]->WeightSize(), 1);
+    this->network[i]->Gradient(input, branchError, branchGradient);
+  }
+}
+
+template<typename MatType>
+void ViewConcatType<MatType>::BranchError(const MatType& error,
+                                          const size_t branch,
+                                          MatType& branchError)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  if (error.n_cols == 1)
+  {
+    MakeAlias(branchError, const_cast<ElemType*>(error.memptr()) +
+        offsets[branch], sizes[branch], 1);
+    return;
+  }
+
+  branchError.set_size(sizes[branch], error.n_cols);
+  for (size_t s = 0; s < error.n_cols; ++s)
+  {
+    const ElemType* block = error.colptr(s) + offsets[branch];
+    std::copy(block, block + sizes[branch], branchError.colptr(s));
+  }
+}
+
+template<typename MatType>
+template<typename Archive>
+void ViewConcatType<MatType>::serialize(
+    Archive& ar, const uint32_t /* version */)
+{
+  ar(cereal::base_class<ConcatType<MatType>>(this));
+
+  ar(CEREAL_NVP(axis));
+  ar(CEREAL_NVP(useAxis));
+  ar(CEREAL_NVP(contiguous));
+  ar(CEREAL_NVP(concurrent));
+  ar(CEREAL_NVP(offsets));
+  ar(CEREAL_NVP(sizes));
+}
+
+} // namespace models
+} // namespace mlpack
+
+#endif
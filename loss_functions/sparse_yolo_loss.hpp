@@ -0,0 +1,200 @@
+/**
+ * @file sparse_yolo_loss.hpp
+ * @author Kartik Dutt
+ *
+ * Definition of the YOLO loss that reads the sparse targets of
+ * PreProcessor::YOLOSparsePreProcessor().
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_LOSS_FUNCTIONS_SPARSE_YOLO_LOSS_HPP
+#define MODELS_LOSS_FUNCTIONS_SPARSE_YOLO_LOSS_HPP
+
+#include <mlpack.hpp>
+
+namespace mlpack {
+namespace models {
+
+/**
+ * The YOLO loss computed from sparse targets. The predictions have the layout
+ * of the dense YOLOPreProcessor targets, i.e. element s of cell c is stored
+ * at row c + s * gridWidth * gridHeight. Each column of the targets lists the
+ * objects of an image as
+ *
+ *   numObjects, (cell, slot, x, y, width, height, class) * numObjects
+ *
+ * which PreProcessor::YOLOSparsePreProcessor() creates. The loss is the sum
+ * of the coordinate, objectness, no-object and class terms of the paper,
+ *
+ *   lambdaCoord * sum_obj [(x - x')^2 + (y - y')^2 +
+ *       (sqrt(w) - sqrt(w'))^2 + (sqrt(h) - sqrt(h'))^2]
+ *   + sum_obj (1 - C')^2 + lambdaNoObject * sum_noobj C'^2
+ *   + sum_obj sum_classes (p - p')^2.
+ *
+ * The no-object term is the only one that touches every cell: it is taken
+ * over all confidences and the responsible boxes are corrected while the
+ * objects are visited, so all other work grows with the number of objects.
+ * For YOLO v1 the responsible box of an object is the predicted box of its
+ * cell with the largest IoU, for YOLO v2 and v3 it is the slot of the object.
+ *
+ * @code
+ * arma::mat targets;
+ * PreProcessor<arma::mat, arma::field<arma::vec>>::YOLOSparsePreProcessor(
+ *     annotations, targets, 1, 448, 448);
+ * SparseYOLOLoss loss;
+ * const double error = loss.Forward(predictions, targets);
+ * @endcode
+ *
+ * @tparam MatType Matrix representation to accept as input and use for
+ *    computation.
+ */
+template<typename MatType = arma::mat>
+class SparseYOLOLossType
+{
+ public:
+  /**
+   * Create the loss.
+   *
+   * @param version Version of YOLO.
+   * @param gridWidth Width of output feature map of YOLO model.
+   * @param gridHeight Height of output feature map of YOLO model.
+   * @param numBoxes Number of bounding boxes per grid.
+   * @param numClasses Number of classes in training set.
+   * @param lambdaCoord Weight of the coordinate terms.
+   * @param lambdaNoObject Weight of the confidence of boxes without object.
+   * @param reduction If true the loss is summed over the batch, otherwise it
+   *     is averaged.
+   */
+  SparseYOLOLossType(const size_t version = 1,
+                     const size_t gridWidth = 7,
+                     const size_t gridHeight = 7,
+                     const size_t numBoxes = 2,
+                     const size_t numClasses = 20,
+                     const double lambdaCoord = 5.0,
+                     const double lambdaNoObject = 0.5,
+                     const bool reduction = true);
+
+  /**
+   * Computes the loss of the predictions.
+   *
+   * @param prediction Predictions of the network, one column per image.
+   * @param target Sparse targets, one column per image.
+   */
+  typename MatType::elem_type Forward(const MatType& prediction,
+                                      const MatType& target);
+
+  /**
+   * Computes the gradient of the loss with respect to the predictions.
+   *
+   * @param prediction Predictions of the network, one column per image.
+   * @param target Sparse targets, one column per image.
+   * @param loss The calculated error.
+   */
+  void Backward(const MatType& prediction,
+                const MatType& target,
+                MatType& loss);
+
+  //! Get the version of YOLO.
+  size_t Version() const { return version; }
+  //! Get the number of bounding boxes per grid.
+  size_t NumBoxes() const { return numBoxes; }
+  //! Get the number of classes.
+  size_t NumClasses() const { return numClasses; }
+
+  //! Get the weight of the coordinate terms.
+  double LambdaCoord() const { return lambdaCoord; }
+  //! Modify the weight of the coordinate terms.
+  double& LambdaCoord() { return lambdaCoord; }
+
+  //! Get the weight of the no-object term.
+  double LambdaNoObject() const { return lambdaNoObject; }
+  //! Modify the weight of the no-object term.
+  double& LambdaNoObject() { return lambdaNoObject; }
+
+  //! Get the reduction type, represented as boolean
+  //! (false 'mean' reduction, true 'sum' reduction).
+  bool Reduction() const { return reduction; }
+  //! Modify the type of reduction used.
+  bool& Reduction() { return reduction; }
+
+  //! Serialize the loss.
+  template<typename Archive>
+  void serialize(Archive& ar, const uint32_t /* version */);
+
+ private:
+  typedef typename MatType::elem_type ElemType;
+
+  //! Check that the predictions and targets match the configuration.
+  void CheckSizes(const MatType& prediction, const MatType& target) const;
+
+  //! Index of the first element of the given box of a cell.
+  size_t BoxOffset(const size_t box) const
+  {
+    return (version == 1) ? 5 * box : (5 + numClasses) * box;
+  }
+
+  //! Index of the first class probability of the given box of a cell.
+  size_t ClassOffset(const size_t box) const
+  {
+    return (version == 1) ? 5 * numBoxes : BoxOffset(box) + 5;
+  }
+
+  /**
+   * Find the box of a cell that is responsible for the given object.
+   *
+   * @param cell Predictions of the cell, element s is at cell[s * gridSize].
+   * @param object Sparse target of the object.
+   */
+  size_t ResponsibleBox(const ElemType* cell, const ElemType* object) const;
+
+  /**
+   * Compute the terms of a single object and optionally their gradient. The
+   * no-object term of the responsible box is removed again.
+   *
+   * @param cell Predictions of the cell, element s is at cell[s * gridSize].
+   * @param object Sparse target of the object.
+   * @param gradient If not NULL, the gradient of the cell is accumulated
+   *     here, with the same layout as the predictions.
+   * @return The loss of the object.
+   */
+  double ObjectLoss(const ElemType* cell,
+                    const ElemType* object,
+                    ElemType* gradient) const;
+
+  //! Locally stored version of YOLO.
+  size_t version;
+
+  //! Locally stored width of the output feature map.
+  size_t gridWidth;
+
+  //! Locally stored height of the output feature map.
+  size_t gridHeight;
+
+  //! Locally stored number of bounding boxes per grid.
+  size_t numBoxes;
+
+  //! Locally stored number of classes.
+  size_t numClasses;
+
+  //! Locally stored weight of the coordinate terms.
+  double lambdaCoord;
+
+  //! Locally stored weight of the no-object term.
+  double lambdaNoObject;
+
+  //! Locally stored reduction type.
+  bool reduction;
+}; // class SparseYOLOLossType
+
+// Default typedef for typical `arma::mat` usage.
+typedef SparseYOLOLossType<arma::mat> SparseYOLOLoss;
+
+} // namespace models
+} // namespace mlpack
+
+#include "sparse_yolo_loss_impl.hpp"
+
+#endif
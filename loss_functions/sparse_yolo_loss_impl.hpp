@@ -0,0 +1,287 @@
+/**
+ * @file sparse_yolo_loss_impl.hpp
+ * @author Kartik Dutt
+ *
+ * Implementation of the YOLO loss that reads sparse targets.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_LOSS_FUNCTIONS_SPARSE_YOLO_LOSS_IMPL_HPP
+#define MODELS_LOSS_FUNCTIONS_SPARSE_YOLO_LOSS_IMPL_HPP
+
+// In case it hasn't yet been included.
+#include "sparse_yolo_loss.hpp"
+
+namespace mlpack {
+namespace models {
+
+template<typename MatType>
+SparseYOLOLossType<MatType>::SparseYOLOLossType(
+    const size_t version,
+    const size_t gridWidth,
+    const size_t gridHeight,
+    const size_t numBoxes,
+    const size_t numClasses,
+    const double lambdaCoord,
+    const double lambdaNoObject,
+    const bool reduction) :
+    version(version),
+    gridWidth(gridWidth),
+    gridHeight(gridHeight),
+    numBoxes(numBoxes),
+    numClasses(numClasses),
+    lambdaCoord(lambdaCoord),
+    lambdaNoObject(lambdaNoObject),
+    reduction(reduction)
+{
+  mlpack::Log::Assert(version >= 1 && version <= 3, "Supported YOLO versions "
+      "are version 1 to version 3.");
+}
+
+template<typename MatType>
+typename MatType::elem_type SparseYOLOLossType<MatType>::Forward(
+    const MatType& prediction,
+    const MatType& target)
+{
+  CheckSizes(prediction, target);
+
+  const size_t gridSize = gridWidth * gridHeight;
+  double loss = 0.0;
+
+  #pragma omp parallel for schedule(static) reduction(+:loss)
+  for (omp_size_t i = 0; i < (omp_size_t) prediction.n_cols; ++i)
+  {
+    const ElemType* output = prediction.colptr(i);
+    const ElemType* objects = target.colptr(i);
+
+    // No-object term of every box, the responsible boxes are corrected with
+    // their objects.
+    double noObject = 0.0;
+    for (size_t b = 0; b < numBoxes; ++b)
+    {
+      const ElemType* confidence = output + (BoxOffset(b) + 4) * gridSize;
+      #pragma omp simd reduction(+:noObject)
+      for (size_t c = 0; c < gridSize; ++c)
+        noObject += confidence[c] * confidence[c];
+    }
+    loss += lambdaNoObject * noObject;
+
+    const size_t numObjects = (size_t) objects[0];
+    for (size_t j = 0; j < numObjects; ++j)
+    {
+      const ElemType* object = objects + 1 + 7 * j;
+      loss += ObjectLoss(output + (size_t) object[0], object, NULL);
+    }
+  }
+
+  if (!reduction)
+    loss /= prediction.n_cols;
+
+  return (ElemType) loss;
+}
+
+template<typename MatType>
+void SparseYOLOLossType<MatType>::Backward(
+    const MatType& prediction,
+    const MatType& target,
+    MatType& loss)
+{
+  CheckSizes(prediction, target);
+
+  const size_t gridSize = gridWidth * gridHeight;
+  loss.set_size(prediction.n_rows, prediction.n_cols);
+  const ElemType noObjectScale = 2 * lambdaNoObject;
+
+  #pragma omp parallel for schedule(static)
+  for (omp_size_t i = 0; i < (omp_size_t) prediction.n_cols; ++i)
+  {
+    const ElemType* output = prediction.colptr(i);
+    const ElemType* objects = target.colptr(i);
+    ElemType* gradient = loss.colptr(i);
+
+    // Only the confidences have a gradient in cells without objects.
+    std::fill(gradient, gradient + loss.n_rows, ElemType(0));
+    for (size_t b = 0; b < numBoxes; ++b)
+    {
+      const size_t offset = (BoxOffset(b) + 4) * gridSize;
+      const ElemType* confidence = output + offset;
+      ElemType* confidenceGradient = gradient + offset;
+      #pragma omp simd
+      for (size_t c = 0; c < gridSize; ++c)
+        confidenceGradient[c] = noObjectScale * confidence[c];
+    }
+
+    const size_t numObjects = (size_t) objects[0];
+    for (size_t j = 0; j < numObjects; ++j)
+    {
+      const ElemType* object = objects + 1 + 7 * j;
+      const size_t cell = (size_t) object[0];
+      ObjectLoss(output + cell, object, gradient + cell);
+    }
+  }
+
+  if (!reduction)
+    loss /= prediction.n_cols;
+}
+
+template<typename MatType>
+void SparseYOLOLossType<MatType>::CheckSizes(const MatType& prediction,
+                                             const MatType& target) const
+{
+  const size_t numPredictions = (version == 1) ?
+      5 * numBoxes + numClasses : numBoxes * (5 + numClasses);
+  if (prediction.n_rows != gridWidth * gridHeight * numPredictions)
+  {
+    mlpack::Log::Fatal << "SparseYOLOLoss: predictions have "
+        << prediction.n_rows << " rows, expected " << gridWidth << " x "
+        << gridHeight << " cells x " << numPredictions << " values."
+        << std::endl;
+  }
+
+  if (target.n_cols != prediction.n_cols || target.n_rows == 0 ||
+      (target.n_rows - 1) % 7 != 0)
+  {
+    mlpack::Log::Fatal << "SparseYOLOLoss: targets must have one column per "
+        << "prediction and 1 + 7 * numObjects rows, found " << target.n_rows
+        << " x " << target.n_cols << "." << std::endl;
+  }
+}
+
+template<typename MatType>
+size_t SparseYOLOLossType<MatType>::ResponsibleBox(
+    const ElemType* cell,
+    const ElemType* object) const
+{
+  if (version > 1)
+    return (size_t) object[1];
+
+  if (numBoxes == 1)
+    return 0;
+
+  // Both boxes are in the same cell, so the IoU can be computed from the
+  // centres relative to the cell.
+  const size_t gridSize = gridWidth * gridHeight;
+  auto corners = [&](const double x, const double y, const double w,
+      const double h, double* box)
+  {
+    box[0] = x / gridWidth - w / 2;
+    box[1] = y / gridHeight - h / 2;
+    box[2] = x / gridWidth + w / 2;
+    box[3] = y / gridHeight + h / 2;
+  };
+
+  double truth[4];
+  corners(object[2], object[3], object[4], object[5], truth);
+  const double truthArea = object[4] * object[5];
+
+  size_t responsible = 0;
+  double bestIoU = -1.0;
+  for (size_t b = 0; b < numBoxes; ++b)
+  {
+    const ElemType* box = cell + BoxOffset(b) * gridSize;
+    const double w = std::max((double) box[2 * gridSize], 0.0);
+    const double h = std::max((double) box[3 * gridSize], 0.0);
+    double predicted[4];
+    corners(box[0], box[gridSize], w, h, predicted);
+
+    const double intersection =
+        std::max(std::min(truth[2], predicted[2]) -
+        std::max(truth[0], predicted[0]), 0.0) *
+        std::max(std::min(truth[3], predicted[3]) -
+        std::max(truth[1], predicted[1]), 0.0);
+    const double unionArea = truthArea + w * h - intersection;
+    const double iou = (unionArea > 0) ? intersection / unionArea : 0.0;
+    if (iou > bestIoU)
+    {
+      bestIoU = iou;
+      responsible = b;
+    }
+  }
+
+  return responsible;
+}
+
+template<typename MatType>
+double SparseYOLOLossType<MatType>::ObjectLoss(
+    const ElemType* cell,
+    const ElemType* object,
+    ElemType* gradient) const
+{
+  // Predictions below eps are treated as eps in the square root terms.
+  const double eps = 1e-8;
+  const size_t gridSize = gridWidth * gridHeight;
+  const size_t box = ResponsibleBox(cell, object);
+  const size_t offset = BoxOffset(box);
+  double loss = 0.0;
+
+  // Centre of the box.
+  for (size_t j = 0; j < 2; ++j)
+  {
+    const size_t index = (offset + j) * gridSize;
+    const double difference = cell[index] - object[2 + j];
+    loss += lambdaCoord * difference * difference;
+    if (gradient)
+      gradient[index] += (ElemType) (2 * lambdaCoord * difference);
+  }
+
+  // Width and height of the box.
+  for (size_t j = 2; j < 4; ++j)
+  {
+    const size_t index = (offset + j) * gridSize;
+    const double root = std::sqrt(std::max((double) cell[index], eps));
+    const double difference = root - std::sqrt(std::max(
+        (double) object[2 + j], 0.0));
+    loss += lambdaCoord * difference * difference;
+    if (gradient && cell[index] > eps)
+      gradient[index] += (ElemType) (lambdaCoord * difference / root);
+  }
+
+  // Confidence of the box, without the no-object term added for every box.
+  const size_t index = (offset + 4) * gridSize;
+  const double confidence = cell[index];
+  loss += (1 - confidence) * (1 - confidence) -
+      lambdaNoObject * confidence * confidence;
+  if (gradient)
+  {
+    gradient[index] += (ElemType) (2 * (confidence - 1) -
+        2 * lambdaNoObject * confidence);
+  }
+
+  // Class probabilities.
+  const size_t classOffset = ClassOffset(box);
+  const size_t label = (size_t) object[6];
+  for (size_t k = 0; k < numClasses; ++k)
+  {
+    const size_t classIndex = (classOffset + k) * gridSize;
+    const double difference = cell[classIndex] - (k == label ? 1.0 : 0.0);
+    loss += difference * difference;
+    if (gradient)
+      gradient[classIndex] += (ElemType) (2 * difference);
+  }
+
+  return loss;
+}
+
+template<typename MatType>
+template<typename Archive>
+void SparseYOLOLossType<MatType>::serialize(
+    Archive& ar,
+    const uint32_t /* version */)
+{
+  ar(CEREAL_NVP(version));
+  ar(CEREAL_NVP(gridWidth));
+  ar(CEREAL_NVP(gridHeight));
+  ar(CEREAL_NVP(numBoxes));
+  ar(CEREAL_NVP(numClasses));
+  ar(CEREAL_NVP(lambdaCoord));
+  ar(CEREAL_NVP(lambdaNoObject));
+  ar(CEREAL_NVP(reduction));
+}
+
+} // namespace models
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,179 @@
+/**
+ * @file yolo_loss.hpp
+ * @author Kartik Dutt
+ *
+ * Definition of the YOLO v1 loss for the dense targets of
+ * PreProcessor::YOLOPreProcessor().
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_LOSS_FUNCTIONS_YOLO_LOSS_HPP
+#define MODELS_LOSS_FUNCTIONS_YOLO_LOSS_HPP
+
+#include <mlpack.hpp>
+
+namespace mlpack {
+namespace models {
+
+/**
+ * The YOLO v1 loss of the paper, computed on the dense grid targets of
+ * PreProcessor::YOLOPreProcessor(). Predictions and targets share the same
+ * layout, element s of cell c is stored at row c + s * gridWidth * gridHeight,
+ * so every value of the grid is a contiguous plane of cells.
+ *
+ * The box of a cell with the largest IoU with the target is responsible for
+ * its object. The loss is
+ *
+ *   lambdaCoord * sum_resp [(x - x')^2 + (y - y')^2 +
+ *       (sqrt(w) - sqrt(w'))^2 + (sqrt(h) - sqrt(h'))^2]
+ *   + sum_resp (1 - C')^2 + lambdaNoObject * sum_other C'^2
+ *   + sum_obj sum_classes (p - p')^2.
+ *
+ * Both passes work plane by plane: the responsible box of every cell is
+ * found with one loop over the cells per box, and each term is then
+ * evaluated with masked SIMD loops over the cells, without branches on the
+ * cells that hold an object. Images are processed in parallel.
+ *
+ * The loss can be used as the OutputLayerType of an FFN, it is the default
+ * output layer of the YOLO model.
+ *
+ * @tparam MatType Matrix representation to accept as input and use for
+ *    computation.
+ */
+template<typename MatType = arma::mat>
+class YOLOLossType
+{
+ public:
+  /**
+   * Create the loss.
+   *
+   * @param gridWidth Width of output feature map of YOLO model.
+   * @param gridHeight Height of output feature map of YOLO model.
+   * @param numBoxes Number of bounding boxes per grid.
+   * @param numClasses Number of classes in training set.
+   * @param lambdaCoord Weight of the coordinate terms.
+   * @param lambdaNoObject Weight of the confidence of boxes without object.
+   * @param reduction If true the loss is summed over the batch, otherwise it
+   *     is averaged.
+   */
+  YOLOLossType(const size_t gridWidth = 7,
+               const size_t gridHeight = 7,
+               const size_t numBoxes = 2,
+               const size_t numClasses = 20,
+               const double lambdaCoord = 5.0,
+               const double lambdaNoObject = 0.5,
+               const bool reduction = true);
+
+  /**
+   * Computes the loss of the predictions.
+   *
+   * @param prediction Predictions of the network, one column per image.
+   * @param target Dense targets, one column per image.
+   */
+  typename MatType::elem_type Forward(const MatType& prediction,
+                                      const MatType& target);
+
+  /**
+   * Computes the gradient of the loss with respect to the predictions.
+   *
+   * @param prediction Predictions of the network, one column per image.
+   * @param target Dense targets, one column per image.
+   * @param loss The calculated error.
+   */
+  void Backward(const MatType& prediction,
+                const MatType& target,
+                MatType& loss);
+
+  //! Get the width of the output feature map.
+  size_t GridWidth() const { return gridWidth; }
+  //! Get the height of the output feature map.
+  size_t GridHeight() const { return gridHeight; }
+  //! Get the number of bounding boxes per grid.
+  size_t NumBoxes() const { return numBoxes; }
+  //! Get the number of classes.
+  size_t NumClasses() const { return numClasses; }
+
+  //! Get the weight of the coordinate terms.
+  double LambdaCoord() const { return lambdaCoord; }
+  //! Modify the weight of the coordinate terms.
+  double& LambdaCoord() { return lambdaCoord; }
+
+  //! Get the weight of the no-object term.
+  double LambdaNoObject() const { return lambdaNoObject; }
+  //! Modify the weight of the no-object term.
+  double& LambdaNoObject() { return lambdaNoObject; }
+
+  //! Get the reduction type, represented as boolean
+  //! (false 'mean' reduction, true 'sum' reduction).
+  bool Reduction() const { return reduction; }
+  //! Modify the type of reduction used.
+  bool& Reduction() { return reduction; }
+
+  //! Serialize the loss.
+  template<typename Archive>
+  void serialize(Archive& ar, const uint32_t /* version */);
+
+ private:
+  typedef typename MatType::elem_type ElemType;
+
+  //! Check that the predictions and targets match the configuration.
+  void CheckSizes(const MatType& prediction, const MatType& target) const;
+
+  /**
+   * Compute the loss of a single image and optionally its gradient.
+   *
+   * @param output Predictions of the image.
+   * @param target Targets of the image.
+   * @param gradient If not NULL, set to the gradient of the image.
+   * @param responsible Buffer with one entry per cell, set to the responsible
+   *     box of the cell.
+   * @param bestIoU Buffer with one entry per cell.
+   * @return The loss of the image.
+   */
+  double Evaluate(const ElemType* output,
+                  const ElemType* target,
+                  ElemType* gradient,
+                  std::vector<size_t>& responsible,
+                  std::vector<ElemType>& bestIoU) const;
+
+  //! Locally stored width of the output feature map.
+  size_t gridWidth;
+
+  //! Locally stored height of the output feature map.
+  size_t gridHeight;
+
+  //! Locally stored number of bounding boxes per grid.
+  size_t numBoxes;
+
+  //! Locally stored number of classes.
+  size_t numClasses;
+
+  //! Locally stored weight of the coordinate terms.
+  double lambdaCoord;
+
+  //! Locally stored weight of the no-object term.
+  double lambdaNoObject;
+
+  //! Locally stored reduction type.
+  bool reduction;
+}; // class YOLOLossType
+
+// Default typedef for typical `arma::mat` usage.
+typedef YOLOLossType<arma::mat> YOLOLoss;
+
+//! Determine whether the given output layer is a YOLOLossType.
+template<typename T>
+struct IsYOLOLoss : std::false_type { };
+
+template<typename MatType>
+struct IsYOLOLoss<YOLOLossType<MatType>> : std::true_type { };
+
+} // namespace models
+} // namespace mlpack
+
+#include "yolo_loss_impl.hpp"
+
+#endif
@@ -0,0 +1,249 @@
+/**
+ * @file yolo_loss_impl.hpp
+ * @author Kartik Dutt
+ *
+ * Implementation of the YOLO v1 loss for dense targets.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_LOSS_FUNCTIONS_YOLO_LOSS_IMPL_HPP
+#define MODELS_LOSS_FUNCTIONS_YOLO_LOSS_IMPL_HPP
+
+// In case it hasn't yet been included.
+#include "yolo_loss.hpp"
+
+namespace mlpack {
+namespace models {
+
+template<typename MatType>
+YOLOLossType<MatType>::YOLOLossType(
+    const size_t gridWidth,
+    const size_t gridHeight,
+    const size_t numBoxes,
+    const size_t numClasses,
+    const double lambdaCoord,
+    const double lambdaNoObject,
+    const bool reduction) :
+    gridWidth(gridWidth),
+    gridHeight(gridHeight),
+    numBoxes(numBoxes),
+    numClasses(numClasses),
+    lambdaCoord(lambdaCoord),
+    lambdaNoObject(lambdaNoObject),
+    reduction(reduction)
+{
+  // Nothing to do here.
+}
+
+template<typename MatType>
+typename MatType::elem_type YOLOLossType<MatType>::Forward(
+    const MatType& prediction,
+    const MatType& target)
+{
+  CheckSizes(prediction, target);
+
+  double loss = 0.0;
+  #pragma omp parallel
+  {
+    std::vector<size_t> responsible(gridWidth * gridHeight);
+    std::vector<ElemType> bestIoU(gridWidth * gridHeight);
+
+    #pragma omp for schedule(static) reduction(+:loss)
+    for (omp_size_t i = 0; i < (omp_size_t) prediction.n_cols; ++i)
+    {
+      loss += Evaluate(prediction.colptr(i), target.colptr(i), NULL,
+          responsible, bestIoU);
+    }
+  }
+
+  if (!reduction)
+    loss /= prediction.n_cols;
+
+  return (ElemType) loss;
+}
+
+template<typename MatType>
+void YOLOLossType<MatType>::Backward(
+    const MatType& prediction,
+    const MatType& target,
+    MatType& loss)
+{
+  CheckSizes(prediction, target);
+  loss.set_size(prediction.n_rows, prediction.n_cols);
+
+  #pragma omp parallel
+  {
+    std::vector<size_t> responsible(gridWidth * gridHeight);
+    std::vector<ElemType> bestIoU(gridWidth * gridHeight);
+
+    #pragma omp for schedule(static)
+    for (omp_size_t i = 0; i < (omp_size_t) prediction.n_cols; ++i)
+    {
+      Evaluate(prediction.colptr(i), target.colptr(i), loss.colptr(i),
+          responsible, bestIoU);
+    }
+  }
+
+  if (!reduction)
+    loss /= prediction.n_cols;
+}
+
+template<typename MatType>
+void YOLOLossType<MatType>::CheckSizes(const MatType& prediction,
+                                       const MatType& target) const
+{
+  const size_t numPredictions = 5 * numBoxes + numClasses;
+  if (prediction.n_rows != gridWidth * gridHeight * numPredictions)
+  {
+    mlpack::Log::Fatal << "YOLOLoss: predictions have " << prediction.n_rows
+        << " rows, expected " << gridWidth << " x " << gridHeight
+        << " cells x " << numPredictions << " values." << std::endl;
+  }
+
+  if (target.n_rows != prediction.n_rows || target.n_cols != prediction.n_cols)
+  {
+    mlpack::Log::Fatal << "YOLOLoss: targets (" << target.n_rows << " x "
+        << target.n_cols << ") must have the size of the predictions ("
+        << prediction.n_rows << " x " << prediction.n_cols << ")."
+        << std::endl;
+  }
+}
+
+template<typename MatType>
+double YOLOLossType<MatType>::Evaluate(
+    const ElemType* output,
+    const ElemType* target,
+    ElemType* gradient,
+    std::vector<size_t>& responsible,
+    std::vector<ElemType>& bestIoU) const
+{
+  // Predictions below eps are treated as eps in the square root terms.
+  const ElemType eps = 1e-8;
+  const size_t gridSize = gridWidth * gridHeight;
+  const ElemType coord = lambdaCoord;
+  const ElemType noObject = lambdaNoObject;
+
+  // Every box of a cell holds the same target, the confidence of the first
+  // one marks the cells with an object.
+  const ElemType* object = target + 4 * gridSize;
+
+  // Find the responsible box of every cell. The boxes of a cell share the
+  // cell, so the IoU is computed from centres relative to the cell.
+  std::fill(responsible.begin(), responsible.end(), 0);
+  if (numBoxes > 1)
+  {
+    std::fill(bestIoU.begin(), bestIoU.end(), ElemType(-1));
+    const ElemType xScale = ElemType(1) / gridWidth;
+    const ElemType yScale = ElemType(1) / gridHeight;
+    for (size_t b = 0; b < numBoxes; ++b)
+    {
+      const ElemType* box = output + 5 * b * gridSize;
+      for (size_t c = 0; c < gridSize; ++c)
+      {
+        const ElemType tw = target[c + 2 * gridSize];
+        const ElemType th = target[c + 3 * gridSize];
+        const ElemType tx = target[c] * xScale;
+        const ElemType ty = target[c + gridSize] * yScale;
+        const ElemType pw = std::max(box[c + 2 * gridSize], ElemType(0));
+        const ElemType ph = std::max(box[c + 3 * gridSize], ElemType(0));
+        const ElemType px = box[c] * xScale;
+        const ElemType py = box[c + gridSize] * yScale;
+
+        const ElemType width = std::max(std::min(tx + tw / 2, px + pw / 2) -
+            std::max(tx - tw / 2, px - pw / 2), ElemType(0));
+        const ElemType height = std::max(std::min(ty + th / 2, py + ph / 2) -
+            std::max(ty - th / 2, py - ph / 2), ElemType(0));
+        const ElemType intersection = width * height;
+        const ElemType unionArea = tw * th + pw * ph - intersection;
+        const ElemType iou = (unionArea > 0) ? intersection / unionArea : 0;
+
+        responsible[c] = (iou > bestIoU[c]) ? b : responsible[c];
+        bestIoU[c] = std::max(iou, bestIoU[c]);
+      }
+    }
+  }
+
+  // Coordinate and confidence terms of every box, masked by responsibility.
+  double loss = 0.0;
+  for (size_t b = 0; b < numBoxes; ++b)
+  {
+    const ElemType* p = output + 5 * b * gridSize;
+    const ElemType* t = target + 5 * b * gridSize;
+    ElemType* g = gradient ? gradient + 5 * b * gridSize : NULL;
+
+    #pragma omp simd reduction(+:loss)
+    for (size_t c = 0; c < gridSize; ++c)
+    {
+      const ElemType mask = (object[c] > 0 && responsible[c] == b) ? 1 : 0;
+      const ElemType dx = p[c] - t[c];
+      const ElemType dy = p[c + gridSize] - t[c + gridSize];
+      const ElemType rootW = std::sqrt(std::max(p[c + 2 * gridSize], eps));
+      const ElemType rootH = std::sqrt(std::max(p[c + 3 * gridSize], eps));
+      const ElemType dw = rootW - std::sqrt(std::max(t[c + 2 * gridSize],
+          ElemType(0)));
+      const ElemType dh = rootH - std::sqrt(std::max(t[c + 3 * gridSize],
+          ElemType(0)));
+      const ElemType confidence = p[c + 4 * gridSize];
+
+      loss += mask * (coord * (dx * dx + dy * dy + dw * dw + dh * dh) +
+          (1 - confidence) * (1 - confidence)) +
+          (1 - mask) * noObject * confidence * confidence;
+
+      if (g)
+      {
+        g[c] = 2 * mask * coord * dx;
+        g[c + gridSize] = 2 * mask * coord * dy;
+        g[c + 2 * gridSize] = (p[c + 2 * gridSize] > eps) ?
+            mask * coord * dw / rootW : 0;
+        g[c + 3 * gridSize] = (p[c + 3 * gridSize] > eps) ?
+            mask * coord * dh / rootH : 0;
+        g[c + 4 * gridSize] = 2 * mask * (confidence - 1) +
+            2 * (1 - mask) * noObject * confidence;
+      }
+    }
+  }
+
+  // Class terms of the cells with an object.
+  for (size_t k = 0; k < numClasses; ++k)
+  {
+    const size_t offset = (5 * numBoxes + k) * gridSize;
+    const ElemType* p = output + offset;
+    const ElemType* t = target + offset;
+    ElemType* g = gradient ? gradient + offset : NULL;
+
+    #pragma omp simd reduction(+:loss)
+    for (size_t c = 0; c < gridSize; ++c)
+    {
+      const ElemType mask = (object[c] > 0) ? 1 : 0;
+      const ElemType difference = p[c] - t[c];
+      loss += mask * difference * difference;
+      if (g)
+        g[c] = 2 * mask * difference;
+    }
+  }
+
+  return loss;
+}
+
+template<typename MatType>
+template<typename Archive>
+void YOLOLossType<MatType>::serialize(
+    Archive& ar,
+    const uint32_t /* version */)
+{
+  ar(CEREAL_NVP(gridWidth));
+  ar(CEREAL_NVP(gridHeight));
+  ar(CEREAL_NVP(numBoxes));
+  ar(CEREAL_NVP(numClasses));
+  ar(CEREAL_NVP(lambdaCoord));
+  ar(CEREAL_NVP(lambdaNoObject));
+  ar(CEREAL_NVP(reduction));
+}
+
+} // namespace models
+} // namespace mlpack
+
+#endif
@@ -28,6 +28,7 @@
 
 #define MLPACK_ENABLE_ANN_SERIALIZATION
 #include <mlpack.hpp>
+#include <layers/serialization.hpp>
 
 namespace mlpack {
 namespace models {
@@ -75,7 +76,7 @@ class AlexNetType : public MultiLayer<MatType>
    * @tparam InitializationRuleType Rule used to initialize the weight matrix.
    */
   template<
-    typename OutputLayerType = CrossEntropyError,
+    typename OutputLayerType = CrossEntropyErrorType<MatType>,
     typename InitializationRuleType = RandomInitialization
   >
   FFN<OutputLayerType, InitializationRuleType, MatType>* GetModel()
@@ -91,6 +92,14 @@ class AlexNetType : public MultiLayer<MatType>
   void serialize(Archive& ar, const uint32_t /* version */);
 
  private:
+  //! The convolution type of the model.
+  typedef ConvolutionType<
+      NaiveConvolution<ValidConvolution>,
+      NaiveConvolution<FullConvolution>,
+      NaiveConvolution<ValidConvolution>,
+      MatType
+  > ConvolutionLayerType;
+
   //! Generate the layers of the AlexNet.
   void MakeModel();
 
@@ -108,6 +117,7 @@ typedef AlexNetType<arma::mat> AlexNet;
 } // namespace mlpack
 
 CEREAL_REGISTER_TYPE(mlpack::models::AlexNetType<arma::mat>);
+CEREAL_REGISTER_TYPE(mlpack::models::AlexNetType<arma::fmat>);
 
 #include "alexnet_impl.hpp"
 
@@ -86,28 +86,28 @@ void AlexNetType<MatType>::serialize(
 template<typename MatType>
 void AlexNetType<MatType>::MakeModel()
 {
-  this->template Add<Convolution>(64, 11, 11, 4, 4, 2, 2);
-  this->template Add<ReLU>();
-  this->template Add<MaxPooling>(3, 3, 2, 2);
-  this->template Add<Convolution>(192, 5, 5, 1, 1, 2, 2);
-  this->template Add<ReLU>();
-  this->template Add<MaxPooling>(3, 3, 2, 2);
-  this->template Add<Convolution>(384, 3, 3, 1, 1, 1, 1);
-  this->template Add<ReLU>();
-  this->template Add<Convolution>(256, 3, 3, 1, 1, 1, 1);
-  this->template Add<ReLU>();
-  this->template Add<Convolution>(256, 3, 3, 1, 1, 1, 1);
-  this->template Add<ReLU>();
-  this->template Add<MaxPooling>(3, 3, 2, 2);
+  this->template Add<ConvolutionLayerType>(64, 11, 11, 4, 4, 2, 2);
+  this->template Add<ReLUType<MatType>>();
+  this->template Add<MaxPoolingType<MatType>>(3, 3, 2, 2);
+  this->template Add<ConvolutionLayerType>(192, 5, 5, 1, 1, 2, 2);
+  this->template Add<ReLUType<MatType>>();
+  this->template Add<MaxPoolingType<MatType>>(3, 3, 2, 2);
+  this->template Add<ConvolutionLayerType>(384, 3, 3, 1, 1, 1, 1);
+  this->template Add<ReLUType<MatType>>();
+  this->template Add<ConvolutionLayerType>(256, 3, 3, 1, 1, 1, 1);
+  this->template Add<ReLUType<MatType>>();
+  this->template Add<ConvolutionLayerType>(256, 3, 3, 1, 1, 1, 1);
+  this->template Add<ReLUType<MatType>>();
+  this->template Add<MaxPoolingType<MatType>>(3, 3, 2, 2);
   if (includeTop)
   {
-    this->template Add<Dropout>();
-    this->template Add<Linear>(4096);
-    this->template Add<ReLU>();
-    this->template Add<Dropout>();
-    this->template Add<Linear>(4096);
-    this->template Add<ReLU>();
-    this->template Add<Linear>(numClasses);
+    this->template Add<DropoutType<MatType>>();
+    this->template Add<LinearType<MatType>>(4096);
+    this->template Add<ReLUType<MatType>>();
+    this->template Add<DropoutType<MatType>>();
+    this->template Add<LinearType<MatType>>(4096);
+    this->template Add<ReLUType<MatType>>();
+    this->template Add<LinearType<MatType>>(numClasses);
   }
 }
 
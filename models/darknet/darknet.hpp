@@ -39,6 +39,11 @@
 
 #define MLPACK_ENABLE_ANN_SERIALIZATION
 #include <mlpack.hpp>
+#include <layers/conv_bn_leaky_relu.hpp>
+#include <layers/downsample_pooling.hpp>
+#include <layers/fast_convolution.hpp>
+
+#include "./../../utils/weight_file.hpp"
 
 namespace mlpack {
 namespace models {
@@ -46,12 +51,15 @@ namespace models {
 /**
  * Definition of a DarkNet CNN.
  * 
+ * @tparam MatType Matrix representation to accept as input and use for
+ *    computation.
  * @tparam OutputLayerType The output layer type used to evaluate the network.
  * @tparam InitializationRuleType Rule used to initialize the weight matrix.
- * @tparam DaknetVer Version of DarkNet.
+ * @tparam DarkNetVersion Version of DarkNet.
  */
 template<
-  typename OutputLayerType = CrossEntropyError<>,
+  typename MatType = arma::mat,
+  typename OutputLayerType = CrossEntropyErrorType<MatType>,
   typename InitializationRuleType = RandomInitialization,
   size_t DarkNetVersion = 19
 >
@@ -69,8 +77,10 @@ class DarkNet
    * @param inputHeight Height of the input image.
    * @param numClasses Optional number of classes to classify images into,
    *     only to be specified if includeTop is  true.
-   * @param weights One of 'none', 'imagenet'(pre-training on ImageNet) or path to weights.
-   * @param includeTop Must be set to true if weights are set.
+   * @param weights One of 'none', 'imagenet'(pre-training on ImageNet) or path to weights;
+   *     a weight file saved with SaveWeights() is bound to the layers.
+   * @param includeTop Must be set to true if weights are set, unless they
+   *     are a weight file.
    */
   DarkNet(const size_t inputChannel,
           const size_t inputWidth,
@@ -87,7 +97,8 @@ class DarkNet
    *     Second value is input height. Third value is input width.
    * @param numClasses Optional number of classes to classify images into,
    *     only to be specified if includeTop is  true.
-   * @param weights One of 'none', 'imagenet'(pre-training on ImageNet) or path to weights.
+   * @param weights One of 'none', 'imagenet'(pre-training on ImageNet) or path to weights;
+   *     a weight file saved with SaveWeights() is bound to the layers.
    */
   DarkNet(const std::tuple<size_t, size_t, size_t> inputShape,
           const size_t numClasses = 1000,
@@ -95,7 +106,7 @@ class DarkNet
           const bool includeTop = true);
 
   //! Get Layers of the model.
-  FFN<OutputLayerType, InitializationRuleType>& GetModel()
+  FFN<OutputLayerType, InitializationRuleType, MatType>& GetModel()
   {
     return darkNet;
   }
@@ -106,13 +117,20 @@ class DarkNet
   //! Save weights for the model.
   void SaveModel(const std::string& filePath);
 
+  //! Map the given weight file and bind the model to it; the model may have
+  //! fewer layers than the file, e.g. if includeTop is false.
+  void LoadWeights(const std::string& filePath);
+
+  //! Save the weights of the model as a weight file.
+  void SaveWeights(const std::string& filePath);
+
  private:
+  //! The convolution type of the model, see FastConvolutionType.
+  typedef FastConvolutionType<MatType> ConvolutionLayerType;
+
   /**
    * Adds Convolution Block.
    *
-   * @tparam SequentialType Layer type in which convolution block will
-   *     be added.
-   *
    * @param inSize Number of input maps.
    * @param outSize Number of output maps.
    * @param kernelWidth Width of the filter/kernel.
@@ -122,12 +140,12 @@ class DarkNet
    * @param padW Padding width of the input.
    * @param padH Padding height of the input.
    * @param batchNorm Boolean to determine whether a batch normalization
-   *     layer is added.
+   *     layer is added. The convolution, the normalization and the
+   *     activation are then computed by a single ConvBNLeakyReLU layer.
    * @param negativeSlope Negative slope hyper-parameter for LeakyReLU.
    * @param baseLayer Layer in which Convolution block will be added, if
    *                  NULL added to darkNet FFN.
    */
-  template<typename SequentialType = Sequential<>>
   void ConvolutionBlock(const size_t inSize,
                         const size_t outSize,
                         const size_t kernelWidth,
@@ -138,12 +156,31 @@ class DarkNet
                         const size_t padH = 0,
                         const bool batchNorm = true,
                         const double negativeSlope = 1e-1,
-                        SequentialType* baseLayer = NULL)
+                        MultiLayer<MatType>* baseLayer = NULL)
   {
-    Sequential<>* bottleNeck = new Sequential<>();
-    bottleNeck->Add(new Convolution<>(inSize, outSize, kernelWidth,
-        kernelHeight, strideWidth, strideHeight, padW, padH, inputWidth,
-        inputHeight));
+    if (batchNorm)
+    {
+      // Convolution, batch normalization and activation in a single layer,
+      // which normalizes the output of the convolution in place.
+      ConvBNLeakyReLUType<MatType>* block = new ConvBNLeakyReLUType<MatType>(
+          outSize, kernelWidth, kernelHeight, strideWidth, strideHeight,
+          padW, padH, 1e-5, 0.1, negativeSlope);
+      if (baseLayer != NULL)
+        baseLayer->Add(block);
+      else
+        darkNet.Add(block);
+    }
+    else
+    {
+      MultiLayer<MatType>* bottleNeck = new MultiLayer<MatType>();
+      bottleNeck->template Add<ConvolutionLayerType>(outSize, kernelWidth,
+          kernelHeight, strideWidth, strideHeight, padW, padH);
+      bottleNeck->template Add<LeakyReLUType<MatType>>(negativeSlope);
+      if (baseLayer != NULL)
+        baseLayer->Add(bottleNeck);
+      else
+        darkNet.Add(bottleNeck);
+    }
 
     // Update inputWidth and input Height.
     mlpack::Log::Info << "Conv Layer.  ";
@@ -154,16 +191,6 @@ class DarkNet
     inputHeight = ConvOutSize(inputHeight, kernelHeight, strideHeight, padH);
     mlpack::Log::Info << "(" << inputWidth << ", " << inputHeight <<
         ", " << outSize << ")" << std::endl;
-
-    if (batchNorm)
-      bottleNeck->Add(new BatchNorm<>(outSize, 1e-5, false));
-
-    bottleNeck->Add(new LeakyReLU<>(negativeSlope));
-
-    if (baseLayer != NULL)
-      baseLayer->Add(bottleNeck);
-    else
-      darkNet.Add(bottleNeck);
   }
 
   /**
@@ -176,16 +203,23 @@ class DarkNet
   void PoolingBlock(const size_t factor = 2,
                     const std::string type = "max")
   {
-    if (type == "max")
+    if (factor == 2)
     {
-      darkNet.Add(new AdaptiveMaxPooling<>(
+      // Same windows as the adaptive pooling layers, with a specialized
+      // kernel for the 2 x 2 windows of even sizes.
+      darkNet.template Add<DownsamplePoolingType<MatType>>(type == "max");
+    }
+    else if (type == "max")
+    {
+      darkNet.template Add<AdaptiveMaxPoolingType<MatType>>(
           std::ceil(inputWidth * 1.0 / factor),
-          std::ceil(inputHeight * 1.0 / factor)));
+          std::ceil(inputHeight * 1.0 / factor));
     }
     else
     {
-      darkNet.Add(new AdaptiveMeanPooling<>(std::ceil(inputWidth * 1.0 /
-          factor), std::ceil(inputHeight * 1.0 / factor)));
+      darkNet.template Add<AdaptiveMeanPoolingType<MatType>>(
+          std::ceil(inputWidth * 1.0 / factor),
+          std::ceil(inputHeight * 1.0 / factor));
     }
 
     mlpack::Log::Info << "Pooling Layer.  ";
@@ -230,7 +264,8 @@ class DarkNet
   }
 
   /**
-   * Adds residual bottleneck block for DarkNet 53.
+   * Adds residual bottleneck block for DarkNet 53. The output of the two
+   * convolution blocks is added to the input of the block.
    *
    * @param inputChannel Input channel in the bottle-neck.
    * @param kernelWidth Width of the filter/kernel.
@@ -245,12 +280,16 @@ class DarkNet
                               const size_t padHeight = 1)
   {
     mlpack::Log::Info << "Residual Block Begin." << std::endl;
-    Residual<>* residualBlock = new Residual<>();
+    MultiLayer<MatType>* residualBlock = new MultiLayer<MatType>();
     ConvolutionBlock(inputChannel, inputChannel / 2,
         1, 1, 1, 1, 0, 0, true, 1e-2, residualBlock);
     ConvolutionBlock(inputChannel / 2, inputChannel, kernelWidth,
         kernelHeight, 1, 1, padWidth, padHeight, true, 1e-2, residualBlock);
-    darkNet.Add(residualBlock);
+
+    AddMergeType<MatType>* residual = new AddMergeType<MatType>();
+    residual->Add(residualBlock);
+    residual->template Add<IdentityType<MatType>>();
+    darkNet.Add(residual);
     mlpack::Log::Info << "Residual Block end." << std::endl;
   }
 
@@ -272,7 +311,7 @@ class DarkNet
   }
 
   //! Locally stored DarkNet Model.
-  FFN<OutputLayerType, InitializationRuleType> darkNet;
+  FFN<OutputLayerType, InitializationRuleType, MatType> darkNet;
 
   //! Locally stored width of the image.
   size_t inputWidth;
@@ -288,13 +327,16 @@ class DarkNet
 
   //! Locally stored type of pre-trained weights.
   std::string weights;
+
+  //! Locally stored weight file the model is bound to.
+  std::shared_ptr<WeightFile<MatType>> weightFile;
 }; // DarkNet class.
 
 // Convenience typedefs for different DarkNet models.
-typedef DarkNet<CrossEntropyError<>, RandomInitialization, 19>
+typedef DarkNet<arma::mat, CrossEntropyError, RandomInitialization, 19>
     DarkNet19;
 
-typedef DarkNet<CrossEntropyError<>, RandomInitialization, 53>
+typedef DarkNet<arma::mat, CrossEntropyError, RandomInitialization, 53>
     DarkNet53;
 
 } // namespace models
@@ -18,11 +18,14 @@ namespace mlpack {
 namespace models {
 
 template<
+     typename MatType,
      typename OutputLayerType,
      typename InitializationRuleType,
      size_t DarkNetVersion
 >
-DarkNet<OutputLayerType, InitializationRuleType, DarkNetVersion>::DarkNet() :
+DarkNet<
+    MatType, OutputLayerType, InitializationRuleType, DarkNetVersion
+>::DarkNet() :
     inputWidth(0),
     inputHeight(0),
     inputChannel(0),
@@ -33,18 +36,21 @@ DarkNet<OutputLayerType, InitializationRuleType, DarkNetVersion>::DarkNet() :
 }
 
 template<
+     typename MatType,
      typename OutputLayerType,
      typename InitializationRuleType,
      size_t DarkNetVersion
 >
-DarkNet<OutputLayerType, InitializationRuleType, DarkNetVersion>::DarkNet(
+DarkNet<
+    MatType, OutputLayerType, InitializationRuleType, DarkNetVersion
+>::DarkNet(
   const size_t inputChannel,
   const size_t inputWidth,
   const size_t inputHeight,
   const size_t numClasses,
   const std::string& weights,
   const bool includeTop) :
-  DarkNet<OutputLayerType, InitializationRuleType, DarkNetVersion>(
+  DarkNet<MatType, OutputLayerType, InitializationRuleType, DarkNetVersion>(
     std::tuple<size_t, size_t, size_t>(
       inputChannel,
       inputWidth,
@@ -57,11 +63,14 @@ DarkNet<OutputLayerType, InitializationRuleType, DarkNetVersion>::DarkNet(
 }
 
 template<
+     typename MatType,
      typename OutputLayerType,
      typename InitializationRuleType,
      size_t DarkNetVersion
 >
-DarkNet<OutputLayerType, InitializationRuleType, DarkNetVersion>::DarkNet(
+DarkNet<
+    MatType, OutputLayerType, InitializationRuleType, DarkNetVersion
+>::DarkNet(
     const std::tuple<size_t, size_t, size_t> inputShape,
     const size_t numClasses,
     const std::string& weights,
@@ -83,15 +92,17 @@ DarkNet<OutputLayerType, InitializationRuleType, DarkNetVersion>::DarkNet(
         "_imagenet.bin");
     return;
   }
-  else if (weights != "none")
+  else if (weights != "none" && !WeightFile<MatType>::IsWeightFile(weights))
   {
     LoadModel(weights);
     return;
   }
 
+  darkNet.InputDimensions() = std::vector<size_t>({inputWidth, inputHeight,
+      inputChannel});
   if (DarkNetVersion == 19)
   {
-    darkNet.Add(new IdentityLayer<>());
+    darkNet.template Add<IdentityType<MatType>>();
 
     // Convolution and activation function in a block.
     ConvolutionBlock(inputChannel, 32, 3, 3, 1, 1, 1, 1, true);
@@ -112,17 +123,15 @@ DarkNet<OutputLayerType, InitializationRuleType, DarkNetVersion>::DarkNet(
 
     if (includeTop)
     {
-      darkNet.Add(new Convolution<>(1024, numClasses, 1, 1,
-          1, 1, 0, 0, inputWidth, inputHeight));
-      darkNet.Add(new AdaptiveMeanPooling<>(1, 1));
-      darkNet.Add(new LogSoftMax<>());
+      darkNet.template Add<ConvolutionLayerType>(numClasses, 1, 1, 1, 1, 0,
+          0);
+      darkNet.template Add<AdaptiveMeanPoolingType<MatType>>(1, 1);
+      darkNet.template Add<LogSoftMaxType<MatType>>();
     }
-
-    darkNet.ResetParameters();
   }
   else if (DarkNetVersion == 53)
   {
-    darkNet.Add(new IdentityLayer<>());
+    darkNet.template Add<IdentityType<MatType>>();
     ConvolutionBlock(inputChannel, 32, 3, 3, 1, 1, 1, 1, true, 1e-2);
     ConvolutionBlock(32, 64, 3, 3, 2, 2, 1, 1, true, 1e-2);
 
@@ -146,21 +155,26 @@ DarkNet<OutputLayerType, InitializationRuleType, DarkNetVersion>::DarkNet(
 
     if (includeTop)
     {
-      darkNet.Add(new AdaptiveMeanPooling<>(1, 1));
-      darkNet.Add(new Linear<>(curChannels, numClasses));
+      darkNet.template Add<AdaptiveMeanPoolingType<MatType>>(1, 1);
+      darkNet.template Add<LinearType<MatType>>(numClasses);
     }
-
-    darkNet.ResetParameters();
   }
+
+  // Bind the weights of a weight file or reset parameters for a new network.
+  if (weights != "none")
+    LoadWeights(weights);
+  else
+    darkNet.Reset();
 }
 
 template<
+     typename MatType,
      typename OutputLayerType,
      typename InitializationRuleType,
      size_t DarkNetVersion
 >
 void DarkNet<
-    OutputLayerType, InitializationRuleType, DarkNetVersion
+    MatType, OutputLayerType, InitializationRuleType, DarkNetVersion
 >::LoadModel(const std::string& filePath)
 {
   data::Load(filePath, "DarkNet", darkNet);
@@ -168,12 +182,13 @@ void DarkNet<
 }
 
 template<
+     typename MatType,
      typename OutputLayerType,
      typename InitializationRuleType,
      size_t DarkNetVersion
 >
 void DarkNet<
-    OutputLayerType, InitializationRuleType, DarkNetVersion
+    MatType, OutputLayerType, InitializationRuleType, DarkNetVersion
 >::SaveModel(const std::string& filePath)
 {
   Log::Info<< "Saving model." << std::endl;
@@ -181,6 +196,36 @@ void DarkNet<
   Log::Info << "Model saved in " << filePath << "." << std::endl;
 }
 
+template<
+     typename MatType,
+     typename OutputLayerType,
+     typename InitializationRuleType,
+     size_t DarkNetVersion
+>
+void DarkNet<
+    MatType, OutputLayerType, InitializationRuleType, DarkNetVersion
+>::LoadWeights(const std::string& filePath)
+{
+  weightFile = std::make_shared<WeightFile<MatType>>(filePath);
+  const size_t layers = weightFile->Bind(darkNet);
+  Log::Info << "Bound " << layers << " layers to " << filePath << "."
+      << std::endl;
+}
+
+template<
+     typename MatType,
+     typename OutputLayerType,
+     typename InitializationRuleType,
+     size_t DarkNetVersion
+>
+void DarkNet<
+    MatType, OutputLayerType, InitializationRuleType, DarkNetVersion
+>::SaveWeights(const std::string& filePath)
+{
+  WeightFile<MatType>::Save(filePath, darkNet);
+  Log::Info << "Weights saved in " << filePath << "." << std::endl;
+}
+
 } // namespace models
 } // namespace mlpack
 
@@ -27,8 +27,12 @@
 
 #define MLPACK_ENABLE_ANN_SERIALIZATION
 #include <mlpack.hpp>
+#include <layers/serialization.hpp>
+#include <layers/depthwise_convolution.hpp>
+#include <layers/fast_convolution.hpp>
 
 #include "./../../utils/utils.hpp"
+#include "./../../utils/weight_file.hpp"
 
 namespace mlpack {
 namespace models {
@@ -36,11 +40,14 @@ namespace models {
 /**
  * Definition of a MobileNet V1 CNN.
  * 
+ * @tparam MatType Matrix representation to accept as input and use for
+ *    computation.
  * @tparam OutputLayerType The output layer type used to evaluate the network.
  * @tparam InitializationRuleType Rule used to initialize the weight matrix.
  */
 template<
-  typename OutputLayerType = CrossEntropyError<>,
+  typename MatType = arma::mat,
+  typename OutputLayerType = CrossEntropyErrorType<MatType>,
   typename InitializationRuleType = RandomInitialization
 >
 class MobileNetV1
@@ -55,7 +62,8 @@ class MobileNetV1
    * @param inputChannels Number of input channels of the input image.
    * @param inputWidth Width of the input image.
    * @param inputHeight Height of the input image.
-   * @param includeTop Must be set to true if preTrained is set to true.
+   * @param includeTop Whether to include the classifier; without it, the
+   *    pre-trained weights are bound to the layers before the classifier.
    * @param preTrained True for pre-trained weights of ImageNet,
    *    default is false.
    * @param numClasses Optional number of classes to classify images into,
@@ -76,6 +84,8 @@ class MobileNetV1
    * @param inputShape A three-valued tuple indicating input shape.
    *     First value is number of channels (channels-first).
    *     Second value is input height. Third value is input width.
+   * @param includeTop Whether to include the classifier; without it, the
+   *    pre-trained weights are bound to the layers before the classifier.
    * @param preTrained True for pre-trained weights of ImageNet,
    *    default is false.
    * @param numClasses Optional number of classes to classify images into,
@@ -89,7 +99,10 @@ class MobileNetV1
               const size_t numClasses = 1000);
 
   //! Get Layers of the model.
-  FFN<OutputLayerType, InitializationRuleType>& GetModel() { return mobileNet; }
+  FFN<OutputLayerType, InitializationRuleType, MatType>& GetModel()
+  {
+    return mobileNet;
+  }
 
   //! Load weights into the model and assumes the internal matrix to be
   //!  named "MobileNetV1".
@@ -100,23 +113,37 @@ class MobileNetV1
 
   void SaveModel(const std::string& filepath);
 
+  //! Map the given weight file and bind the model to it; the model may have
+  //! fewer layers than the file, e.g. if includeTop is false.
+  void LoadWeights(const std::string& filePath);
+
+  //! Save the weights of the model as a weight file.
+  void SaveWeights(const std::string& filePath);
+
  private:
+  //! The convolution type of the model, see FastConvolutionType.
+  typedef FastConvolutionType<MatType> ConvolutionLayerType;
+
+  //! The grouped convolution type of the model, 3x3 depthwise convolutions
+  //! use the specialized depthwise kernel.
+  typedef DepthwiseConvolutionType<MatType> GroupedConvolutionLayerType;
+
   /**
    * Adds a ReLU6 Layer.
    *
-   * @param baseLayer Sequential layer type in which ReLU6 layer will be added
+   * @param baseLayer Layer in which ReLU6 layer will be added
    *     if it's not NULL otherwise added to mobileNet.
    */
-  void ReLU6Layer(Sequential<>* baseLayer = NULL)
+  void ReLU6Layer(MultiLayer<MatType>* baseLayer = NULL)
   {
     if (baseLayer != NULL)
     {
-      baseLayer->Add(new ReLU6<>);
+      baseLayer->template Add<ReLU6Type<MatType>>();
       mlpack::Log::Info << "RelU6" << std::endl;
       return;
     }
 
-    mobileNet.Add(new ReLU6<>);
+    mobileNet.template Add<ReLU6Type<MatType>>();
     mlpack::Log::Info << "RelU6" << std::endl;
   }
 
@@ -134,11 +161,9 @@ class MobileNetV1
    * @param padT Top padding width of the input.
    * @param padB Bottom padding height of the input.
    * @param paddingType Type of padding used.
-   *
-   * @tparam SequentialType Layer type in which convolution block will
-   *    be added if it's not NULL otherwise added to mobileNet.
+   * @param baseLayer Layer in which convolution block will be added if it's
+   *    not NULL otherwise added to mobileNet.
    */
-  template<typename SequentialType = Sequential<>>
   void ConvolutionBlock(const size_t inSize,
                         const size_t outSize,
                         const size_t kernelWidth = 1,
@@ -150,12 +175,12 @@ class MobileNetV1
                         const size_t padT = 0,
                         const size_t padB = 0,
                         const std::string paddingType = "None",
-                        SequentialType* baseLayer = NULL)
+                        MultiLayer<MatType>* baseLayer = NULL)
   {
-    Sequential<>* sequentialBlock = new Sequential<>();
-    sequentialBlock->Add(new Convolution<>(inSize, outSize, kernelWidth,
+    MultiLayer<MatType>* sequentialBlock = new MultiLayer<MatType>();
+    sequentialBlock->template Add<ConvolutionLayerType>(outSize, kernelWidth,
         kernelHeight, strideWidth, strideHeight, std::make_tuple(padL, padR),
-        std::make_tuple(padT, padB), inputWidth, inputHeight, paddingType));
+        std::make_tuple(padT, padB), paddingType);
 
     mlpack::Log::Info << "Convolution: " << "(" << inSize << ", " << inputWidth
         << ", " << inputHeight << ")" << " ---> (";
@@ -187,15 +212,14 @@ class MobileNetV1
    * It's represented as:
    * 
    * @code
-   * sequentialBlock - Sequential
+   * sequentialBlock - MultiLayer
    * {
-   *   Padding(0, 1, 0, 1, inputWidth, inputHeight)
-   *   SeparableConvolution(inSize, depthMultipliedOutSize, 3, 3, stride,
-   *       stride, 0, 0, inputWidth, inputHeight, inSize, paddingType)
-   *   BatchNorm(depthMultipliedOutSize, 1e-3, true)
-   *   Convolution(depthMultipliedOutSize, pointwiseOutSize, 1, 1, 1, 1, 0,
-   *       0, inputWidth, inputHeight, "same")
-   *   BatchNorm(pointwiseOutSize, 1e-3, true)
+   *   Padding(0, 1, 0, 1)
+   *   GroupedConvolution(depthMultipliedOutSize, 3, 3, inSize, stride,
+   *       stride, 0, 0, paddingType)
+   *   BatchNorm(2, 2, 1e-3, true)
+   *   Convolution(pointwiseOutSize, 1, 1, 1, 1, 0, 0, "same")
+   *   BatchNorm(2, 2, 1e-3, true)
    * }
    * @endcode
    * 
@@ -216,12 +240,11 @@ class MobileNetV1
     paddingType = "same";
     size_t pointwiseOutSize = size_t(outSize * alpha);
     size_t depthMultipliedOutSize = size_t(inSize * depthMultiplier);
-    Sequential<>* sequentialBlock = new Sequential<>();
+    MultiLayer<MatType>* sequentialBlock = new MultiLayer<MatType>();
 
     if (stride != 1)
     {
-      sequentialBlock->Add(new Padding<>(0, 1, 0, 1, inputWidth,
-          inputHeight));
+      sequentialBlock->template Add<PaddingType<MatType>>(0, 1, 0, 1);
       mlpack::Log::Info << "Padding: " << "(" << inSize << ", " << inputWidth
           << ", " << inputWidth << " ---> (";
       inputWidth += 1;
@@ -231,9 +254,9 @@ class MobileNetV1
       paddingType = "valid";
     }
 
-    sequentialBlock->Add(new SeparableConvolution<>(inSize,
-        depthMultipliedOutSize, 3, 3, stride, stride, 0, 0, inputWidth,
-        inputHeight, inSize, paddingType));
+    sequentialBlock->template Add<GroupedConvolutionLayerType>(
+        depthMultipliedOutSize, 3, 3, inSize, stride, stride, 0, 0,
+        paddingType);
     mlpack::Log::Info << "Separable convolution: " << "(" << inSize << ", " <<
         inputWidth << ", " << inputHeight << ")" << " ---> (";
 
@@ -246,14 +269,13 @@ class MobileNetV1
     mlpack::Log::Info << depthMultipliedOutSize << ", " << inputWidth << ", "
         << inputHeight << ")" << std::endl;
 
-    sequentialBlock->Add(new BatchNorm<>(depthMultipliedOutSize, 1e-3,
-        true));
+    sequentialBlock->template Add<BatchNormType<MatType>>(2, 2, 1e-3, true);
     mlpack::Log::Info << "BatchNorm: " << "(" << depthMultipliedOutSize << ")"
         << " ---> (" << depthMultipliedOutSize << ")" << std::endl;
     ReLU6Layer(sequentialBlock);
     ConvolutionBlock(depthMultipliedOutSize, pointwiseOutSize, 1, 1, 1, 1, 0,
         0, 0, 0, "same", sequentialBlock);
-    sequentialBlock->Add(new BatchNorm<>(pointwiseOutSize, 1e-3, true));
+    sequentialBlock->template Add<BatchNormType<MatType>>(2, 2, 1e-3, true);
     mlpack::Log::Info << "BatchNorm: " << "(" << pointwiseOutSize << ")"
         << " ---> (" << pointwiseOutSize << ")" << std::endl;
     ReLU6Layer(sequentialBlock);
@@ -280,7 +302,7 @@ class MobileNetV1
   }
 
   //! Locally stored DarkNet Model.
-  FFN<OutputLayerType, InitializationRuleType> mobileNet;
+  FFN<OutputLayerType, InitializationRuleType, MatType> mobileNet;
 
   //! Locally stored number of channels in the image.
   size_t inputChannel;
@@ -332,10 +354,13 @@ class MobileNetV1
 
   //! Locally stored path string for pre-trained model.
   std::string preTrainedPath;
+
+  //! Locally stored weight file the model is bound to.
+  std::shared_ptr<WeightFile<MatType>> weightFile;
 }; // MobileNetV1 class
 
 // convenience typedef.
-typedef MobileNetV1<CrossEntropyError<>, RandomInitialization>
+typedef MobileNetV1<arma::mat, CrossEntropyError, RandomInitialization>
     MobilenetV1;
 
 } // namespace models
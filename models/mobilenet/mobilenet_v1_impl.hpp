@@ -17,8 +17,12 @@
 namespace mlpack {
 namespace models {
 
-template<typename OutputLayerType, typename InitializationRuleType>
-MobileNetV1<OutputLayerType, InitializationRuleType>::MobileNetV1() :
+template<
+    typename MatType,
+    typename OutputLayerType,
+    typename InitializationRuleType
+>
+MobileNetV1<MatType, OutputLayerType, InitializationRuleType>::MobileNetV1() :
     inputChannel(0),
     inputWidth(0),
     inputHeight(0),
@@ -29,8 +33,12 @@ MobileNetV1<OutputLayerType, InitializationRuleType>::MobileNetV1() :
   // Nothing to do here.
 }
 
-template<typename OutputLayerType, typename InitializationRuleType>
-MobileNetV1<OutputLayerType, InitializationRuleType>::MobileNetV1(
+template<
+    typename MatType,
+    typename OutputLayerType,
+    typename InitializationRuleType
+>
+MobileNetV1<MatType, OutputLayerType, InitializationRuleType>::MobileNetV1(
     const size_t inputChannel,
     const size_t inputWidth,
     const size_t inputHeight,
@@ -39,7 +47,7 @@ MobileNetV1<OutputLayerType, InitializationRuleType>::MobileNetV1(
     const bool includeTop,
     const bool preTrained,
     const size_t numClasses) :
-    MobileNetV1<OutputLayerType, InitializationRuleType>(
+    MobileNetV1<MatType, OutputLayerType, InitializationRuleType>(
         std::tuple<size_t, size_t, size_t>(
         inputChannel,
         inputWidth,
@@ -53,8 +61,12 @@ MobileNetV1<OutputLayerType, InitializationRuleType>::MobileNetV1(
   // Nothing to do here.
 }
 
-template<typename OutputLayerType, typename InitializationRuleType>
-MobileNetV1<OutputLayerType, InitializationRuleType>::MobileNetV1(
+template<
+    typename MatType,
+    typename OutputLayerType,
+    typename InitializationRuleType
+>
+MobileNetV1<MatType, OutputLayerType, InitializationRuleType>::MobileNetV1(
     std::tuple<size_t, size_t, size_t> inputShape,
     const float alpha,
     const size_t depthMultiplier,
@@ -75,6 +87,7 @@ MobileNetV1<OutputLayerType, InitializationRuleType>::MobileNetV1(
         << inputHeight << ")" << std::endl;
   }
 
+  std::string weightsPath;
   if (preTrained)
   {
     if (numClasses != 1000)
@@ -118,13 +131,23 @@ MobileNetV1<OutputLayerType, InitializationRuleType>::MobileNetV1(
           "http://models.mlpack.org/mobilenetv1/");
     }
 
-    LoadModel(preTrainedPath);
-    return;
+    // The checkpoint is converted once to a weight file, which is bound to
+    // the layers built below.
+    weightsPath = preTrainedPath.substr(0, preTrainedPath.size() - 4) +
+        ".weights";
+    if (Utils::PathExists(weightsPath, true) == false)
+    {
+      LoadModel(preTrainedPath);
+      SaveWeights(weightsPath);
+      mobileNet = FFN<OutputLayerType, InitializationRuleType, MatType>();
+    }
   }
 
+  mobileNet.InputDimensions() = std::vector<size_t>({inputWidth,
+      inputHeight, inputChannel});
   outSize = size_t(32 * alpha);
   ConvolutionBlock(inputChannel, outSize, 3, 3, 2, 2, 0, 1, 0, 1);
-  mobileNet.Add(new BatchNorm<>(outSize, 1e-3, true));
+  mobileNet.template Add<BatchNormType<MatType>>(2, 2, 1e-3, true);
   mlpack::Log::Info << "BatchNorm: " << "(" << outSize << ")"
         << " ---> (" << outSize << ")" << std::endl;
   ReLU6Layer();
@@ -142,37 +165,48 @@ MobileNetV1<OutputLayerType, InitializationRuleType>::MobileNetV1(
     }
   }
 
-  mobileNet.Add(new AdaptiveMeanPooling<>(1, 1));
+  mobileNet.template Add<AdaptiveMeanPoolingType<MatType>>(1, 1);
   mlpack::Log::Info << "Adaptive mean pooling: (" << size_t(1024 * alpha)
       << ", " << inputWidth << ", " << inputHeight << ") ---> ("
       << size_t(1024 * alpha) << ", 1, 1)" << std::endl;
 
   if (includeTop)
   {
-    mobileNet.Add(new Dropout<>(1e-3));
+    mobileNet.template Add<DropoutType<MatType>>(1e-3);
     mlpack::Log::Info << "Dropout" << std::endl;
-    mobileNet.Add(new Convolution<>(size_t(1024 * alpha), numClasses, 1,
-        1, 1, 1, 0, 0, 1, 1, "same"));
+    mobileNet.template Add<ConvolutionLayerType>(numClasses, 1, 1, 1, 1, 0,
+        0, "same");
     mlpack::Log::Info << "Convolution: (" << size_t(1024 * alpha)
         << ", 1, 1) ---> (" << numClasses << " , 1, 1)" << std::endl;
-    mobileNet.Add(new Softmax<>);
+    mobileNet.template Add<SoftmaxType<MatType>>();
     mlpack::Log::Info << "Softmax" << std::endl;
   }
 
-  // Reset parameters for a new network.
-  mobileNet.ResetParameters();
+  // Bind the pre-trained weights or reset parameters for a new network.
+  if (preTrained)
+    LoadWeights(weightsPath);
+  else
+    mobileNet.Reset();
 }
 
-template<typename OutputLayerType, typename InitializationRuleType>
-void MobileNetV1<OutputLayerType, InitializationRuleType>::LoadModel(
+template<
+    typename MatType,
+    typename OutputLayerType,
+    typename InitializationRuleType
+>
+void MobileNetV1<MatType, OutputLayerType, InitializationRuleType>::LoadModel(
     const std::string& filePath)
 {
   data::Load(filePath, "mobilenet_v1", mobileNet);
   Log::Info << "Loaded model" << std::endl;
 }
 
-template<typename OutputLayerType, typename InitializationRuleType>
-void MobileNetV1<OutputLayerType, InitializationRuleType>::SaveModel(
+template<
+    typename MatType,
+    typename OutputLayerType,
+    typename InitializationRuleType
+>
+void MobileNetV1<MatType, OutputLayerType, InitializationRuleType>::SaveModel(
     const std::string& filePath)
 {
   Log::Info<< "Saving model." << std::endl;
@@ -180,6 +214,32 @@ void MobileNetV1<OutputLayerType, InitializationRuleType>::SaveModel(
   Log::Info << "Model saved in " << filePath << "." << std::endl;
 }
 
+template<
+    typename MatType,
+    typename OutputLayerType,
+    typename InitializationRuleType
+>
+void MobileNetV1<MatType, OutputLayerType, InitializationRuleType>::LoadWeights(
+    const std::string& filePath)
+{
+  weightFile = std::make_shared<WeightFile<MatType>>(filePath);
+  const size_t layers = weightFile->Bind(mobileNet);
+  Log::Info << "Bound " << layers << " layers to " << filePath << "."
+      << std::endl;
+}
+
+template<
+    typename MatType,
+    typename OutputLayerType,
+    typename InitializationRuleType
+>
+void MobileNetV1<MatType, OutputLayerType, InitializationRuleType>::SaveWeights(
+    const std::string& filePath)
+{
+  WeightFile<MatType>::Save(filePath, mobileNet);
+  Log::Info << "Weights saved in " << filePath << "." << std::endl;
+}
+
 } // namespace models
 } // namespace mlpack
 
@@ -25,8 +25,12 @@
 
 #define MLPACK_ENABLE_ANN_SERIALIZATION
 #include <mlpack.hpp>
+#include <layers/serialization.hpp>
+#include <layers/parallel_add_merge.hpp>
+#include <layers/fast_convolution.hpp>
 
 #include "./../../utils/utils.hpp"
+#include "./../../utils/weight_file.hpp"
 
 namespace mlpack {
 namespace models {
@@ -34,12 +38,15 @@ namespace models {
 /**
  * Definition of a ResNet CNN.
  * 
+ * @tparam MatType Matrix representation to accept as input and use for
+ *    computation.
  * @tparam OutputLayerType The output layer type used to evaluate the network.
  * @tparam InitializationRuleType Rule used to initialize the weight matrix.
  * @tparam ResNetVersion Version of ResNet.
  */
 template<
-  typename OutputLayerType = CrossEntropyError<>,
+  typename MatType = arma::mat,
+  typename OutputLayerType = CrossEntropyErrorType<MatType>,
   typename InitializationRuleType = RandomInitialization,
   size_t ResNetVersion = 18
 >
@@ -55,7 +62,8 @@ class ResNet
    * @param inputChannels Number of input channels of the input image.
    * @param inputWidth Width of the input image.
    * @param inputHeight Height of the input image.
-   * @param includeTop Must be set to true if preTrained is set to true.
+   * @param includeTop Whether to include the classifier; without it, the
+   *    pre-trained weights are bound to the layers before the classifier.
    * @param preTrained True for pre-trained weights of ImageNet,
    *    default is false.
    * @param numClasses Optional number of classes to classify images into,
@@ -85,7 +93,10 @@ class ResNet
          const size_t numClasses = 1000);
 
   //! Get Layers of the model.
-  FFN<OutputLayerType, InitializationRuleType>& GetModel() { return resNet; }
+  FFN<OutputLayerType, InitializationRuleType, MatType>& GetModel()
+  {
+    return resNet;
+  }
 
   //! Load weights into the model and assumes the internal matrix to be
   //  named "ResNet".
@@ -95,13 +106,21 @@ class ResNet
   //  named "ResNet".
   void SaveModel(const std::string& filepath);
 
+  //! Map the given weight file and bind the model to it; the model may have
+  //  fewer layers than the file, e.g. if includeTop is false.
+  void LoadWeights(const std::string& filePath);
+
+  //! Save the weights of the model as a weight file.
+  void SaveWeights(const std::string& filePath);
+
  private:
+  //! The convolution type of the model, see FastConvolutionType.
+  typedef FastConvolutionType<MatType> ConvolutionLayerType;
+
   /**
    * Adds a Convolution Block depending on the configuration.
    *
-   * @tparam SequentialType Layer type in which convolution block will
-   *     be added.
-   *
+   * @param baseLayer Layer in which convolution block will be added.
    * @param inSize Number of input maps.
    * @param outSize Number of output maps.
    * @param strideWidth Stride of filter application in the x direction.
@@ -114,8 +133,7 @@ class ResNet
    * @param downSampleInputWidth Input widht for downSample block.
    * @param downSampleInputHeight Input height for downSample block.
    */
-  template<typename SequentialType = Sequential<>>
-  void ConvolutionBlock(SequentialType* baseLayer,
+  void ConvolutionBlock(MultiLayer<MatType>* baseLayer,
                         const size_t inSize,
                         const size_t outSize,
                         const size_t strideWidth = 1,
@@ -135,10 +153,9 @@ class ResNet
       inputHeight = downSampleInputHeight;
     }
 
-    Sequential<>* tempBaseLayer = new Sequential<>();
-    tempBaseLayer->Add(new Convolution<>(inSize, outSize, kernelWidth,
-        kernelHeight, strideWidth, strideHeight, padW, padH, inputWidth,
-        inputHeight));
+    MultiLayer<MatType>* tempBaseLayer = new MultiLayer<MatType>();
+    tempBaseLayer->template Add<ConvolutionLayerType>(outSize, kernelWidth,
+        kernelHeight, strideWidth, strideHeight, padW, padH);
     mlpack::Log::Info << "Convolution: " << "(" << inSize << ", " <<
         inputWidth << ", " << inputHeight << ")" << " ---> (";
 
@@ -150,7 +167,7 @@ class ResNet
     mlpack::Log::Info << outSize << ", " << inputWidth << ", " <<
         inputHeight << ")" << std::endl;
 
-    tempBaseLayer->Add(new BatchNorm<>(outSize, 1e-5));
+    tempBaseLayer->template Add<BatchNormType<MatType>>(2, 2, 1e-5);
     mlpack::Log::Info << "BatchNorm: " << "(" << outSize << ")" << " ---> ("
         << outSize << ")" << std::endl;
     baseLayer->Add(tempBaseLayer);
@@ -161,11 +178,11 @@ class ResNet
   /**
    * Adds a ReLU Layer.
    *
-   * @param baseLayer Sequential layer type in which ReLU layer will be added.
+   * @param baseLayer Layer in which ReLU layer will be added.
    */
-  void ReLULayer(Sequential<>* baseLayer)
+  void ReLULayer(MultiLayer<MatType>* baseLayer)
   {
-    baseLayer->Add(new ReLULayer<>);
+    baseLayer->template Add<ReLUType<MatType>>();
     mlpack::Log::Info << "Relu" << std::endl;
   }
 
@@ -213,9 +230,9 @@ class ResNet
     downSampleInputWidth = inputWidth;
     downSampleInputHeight = inputHeight;
 
-    Sequential<>* basicBlock = new Sequential<>();
-    AddMerge<>* resBlock = new AddMerge<>(true, true);
-    Sequential<>* sequentialBlock = new Sequential<>();
+    MultiLayer<MatType>* basicBlock = new MultiLayer<MatType>();
+    AddMergeType<MatType>* resBlock = new ParallelAddMergeType<MatType>();
+    MultiLayer<MatType>* sequentialBlock = new MultiLayer<MatType>();
     ConvolutionBlock(sequentialBlock, inSize, outSize, strideWidth,
         strideHeight);
     ReLULayer(sequentialBlock);
@@ -231,7 +248,7 @@ class ResNet
     else
     {
       mlpack::Log::Info << "IdentityLayer" << std::endl;
-      resBlock->Add(new IdentityLayer<>);
+      resBlock->template Add<IdentityType<MatType>>();
     }
 
     basicBlock->Add(resBlock);
@@ -292,9 +309,9 @@ class ResNet
     downSampleInputHeight = inputHeight;
 
     size_t width = int((baseWidth / 64.0) * outSize) * groups;
-    Sequential<>* basicBlock = new Sequential<>();
-    AddMerge<>* resBlock = new AddMerge<>(true, true);
-    Sequential<>* sequentialBlock = new Sequential<>();
+    MultiLayer<MatType>* basicBlock = new MultiLayer<MatType>();
+    AddMergeType<MatType>* resBlock = new ParallelAddMergeType<MatType>();
+    MultiLayer<MatType>* sequentialBlock = new MultiLayer<MatType>();
     ConvolutionBlock(sequentialBlock, inSize, width, 1, 1, 1, 1, 0, 0);
     ReLULayer(sequentialBlock);
     ConvolutionBlock(sequentialBlock, width, width, strideWidth,
@@ -313,7 +330,7 @@ class ResNet
     else
     {
       mlpack::Log::Info << "IdentityLayer" << std::endl;
-      resBlock->Add(new IdentityLayer<>);
+      resBlock->template Add<IdentityType<MatType>>();
     }
 
     basicBlock->Add(resBlock);
@@ -374,7 +391,7 @@ class ResNet
   }
 
   //! Locally stored DarkNet Model.
-  FFN<OutputLayerType, InitializationRuleType> resNet;
+  FFN<OutputLayerType, InitializationRuleType, MatType> resNet;
 
   //! Locally stored number of channels in the image.
   size_t inputChannel;
@@ -421,14 +438,22 @@ class ResNet
 
   //! Locally stored path string for pre-trained model.
   std::string preTrainedPath;
+
+  //! Locally stored weight file the model is bound to.
+  std::shared_ptr<WeightFile<MatType>> weightFile;
 }; // ResNet class
 
 // convenience typedefs for different ResNet models.
-typedef ResNet<CrossEntropyError<>, RandomInitialization, 18> ResNet18;
-typedef ResNet<CrossEntropyError<>, RandomInitialization, 34> ResNet34;
-typedef ResNet<CrossEntropyError<>, RandomInitialization, 50> ResNet50;
-typedef ResNet<CrossEntropyError<>, RandomInitialization, 101> ResNet101;
-typedef ResNet<CrossEntropyError<>, RandomInitialization, 152> ResNet152;
+typedef ResNet<arma::mat, CrossEntropyError, RandomInitialization, 18>
+    ResNet18;
+typedef ResNet<arma::mat, CrossEntropyError, RandomInitialization, 34>
+    ResNet34;
+typedef ResNet<arma::mat, CrossEntropyError, RandomInitialization, 50>
+    ResNet50;
+typedef ResNet<arma::mat, CrossEntropyError, RandomInitialization, 101>
+    ResNet101;
+typedef ResNet<arma::mat, CrossEntropyError, RandomInitialization, 152>
+    ResNet152;
 
 } // namespace models
 } // namespace mlpack
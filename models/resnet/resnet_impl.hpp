@@ -17,9 +17,11 @@
 namespace mlpack {
 namespace models {
 
-template<typename OutputLayerType, typename InitializationRuleType,
-    size_t ResNetVersion>
-ResNet<OutputLayerType, InitializationRuleType, ResNetVersion>::ResNet() :
+template<typename MatType, typename OutputLayerType,
+    typename InitializationRuleType, size_t ResNetVersion>
+ResNet<
+    MatType, OutputLayerType, InitializationRuleType, ResNetVersion
+>::ResNet() :
     inputChannel(0),
     inputWidth(0),
     inputHeight(0),
@@ -28,16 +30,18 @@ ResNet<OutputLayerType, InitializationRuleType, ResNetVersion>::ResNet() :
   // Nothing to do here.
 }
 
-template<typename OutputLayerType, typename InitializationRuleType,
-    size_t ResNetVersion>
-ResNet<OutputLayerType, InitializationRuleType, ResNetVersion>::ResNet(
+template<typename MatType, typename OutputLayerType,
+    typename InitializationRuleType, size_t ResNetVersion>
+ResNet<
+    MatType, OutputLayerType, InitializationRuleType, ResNetVersion
+>::ResNet(
     const size_t inputChannel,
     const size_t inputWidth,
     const size_t inputHeight,
     const bool includeTop,
     const bool preTrained,
     const size_t numClasses) :
-    ResNet<OutputLayerType, InitializationRuleType, ResNetVersion>(
+    ResNet<MatType, OutputLayerType, InitializationRuleType, ResNetVersion>(
         std::tuple<size_t, size_t, size_t>(
         inputChannel,
         inputWidth,
@@ -49,9 +53,11 @@ ResNet<OutputLayerType, InitializationRuleType, ResNetVersion>::ResNet(
   // Nothing to do here.
 }
 
-template<typename OutputLayerType, typename InitializationRuleType,
-    size_t ResNetVersion>
-ResNet<OutputLayerType, InitializationRuleType, ResNetVersion>::ResNet(
+template<typename MatType, typename OutputLayerType,
+    typename InitializationRuleType, size_t ResNetVersion>
+ResNet<
+    MatType, OutputLayerType, InitializationRuleType, ResNetVersion
+>::ResNet(
     std::tuple<size_t, size_t, size_t> inputShape,
     const bool includeTop,
     const bool preTrained,
@@ -61,6 +67,7 @@ ResNet<OutputLayerType, InitializationRuleType, ResNetVersion>::ResNet(
     inputHeight(std::get<2>(inputShape)),
     numClasses(numClasses)
 {
+  std::string weightsPath;
   if (preTrained)
   {
     std::string home = getenv("HOME");
@@ -75,8 +82,16 @@ ResNet<OutputLayerType, InitializationRuleType, ResNetVersion>::ResNet(
           "http://models.mlpack.org/resnet/");
     }
 
-    LoadModel(preTrainedPath);
-    return;
+    // The checkpoint is converted once to a weight file, which is bound to
+    // the layers built below.
+    weightsPath = preTrainedPath.substr(0, preTrainedPath.size() - 4) +
+        ".weights";
+    if (Utils::PathExists(weightsPath, true) == false)
+    {
+      LoadModel(preTrainedPath);
+      SaveWeights(weightsPath);
+      resNet = FFN<OutputLayerType, InitializationRuleType, MatType>();
+    }
   }
 
   // Config for different versions.
@@ -92,13 +107,15 @@ ResNet<OutputLayerType, InitializationRuleType, ResNetVersion>::ResNet(
         "34, 50, 101 and 152" << std::endl;
   }
 
-  resNet.Add(new IdentityLayer<>);
-  Sequential<>* seqBlock = new Sequential<>();
+  resNet.InputDimensions() = std::vector<size_t>({inputWidth, inputHeight,
+      inputChannel});
+  resNet.template Add<IdentityType<MatType>>();
+  MultiLayer<MatType>* seqBlock = new MultiLayer<MatType>();
   ConvolutionBlock(seqBlock, 3, 64, 2, 2, 7, 7, 3, 3);
   ReLULayer(seqBlock);
   resNet.Add(seqBlock);
 
-  resNet.Add(new Padding<>(1, 1, 1, 1, inputWidth, inputHeight));
+  resNet.template Add<PaddingType<MatType>>(1, 1, 1, 1);
   mlpack::Log::Info << "Padding: " << "(" << "64, " << inputWidth << ", " <<
       inputWidth << " ---> (";
 
@@ -109,7 +126,7 @@ ResNet<OutputLayerType, InitializationRuleType, ResNetVersion>::ResNet(
   mlpack::Log::Info <<"64, "<< inputWidth << ", " << inputHeight << ")" <<
       std::endl;
 
-  resNet.Add(new MaxPooling<>(3, 3, 2, 2));
+  resNet.template Add<MaxPoolingType<MatType>>(3, 3, 2, 2);
   mlpack::Log::Info << "MaxPool: " << "(" <<"64, " << inputWidth << ", " <<
       inputHeight << " ---> (";
 
@@ -127,46 +144,73 @@ ResNet<OutputLayerType, InitializationRuleType, ResNetVersion>::ResNet(
 
   if (includeTop)
   {
-    resNet.Add(new AdaptiveMeanPooling<>(1, 1));
+    resNet.template Add<AdaptiveMeanPoolingType<MatType>>(1, 1);
     mlpack::Log::Info << "AdaptiveMeanPooling: " << "(1, 1)" << std::endl;
 
     if (ResNetVersion == 18 || ResNetVersion == 34)
     {
-      resNet.Add(new Linear<>(512 * basicBlockExpansion, numClasses));
+      resNet.template Add<LinearType<MatType>>(numClasses);
       mlpack::Log::Info << "Linear: " << "(" << 512 * basicBlockExpansion <<
           ") ---> (" << numClasses << ")" <<std::endl;
     }
     else if (ResNetVersion == 50 || ResNetVersion == 101 ||
         ResNetVersion == 152)
     {
-      resNet.Add(new Linear<>(512 * bottleNeckExpansion, numClasses));
+      resNet.template Add<LinearType<MatType>>(numClasses);
       mlpack::Log::Info<<"Linear: " << "(" << 512 * bottleNeckExpansion <<
           ") ---> (" << numClasses << ")" << std::endl;
     }
   }
 
-  resNet.ResetParameters();
+  if (preTrained)
+    LoadWeights(weightsPath);
+  else
+    resNet.Reset();
 }
 
-template<typename OutputLayerType, typename InitializationRuleType,
-    size_t ResNetVersion>
-void ResNet<OutputLayerType, InitializationRuleType, ResNetVersion>::
-    LoadModel(const std::string& filePath)
+template<typename MatType, typename OutputLayerType,
+    typename InitializationRuleType, size_t ResNetVersion>
+void ResNet<
+    MatType, OutputLayerType, InitializationRuleType, ResNetVersion
+>::LoadModel(const std::string& filePath)
 {
   data::Load(filePath, "ResNet", resNet);
   Log::Info << "Loaded model" << std::endl;
 }
 
-template<typename OutputLayerType, typename InitializationRuleType,
-    size_t ResNetVersion>
-void ResNet<OutputLayerType, InitializationRuleType, ResNetVersion>::
-    SaveModel(const std::string& filePath)
+template<typename MatType, typename OutputLayerType,
+    typename InitializationRuleType, size_t ResNetVersion>
+void ResNet<
+    MatType, OutputLayerType, InitializationRuleType, ResNetVersion
+>::SaveModel(const std::string& filePath)
 {
   Log::Info<< "Saving model." << std::endl;
   data::Save(filePath, "ResNet", resNet);
   Log::Info << "Model saved in " << filePath << "." << std::endl;
 }
 
+template<typename MatType, typename OutputLayerType,
+    typename InitializationRuleType, size_t ResNetVersion>
+void ResNet<
+    MatType, OutputLayerType, InitializationRuleType, ResNetVersion
+>::LoadWeights(const std::string& filePath)
+{
+  weightFile = std::make_shared<WeightFile<MatType>>(filePath);
+  const size_t layers = weightFile->Bind(resNet);
+  Log::Info << "Bound " << layers << " layers to " << filePath << "."
+      << std::endl;
+}
+
+template<typename MatType, typename OutputLayerType,
+    typename InitializationRuleType, size_t ResNetVersion>
+void ResNet<
+    MatType, OutputLayerType, InitializationRuleType, ResNetVersion
+>::SaveWeights(const std::string& filePath)
+{
+  WeightFile<MatType>::Save(filePath, resNet);
+  Log::Info << "Weights saved in " << filePath << "." << std::endl;
+}
+
 } // namespace models
 } // namespace mlpack
 
@@ -30,6 +30,9 @@
 
 #define MLPACK_ENABLE_ANN_SERIALIZATION
 #include <mlpack.hpp>
+#include <layers/serialization.hpp>
+#include <layers/fast_convolution.hpp>
+#include <layers/view_concat.hpp>
 
 namespace mlpack {
 namespace models {
@@ -87,7 +90,7 @@ class SqueezeNetType : public MultiLayer<MatType>
    * @tparam InitializationRuleType Rule used to initialize the weight matrix.
    */
   template<
-    typename OutputLayerType = CrossEntropyError,
+    typename OutputLayerType = CrossEntropyErrorType<MatType>,
     typename InitializationRuleType = RandomInitialization
   >
   FFN<OutputLayerType, InitializationRuleType, MatType>* GetModel()
@@ -103,6 +106,9 @@ class SqueezeNetType : public MultiLayer<MatType>
   void serialize(Archive& ar, const uint32_t /* version */);
 
  private:
+  //! The convolution type of the model, see FastConvolutionType.
+  typedef FastConvolutionType<MatType> ConvolutionLayerType;
+
   /**
    * Adds Fire Block.
    *
@@ -134,6 +140,8 @@ typedef SqueezeNetType<arma::mat, 1> SqueezeNet1;
 
 CEREAL_REGISTER_TYPE(mlpack::models::SqueezeNetType<arma::mat, 0>);
 CEREAL_REGISTER_TYPE(mlpack::models::SqueezeNetType<arma::mat, 1>);
+CEREAL_REGISTER_TYPE(mlpack::models::SqueezeNetType<arma::fmat, 0>);
+CEREAL_REGISTER_TYPE(mlpack::models::SqueezeNetType<arma::fmat, 1>);
 
 #include "squeezenet_impl.hpp"
 
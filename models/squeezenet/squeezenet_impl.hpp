@@ -94,18 +94,21 @@ void SqueezeNetType<MatType, SqueezeNetVersion>::Fire(
     const size_t expand1x1Planes,
     const size_t expand3x3Planes)
 {
-  this->template Add<Convolution>(squeezePlanes, 1, 1);
-  this->template Add<ReLU>();
+  this->template Add<ConvolutionLayerType>(squeezePlanes, 1, 1);
+  this->template Add<ReLUType<MatType>>();
 
   MultiLayer<MatType>* expand1x1 = new MultiLayer<MatType>();
-  expand1x1->template Add<Convolution>(expand1x1Planes, 1, 1);
-  expand1x1->template Add<ReLU>();
+  expand1x1->template Add<ConvolutionLayerType>(expand1x1Planes, 1, 1);
+  expand1x1->template Add<ReLUType<MatType>>();
 
   MultiLayer<MatType>* expand3x3 = new MultiLayer<MatType>();
-  expand3x3->template Add<Convolution>(expand3x3Planes, 3, 3, 1, 1, 1, 1);
-  expand3x3->template Add<ReLU>();
+  expand3x3->template Add<ConvolutionLayerType>(expand3x3Planes, 3, 3, 1, 1,
+      1, 1);
+  expand3x3->template Add<ReLUType<MatType>>();
 
-  Concat* catLayer = new Concat(2);
+  // The expand branches write the output of a single sample into the output
+  // of the block.
+  ViewConcatType<MatType>* catLayer = new ViewConcatType<MatType>(2);
   catLayer->template Add(expand1x1);
   catLayer->template Add(expand3x3);
 
@@ -117,31 +120,31 @@ void SqueezeNetType<MatType, SqueezeNetVersion>::MakeModel()
 {
   if (SqueezeNetVersion == 0)
   {
-    this->template Add<Convolution>(96, 7, 7, 2, 2);
-    this->template Add<ReLU>();
-    this->template Add<MaxPooling>(3, 3, 2, 2, false);
+    this->template Add<ConvolutionLayerType>(96, 7, 7, 2, 2);
+    this->template Add<ReLUType<MatType>>();
+    this->template Add<MaxPoolingType<MatType>>(3, 3, 2, 2, false);
     Fire(16, 64, 64);
     Fire(16, 64, 64);
     Fire(32, 128, 128);
-    this->template Add<MaxPooling>(3, 3, 2, 2, false);
+    this->template Add<MaxPoolingType<MatType>>(3, 3, 2, 2, false);
     Fire(32, 128, 128);
     Fire(48, 192, 192);
     Fire(48, 192, 192);
     Fire(64, 256, 256);
-    this->template Add<MaxPooling>(3, 3, 2, 2, false);
+    this->template Add<MaxPoolingType<MatType>>(3, 3, 2, 2, false);
     Fire(64, 256, 256);
   }
   else if (SqueezeNetVersion == 1)
   {
-    this->template Add<Convolution>(64, 3, 3, 2, 2);
-    this->template Add<ReLU>();
-    this->template Add<MaxPooling>(3, 3, 2, 2, false);
+    this->template Add<ConvolutionLayerType>(64, 3, 3, 2, 2);
+    this->template Add<ReLUType<MatType>>();
+    this->template Add<MaxPoolingType<MatType>>(3, 3, 2, 2, false);
     Fire(16, 64, 64);
     Fire(16, 64, 64);
-    this->template Add<MaxPooling>(3, 3, 2, 2, false);
+    this->template Add<MaxPoolingType<MatType>>(3, 3, 2, 2, false);
     Fire(32, 128, 128);
     Fire(32, 128, 128);
-    this->template Add<MaxPooling>(3, 3, 2, 2, false);
+    this->template Add<MaxPoolingType<MatType>>(3, 3, 2, 2, false);
     Fire(48, 192, 192);
     Fire(48, 192, 192);
     Fire(64, 256, 256);
@@ -153,10 +156,10 @@ void SqueezeNetType<MatType, SqueezeNetVersion>::MakeModel()
   }
   if (includeTop)
   {
-    this->template Add<Dropout>();
-    this->template Add<Convolution>(numClasses, 1, 1);
-    this->template Add<ReLU>();
-    this->template Add<AdaptiveMeanPooling>(1, 1);
+    this->template Add<DropoutType<MatType>>();
+    this->template Add<ConvolutionLayerType>(numClasses, 1, 1);
+    this->template Add<ReLUType<MatType>>();
+    this->template Add<AdaptiveMeanPoolingType<MatType>>(1, 1);
   }
 }
 
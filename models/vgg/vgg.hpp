@@ -28,6 +28,8 @@
 
 #define MLPACK_ENABLE_ANN_SERIALIZATION
 #include <mlpack.hpp>
+#include <layers/serialization.hpp>
+#include <layers/fast_convolution.hpp>
 
 namespace mlpack {
 namespace models {
@@ -87,7 +89,7 @@ class VGGType : public MultiLayer<MatType>
    * @tparam InitializationRuleType Rule used to initialize the weight matrix.
    */
   template<
-    typename OutputLayerType = CrossEntropyError,
+    typename OutputLayerType = CrossEntropyErrorType<MatType>,
     typename InitializationRuleType = RandomInitialization
   >
   FFN<OutputLayerType, InitializationRuleType, MatType>* GetModel()
@@ -103,6 +105,9 @@ class VGGType : public MultiLayer<MatType>
   void serialize(Archive& ar, const uint32_t /* version */);
 
  private:
+  //! The convolution type of the model, see FastConvolutionType.
+  typedef FastConvolutionType<MatType> ConvolutionLayerType;
+
   void MakeModel();
 
   //! Locally stored number of output classes.
@@ -137,6 +142,16 @@ CEREAL_REGISTER_TYPE(mlpack::models::VGGType<arma::mat, 13, true>);
 CEREAL_REGISTER_TYPE(mlpack::models::VGGType<arma::mat, 16, true>);
 CEREAL_REGISTER_TYPE(mlpack::models::VGGType<arma::mat, 19, true>);
 
+CEREAL_REGISTER_TYPE(mlpack::models::VGGType<arma::fmat, 11, false>);
+CEREAL_REGISTER_TYPE(mlpack::models::VGGType<arma::fmat, 13, false>);
+CEREAL_REGISTER_TYPE(mlpack::models::VGGType<arma::fmat, 16, false>);
+CEREAL_REGISTER_TYPE(mlpack::models::VGGType<arma::fmat, 19, false>);
+
+CEREAL_REGISTER_TYPE(mlpack::models::VGGType<arma::fmat, 11, true>);
+CEREAL_REGISTER_TYPE(mlpack::models::VGGType<arma::fmat, 13, true>);
+CEREAL_REGISTER_TYPE(mlpack::models::VGGType<arma::fmat, 16, true>);
+CEREAL_REGISTER_TYPE(mlpack::models::VGGType<arma::fmat, 19, true>);
+
 
 #include "vgg_impl.hpp"
 
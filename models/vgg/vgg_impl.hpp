@@ -107,25 +107,25 @@ void VGGType<MatType, VGGVersion, UsesBatchNorm>::MakeModel()
   {
     if (layers[i] == 0)
     {
-      this->template Add<MaxPooling>(2, 2, 2, 2);
+      this->template Add<MaxPoolingType<MatType>>(2, 2, 2, 2);
     }
     else
     {
-      this->template Add<Convolution>(layers[i], 3, 3, 1, 1, 1, 1);
+      this->template Add<ConvolutionLayerType>(layers[i], 3, 3, 1, 1, 1, 1);
       if (UsesBatchNorm)
-        this->template Add<BatchNorm>(2, 2, 1e-5, false, 0.1);
-      this->template Add<ReLU>();
+        this->template Add<BatchNormType<MatType>>(2, 2, 1e-5, false, 0.1);
+      this->template Add<ReLUType<MatType>>();
     }
   }
   if (includeTop)
   {
-    this->template Add<Linear>(4096);
-    this->template Add<ReLU>();
-    this->template Add<Dropout>();
-    this->template Add<Linear>(4096);
-    this->template Add<ReLU>();
-    this->template Add<Dropout>();
-    this->template Add<Linear>(numClasses);
+    this->template Add<LinearType<MatType>>(4096);
+    this->template Add<ReLUType<MatType>>();
+    this->template Add<DropoutType<MatType>>();
+    this->template Add<LinearType<MatType>>(4096);
+    this->template Add<ReLUType<MatType>>();
+    this->template Add<DropoutType<MatType>>();
+    this->template Add<LinearType<MatType>>(numClasses);
   }
 }
 
@@ -28,6 +28,10 @@
 
 #define MLPACK_ENABLE_ANN_SERIALIZATION
 #include <mlpack.hpp>
+#include <layers/serialization.hpp>
+#include <layers/depthwise_convolution.hpp>
+#include <layers/fast_convolution.hpp>
+#include <layers/parallel_add_merge.hpp>
 
 namespace mlpack {
 namespace models {
@@ -79,7 +83,7 @@ class XceptionType : public MultiLayer<MatType>
    * @tparam InitializationRuleType Rule used to initialize the weight matrix.
    */
   template<
-    typename OutputLayerType = CrossEntropyError,
+    typename OutputLayerType = CrossEntropyErrorType<MatType>,
     typename InitializationRuleType = RandomInitialization
   >
   FFN<OutputLayerType, InitializationRuleType, MatType>* GetModel()
@@ -95,6 +99,13 @@ class XceptionType : public MultiLayer<MatType>
   void serialize(Archive& ar, const uint32_t /* version */);
 
  private:
+  //! The convolution type of the model, see FastConvolutionType.
+  typedef FastConvolutionType<MatType> ConvolutionLayerType;
+
+  //! The grouped convolution type of the model, 3x3 depthwise convolutions
+  //! use the specialized depthwise kernel.
+  typedef DepthwiseConvolutionType<MatType> GroupedConvolutionLayerType;
+
   /**
    * Adds Separable Convolution to the given block.
    *
@@ -149,6 +160,7 @@ typedef XceptionType<arma::mat> Xception;
 } // namespace mlpack
 
 CEREAL_REGISTER_TYPE(mlpack::models::XceptionType<arma::mat>);
+CEREAL_REGISTER_TYPE(mlpack::models::XceptionType<arma::fmat>);
 
 #include "xception_impl.hpp"
 
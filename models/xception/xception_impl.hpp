@@ -97,9 +97,9 @@ void XceptionType<MatType>::SeparableConv(
     const size_t padding,
     const bool useBias)
 {
-  block->template Add<GroupedConvolution>(inMaps, kernelSize, kernelSize,
-      inMaps, stride, stride, padding, padding, "none", useBias);
-  block->template Add<Convolution>(outMaps, 1, 1, 1, 1, 0, 0, "none",
+  block->template Add<GroupedConvolutionLayerType>(inMaps, kernelSize,
+      kernelSize, inMaps, stride, stride, padding, padding, "none", useBias);
+  block->template Add<ConvolutionLayerType>(outMaps, 1, 1, 1, 1, 0, 0, "none",
       useBias);
 }
 
@@ -117,53 +117,53 @@ void XceptionType<MatType>::Block(
   if (reps < 2)
   {
     if (startWithRelu)
-      block->template Add<ReLU>();
+      block->template Add<ReLUType<MatType>>();
     SeparableConv(block, inMaps, outMaps, 3, 1, 1, false);
-    block->template Add<BatchNorm>();
+    block->template Add<BatchNormType<MatType>>();
   }
   else
   {
     if (growFirst)
     {
       if (startWithRelu)
-        block->template Add<ReLU>();
+        block->template Add<ReLUType<MatType>>();
       SeparableConv(block, inMaps, outMaps, 3, 1, 1, false);
-      block->template Add<BatchNorm>();
+      block->template Add<BatchNormType<MatType>>();
       filter = outMaps;
     }
     if (startWithRelu || growFirst)
-      block->template Add<ReLU>();
+      block->template Add<ReLUType<MatType>>();
     SeparableConv(block, filter, filter, 3, 1, 1, false);
-    block->template Add<BatchNorm>();
+    block->template Add<BatchNormType<MatType>>();
     if (reps > 2)
     {
       for (size_t i = 0; i < reps - 2; i++)
       {
-        block->template Add<ReLU>();
+        block->template Add<ReLUType<MatType>>();
         SeparableConv(block, filter, filter, 3, 1, 1, false);
-        block->template Add<BatchNorm>();
+        block->template Add<BatchNormType<MatType>>();
       }
     }
     if (!growFirst)
     {
-      block->template Add<ReLU>();
+      block->template Add<ReLUType<MatType>>();
       SeparableConv(block, inMaps, outMaps, 3, 1, 1, false);
-      block->template Add<BatchNorm>();
+      block->template Add<BatchNormType<MatType>>();
     }
   }
   if (strides != 1)
   {
-    block->template Add<Padding>(1, 1, 1, 1);
-    block->template Add<MaxPooling>(3, 3, strides, strides);
+    block->template Add<PaddingType<MatType>>(1, 1, 1, 1);
+    block->template Add<MaxPoolingType<MatType>>(3, 3, strides, strides);
   }
   if (inMaps != outMaps || strides != 1)
   {
     MultiLayer<MatType>* block2 = new MultiLayer<MatType>();
-    block2->template Add<Convolution>(outMaps, 1, 1, strides, strides,
+    block2->template Add<ConvolutionLayerType>(outMaps, 1, 1, strides, strides,
         0, 0, "none", false);
-    block2->template Add<BatchNorm>();
+    block2->template Add<BatchNormType<MatType>>();
 
-    AddMerge* merge = new AddMerge();
+    AddMergeType<MatType>* merge = new ParallelAddMergeType<MatType>();
     merge->template Add(block);
     merge->template Add(block2);
 
@@ -171,9 +171,9 @@ void XceptionType<MatType>::Block(
   }
   else
   {
-    AddMerge* merge = new AddMerge();
+    AddMergeType<MatType>* merge = new ParallelAddMergeType<MatType>();
     merge->template Add(block);
-    merge->template Add<Identity>();
+    merge->template Add<IdentityType<MatType>>();
 
     this->template Add(merge);
   }
@@ -182,13 +182,13 @@ void XceptionType<MatType>::Block(
 template<typename MatType>
 void XceptionType<MatType>::MakeModel()
 {
-  this->template Add<Convolution>(32, 3, 3, 2, 2, 0, 0, "none", false);
-  this->template Add<BatchNorm>();
-  this->template Add<ReLU>();
+  this->template Add<ConvolutionLayerType>(32, 3, 3, 2, 2, 0, 0, "none", false);
+  this->template Add<BatchNormType<MatType>>();
+  this->template Add<ReLUType<MatType>>();
 
-  this->template Add<Convolution>(64, 3, 3, 1, 1, 0, 0, "none", false);
-  this->template Add<BatchNorm>();
-  this->template Add<ReLU>();
+  this->template Add<ConvolutionLayerType>(64, 3, 3, 1, 1, 0, 0, "none", false);
+  this->template Add<BatchNormType<MatType>>();
+  this->template Add<ReLUType<MatType>>();
 
   Block(64, 128, 2, 2, false, true);
   Block(128, 256, 2, 2);
@@ -207,17 +207,17 @@ void XceptionType<MatType>::MakeModel()
   Block(728, 1024, 2, 2, true, false);
 
   SeparableConv(this, 1024, 1536, 3, 1, 1);
-  this->template Add<BatchNorm>();
-  this->template Add<ReLU>();
+  this->template Add<BatchNormType<MatType>>();
+  this->template Add<ReLUType<MatType>>();
 
   SeparableConv(this, 1536, 2048, 3, 1, 1);
-  this->template Add<BatchNorm>();
+  this->template Add<BatchNormType<MatType>>();
 
   if (includeTop)
   {
-    this->template Add<ReLU>();
-    this->template Add<AdaptiveMeanPooling>(1, 1);
-    this->template Add<Linear>(numClasses);
+    this->template Add<ReLUType<MatType>>();
+    this->template Add<AdaptiveMeanPoolingType<MatType>>(1, 1);
+    this->template Add<LinearType<MatType>>(numClasses);
   }
 }
 
@@ -28,6 +28,12 @@
 
 #define MLPACK_ENABLE_ANN_SERIALIZATION
 #include <mlpack.hpp>
+#include <layers/conv_bn_leaky_relu.hpp>
+#include <layers/downsample_pooling.hpp>
+#include <layers/fast_convolution.hpp>
+#include <loss_functions/yolo_loss.hpp>
+
+#include "./../../utils/weight_file.hpp"
 
 namespace mlpack {
 namespace models {
@@ -35,11 +41,16 @@ namespace models {
 /**
  * Definition of a YOLO object detection models.
  * 
+ * @tparam MatType Matrix representation to accept as input and use for
+ *    computation.
  * @tparam OutputLayerType The output layer type used to evaluate the network.
+ *     Defaults to YOLOLoss, which is configured with the grid of the model
+ *     and trains on the targets of PreProcessor::YOLOPreProcessor().
  * @tparam InitializationRuleType Rule used to initialize the weight matrix.
  */
 template<
-  typename OutputLayerType = NegativeLogLikelihood<>,
+  typename MatType = arma::mat,
+  typename OutputLayerType = YOLOLossType<MatType>,
   typename InitializationRuleType = RandomInitialization
 >
 class YOLO
@@ -60,8 +71,10 @@ class YOLO
    * @param numBoxes Number of bounding boxes per image.
    * @param featureSizeWidth Width of output feature map.
    * @param featureSizeHeight Height of output feature map.
-   * @param weights One of 'none', 'voc'(pre-training on VOC-2012) or path to weights.
-   * @param includeTop Must be set to true if weights are set.
+   * @param weights One of 'none', 'voc'(pre-training on VOC-2012) or path to weights;
+   *     a weight file saved with SaveWeights() is bound to the layers.
+   * @param includeTop Must be set to true if weights are set, unless they
+   *     are a weight file.
    */
   YOLO(const size_t inputChannel,
        const size_t inputWidth,
@@ -86,7 +99,8 @@ class YOLO
    * @param numBoxes Number of bounding boxes per image.
    * @param featureShape A twp-valued tuple indicating width and height of output feature
    *     map.
-   * @param weights One of 'none', 'voc'(pre-training on VOC) or path to weights.
+   * @param weights One of 'none', 'voc'(pre-training on VOC) or path to weights;
+   *     a weight file saved with SaveWeights() is bound to the layers.
    */
   YOLO(const std::tuple<size_t, size_t, size_t> inputShape,
        const std::string yoloVersion = "v1-tiny",
@@ -97,7 +111,10 @@ class YOLO
        const bool includeTop = true);
 
   //! Get Layers of the model.
-  FFN<OutputLayerType, InitializationRuleType>& GetModel() { return yolo; }
+  FFN<OutputLayerType, InitializationRuleType, MatType>& GetModel()
+  {
+    return yolo;
+  }
 
   //! Load weights into the model.
   void LoadModel(const std::string& filePath);
@@ -105,13 +122,20 @@ class YOLO
   //! Save weights for the model.
   void SaveModel(const std::string& filePath);
 
+  //! Map the given weight file and bind the model to it; the model may have
+  //! fewer layers than the file, e.g. if includeTop is false.
+  void LoadWeights(const std::string& filePath);
+
+  //! Save the weights of the model as a weight file.
+  void SaveWeights(const std::string& filePath);
+
  private:
+  //! The convolution type of the model, see FastConvolutionType.
+  typedef FastConvolutionType<MatType> ConvolutionLayerType;
+
   /**
    * Adds Convolution Block.
    *
-   * @tparam SequentialType Layer type in which convolution block will
-   *     be added.
-   *
    * @param inSize Number of input maps.
    * @param outSize Number of output maps.
    * @param kernelWidth Width of the filter/kernel.
@@ -121,11 +145,11 @@ class YOLO
    * @param padW Padding width of the input.
    * @param padH Padding height of the input.
    * @param batchNorm Boolean to determine whether a batch normalization
-   *     layer is added.
+   *     layer is added. The convolution, the normalization and the
+   *     activation are then computed by a single ConvBNLeakyReLU layer.
    * @param baseLayer Layer in which Convolution block will be added, if
    *     NULL added to YOLO FFN.
    */
-  template<typename SequentialType = Sequential<>>
   void ConvolutionBlock(const size_t inSize,
                         const size_t outSize,
                         const size_t kernelWidth,
@@ -135,12 +159,31 @@ class YOLO
                         const size_t padW = 0,
                         const size_t padH = 0,
                         const bool batchNorm = false,
-                        SequentialType* baseLayer = NULL)
+                        MultiLayer<MatType>* baseLayer = NULL)
   {
-    Sequential<>* bottleNeck = new Sequential<>();
-    bottleNeck->Add(new Convolution<>(inSize, outSize, kernelWidth,
-        kernelHeight, strideWidth, strideHeight, padW, padH, inputWidth,
-        inputHeight));
+    if (batchNorm)
+    {
+      // Convolution, batch normalization and activation in a single layer,
+      // which normalizes the output of the convolution in place.
+      ConvBNLeakyReLUType<MatType>* block = new ConvBNLeakyReLUType<MatType>(
+          outSize, kernelWidth, kernelHeight, strideWidth, strideHeight,
+          padW, padH, 1e-8, 0.1, 0.01);
+      if (baseLayer != NULL)
+        baseLayer->Add(block);
+      else
+        yolo.Add(block);
+    }
+    else
+    {
+      MultiLayer<MatType>* bottleNeck = new MultiLayer<MatType>();
+      bottleNeck->template Add<ConvolutionLayerType>(outSize, kernelWidth,
+          kernelHeight, strideWidth, strideHeight, padW, padH);
+      bottleNeck->template Add<LeakyReLUType<MatType>>(0.01);
+      if (baseLayer != NULL)
+        baseLayer->Add(bottleNeck);
+      else
+        yolo.Add(bottleNeck);
+    }
 
     mlpack::Log::Info << "Conv Layer.  ";
     mlpack::Log::Info << "(" << inputWidth << ", " << inputHeight <<
@@ -150,16 +193,20 @@ class YOLO
     inputHeight = ConvOutSize(inputHeight, kernelHeight, strideHeight, padH);
     mlpack::Log::Info << "(" << inputWidth << ", " << inputHeight <<
         ", " << outSize << ")" << std::endl;
+  }
 
-    if (batchNorm)
-      bottleNeck->Add(new BatchNorm<>(outSize, 1e-8, false));
-
-    bottleNeck->Add(new LeakyReLU<>(0.01));
-
-    if (baseLayer != NULL)
-      baseLayer->Add(bottleNeck);
+  //! Create the output layer, a YOLOLoss is configured for the model.
+  OutputLayerType CreateOutputLayer() const
+  {
+    if constexpr (IsYOLOLoss<OutputLayerType>::value)
+    {
+      return OutputLayerType(featureWidth, featureHeight, numBoxes,
+          numClasses);
+    }
     else
-      yolo.Add(bottleNeck);
+    {
+      return OutputLayerType();
+    }
   }
 
   /**
@@ -172,16 +219,23 @@ class YOLO
   void PoolingBlock(const size_t factor = 2,
                     const std::string type = "max")
   {
-    if (type == "max")
+    if (factor == 2)
+    {
+      // Same windows as the adaptive pooling layers, with a specialized
+      // kernel for the 2 x 2 windows of even sizes.
+      yolo.template Add<DownsamplePoolingType<MatType>>(type == "max");
+    }
+    else if (type == "max")
     {
-      yolo.Add(new AdaptiveMaxPooling<>(
+      yolo.template Add<AdaptiveMaxPoolingType<MatType>>(
           std::ceil(inputWidth * 1.0 / factor),
-          std::ceil(inputHeight * 1.0 / factor)));
+          std::ceil(inputHeight * 1.0 / factor));
     }
     else
     {
-      yolo.Add(new AdaptiveMeanPooling<>(std::ceil(inputWidth * 1.0 /
-          factor), std::ceil(inputHeight * 1.0 / factor)));
+      yolo.template Add<AdaptiveMeanPoolingType<MatType>>(
+          std::ceil(inputWidth * 1.0 / factor),
+          std::ceil(inputHeight * 1.0 / factor));
     }
 
     mlpack::Log::Info << "Pooling Layer.  ";
@@ -213,7 +267,7 @@ class YOLO
   }
 
   //! Locally stored YOLO Model.
-  FFN<OutputLayerType, InitializationRuleType> yolo;
+  FFN<OutputLayerType, InitializationRuleType, MatType> yolo;
 
   //! Locally stored number of channels in the image.
   size_t inputChannel;
@@ -241,6 +295,9 @@ class YOLO
 
   //! Locally stored version of yolo model.
   std::string yoloVersion;
+
+  //! Locally stored weight file the model is bound to.
+  std::shared_ptr<WeightFile<MatType>> weightFile;
 }; // YOLO class.
 
 } // namespace models
@@ -18,10 +18,11 @@ namespace mlpack {
 namespace models {
 
 template<
+    typename MatType,
     typename OutputLayerType,
     typename InitializationRuleType
 >
-YOLO<OutputLayerType, InitializationRuleType>::YOLO() :
+YOLO<MatType, OutputLayerType, InitializationRuleType>::YOLO() :
     inputChannel(0),
     inputWidth(0),
     inputHeight(0),
@@ -36,10 +37,11 @@ YOLO<OutputLayerType, InitializationRuleType>::YOLO() :
 }
 
 template<
+    typename MatType,
     typename OutputLayerType,
     typename InitializationRuleType
 >
-YOLO<OutputLayerType, InitializationRuleType>::YOLO(
+YOLO<MatType, OutputLayerType, InitializationRuleType>::YOLO(
   const size_t inputChannel,
   const size_t inputWidth,
   const size_t inputHeight,
@@ -50,7 +52,7 @@ YOLO<OutputLayerType, InitializationRuleType>::YOLO(
   const size_t featureHeight,
   const std::string& weights,
   const bool includeTop) :
-  YOLO<OutputLayerType, InitializationRuleType>(
+  YOLO<MatType, OutputLayerType, InitializationRuleType>(
     std::tuple<size_t, size_t, size_t>(
       inputChannel,
       inputWidth,
@@ -66,10 +68,11 @@ YOLO<OutputLayerType, InitializationRuleType>::YOLO(
 }
 
 template<
+    typename MatType,
     typename OutputLayerType,
     typename InitializationRuleType
 >
-YOLO<OutputLayerType, InitializationRuleType>::YOLO(
+YOLO<MatType, OutputLayerType, InitializationRuleType>::YOLO(
     const std::tuple<size_t, size_t, size_t> inputShape,
     const std::string yoloVersion,
     const size_t numClasses,
@@ -97,7 +100,7 @@ YOLO<OutputLayerType, InitializationRuleType>::YOLO(
     LoadModel("./../weights/YOLO/yolo" + yoloVersion + "_voc.bin");
     return;
   }
-  else if (weights != "none")
+  else if (weights != "none" && !WeightFile<MatType>::IsWeightFile(weights))
   {
     LoadModel(weights);
     return;
@@ -105,7 +108,11 @@ YOLO<OutputLayerType, InitializationRuleType>::YOLO(
 
   if (yoloVersion == "v1-tiny")
   {
-    yolo.Add(new IdentityLayer<>());
+    yolo = FFN<OutputLayerType, InitializationRuleType, MatType>(
+        CreateOutputLayer());
+    yolo.InputDimensions() = std::vector<size_t>({inputWidth, inputHeight,
+        inputChannel});
+    yolo.template Add<IdentityType<MatType>>();
 
     // Convolution and activation function in a block.
     ConvolutionBlock(inputChannel, 16, 3, 3, 1, 1, 1, 1, true);
@@ -127,21 +134,26 @@ YOLO<OutputLayerType, InitializationRuleType>::YOLO(
 
     if (includeTop)
     {
-      yolo.Add(new Linear<>(inputWidth * inputHeight * outChannels,
-          featureWidth * featureHeight * (5 * numBoxes + numClasses)));
-      yolo.Add(new SigmoidLayer<>());
+      yolo.template Add<LinearType<MatType>>(
+          featureWidth * featureHeight * (5 * numBoxes + numClasses));
+      yolo.template Add<SigmoidType<MatType>>();
     }
-
-    yolo.ResetParameters();
   }
+
+  // Bind the weights of a weight file or reset parameters for a new network.
+  if (weights != "none")
+    LoadWeights(weights);
+  else
+    yolo.Reset();
 }
 
 template<
+    typename MatType,
     typename OutputLayerType,
     typename InitializationRuleType
 >
 void YOLO<
-    OutputLayerType, InitializationRuleType
+    MatType, OutputLayerType, InitializationRuleType
 >::LoadModel(const std::string& filePath)
 {
   data::Load(filePath, "yolo" + yoloVersion, yolo);
@@ -149,11 +161,12 @@ void YOLO<
 }
 
 template<
+    typename MatType,
     typename OutputLayerType,
     typename InitializationRuleType
 >
 void YOLO<
-    OutputLayerType, InitializationRuleType
+    MatType, OutputLayerType, InitializationRuleType
 >::SaveModel(const std::string& filePath)
 {
   Log::Info<< "Saving model." << std::endl;
@@ -161,6 +174,34 @@ void YOLO<
   Log::Info << "Model saved in " << filePath << "." << std::endl;
 }
 
+template<
+    typename MatType,
+    typename OutputLayerType,
+    typename InitializationRuleType
+>
+void YOLO<
+    MatType, OutputLayerType, InitializationRuleType
+>::LoadWeights(const std::string& filePath)
+{
+  weightFile = std::make_shared<WeightFile<MatType>>(filePath);
+  const size_t layers = weightFile->Bind(yolo);
+  Log::Info << "Bound " << layers << " layers to " << filePath << "."
+      << std::endl;
+}
+
+template<
+    typename MatType,
+    typename OutputLayerType,
+    typename InitializationRuleType
+>
+void YOLO<
+    MatType, OutputLayerType, InitializationRuleType
+>::SaveWeights(const std::string& filePath)
+{
+  WeightFile<MatType>::Save(filePath, yolo);
+  Log::Info << "Weights saved in " << filePath << "." << std::endl;
+}
+
 } // namespace models
 } // namespace mlpack
 
@@ -0,0 +1,214 @@
+/**
+ * @file yolo_postprocessor.hpp
+ * @author Kartik Dutt
+ *
+ * Definition of YOLOPostProcessor class which turns the output of YOLO
+ * models into detections.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_MODELS_YOLO_YOLO_POSTPROCESSOR_HPP
+#define MODELS_MODELS_YOLO_YOLO_POSTPROCESSOR_HPP
+
+#include <mlpack.hpp>
+
+namespace mlpack {
+namespace models {
+
+/**
+ * Decodes the output grid of a YOLO model into scored boxes and removes
+ * overlapping boxes with class-wise non-maximum suppression.
+ *
+ * Decoding is the inverse of PreProcessor::YOLOPreProcessor(): every column
+ * of the output is the grid of an image, element s of cell c is stored at
+ * row c + s * gridWidth * gridHeight. The score of a box is its confidence
+ * times the probability of its most likely class, boxes below the score
+ * threshold are dropped. Each image's detections form a matrix with one
+ * column per box holding (class, x1, y1, x2, y2, score) in pixels, i.e. the
+ * annotation layout of the DataLoader with the score appended.
+ *
+ * Suppression sorts the boxes of an image by score and, for every class,
+ * greedily keeps the best remaining box and removes the boxes overlapping it
+ * by more than the IoU threshold. The overlaps of a kept box with all lower
+ * scored boxes are computed in a single SIMD friendly loop over structure of
+ * arrays coordinates. With bucketing enabled, boxes are additionally sorted
+ * into a uniform grid of buckets, so a kept box is only compared with boxes
+ * in the buckets it covers, which keeps suppression far below quadratic time
+ * for thousands of boxes. Images are processed in parallel.
+ *
+ * @code
+ * YOLOPostProcessor postProcessor(1, 448, 448, 7, 7, 2, 20);
+ * arma::field<arma::mat> detections;
+ * postProcessor.Apply(output, detections);
+ * @endcode
+ */
+class YOLOPostProcessor
+{
+ public:
+  /**
+   * Create the post processor.
+   *
+   * @param version Version of YOLO.
+   * @param imageWidth Width of image used for the YOLO model.
+   * @param imageHeight Height of image used for the YOLO model.
+   * @param gridWidth Width of output feature map of YOLO model.
+   * @param gridHeight Height of output feature map of YOLO model.
+   * @param numBoxes Number of bounding boxes per grid.
+   * @param numClasses Number of classes.
+   * @param scoreThreshold Boxes with a lower score are dropped.
+   * @param iouThreshold Boxes overlapping a better box of the same class by
+   *     more than this IoU are removed.
+   * @param bucketed Whether to bucket boxes by position during suppression.
+   * @param normalize Whether the centres are relative to the cell, as
+   *     YOLOPreProcessor creates them with normalize set to true.
+   */
+  YOLOPostProcessor(const size_t version = 1,
+                    const size_t imageWidth = 224,
+                    const size_t imageHeight = 224,
+                    const size_t gridWidth = 7,
+                    const size_t gridHeight = 7,
+                    const size_t numBoxes = 2,
+                    const size_t numClasses = 20,
+                    const double scoreThreshold = 0.25,
+                    const double iouThreshold = 0.45,
+                    const bool bucketed = false,
+                    const bool normalize = true);
+
+  /**
+   * Decode the output of a YOLO model and suppress overlapping boxes.
+   *
+   * @param output Output of the model, each column is an image.
+   * @param detections Set to the detections of each image, sorted by score.
+   */
+  template<typename eT>
+  void Apply(const arma::Mat<eT>& output,
+             arma::field<arma::Mat<eT>>& detections) const;
+
+  /**
+   * Decode the output of a YOLO model into scored boxes.
+   *
+   * @param output Output of the model, each column is an image.
+   * @param detections Set to the detections of each image.
+   */
+  template<typename eT>
+  void Decode(const arma::Mat<eT>& output,
+              arma::field<arma::Mat<eT>>& detections) const;
+
+  /**
+   * Suppress overlapping boxes of every image.
+   *
+   * @param detections Detections of each image, set to the kept detections
+   *     sorted by score.
+   */
+  template<typename eT>
+  void Suppress(arma::field<arma::Mat<eT>>& detections) const;
+
+  /**
+   * Suppress overlapping boxes of a single image.
+   *
+   * @param detections Detections of the image, set to the kept detections
+   *     sorted by score.
+   */
+  template<typename eT>
+  void Suppress(arma::Mat<eT>& detections) const;
+
+  //! Get the score threshold.
+  double ScoreThreshold() const { return scoreThreshold; }
+  //! Modify the score threshold.
+  double& ScoreThreshold() { return scoreThreshold; }
+
+  //! Get the IoU threshold.
+  double IoUThreshold() const { return iouThreshold; }
+  //! Modify the IoU threshold.
+  double& IoUThreshold() { return iouThreshold; }
+
+  //! Get whether boxes are bucketed during suppression.
+  bool Bucketed() const { return bucketed; }
+  //! Modify whether boxes are bucketed during suppression.
+  bool& Bucketed() { return bucketed; }
+
+ private:
+  //! Index of the first element of the given box of a cell.
+  size_t BoxOffset(const size_t box) const
+  {
+    return (version == 1) ? 5 * box : (5 + numClasses) * box;
+  }
+
+  //! Index of the first class probability of the given box of a cell.
+  size_t ClassOffset(const size_t box) const
+  {
+    return (version == 1) ? 5 * numBoxes : BoxOffset(box) + 5;
+  }
+
+  /**
+   * Suppress the boxes [begin, end) of a single class, which are sorted by
+   * score, by comparing every kept box with all boxes after it.
+   */
+  template<typename eT>
+  void SuppressAll(const size_t begin,
+                   const size_t end,
+                   const eT* x1,
+                   const eT* y1,
+                   const eT* x2,
+                   const eT* y2,
+                   const eT* area,
+                   unsigned char* removed) const;
+
+  /**
+   * Suppress the boxes [begin, end) of a single class, which are sorted by
+   * score, by comparing every kept box only with boxes in the buckets it
+   * covers.
+   */
+  template<typename eT>
+  void SuppressBucketed(const size_t begin,
+                        const size_t end,
+                        const eT* x1,
+                        const eT* y1,
+                        const eT* x2,
+                        const eT* y2,
+                        const eT* area,
+                        unsigned char* removed) const;
+
+  //! Locally stored version of YOLO.
+  size_t version;
+
+  //! Locally stored width of the image.
+  size_t imageWidth;
+
+  //! Locally stored height of the image.
+  size_t imageHeight;
+
+  //! Locally stored width of the output feature map.
+  size_t gridWidth;
+
+  //! Locally stored height of the output feature map.
+  size_t gridHeight;
+
+  //! Locally stored number of bounding boxes per grid.
+  size_t numBoxes;
+
+  //! Locally stored number of classes.
+  size_t numClasses;
+
+  //! Locally stored score threshold.
+  double scoreThreshold;
+
+  //! Locally stored IoU threshold.
+  double iouThreshold;
+
+  //! Locally stored value of whether boxes are bucketed.
+  bool bucketed;
+
+  //! Locally stored value of whether centres are relative to the cell.
+  bool normalize;
+};
+
+} // namespace models
+} // namespace mlpack
+
+#include "yolo_postprocessor_impl.hpp" // Include implementation.
+
+#endif
@@ -0,0 +1,382 @@
+/**
+ * @file yolo_postprocessor_impl.hpp
+ * @author Kartik Dutt
+ *
+ * Implementation of YOLOPostProcessor class which turns the output of YOLO
+ * models into detections.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_MODELS_YOLO_YOLO_POSTPROCESSOR_IMPL_HPP
+#define MODELS_MODELS_YOLO_YOLO_POSTPROCESSOR_IMPL_HPP
+
+// Incase it has not been included already.
+#include "yolo_postprocessor.hpp"
+
+namespace mlpack {
+namespace models {
+
+inline YOLOPostProcessor::YOLOPostProcessor(const size_t version,
+                                            const size_t imageWidth,
+                                            const size_t imageHeight,
+                                            const size_t gridWidth,
+                                            const size_t gridHeight,
+                                            const size_t numBoxes,
+                                            const size_t numClasses,
+                                            const double scoreThreshold,
+                                            const double iouThreshold,
+                                            const bool bucketed,
+                                            const bool normalize) :
+    version(version),
+    imageWidth(imageWidth),
+    imageHeight(imageHeight),
+    gridWidth(gridWidth),
+    gridHeight(gridHeight),
+    numBoxes(numBoxes),
+    numClasses(numClasses),
+    scoreThreshold(scoreThreshold),
+    iouThreshold(iouThreshold),
+    bucketed(bucketed),
+    normalize(normalize)
+{
+  mlpack::Log::Assert(version >= 1 && version <= 3, "Supported YOLO versions "
+      "are version 1 to version 3.");
+}
+
+template<typename eT>
+void YOLOPostProcessor::Apply(const arma::Mat<eT>& output,
+                              arma::field<arma::Mat<eT>>& detections) const
+{
+  Decode(output, detections);
+  Suppress(detections);
+}
+
+template<typename eT>
+void YOLOPostProcessor::Decode(const arma::Mat<eT>& output,
+                               arma::field<arma::Mat<eT>>& detections) const
+{
+  const size_t gridSize = gridWidth * gridHeight;
+  const size_t numPredictions = (version == 1) ?
+      5 * numBoxes + numClasses : numBoxes * (5 + numClasses);
+  if (output.n_rows != gridSize * numPredictions)
+  {
+    mlpack::Log::Fatal << "YOLOPostProcessor: output has " << output.n_rows
+        << " rows, expected " << gridWidth << " x " << gridHeight
+        << " cells x " << numPredictions << " values." << std::endl;
+  }
+
+  detections.set_size(1, output.n_cols);
+
+  #pragma omp parallel
+  {
+    // Best class and its probability of each cell.
+    std::vector<eT> probability(gridSize), score(gridSize);
+    std::vector<size_t> label(gridSize);
+    std::vector<eT> boxes;
+
+    #pragma omp for schedule(static)
+    for (omp_size_t i = 0; i < (omp_size_t) output.n_cols; ++i)
+    {
+      const eT* column = output.colptr(i);
+      boxes.clear();
+
+      for (size_t b = 0; b < numBoxes; ++b)
+      {
+        // The classes of YOLO v1 are shared by all boxes of a cell.
+        if (b == 0 || version > 1)
+        {
+          const eT* classes = column + ClassOffset(b) * gridSize;
+          std::fill(probability.begin(), probability.end(),
+              -std::numeric_limits<eT>::max());
+          for (size_t k = 0; k < numClasses; ++k)
+          {
+            const eT* plane = classes + k * gridSize;
+            for (size_t c = 0; c < gridSize; ++c)
+            {
+              if (plane[c] > probability[c])
+              {
+                probability[c] = plane[c];
+                label[c] = k;
+              }
+            }
+          }
+        }
+
+        const eT* box = column + BoxOffset(b) * gridSize;
+        const eT* confidence = box + 4 * gridSize;
+        #pragma omp simd
+        for (size_t c = 0; c < gridSize; ++c)
+          score[c] = confidence[c] * probability[c];
+
+        for (size_t c = 0; c < gridSize; ++c)
+        {
+          if (score[c] < scoreThreshold)
+            continue;
+
+          // Cells are ordered as in YOLOPreProcessor.
+          double centreX = box[c];
+          double centreY = box[c + gridSize];
+          if (normalize)
+          {
+            centreX = (c % gridHeight + centreX) / gridWidth;
+            centreY = (c / gridHeight + centreY) / gridHeight;
+          }
+
+          const double halfWidth = box[c + 2 * gridSize] / 2.0;
+          const double halfHeight = box[c + 3 * gridSize] / 2.0;
+          const double x1 = std::max(centreX - halfWidth, 0.0);
+          const double y1 = std::max(centreY - halfHeight, 0.0);
+          const double x2 = std::min(centreX + halfWidth, 1.0);
+          const double y2 = std::min(centreY + halfHeight, 1.0);
+
+          boxes.insert(boxes.end(), {(eT) label[c], (eT) (x1 * imageWidth),
+              (eT) (y1 * imageHeight), (eT) (x2 * imageWidth),
+              (eT) (y2 * imageHeight), score[c]});
+        }
+      }
+
+      detections(0, i) = arma::Mat<eT>(boxes.data(), 6, boxes.size() / 6);
+    }
+  }
+}
+
+template<typename eT>
+void YOLOPostProcessor::Suppress(arma::field<arma::Mat<eT>>& detections) const
+{
+  #pragma omp parallel for schedule(dynamic)
+  for (omp_size_t i = 0; i < (omp_size_t) detections.n_elem; ++i)
+    Suppress(detections(i));
+}
+
+template<typename eT>
+void YOLOPostProcessor::Suppress(arma::Mat<eT>& detections) const
+{
+  if (detections.n_cols == 0)
+    return;
+
+  if (detections.n_rows != 6)
+  {
+    mlpack::Log::Fatal << "YOLOPostProcessor: detections must have 6 rows "
+        << "(class, x1, y1, x2, y2, score), found " << detections.n_rows
+        << "." << std::endl;
+  }
+
+  // Sort by class and by score within each class.
+  const size_t n = detections.n_cols;
+  std::vector<size_t> order(n);
+  for (size_t i = 0; i < n; ++i)
+    order[i] = i;
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+      {
+        if (detections(0, a) != detections(0, b))
+          return detections(0, a) < detections(0, b);
+        return detections(5, a) > detections(5, b);
+      });
+
+  // Structure of arrays coordinates in sorted order.
+  std::vector<eT> x1(n), y1(n), x2(n), y2(n), area(n);
+  for (size_t i = 0; i < n; ++i)
+  {
+    const eT* detection = detections.colptr(order[i]);
+    x1[i] = detection[1];
+    y1[i] = detection[2];
+    x2[i] = detection[3];
+    y2[i] = detection[4];
+    area[i] = std::max(x2[i] - x1[i], eT(0)) * std::max(y2[i] - y1[i], eT(0));
+  }
+
+  // Bucketing only pays off once a class has enough boxes.
+  const size_t minBucketedBoxes = 64;
+  std::vector<unsigned char> removed(n, 0);
+  for (size_t begin = 0; begin < n; )
+  {
+    size_t end = begin + 1;
+    while (end < n && detections(0, order[end]) == detections(0, order[begin]))
+      ++end;
+
+    if (bucketed && end - begin >= minBucketedBoxes)
+    {
+      SuppressBucketed(begin, end, x1.data(), y1.data(), x2.data(), y2.data(),
+          area.data(), removed.data());
+    }
+    else
+    {
+      SuppressAll(begin, end, x1.data(), y1.data(), x2.data(), y2.data(),
+          area.data(), removed.data());
+    }
+
+    begin = end;
+  }
+
+  std::vector<size_t> kept;
+  for (size_t i = 0; i < n; ++i)
+  {
+    if (!removed[i])
+      kept.push_back(order[i]);
+  }
+
+  std::stable_sort(kept.begin(), kept.end(), [&](size_t a, size_t b)
+      {
+        return detections(5, a) > detections(5, b);
+      });
+
+  arma::Mat<eT> result(6, kept.size());
+  for (size_t i = 0; i < kept.size(); ++i)
+  {
+    const eT* detection = detections.colptr(kept[i]);
+    std::copy(detection, detection + 6, result.colptr(i));
+  }
+
+  detections = std::move(result);
+}
+
+template<typename eT>
+void YOLOPostProcessor::SuppressAll(const size_t begin,
+                                    const size_t end,
+                                    const eT* x1,
+                                    const eT* y1,
+                                    const eT* x2,
+                                    const eT* y2,
+                                    const eT* area,
+                                    unsigned char* removed) const
+{
+  // IoU > t is tested as intersection > t * union to avoid the division.
+  const eT threshold = iouThreshold;
+  for (size_t i = begin; i < end; ++i)
+  {
+    if (removed[i])
+      continue;
+
+    const eT ax1 = x1[i], ay1 = y1[i], ax2 = x2[i], ay2 = y2[i];
+    const eT aArea = area[i];
+    #pragma omp simd
+    for (size_t j = i + 1; j < end; ++j)
+    {
+      const eT width = std::max(std::min(ax2, x2[j]) - std::max(ax1, x1[j]),
+          eT(0));
+      const eT height = std::max(std::min(ay2, y2[j]) -
+          std::max(ay1, y1[j]), eT(0));
+      const eT intersection = width * height;
+      removed[j] |= (intersection > threshold * (aArea + area[j] -
+          intersection));
+    }
+  }
+}
+
+template<typename eT>
+void YOLOPostProcessor::SuppressBucketed(const size_t begin,
+                                         const size_t end,
+                                         const eT* x1,
+                                         const eT* y1,
+                                         const eT* x2,
+                                         const eT* y2,
+                                         const eT* area,
+                                         unsigned char* removed) const
+{
+  const size_t n = end - begin;
+
+  // Buckets are about as large as the average box, but there are never many
+  // more buckets than boxes.
+  eT minX = x1[begin], minY = y1[begin], maxX = x2[begin], maxY = y2[begin];
+  double meanWidth = 0.0, meanHeight = 0.0;
+  for (size_t i = begin; i < end; ++i)
+  {
+    minX = std::min(minX, x1[i]);
+    minY = std::min(minY, y1[i]);
+    maxX = std::max(maxX, x2[i]);
+    maxY = std::max(maxY, y2[i]);
+    meanWidth += x2[i] - x1[i];
+    meanHeight += y2[i] - y1[i];
+  }
+
+  const double extentX = std::max((double) (maxX - minX), 1e-6);
+  const double extentY = std::max((double) (maxY - minY), 1e-6);
+  const size_t maxBuckets = std::max((size_t) std::sqrt((double) n),
+      (size_t) 1);
+  const size_t bucketsX = std::min(std::max((size_t) (extentX /
+      std::max(meanWidth / n, 1e-6)), (size_t) 1), maxBuckets);
+  const size_t bucketsY = std::min(std::max((size_t) (extentY /
+      std::max(meanHeight / n, 1e-6)), (size_t) 1), maxBuckets);
+
+  // Range of buckets covered by a box.
+  auto range = [&](const size_t i, size_t& bx1, size_t& by1, size_t& bx2,
+      size_t& by2)
+  {
+    auto bucket = [](const double position, const double extent,
+        const size_t buckets)
+    {
+      return std::min((size_t) std::max(position / extent * buckets, 0.0),
+          buckets - 1);
+    };
+
+    bx1 = bucket(x1[i] - minX, extentX, bucketsX);
+    bx2 = bucket(x2[i] - minX, extentX, bucketsX);
+    by1 = bucket(y1[i] - minY, extentY, bucketsY);
+    by2 = bucket(y2[i] - minY, extentY, bucketsY);
+  };
+
+  // Boxes of each bucket in score order, stored contiguously.
+  std::vector<size_t> starts(bucketsX * bucketsY + 1, 0);
+  size_t bx1, by1, bx2, by2;
+  for (size_t i = begin; i < end; ++i)
+  {
+    range(i, bx1, by1, bx2, by2);
+    for (size_t y = by1; y <= by2; ++y)
+      for (size_t x = bx1; x <= bx2; ++x)
+        starts[x + y * bucketsX + 1]++;
+  }
+
+  for (size_t b = 1; b < starts.size(); ++b)
+    starts[b] += starts[b - 1];
+
+  std::vector<size_t> members(starts.back());
+  std::vector<size_t> filled(starts.begin(), starts.end() - 1);
+  for (size_t i = begin; i < end; ++i)
+  {
+    range(i, bx1, by1, bx2, by2);
+    for (size_t y = by1; y <= by2; ++y)
+      for (size_t x = bx1; x <= bx2; ++x)
+        members[filled[x + y * bucketsX]++] = i;
+  }
+
+  const eT threshold = iouThreshold;
+  for (size_t i = begin; i < end; ++i)
+  {
+    if (removed[i])
+      continue;
+
+    range(i, bx1, by1, bx2, by2);
+    for (size_t y = by1; y <= by2; ++y)
+    {
+      for (size_t x = bx1; x <= bx2; ++x)
+      {
+        const size_t b = x + y * bucketsX;
+        // Only boxes with a lower score than box i.
+        const size_t* first = std::upper_bound(members.data() + starts[b],
+            members.data() + starts[b + 1], i);
+        const size_t* last = members.data() + starts[b + 1];
+        for (const size_t* j = first; j != last; ++j)
+        {
+          if (removed[*j])
+            continue;
+
+          const eT width = std::max(std::min(x2[i], x2[*j]) -
+              std::max(x1[i], x1[*j]), eT(0));
+          const eT height = std::max(std::min(y2[i], y2[*j]) -
+              std::max(y1[i], y1[*j]), eT(0));
+          const eT intersection = width * height;
+          removed[*j] = (intersection > threshold * (area[i] + area[*j] -
+              intersection));
+        }
+      }
+    }
+  }
+}
+
+} // namespace models
+} // namespace mlpack
+
+#endif
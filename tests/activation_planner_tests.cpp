@@ -0,0 +1,102 @@
+/**
+ * @file activation_planner_tests.cpp
+ * @author Kartik Dutt
+ *
+ * Tests for the ActivationPlanner.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#define MLPACK_ENABLE_ANN_SERIALIZATION
+#include <mlpack.hpp>
+#include <models/resnet/resnet.hpp>
+#include <models/squeezenet/squeezenet.hpp>
+#include <utils/activation_planner.hpp>
+#include "catch.hpp"
+
+using namespace mlpack;
+using namespace mlpack::models;
+
+/**
+ * Check that the planned inference of a network with residual blocks and
+ * concatenated branches predicts the same as the network, with fewer
+ * activations than the network keeps.
+ */
+TEST_CASE("ActivationPlannerBranchesTest", "[ActivationPlannerTest]")
+{
+  FFN<CrossEntropyError, RandomInitialization> model;
+  model.InputDimensions() = std::vector<size_t>({8, 8, 3});
+  model.Add<Convolution>(8, 3, 3, 1, 1, 1, 1);
+  model.Add<ReLU>();
+  for (size_t i = 0; i < 4; ++i)
+  {
+    AddMerge* merge = new AddMerge();
+    MultiLayer<arma::mat>* branch = new MultiLayer<arma::mat>();
+    branch->Add<Convolution>(8, 3, 3, 1, 1, 1, 1);
+    branch->Add<BatchNorm>();
+    branch->Add<ReLU>();
+    branch->Add<Convolution>(8, 3, 3, 1, 1, 1, 1);
+    merge->Add(branch);
+    merge->Add<Identity>();
+    model.Add(merge);
+    model.Add<ReLU>();
+  }
+
+  Concat* concat = new Concat(2);
+  concat->Add<Convolution>(4, 1, 1);
+  concat->Add<Convolution>(6, 3, 3, 1, 1, 1, 1);
+  model.Add(concat);
+  model.Add<Linear>(5);
+  model.Add<LogSoftMax>();
+  model.Reset();
+  model.Parameters().randn();
+
+  arma::mat input(8 * 8 * 3, 20, arma::fill::randu);
+  arma::mat output;
+  model.Predict(input, output);
+
+  // The batches are smaller than the input, so the buffers are reused.
+  ActivationPlanner<> planner(model);
+  arma::mat plannedOutput;
+  planner.Predict(input, plannedOutput, 8);
+
+  REQUIRE(plannedOutput.n_rows == output.n_rows);
+  REQUIRE(plannedOutput.n_cols == output.n_cols);
+  REQUIRE(arma::approx_equal(plannedOutput, output, "absdiff", 1e-10));
+
+  // The input of a block, the output of its branch and a layer of the branch
+  // are live at once.
+  REQUIRE(planner.Buffers() <= 3);
+  REQUIRE(planner.PlannedSize() < planner.TotalSize() / 4);
+}
+
+/**
+ * Check that the planned inference of ResNet and SqueezeNet predicts the same
+ * as the models.
+ */
+TEST_CASE("ActivationPlannerModelsTest", "[ActivationPlannerTest]")
+{
+  arma::mat input(64 * 64 * 3, 2, arma::fill::randu);
+  arma::mat output, plannedOutput;
+
+  ResNet18 resNet(3, 64, 64, true, false, 10);
+  resNet.GetModel().Predict(input, output);
+  ActivationPlanner<> resNetPlanner(resNet.GetModel());
+  resNetPlanner.Predict(input, plannedOutput);
+
+  REQUIRE(arma::approx_equal(plannedOutput, output, "absdiff", 1e-8));
+  REQUIRE(resNetPlanner.PlannedSize() < resNetPlanner.TotalSize() / 4);
+
+  FFN<CrossEntropyError, RandomInitialization> squeezeNet;
+  squeezeNet.Add<SqueezeNet1>(10, true);
+  squeezeNet.InputDimensions() = std::vector<size_t>({64, 64, 3});
+  squeezeNet.Reset();
+  squeezeNet.Predict(input, output);
+  ActivationPlanner<> squeezeNetPlanner(squeezeNet);
+  squeezeNetPlanner.Predict(input, plannedOutput);
+
+  REQUIRE(arma::approx_equal(plannedOutput, output, "absdiff", 1e-8));
+  REQUIRE(squeezeNetPlanner.PlannedSize() < squeezeNetPlanner.TotalSize());
+}
@@ -10,6 +10,7 @@
  * http://www.opensource.org/licenses/BSD-3-Clause for more information.
  */
 #include <augmentation/augmentation.hpp>
+#include <augmentation/box_augmentation.hpp>
 #include "catch.hpp"
 
 using namespace mlpack::models;
@@ -51,3 +52,339 @@ TEST_CASE("ResizeAugmentationTest", "[AugmentationTest]")
   REQUIRE(input.n_cols == 2);
   REQUIRE(input.n_rows == 8 * 8);
 }
+
+/**
+ * Check that resizing the dataset in chunks, in the memory of the dataset or
+ * into a larger matrix, gives the result of the resize kernel.
+ */
+TEST_CASE("ResizeAugmentationChunkTest", "[AugmentationTest]")
+{
+  BilinearResizeKernel kernel;
+  arma::mat input(6 * 5 * 3, 7, arma::fill::randu);
+  arma::mat smaller, larger;
+  kernel.Resize(input, smaller, 6, 5, 3, 4, 3, true);
+  kernel.Resize(input, larger, 6, 5, 3, 9, 8, true);
+
+  // A scratch buffer of a single byte resizes one data point at a time.
+  for (const size_t scratchSize : { (size_t) 1, (size_t) 1000000 })
+  {
+    arma::mat dataset = input;
+    size_t width = 6, height = 5;
+    ResizeAugmentation(4, 3, scratchSize).Transform(dataset, width, height,
+        3);
+    REQUIRE(width == 4);
+    REQUIRE(height == 3);
+    REQUIRE(arma::approx_equal(dataset, smaller, "absdiff", 1e-12));
+
+    dataset = input;
+    width = 6;
+    height = 5;
+    ResizeAugmentation(9, 8, scratchSize).Transform(dataset, width, height,
+        3);
+    REQUIRE(arma::approx_equal(dataset, larger, "absdiff", 1e-12));
+  }
+
+  // Eight bit images are resized in their memory as well.
+  arma::Mat<unsigned char> images = arma::randi<arma::Mat<unsigned char>>(
+      6 * 5 * 3, 7, arma::distr_param(0, 255));
+  arma::Mat<unsigned char> expected;
+  kernel.Resize(images, expected, 6, 5, 3, 4, 3, true);
+  size_t width = 6, height = 5;
+  ResizeAugmentation(4, 3, 100).Transform(images, width, height, 3);
+  REQUIRE(arma::all(arma::vectorise(images == expected)));
+}
+
+TEST_CASE("InvalidAugmentationTest", "[AugmentationTest]")
+{
+  // Unknown augmentations are rejected when the object is created.
+  REQUIRE_THROWS_AS(Augmentation(std::vector<std::string>(1,
+      "random-erase"), 0.2), std::runtime_error);
+
+  // Resize requires a valid size.
+  REQUIRE_THROWS_AS(Augmentation(std::vector<std::string>(1,
+      "resize"), 0.2), std::runtime_error);
+  REQUIRE_THROWS_AS(Augmentation(std::vector<std::string>(1,
+      "resize = (0, 4)"), 0.2), std::runtime_error);
+
+  // Random augmentations require valid parameters.
+  REQUIRE_THROWS_AS(Augmentation(std::vector<std::string>(1,
+      "rotation = 270"), 0.2), std::runtime_error);
+  REQUIRE_THROWS_AS(Augmentation(std::vector<std::string>(1,
+      "brightness = 1.5"), 0.2), std::runtime_error);
+  REQUIRE_THROWS_AS(Augmentation(std::vector<std::string>(1,
+      "random-crop"), 0.2), std::runtime_error);
+
+  // Resize is kept apart from the random augmentations.
+  Augmentation augmentation({"vertical-flip", "resize = {8, 6}",
+      "rotation = 15", "random-crop = (4, 4)", "contrast = 0.2"}, 0.2);
+  REQUIRE(augmentation.HasResize());
+  REQUIRE(augmentation.Operations().size() == 4);
+}
+
+TEST_CASE("FlipAugmentationTest", "[AugmentationTest]")
+{
+  // A single 3 x 2 data point with 2 channels, stored pixel by pixel.
+  arma::mat input = arma::regspace(0, 11);
+  arma::mat flipped = input;
+
+  Augmentation horizontalFlip({"horizontal-flip"}, 1.0);
+  horizontalFlip.Transform(flipped, 3, 2, 2);
+
+  arma::vec desired = {4, 5, 2, 3, 0, 1, 10, 11, 8, 9, 6, 7};
+  REQUIRE(arma::approx_equal(flipped, desired, "absdiff", 1e-10));
+
+  flipped = input;
+  Augmentation verticalFlip({"vertical-flip"}, 1.0);
+  verticalFlip.Transform(flipped, 3, 2, 2);
+
+  desired = {6, 7, 8, 9, 10, 11, 0, 1, 2, 3, 4, 5};
+  REQUIRE(arma::approx_equal(flipped, desired, "absdiff", 1e-10));
+
+  // With zero probability nothing changes.
+  flipped = input;
+  Augmentation noFlip({"horizontal-flip", "vertical-flip"}, 0.0);
+  noFlip.Transform(flipped, 3, 2, 2);
+  REQUIRE(arma::approx_equal(flipped, input, "absdiff", 1e-10));
+}
+
+TEST_CASE("RandomCropChannelsTest", "[AugmentationTest]")
+{
+  // 4 data points of size 8 x 7 whose 3 channels are constant.
+  arma::mat input(8 * 7 * 3, 4);
+  for (size_t i = 0; i < 8 * 7; ++i)
+    for (size_t c = 0; c < 3; ++c)
+      input.row(i * 3 + c).fill(c + 1);
+
+  // Cropping only moves pixels, so every channel keeps its value.
+  arma::mat output = input;
+  Augmentation augmentation({"random-crop = (5, 4)"}, 1.0);
+  augmentation.Transform(output, 8, 7, 3);
+  REQUIRE(arma::approx_equal(output, input, "absdiff", 1e-10));
+
+  // A crop larger than the data point is an error.
+  Augmentation largeCrop({"random-crop = (9, 4)"}, 1.0);
+  REQUIRE_THROWS_AS(largeCrop.Transform(output, 8, 7, 3), std::runtime_error);
+}
+
+TEST_CASE("RandomAugmentationTest", "[AugmentationTest]")
+{
+  const std::vector<std::string> augmentations = {"horizontal-flip",
+      "random-crop = (6, 5)", "rotation = 20", "brightness = 0.3",
+      "contrast = 0.3"};
+
+  // 16 data points of size 8 x 7 with 3 channels.
+  arma::mat input(8 * 7 * 3, 16, arma::fill::randu);
+
+  // The same seed gives the same augmentations.
+  arma::mat first = input;
+  Augmentation augmentation(augmentations, 0.5, 42);
+  augmentation.Transform(first, 8, 7, 3);
+
+  arma::mat second = input;
+  Augmentation augmentation2(augmentations, 0.5, 42);
+  augmentation2.Transform(second, 8, 7, 3);
+
+  REQUIRE(first.n_rows == input.n_rows);
+  REQUIRE(first.n_cols == input.n_cols);
+  REQUIRE(arma::approx_equal(first, second, "absdiff", 1e-10));
+
+  // Calling it again draws new augmentations.
+  second = input;
+  augmentation2.Transform(second, 8, 7, 3);
+  REQUIRE(!arma::approx_equal(first, second, "absdiff", 1e-10));
+
+  // Reseeding restores the first augmentations.
+  second = input;
+  augmentation2.Seed(42);
+  augmentation2.Transform(second, 8, 7, 3);
+  REQUIRE(arma::approx_equal(first, second, "absdiff", 1e-10));
+}
+
+TEST_CASE("BrightnessAugmentationTest", "[AugmentationTest]")
+{
+  arma::mat input(4 * 4 * 2, 8, arma::fill::randu);
+  input += 0.5;
+  arma::mat output = input;
+
+  Augmentation augmentation({"brightness = 0.4"}, 1.0);
+  augmentation.Transform(output, 4, 4, 2);
+
+  // Every data point is scaled by a single factor within the given range.
+  for (size_t i = 0; i < input.n_cols; ++i)
+  {
+    const arma::vec factor = output.col(i) / input.col(i);
+    REQUIRE(factor.min() >= 0.6 - 1e-10);
+    REQUIRE(factor.max() <= 1.4 + 1e-10);
+    REQUIRE(factor.max() - factor.min() == Approx(0.0).margin(1e-10));
+  }
+}
+
+TEST_CASE("ContrastAugmentationTest", "[AugmentationTest]")
+{
+  // 8 data points of size 4 x 4 whose 2 channels are constant.
+  arma::mat input(4 * 4 * 2, 8);
+  for (size_t i = 0; i < 4 * 4; ++i)
+  {
+    input.row(i * 2).fill(0.2);
+    input.row(i * 2 + 1).fill(0.9);
+  }
+
+  // A constant channel is its own mean, so it keeps its value.
+  arma::mat output = input;
+  Augmentation augmentation({"contrast = 0.4"}, 1.0);
+  augmentation.Transform(output, 4, 4, 2);
+  REQUIRE(arma::approx_equal(output, input, "absdiff", 1e-10));
+
+  // Otherwise every channel keeps its mean.
+  input.randu();
+  output = input;
+  augmentation.Transform(output, 4, 4, 2);
+  REQUIRE(!arma::approx_equal(output, input, "absdiff", 1e-10));
+  for (size_t i = 0; i < input.n_cols; ++i)
+  {
+    for (size_t c = 0; c < 2; ++c)
+    {
+      const arma::vec channel = input.col(i).rows(arma::regspace<arma::uvec>(
+          c, 2, input.n_rows - 1));
+      const arma::vec outputChannel = output.col(i).rows(
+          arma::regspace<arma::uvec>(c, 2, input.n_rows - 1));
+      REQUIRE(arma::mean(outputChannel) ==
+          Approx(arma::mean(channel)).epsilon(1e-10));
+    }
+  }
+}
+
+TEST_CASE("ResizeKernelTest", "[AugmentationTest]")
+{
+  BilinearResizeKernel kernel;
+
+  // Two 4 x 4 data points with 2 channels.
+  arma::mat input = arma::reshape(arma::regspace(0, 63), 32, 2);
+  arma::mat output;
+
+  // Halving the size samples every second element.
+  kernel.Resize(input, output, 4, 4, 2, 2, 2);
+  REQUIRE(output.n_rows == 2 * 2 * 2);
+  REQUIRE(output.n_cols == 2);
+  arma::vec desired = {0, 2, 8, 10, 16, 18, 24, 26};
+  REQUIRE(arma::approx_equal(output.col(0), desired, "absdiff", 1e-10));
+  REQUIRE(arma::approx_equal(output.col(1), desired + 32, "absdiff", 1e-10));
+
+  // Single precision gives the same result.
+  arma::fmat floatOutput;
+  kernel.Resize(arma::conv_to<arma::fmat>::from(input), floatOutput, 4, 4,
+      2, 7, 5);
+  kernel.Resize(input, output, 4, 4, 2, 7, 5);
+  REQUIRE(arma::approx_equal(arma::conv_to<arma::mat>::from(floatOutput),
+      output, "absdiff", 1e-4));
+
+  // Tables are computed once per shape.
+  REQUIRE(kernel.CachedShapes() == 2);
+
+  // uint8 images are rounded and stay within range.
+  arma::Mat<unsigned char> image(6 * 6 * 3, 4);
+  image.fill(255);
+  arma::Mat<unsigned char> resizedImage;
+  kernel.Resize(image, resizedImage, 6, 6, 3, 9, 4);
+  REQUIRE(resizedImage.n_rows == 9 * 4 * 3);
+  REQUIRE(arma::all(arma::vectorise(resizedImage) == 255));
+  REQUIRE(kernel.CachedShapes() == 3);
+}
+
+TEST_CASE("InterleavedResizeKernelTest", "[AugmentationTest]")
+{
+  BilinearResizeKernel kernel;
+
+  // The same 5 x 3 data point with 3 channels in planar and interleaved
+  // layout.
+  arma::mat planar(5 * 3 * 3, 2, arma::fill::randu);
+  arma::mat interleaved(planar.n_rows, planar.n_cols);
+  for (size_t i = 0; i < 5 * 3; ++i)
+    for (size_t c = 0; c < 3; ++c)
+      interleaved.row(i * 3 + c) = planar.row(c * 5 * 3 + i);
+
+  arma::mat planarOutput, interleavedOutput;
+  kernel.Resize(planar, planarOutput, 5, 3, 3, 8, 6);
+  kernel.Resize(interleaved, interleavedOutput, 5, 3, 3, 8, 6, true);
+
+  REQUIRE(interleavedOutput.n_rows == 8 * 6 * 3);
+  for (size_t i = 0; i < 8 * 6; ++i)
+  {
+    for (size_t c = 0; c < 3; ++c)
+    {
+      REQUIRE(arma::approx_equal(interleavedOutput.row(i * 3 + c),
+          planarOutput.row(c * 8 * 6 + i), "absdiff", 1e-10));
+    }
+  }
+}
+
+TEST_CASE("BoxAugmentationFlipTest", "[AugmentationTest]")
+{
+  // A single 4 x 2 image with 2 interleaved channels.
+  arma::mat image = arma::regspace(0, 15);
+  arma::field<arma::vec> boxes(1, 1);
+  boxes(0) = arma::vec({3, 0, 0, 1, 2, 7, 1, 1, 4, 2});
+
+  BoxAugmentation augmentation({"horizontal-flip"}, 1.0);
+  augmentation.Transform(image, boxes, 4, 2, 2);
+
+  arma::vec desired = {6, 7, 4, 5, 2, 3, 0, 1, 14, 15, 12, 13, 10, 11, 8, 9};
+  REQUIRE(arma::approx_equal(image, desired, "absdiff", 1e-10));
+
+  arma::vec desiredBoxes = {3, 3, 0, 4, 2, 7, 0, 1, 3, 2};
+  REQUIRE(arma::approx_equal(boxes(0), desiredBoxes, "absdiff", 1e-10));
+
+  // Matrix labels are updated the same way.
+  arma::mat matBoxes = {3, 0, 0, 1, 2};
+  matBoxes = matBoxes.t();
+  image = arma::regspace(0, 15);
+  augmentation.Transform(image, matBoxes, 4, 2, 2);
+  REQUIRE(arma::approx_equal(matBoxes.col(0),
+      arma::vec({3, 3, 0, 4, 2}), "absdiff", 1e-10));
+
+  // Resize is recorded but only random augmentations are stored.
+  BoxAugmentation augmentation2({"resize (64, 64)", "vertical-flip",
+      "translate = 0.1", "scale-jitter = 0.2", "random-crop = 48"}, 0.5);
+  REQUIRE(augmentation2.HasResize());
+  REQUIRE(augmentation2.Operations().size() == 4);
+
+  // Augmentations that can't update boxes are rejected.
+  REQUIRE_THROWS_AS(BoxAugmentation(std::vector<std::string>(1,
+      "rotation = 10"), 0.2), std::runtime_error);
+}
+
+TEST_CASE("BoxAugmentationRandomTest", "[AugmentationTest]")
+{
+  const size_t width = 32, height = 24, depth = 3;
+  arma::mat images(width * height * depth, 16, arma::fill::randu);
+  arma::field<arma::vec> boxes(1, 16);
+  for (size_t i = 0; i < boxes.n_elem; ++i)
+    boxes(i) = arma::vec({1, 4, 4, 20, 16, 2, 10, 2, 30, 22});
+
+  BoxAugmentation augmentation({"horizontal-flip", "random-crop = (24, 16)",
+      "translate = 0.2", "scale-jitter = 0.3"}, 0.5, 7);
+  augmentation.Transform(images, boxes, width, height, depth);
+
+  REQUIRE(images.n_rows == width * height * depth);
+  for (size_t i = 0; i < boxes.n_elem; ++i)
+  {
+    // Every box that is kept lies inside the image and has a positive area.
+    REQUIRE(boxes(i).n_elem % 5 == 0);
+    for (size_t b = 0; b < boxes(i).n_elem / 5; ++b)
+    {
+      const arma::vec box = boxes(i).subvec(5 * b, 5 * b + 4);
+      REQUIRE((box(0) == 1 || box(0) == 2));
+      REQUIRE(box(1) >= 0);
+      REQUIRE(box(2) >= 0);
+      REQUIRE(box(3) <= width);
+      REQUIRE(box(4) <= height);
+      REQUIRE(box(3) > box(1));
+      REQUIRE(box(4) > box(2));
+    }
+  }
+
+  // A crop larger than the image is an error.
+  BoxAugmentation largeCrop({"random-crop = (24, 32)"}, 1.0);
+  REQUIRE_THROWS_AS(largeCrop.Transform(images, boxes, width, height, depth),
+      std::runtime_error);
+}
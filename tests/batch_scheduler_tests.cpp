@@ -0,0 +1,121 @@
+/**
+ * @file batch_scheduler_tests.cpp
+ * @author Kartik Dutt
+ *
+ * Tests for the BatchScheduler and the LatencyHistogram.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#define MLPACK_ENABLE_ANN_SERIALIZATION
+#include <mlpack.hpp>
+#include <utils/batch_scheduler.hpp>
+#include <random>
+#include "catch.hpp"
+
+using namespace mlpack;
+using namespace mlpack::models;
+
+/**
+ * Check the percentiles of the LatencyHistogram.
+ */
+TEST_CASE("LatencyHistogramTest", "[BatchSchedulerTest]")
+{
+  LatencyHistogram histogram;
+  REQUIRE(histogram.Percentile(50) == 0.0);
+
+  for (size_t i = 1; i <= 1000; ++i)
+    histogram.Add((double) i);
+
+  REQUIRE(histogram.Count() == 1000);
+  REQUIRE(histogram.Mean() == Approx(500.5));
+  REQUIRE(histogram.Max() == 1000.0);
+  REQUIRE(histogram.Percentile(50) == Approx(500.0).epsilon(0.05));
+  REQUIRE(histogram.Percentile(99) == Approx(990.0).epsilon(0.05));
+  REQUIRE(histogram.Percentile(50) <= histogram.Percentile(99));
+
+  histogram.Reset();
+  REQUIRE(histogram.Count() == 0);
+}
+
+/**
+ * Submit samples from several client threads with random pauses, like a
+ * service under load, and check that every request gets the output of the
+ * network for its sample, in fewer batches than requests.
+ */
+TEST_CASE("BatchSchedulerLoadTest", "[BatchSchedulerTest]")
+{
+  FFN<CrossEntropyError, RandomInitialization> model;
+  model.InputDimensions() = std::vector<size_t>({8, 8, 3});
+  model.Add<Convolution>(8, 3, 3, 1, 1, 1, 1);
+  model.Add<ReLU>();
+  model.Add<Linear>(5);
+  model.Add<LogSoftMax>();
+  model.Reset();
+  model.Parameters().randn();
+
+  const size_t clients = 6;
+  const size_t requests = 50;
+  arma::mat samples(8 * 8 * 3, clients * requests, arma::fill::randu);
+  arma::mat expected;
+  model.Predict(samples, expected);
+
+  InferenceEngine<> engine(model);
+  BatchScheduler<> scheduler(engine, 8, std::chrono::microseconds(1000), 2);
+
+  std::vector<arma::mat> outputs(clients * requests);
+  std::vector<std::thread> generators;
+  for (size_t c = 0; c < clients; ++c)
+  {
+    generators.emplace_back([&scheduler, &samples, &outputs, c, requests]()
+    {
+      std::mt19937 generator(c);
+      std::uniform_int_distribution<int> pause(0, 500);
+      for (size_t r = 0; r < requests; ++r)
+      {
+        const size_t i = c * requests + r;
+        std::future<arma::mat> result =
+            scheduler.Submit(arma::mat(samples.col(i)));
+        outputs[i] = result.get();
+        std::this_thread::sleep_for(
+            std::chrono::microseconds(pause(generator)));
+      }
+    });
+  }
+
+  for (std::thread& generator : generators)
+    generator.join();
+
+  for (size_t i = 0; i < clients * requests; ++i)
+  {
+    REQUIRE(arma::approx_equal(outputs[i], expected.col(i), "absdiff",
+        1e-10));
+  }
+
+  REQUIRE(scheduler.Requests() == clients * requests);
+  REQUIRE(scheduler.Batches() < clients * requests);
+  REQUIRE(scheduler.Compute().Count() == scheduler.Batches());
+
+  const LatencyHistogram queueWait = scheduler.QueueWait();
+  REQUIRE(queueWait.Percentile(50) <= queueWait.Percentile(99));
+
+  // A sample of another size is rejected.
+  REQUIRE_THROWS_AS(scheduler.Submit(arma::mat(10, 1)), std::runtime_error);
+
+  // Samples submitted together are predicted and counted.
+  scheduler.ResetStatistics();
+  std::vector<std::future<arma::mat>> pending;
+  for (size_t i = 0; i < 3; ++i)
+    pending.push_back(scheduler.Submit(arma::mat(samples.col(i))));
+
+  for (size_t i = 0; i < 3; ++i)
+  {
+    REQUIRE(arma::approx_equal(pending[i].get(), expected.col(i), "absdiff",
+        1e-10));
+  }
+
+  REQUIRE(scheduler.Requests() == 3);
+  REQUIRE(scheduler.Batches() <= 3);
+}
@@ -250,3 +250,27 @@ TEST_CASE("LoadImageDatasetFromDirectoryTest", "[DataLoadersTest]")
   REQUIRE(dataloader.ValidLabels().n_cols == 200);
   REQUIRE(dataloader.ValidLabels().n_rows == 1);
 }
+
+TEST_CASE("LoadResizedImageDatasetFromDirectoryTest", "[DataLoadersTest]")
+{
+  // Download the test dataset.
+  Utils::DownloadFile("/datasets/cifar-test.tar.gz",
+    "./../data/cifar-test.tar.gz", "", false, true,
+    "www.mlpack.org", true);
+
+  DataLoader<> dataloader;
+  Utils::ExtractFiles("./../data/cifar-test.tar.gz", "./../data/");
+
+  // Images are resized to 16 x 16 while they are decoded.
+  dataloader.LoadImageDatasetFromDirectory("./../data/cifar-test/",
+      32, 32, 3, true, 0.2, true, {"resize (16, 16)"});
+
+  REQUIRE(dataloader.TrainFeatures().n_cols == 800);
+  REQUIRE(dataloader.TrainFeatures().n_rows == 16 * 16 * 3);
+  REQUIRE(dataloader.ValidFeatures().n_cols == 200);
+  REQUIRE(dataloader.ValidFeatures().n_rows == 16 * 16 * 3);
+
+  // Pixel values stay within range.
+  REQUIRE(dataloader.TrainFeatures().min() >= 0);
+  REQUIRE(dataloader.TrainFeatures().max() <= 255);
+}
@@ -24,19 +24,20 @@ using namespace mlpack::models;
  * Checks for the output dimensions of the model.
  *
  * @tparam ModelType Type of model to check.
+ * @tparam MatType Type of the input and output of the model.
  *
  * @param model The model to test.
  * @param input Input to pass to the model.
  * @param n_rows Output rows to check against.
  * @param n_cols Output columns to check against..
  */
-template <typename ModelType>
+template <typename ModelType, typename MatType = arma::mat>
 void ModelDimTest(ModelType& model,
-               arma::mat& input,
+               MatType& input,
                const size_t n_rows = 1000,
                const size_t n_cols = 1)
 {
-  arma::mat output;
+  MatType output;
   model.Predict(input, output);
   REQUIRE(output.n_rows == n_rows);
   REQUIRE(output.n_cols == n_cols);
@@ -0,0 +1,94 @@
+/**
+ * @file float_model_tests.cpp
+ * @author Kartik Dutt
+ *
+ * Tests for the single precision DarkNet, YOLO, ResNet and MobileNetV1
+ * models.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#define MLPACK_ENABLE_ANN_SERIALIZATION
+#include <mlpack.hpp>
+#include <models/darknet/darknet.hpp>
+#include <models/yolo/yolo.hpp>
+#include <models/resnet/resnet.hpp>
+#include <models/mobilenet/mobilenet_v1.hpp>
+#include "catch.hpp"
+
+using namespace mlpack;
+using namespace mlpack::models;
+
+/**
+ * Check the output dimensions of a single precision model, and that its
+ * parameters are single precision.
+ *
+ * @param model The model to test.
+ * @param input Input to pass to the model.
+ * @param rows Output rows to check against.
+ */
+template<typename ModelType>
+void FloatModelDimTest(ModelType& model,
+                       const arma::fmat& input,
+                       const size_t rows)
+{
+  static_assert(std::is_same<typename std::decay<decltype(
+      model.Parameters())>::type, arma::fmat>::value,
+      "The parameters of the model must be single precision.");
+
+  arma::fmat output;
+  model.Predict(input, output);
+  REQUIRE(output.n_rows == rows);
+  REQUIRE(output.n_cols == input.n_cols);
+  REQUIRE(output.is_finite());
+}
+
+/**
+ * Simple test for single precision DarkNet models.
+ */
+TEST_CASE("FloatDarkNetTest", "[FloatModelTest]")
+{
+  arma::fmat input(64 * 64 * 3, 2, arma::fill::randu);
+
+  DarkNet<arma::fmat> darknet19(3, 64, 64, 10);
+  FloatModelDimTest(darknet19.GetModel(), input, 10);
+
+  DarkNet<arma::fmat, CrossEntropyErrorType<arma::fmat>, RandomInitialization,
+      53> darknet53(3, 64, 64, 10);
+  FloatModelDimTest(darknet53.GetModel(), input, 10);
+}
+
+/**
+ * Simple test for the single precision YOLO model.
+ */
+TEST_CASE("FloatYOLOTest", "[FloatModelTest]")
+{
+  arma::fmat input(64 * 64 * 3, 2, arma::fill::randu);
+
+  YOLO<arma::fmat> yolo(3, 64, 64);
+  FloatModelDimTest(yolo.GetModel(), input, 7 * 7 * (5 * 2 + 20));
+}
+
+/**
+ * Simple test for the single precision ResNet model.
+ */
+TEST_CASE("FloatResNetTest", "[FloatModelTest]")
+{
+  arma::fmat input(64 * 64 * 3, 2, arma::fill::randu);
+
+  ResNet<arma::fmat> resnet18(3, 64, 64, true, false, 10);
+  FloatModelDimTest(resnet18.GetModel(), input, 10);
+}
+
+/**
+ * Simple test for the single precision MobileNetV1 model.
+ */
+TEST_CASE("FloatMobileNetV1Test", "[FloatModelTest]")
+{
+  arma::fmat input(64 * 64 * 3, 2, arma::fill::randu);
+
+  MobileNetV1<arma::fmat> mobilenet(3, 64, 64, 1.0, 1, true, false, 10);
+  FloatModelDimTest(mobilenet.GetModel(), input, 10);
+}
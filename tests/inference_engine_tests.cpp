@@ -0,0 +1,104 @@
+/**
+ * @file inference_engine_tests.cpp
+ * @author Kartik Dutt
+ *
+ * Tests for the InferenceEngine.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#define MLPACK_ENABLE_ANN_SERIALIZATION
+#include <mlpack.hpp>
+#include <models/resnet/resnet.hpp>
+#include <utils/inference_engine.hpp>
+#include <thread>
+#include "catch.hpp"
+
+using namespace mlpack;
+using namespace mlpack::models;
+
+/**
+ * Check that threads predicting concurrently with the engine get the same
+ * output as the network, with workspaces that share the parameters.
+ */
+TEST_CASE("InferenceEngineThreadsTest", "[InferenceEngineTest]")
+{
+  FFN<CrossEntropyError, RandomInitialization> model;
+  model.InputDimensions() = std::vector<size_t>({8, 8, 3});
+  model.Add<Convolution>(8, 3, 3, 1, 1, 1, 1);
+  model.Add<BatchNorm>();
+  model.Add<ReLU>();
+  AddMerge* merge = new AddMerge();
+  merge->Add<Convolution>(8, 3, 3, 1, 1, 1, 1);
+  merge->Add<Identity>();
+  model.Add(merge);
+  model.Add<Linear>(5);
+  model.Add<LogSoftMax>();
+  model.Reset();
+  model.Parameters().randn();
+
+  arma::mat input(8 * 8 * 3, 6, arma::fill::randu);
+  arma::mat output;
+  model.Predict(input, output);
+
+  InferenceEngine<> engine(model);
+  REQUIRE(engine.Parameters().n_elem == model.Parameters().n_elem);
+  REQUIRE(engine.Parameters().memptr() != model.Parameters().memptr());
+
+  const size_t threads = 4;
+  std::vector<arma::mat> outputs(threads);
+  std::vector<std::thread> workers;
+  for (size_t t = 0; t < threads; ++t)
+  {
+    workers.emplace_back([&engine, &input, &outputs, t]()
+    {
+      for (size_t i = 0; i < 5; ++i)
+        engine.Predict(input, outputs[t]);
+    });
+  }
+
+  for (std::thread& worker : workers)
+    worker.join();
+
+  REQUIRE(engine.Workspaces() >= 1);
+  REQUIRE(engine.Workspaces() <= threads);
+  for (size_t t = 0; t < threads; ++t)
+    REQUIRE(arma::approx_equal(outputs[t], output, "absdiff", 1e-10));
+
+  // Shared parameters aren't copied.
+  InferenceEngine<> sharedEngine(model, true);
+  sharedEngine.Reserve(2);
+  REQUIRE(sharedEngine.Workspaces() == 2);
+  REQUIRE(sharedEngine.Parameters().memptr() == model.Parameters().memptr());
+
+  arma::mat sharedOutput;
+  sharedEngine.Predict(input, sharedOutput);
+  REQUIRE(arma::approx_equal(sharedOutput, output, "absdiff", 1e-10));
+
+  // The weights of every layer of a workspace, also of the layers inside
+  // the AddMerge, point into the shared parameters, so changing the
+  // parameters in place changes the output of the engine.
+  model.Parameters() *= 0.5;
+  model.Predict(input, output);
+  sharedEngine.Predict(input, sharedOutput);
+  REQUIRE(sharedEngine.Parameters().memptr() == model.Parameters().memptr());
+  REQUIRE(arma::approx_equal(sharedOutput, output, "absdiff", 1e-10));
+}
+
+/**
+ * Check that the engine runs a model of the zoo.
+ */
+TEST_CASE("InferenceEngineResNetTest", "[InferenceEngineTest]")
+{
+  arma::mat input(64 * 64 * 3, 2, arma::fill::randu);
+  arma::mat output, engineOutput;
+
+  ResNet18 resNet(3, 64, 64, true, false, 10);
+  resNet.GetModel().Predict(input, output);
+
+  InferenceEngine<> engine(resNet.GetModel());
+  engine.Predict(input, engineOutput);
+  REQUIRE(arma::approx_equal(engineOutput, output, "absdiff", 1e-8));
+}
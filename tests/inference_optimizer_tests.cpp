@@ -0,0 +1,214 @@
+/**
+ * @file inference_optimizer_tests.cpp
+ * @author Kartik Dutt
+ *
+ * Tests for InferenceOptimizer.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#define MLPACK_ENABLE_ANN_SERIALIZATION
+#include <mlpack.hpp>
+#include <models/darknet/darknet.hpp>
+#include <models/mobilenet/mobilenet_v1.hpp>
+#include <utils/inference_optimizer.hpp>
+#include "catch.hpp"
+
+using namespace mlpack;
+using namespace mlpack::models;
+
+/**
+ * Set random running statistics for the given layer if it is a normalization
+ * layer of the given type.
+ */
+template<typename LayerType>
+static void RandomStatistics(Layer<arma::mat>* layer)
+{
+  LayerType* normalization = dynamic_cast<LayerType*>(layer);
+  if (normalization != NULL)
+  {
+    normalization->TrainingMean().randn();
+    normalization->TrainingVariance().randu();
+    normalization->TrainingVariance() += 0.5;
+  }
+}
+
+/**
+ * Set random running statistics for every BatchNorm and ConvBNLeakyReLU layer
+ * of the network, so folding is checked against statistics that aren't the
+ * identity.
+ */
+static void RandomStatistics(const std::vector<Layer<arma::mat>*>& network)
+{
+  for (Layer<arma::mat>* layer : network)
+  {
+    RandomStatistics<BatchNorm>(layer);
+    RandomStatistics<ConvBNLeakyReLU>(layer);
+
+    MultiLayer<arma::mat>* container =
+        dynamic_cast<MultiLayer<arma::mat>*>(layer);
+    if (container != NULL)
+      RandomStatistics(container->Network());
+  }
+}
+
+/**
+ * Check that the optimized network predicts the same values with fewer
+ * layers.
+ */
+TEST_CASE("InferenceOptimizerTest", "[InferenceOptimizerTest]")
+{
+  FFN<MeanSquaredError, RandomInitialization> model;
+  model.InputDimensions() = std::vector<size_t>({8, 8, 3});
+  model.Add<Identity>();
+
+  // Convolution without bias followed by BatchNorm in a nested block.
+  MultiLayer<arma::mat>* block = new MultiLayer<arma::mat>();
+  block->Add<Convolution>(4, 3, 3, 1, 1, 1, 1, "none", false);
+  block->Add<BatchNorm>();
+  block->Add<ReLU>();
+  model.Add(block);
+
+  // Residual block, the convolution has a bias.
+  AddMerge* merge = new AddMerge();
+  MultiLayer<arma::mat>* branch = new MultiLayer<arma::mat>();
+  branch->Add<Convolution>(4, 3, 3, 1, 1, 1, 1, "none", true);
+  branch->Add<BatchNorm>();
+  branch->Add<Identity>();
+  merge->Add(branch);
+  merge->Add<Identity>();
+  model.Add(merge);
+
+  model.Add<Convolution>(2, 1, 1, 1, 1, 0, 0, "none", false);
+  model.Add<BatchNorm>();
+  model.Add<LinearNoBias>(5);
+
+  model.Reset();
+  model.Parameters().randn();
+  RandomStatistics(model.Network());
+
+  arma::mat input(8 * 8 * 3, 4, arma::fill::randu);
+  arma::mat output, optimizedOutput;
+  model.Predict(input, output);
+
+  InferenceOptimizer<> optimizer;
+  FFN<MeanSquaredError, RandomInitialization> optimized =
+      optimizer.Optimize(model);
+  optimized.Predict(input, optimizedOutput);
+
+  REQUIRE(optimizer.FoldedBatchNorms() == 3);
+  REQUIRE(optimizer.RemovedIdentities() == 2);
+  REQUIRE(optimizer.FlattenedContainers() == 2);
+
+  // Conv, ReLU, AddMerge, Conv and LinearNoBias remain.
+  REQUIRE(optimized.Network().size() == 5);
+  REQUIRE(optimizedOutput.n_rows == output.n_rows);
+  REQUIRE(optimizedOutput.n_cols == output.n_cols);
+  REQUIRE(arma::approx_equal(optimizedOutput, output, "absdiff", 1e-8));
+}
+
+/**
+ * Check that the BatchNorm layers which aren't folded keep their running
+ * statistics, whether they are copied alone or inside a Concat layer.
+ */
+TEST_CASE("InferenceOptimizerStatisticsTest", "[InferenceOptimizerTest]")
+{
+  FFN<MeanSquaredError, RandomInitialization> model;
+  model.InputDimensions() = std::vector<size_t>({8, 8, 3});
+  model.Add<Convolution>(4, 3, 3, 1, 1, 1, 1);
+  model.Add<ReLU>();
+  model.Add<BatchNorm>();
+
+  Concat* concat = new Concat(2);
+  MultiLayer<arma::mat>* branch = new MultiLayer<arma::mat>();
+  branch->Add<Convolution>(2, 1, 1);
+  branch->Add<ReLU>();
+  branch->Add<BatchNorm>();
+  concat->Add(branch);
+  concat->Add<Convolution>(2, 1, 1);
+  model.Add(concat);
+  model.Add<LinearNoBias>(5);
+
+  model.Reset();
+  model.Parameters().randn();
+  RandomStatistics(model.Network());
+
+  arma::mat input(8 * 8 * 3, 4, arma::fill::randu);
+  arma::mat output, optimizedOutput;
+  model.Predict(input, output);
+
+  InferenceOptimizer<> optimizer;
+  FFN<MeanSquaredError, RandomInitialization> optimized =
+      optimizer.Optimize(model);
+  optimized.Predict(input, optimizedOutput);
+
+  REQUIRE(optimizer.FoldedBatchNorms() == 0);
+  REQUIRE(arma::approx_equal(optimizedOutput, output, "absdiff", 1e-8));
+}
+
+/**
+ * Check that the ConvBNLeakyReLU layers of DarkNet are folded into
+ * convolutions followed by a LeakyReLU.
+ */
+TEST_CASE("InferenceOptimizerDarkNetTest", "[InferenceOptimizerTest]")
+{
+  DarkNet19 darknet(3, 32, 32, 10);
+  FFN<CrossEntropyError, RandomInitialization>& model = darknet.GetModel();
+  RandomStatistics(model.Network());
+
+  arma::mat input(32 * 32 * 3, 2, arma::fill::randu);
+  arma::mat output, optimizedOutput;
+  model.Predict(input, output);
+
+  InferenceOptimizer<> optimizer;
+  FFN<CrossEntropyError, RandomInitialization> optimized =
+      optimizer.Optimize(model);
+  optimized.Predict(input, optimizedOutput);
+
+  // Every convolution block of DarkNet-19 is a ConvBNLeakyReLU layer.
+  REQUIRE(optimizer.FoldedBatchNorms() == 18);
+  REQUIRE(optimizedOutput.n_rows == output.n_rows);
+  REQUIRE(optimizedOutput.n_cols == output.n_cols);
+  REQUIRE(arma::approx_equal(optimizedOutput, output, "both", 1e-6, 1e-6));
+}
+
+/**
+ * Check that the BatchNorm layers following the depthwise and the pointwise
+ * convolutions of MobileNetV1 are folded.
+ */
+TEST_CASE("InferenceOptimizerMobileNetV1Test", "[InferenceOptimizerTest]")
+{
+  MobileNetV1<> mobilenet(3, 32, 32, 0.25, 1, true, false, 10);
+  FFN<CrossEntropyError, RandomInitialization>& model = mobilenet.GetModel();
+  RandomStatistics(model.Network());
+
+  arma::mat input(32 * 32 * 3, 2, arma::fill::randu);
+  arma::mat output, optimizedOutput;
+  model.Predict(input, output);
+
+  InferenceOptimizer<> optimizer;
+  FFN<CrossEntropyError, RandomInitialization> optimized =
+      optimizer.Optimize(model);
+  optimized.Predict(input, optimizedOutput);
+
+  // The first convolution and the two convolutions of the 13 depthwise
+  // blocks are followed by a BatchNorm.
+  REQUIRE(optimizer.FoldedBatchNorms() == 27);
+  REQUIRE(optimizedOutput.n_rows == output.n_rows);
+  REQUIRE(optimizedOutput.n_cols == output.n_cols);
+  REQUIRE(arma::approx_equal(optimizedOutput, output, "both", 1e-6, 1e-6));
+}
+
+/**
+ * Check that a model that isn't initialized can't be optimized.
+ */
+TEST_CASE("InferenceOptimizerUninitializedTest", "[InferenceOptimizerTest]")
+{
+  FFN<MeanSquaredError, RandomInitialization> model;
+  model.Add<Convolution>(2, 3, 3);
+
+  InferenceOptimizer<> optimizer;
+  REQUIRE_THROWS_AS(optimizer.Optimize(model), std::runtime_error);
+}
@@ -0,0 +1,376 @@
+/**
+ * @file layers_tests.cpp
+ * @author Kartik Dutt
+ *
+ * Tests for the layers of the models repository.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#define MLPACK_ENABLE_ANN_SERIALIZATION
+#include <mlpack.hpp>
+#include <layers/conv_bn_leaky_relu.hpp>
+#include <layers/downsample_pooling.hpp>
+#include <layers/depthwise_convolution.hpp>
+#include <layers/fast_convolution.hpp>
+#include <layers/parallel_add_merge.hpp>
+#include <layers/view_concat.hpp>
+#include <utils/concurrent_branches.hpp>
+#include "catch.hpp"
+
+using namespace mlpack;
+using namespace mlpack::models;
+
+/**
+ * Check that ConvBNLeakyReLU computes the same output and gradients as the
+ * Convolution, BatchNorm and LeakyReLU layers it replaces, in training and
+ * in inference mode.
+ */
+TEST_CASE("ConvBNLeakyReLUTest", "[LayersTest]")
+{
+  FFN<MeanSquaredError, RandomInitialization> fused, reference;
+  fused.InputDimensions() = std::vector<size_t>({7, 6, 3});
+  reference.InputDimensions() = std::vector<size_t>({7, 6, 3});
+
+  fused.Add<ConvBNLeakyReLU>(4, 3, 3, 2, 1, 1, 1, 1e-5, 0.1, 0.1);
+  reference.Add<Convolution>(4, 3, 3, 2, 1, 1, 1, "none", false);
+  reference.Add<BatchNorm>(2, 2, 1e-5, false, 0.1);
+  reference.Add<LeakyReLU>(0.1);
+
+  // The parameters are stored in the same order by both networks.
+  fused.Reset();
+  reference.Reset();
+  REQUIRE(fused.Parameters().n_elem == reference.Parameters().n_elem);
+  fused.Parameters().randn();
+  reference.Parameters() = fused.Parameters();
+
+  arma::mat input(7 * 6 * 3, 5, arma::fill::randn);
+  arma::mat output, referenceOutput;
+  fused.SetNetworkMode(true);
+  reference.SetNetworkMode(true);
+  fused.Forward(input, output);
+  reference.Forward(input, referenceOutput);
+  REQUIRE(arma::approx_equal(output, referenceOutput, "absdiff", 1e-8));
+
+  arma::mat target(output.n_rows, output.n_cols, arma::fill::randn);
+  arma::mat gradient, referenceGradient;
+  fused.Backward(input, target, gradient);
+  reference.Backward(input, target, referenceGradient);
+  REQUIRE(arma::approx_equal(gradient, referenceGradient, "absdiff", 1e-8));
+
+  // The running statistics are updated the same way.
+  const ConvBNLeakyReLU* layer =
+      dynamic_cast<const ConvBNLeakyReLU*>(fused.Network()[0]);
+  const BatchNorm* batchNorm =
+      dynamic_cast<const BatchNorm*>(reference.Network()[1]);
+  REQUIRE(arma::approx_equal(layer->TrainingMean(),
+      batchNorm->TrainingMean(), "absdiff", 1e-8));
+  REQUIRE(arma::approx_equal(layer->TrainingVariance(),
+      batchNorm->TrainingVariance(), "absdiff", 1e-8));
+
+  fused.Predict(input, output);
+  reference.Predict(input, referenceOutput);
+  REQUIRE(arma::approx_equal(output, referenceOutput, "absdiff", 1e-8));
+}
+
+/**
+ * Check that DownsamplePooling computes the same windows as the adaptive
+ * pooling layers for even and odd sizes, and that the error is passed back to
+ * the pooled elements.
+ */
+TEST_CASE("DownsamplePoolingTest", "[LayersTest]")
+{
+  for (const size_t width : { 8, 7 })
+  {
+    for (const size_t height : { 6, 5 })
+    {
+      const size_t outputWidth = (width + 1) / 2;
+      const size_t outputHeight = (height + 1) / 2;
+      arma::mat input(width * height * 3, 4, arma::fill::randn);
+      arma::mat gy(outputWidth * outputHeight * 3, 4, arma::fill::randn);
+
+      DownsamplePooling maxPooling(true), meanPooling(false);
+      AdaptiveMaxPooling adaptiveMax(outputWidth, outputHeight);
+      AdaptiveMeanPooling adaptiveMean(outputWidth, outputHeight);
+      maxPooling.InputDimensions() = std::vector<size_t>({width, height, 3});
+      meanPooling.InputDimensions() = maxPooling.InputDimensions();
+      adaptiveMax.InputDimensions() = maxPooling.InputDimensions();
+      adaptiveMean.InputDimensions() = maxPooling.InputDimensions();
+      maxPooling.ComputeOutputDimensions();
+      meanPooling.ComputeOutputDimensions();
+      adaptiveMax.ComputeOutputDimensions();
+      adaptiveMean.ComputeOutputDimensions();
+      REQUIRE(maxPooling.OutputDimensions() == adaptiveMax.OutputDimensions());
+
+      arma::mat output(gy.n_rows, gy.n_cols), expected(gy.n_rows, gy.n_cols);
+      maxPooling.Forward(input, output);
+      adaptiveMax.Forward(input, expected);
+      REQUIRE(arma::approx_equal(output, expected, "absdiff", 1e-12));
+
+      // Every error ends up at the maximum of its window.
+      arma::mat g(input.n_rows, input.n_cols);
+      maxPooling.Backward(output, gy, g);
+      REQUIRE(arma::accu(g) == Approx(arma::accu(gy)).epsilon(1e-10));
+      REQUIRE(arma::accu(g % input) ==
+          Approx(arma::accu(gy % output)).epsilon(1e-10));
+
+      meanPooling.Forward(input, output);
+      adaptiveMean.Forward(input, expected);
+      REQUIRE(arma::approx_equal(output, expected, "absdiff", 1e-12));
+
+      meanPooling.Backward(output, gy, g);
+      REQUIRE(arma::accu(g) == Approx(arma::accu(gy)).epsilon(1e-10));
+    }
+  }
+}
+
+/**
+ * Check that FastConvolution computes 3x3 kernels with the same output and
+ * gradients as the Convolution layer, with and without padding and for odd
+ * sizes. The error of the first layer is computed by the backward pass of the
+ * second.
+ */
+TEST_CASE("FastConvolutionWinogradTest", "[LayersTest]")
+{
+  FFN<MeanSquaredError, RandomInitialization> winograd, reference;
+  winograd.InputDimensions() = std::vector<size_t>({7, 6, 3});
+  reference.InputDimensions() = std::vector<size_t>({7, 6, 3});
+
+  winograd.Add<FastConvolution>(4, 3, 3, 1, 1, 1, 1);
+  winograd.Add<FastConvolution>(5, 3, 3, 1, 1, 0, 0, "none", false);
+  winograd.Add<FastConvolution>(2, 3, 3, 2, 2, 1, 1);
+  reference.Add<Convolution>(4, 3, 3, 1, 1, 1, 1);
+  reference.Add<Convolution>(5, 3, 3, 1, 1, 0, 0, "none", false);
+  reference.Add<Convolution>(2, 3, 3, 2, 2, 1, 1);
+
+  winograd.Reset();
+  reference.Reset();
+  REQUIRE(winograd.Parameters().n_elem == reference.Parameters().n_elem);
+  winograd.Parameters().randn();
+  reference.Parameters() = winograd.Parameters();
+
+  // The strided convolution is computed by the Convolution layer.
+  REQUIRE(dynamic_cast<const FastConvolution*>(
+      winograd.Network()[0])->Winograd());
+  REQUIRE(dynamic_cast<const FastConvolution*>(
+      winograd.Network()[1])->Winograd());
+  REQUIRE(!dynamic_cast<const FastConvolution*>(
+      winograd.Network()[2])->Winograd());
+
+  arma::mat input(7 * 6 * 3, 4, arma::fill::randn);
+  arma::mat output, referenceOutput;
+  winograd.Forward(input, output);
+  reference.Forward(input, referenceOutput);
+  REQUIRE(arma::approx_equal(output, referenceOutput, "absdiff", 1e-10));
+
+  arma::mat target(output.n_rows, output.n_cols, arma::fill::randn);
+  arma::mat gradient, referenceGradient;
+  winograd.Backward(input, target, gradient);
+  reference.Backward(input, target, referenceGradient);
+  REQUIRE(arma::approx_equal(gradient, referenceGradient, "absdiff", 1e-10));
+
+  // The transformed kernels are dropped with the gradient, so the updated
+  // weights are used by the next forward pass.
+  winograd.Parameters() -= 0.1 * gradient;
+  reference.Parameters() = winograd.Parameters();
+  winograd.Forward(input, output);
+  reference.Forward(input, referenceOutput);
+  REQUIRE(arma::approx_equal(output, referenceOutput, "absdiff", 1e-10));
+}
+
+/**
+ * Check that DepthwiseConvolution computes the same output and gradients as
+ * the GroupedConvolution layer, for strides of 1 and 2, "same" and "valid"
+ * padding and a depth multiplier.
+ */
+TEST_CASE("DepthwiseConvolutionTest", "[LayersTest]")
+{
+  FFN<MeanSquaredError, RandomInitialization> depthwise, reference;
+  depthwise.InputDimensions() = std::vector<size_t>({9, 7, 3});
+  reference.InputDimensions() = std::vector<size_t>({9, 7, 3});
+
+  depthwise.Add<DepthwiseConvolution>(3, 3, 3, 3, 1, 1, 0, 0, "same");
+  depthwise.Add<DepthwiseConvolution>(6, 3, 3, 3, 2, 2, 0, 0, "valid");
+  depthwise.Add<DepthwiseConvolution>(6, 3, 3, 6, 2, 2, 1, 1, "none", false);
+  depthwise.Add<DepthwiseConvolution>(4, 3, 3, 2);
+  reference.Add<GroupedConvolution>(3, 3, 3, 3, 1, 1, 0, 0, "same");
+  reference.Add<GroupedConvolution>(6, 3, 3, 3, 2, 2, 0, 0, "valid");
+  reference.Add<GroupedConvolution>(6, 3, 3, 6, 2, 2, 1, 1, "none", false);
+  reference.Add<GroupedConvolution>(4, 3, 3, 2);
+
+  depthwise.Reset();
+  reference.Reset();
+  REQUIRE(depthwise.Parameters().n_elem == reference.Parameters().n_elem);
+  depthwise.Parameters().randn();
+  reference.Parameters() = depthwise.Parameters();
+
+  // The last convolution has three input maps in each group, so it is
+  // computed by the GroupedConvolution layer.
+  for (size_t i = 0; i < 3; ++i)
+  {
+    REQUIRE(dynamic_cast<const DepthwiseConvolution*>(
+        depthwise.Network()[i])->Depthwise());
+  }
+  REQUIRE(!dynamic_cast<const DepthwiseConvolution*>(
+      depthwise.Network()[3])->Depthwise());
+
+  arma::mat input(9 * 7 * 3, 4, arma::fill::randn);
+  arma::mat output, referenceOutput;
+  depthwise.Forward(input, output);
+  reference.Forward(input, referenceOutput);
+  REQUIRE(arma::approx_equal(output, referenceOutput, "absdiff", 1e-10));
+
+  arma::mat target(output.n_rows, output.n_cols, arma::fill::randn);
+  arma::mat gradient, referenceGradient;
+  depthwise.Backward(input, target, gradient);
+  reference.Backward(input, target, referenceGradient);
+  REQUIRE(arma::approx_equal(gradient, referenceGradient, "absdiff", 1e-10));
+}
+
+/**
+ * Check that FastConvolution computes 1x1 kernels with the same output and
+ * gradients as the Convolution layer, with and without a stride and a bias.
+ */
+TEST_CASE("FastConvolutionPointwiseTest", "[LayersTest]")
+{
+  FFN<MeanSquaredError, RandomInitialization> pointwise, reference;
+  pointwise.InputDimensions() = std::vector<size_t>({7, 6, 3});
+  reference.InputDimensions() = std::vector<size_t>({7, 6, 3});
+
+  pointwise.Add<FastConvolution>(5, 1, 1);
+  pointwise.Add<FastConvolution>(4, 1, 1, 2, 2, 0, 0, "none", false);
+  pointwise.Add<FastConvolution>(2, 3, 3, 1, 1, 1, 1);
+  reference.Add<Convolution>(5, 1, 1);
+  reference.Add<Convolution>(4, 1, 1, 2, 2, 0, 0, "none", false);
+  reference.Add<Convolution>(2, 3, 3, 1, 1, 1, 1);
+
+  pointwise.Reset();
+  reference.Reset();
+  REQUIRE(pointwise.Parameters().n_elem == reference.Parameters().n_elem);
+  pointwise.Parameters().randn();
+  reference.Parameters() = pointwise.Parameters();
+
+  // The 3x3 convolution is computed with the Winograd algorithm.
+  REQUIRE(dynamic_cast<const FastConvolution*>(
+      pointwise.Network()[0])->Pointwise());
+  REQUIRE(dynamic_cast<const FastConvolution*>(
+      pointwise.Network()[1])->Pointwise());
+  REQUIRE(!dynamic_cast<const FastConvolution*>(
+      pointwise.Network()[2])->Pointwise());
+  REQUIRE(dynamic_cast<const FastConvolution*>(
+      pointwise.Network()[2])->Winograd());
+
+  arma::mat input(7 * 6 * 3, 4, arma::fill::randn);
+  arma::mat output, referenceOutput;
+  pointwise.Forward(input, output);
+  reference.Forward(input, referenceOutput);
+  REQUIRE(arma::approx_equal(output, referenceOutput, "absdiff", 1e-10));
+
+  arma::mat target(output.n_rows, output.n_cols, arma::fill::randn);
+  arma::mat gradient, referenceGradient;
+  pointwise.Backward(input, target, gradient);
+  reference.Backward(input, target, referenceGradient);
+  REQUIRE(arma::approx_equal(gradient, referenceGradient, "absdiff", 1e-10));
+}
+
+/**
+ * Check that ViewConcat computes the same output, error and gradient as the
+ * Concat layer, for a single sample, whose branches write in place, and for a
+ * batch of 3, whose outputs and errors are copied.
+ */
+TEST_CASE("ViewConcatTest", "[LayersTest]")
+{
+  FFN<MeanSquaredError, RandomInitialization> view, reference;
+  view.InputDimensions() = std::vector<size_t>({6, 5, 3});
+  reference.InputDimensions() = std::vector<size_t>({6, 5, 3});
+
+  ViewConcat* viewConcat = new ViewConcat(2);
+  viewConcat->Add<Convolution>(4, 1, 1);
+  viewConcat->Add<Convolution>(2, 3, 3, 1, 1, 1, 1);
+  view.Add<Convolution>(3, 1, 1);
+  view.Add(viewConcat);
+  view.Add<Linear>(3);
+
+  Concat* concat = new Concat(2);
+  concat->Add<Convolution>(4, 1, 1);
+  concat->Add<Convolution>(2, 3, 3, 1, 1, 1, 1);
+  reference.Add<Convolution>(3, 1, 1);
+  reference.Add(concat);
+  reference.Add<Linear>(3);
+
+  view.Reset();
+  reference.Reset();
+  REQUIRE(view.Parameters().n_elem == reference.Parameters().n_elem);
+  view.Parameters().randn();
+  reference.Parameters() = view.Parameters();
+  REQUIRE(viewConcat->Contiguous());
+
+  for (size_t batchSize = 1; batchSize <= 3; batchSize += 2)
+  {
+    arma::mat input(6 * 5 * 3, batchSize, arma::fill::randn);
+    arma::mat output, referenceOutput;
+    view.Forward(input, output);
+    reference.Forward(input, referenceOutput);
+    REQUIRE(arma::approx_equal(output, referenceOutput, "absdiff", 1e-10));
+
+    arma::mat target(output.n_rows, output.n_cols, arma::fill::randn);
+    arma::mat gradient, referenceGradient;
+    view.Backward(input, target, gradient);
+    reference.Backward(input, target, referenceGradient);
+    REQUIRE(arma::approx_equal(gradient, referenceGradient, "absdiff",
+        1e-10));
+  }
+}
+
+/**
+ * Check that running the branches of ParallelAddMerge and ViewConcat blocks
+ * concurrently gives the same output and gradient as running them one after
+ * another.
+ */
+TEST_CASE("ConcurrentBranchesTest", "[LayersTest]")
+{
+  FFN<MeanSquaredError, RandomInitialization> model;
+  model.InputDimensions() = std::vector<size_t>({6, 5, 4});
+  ParallelAddMerge* merge = new ParallelAddMerge();
+  MultiLayer<arma::mat>* branch = new MultiLayer<arma::mat>();
+  branch->Add<Convolution>(4, 3, 3, 1, 1, 1, 1);
+  branch->Add<ReLU>();
+  branch->Add<Convolution>(4, 1, 1);
+  merge->Add(branch);
+  merge->Add<Convolution>(4, 1, 1);
+  merge->Add<Identity>();
+  // The backward pass of a sigmoid reads its output.
+  merge->Add<Sigmoid>();
+  model.Add(merge);
+
+  ViewConcat* concat = new ViewConcat(2);
+  concat->Add<Convolution>(3, 1, 1);
+  concat->Add<Convolution>(2, 3, 3, 1, 1, 1, 1);
+  model.Add(concat);
+  model.Add<Linear>(3);
+  model.Reset();
+  model.Parameters().randn();
+
+  for (size_t batchSize = 1; batchSize <= 4; batchSize += 3)
+  {
+    arma::mat input(6 * 5 * 4, batchSize, arma::fill::randn);
+    arma::mat target(3, batchSize, arma::fill::randn);
+    arma::mat output, gradient, concurrentOutput, concurrentGradient;
+
+    REQUIRE(ConcurrentBranches<>::Set(model, false) == 2);
+    model.Forward(input, output);
+    model.Backward(input, target, gradient);
+
+    REQUIRE(ConcurrentBranches<>::Set(model, true) == 2);
+    REQUIRE(merge->Concurrent());
+    REQUIRE(concat->Concurrent());
+    model.Forward(input, concurrentOutput);
+    model.Backward(input, target, concurrentGradient);
+
+    REQUIRE(arma::approx_equal(concurrentOutput, output, "absdiff", 1e-12));
+    REQUIRE(arma::approx_equal(concurrentGradient, gradient, "absdiff",
+        1e-12));
+  }
+}
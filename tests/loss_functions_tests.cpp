@@ -0,0 +1,226 @@
+/**
+ * @file loss_functions_tests.cpp
+ * @author Kartik Dutt
+ *
+ * Tests for the loss functions of the models repository.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#include <dataloader/preprocessor.hpp>
+#include <loss_functions/sparse_yolo_loss.hpp>
+#include <loss_functions/yolo_loss.hpp>
+#include "test_catch_tools.hpp"
+#include "catch.hpp"
+
+using namespace mlpack::models;
+
+/**
+ * Create random annotations for a batch of images, with every image holding
+ * between zero and three boxes.
+ */
+inline arma::field<arma::vec> RandomAnnotations(const size_t batchSize,
+                                                const size_t numClasses,
+                                                const size_t imageSize)
+{
+  arma::field<arma::vec> annotations(1, batchSize);
+  for (size_t i = 0; i < batchSize; ++i)
+  {
+    const size_t numObjects = i % 4;
+    annotations(0, i).set_size(5 * numObjects);
+    for (size_t j = 0; j < numObjects; ++j)
+    {
+      const arma::vec corner = arma::randu<arma::vec>(2) * imageSize * 0.6;
+      const arma::vec size = (arma::randu<arma::vec>(2) + 0.2) * imageSize *
+          0.3;
+      annotations(0, i).subvec(5 * j, 5 * j + 4) = arma::vec({
+          (double) (j % numClasses), corner(0), corner(1),
+          corner(0) + size(0), corner(1) + size(1)});
+    }
+  }
+
+  return annotations;
+}
+
+/**
+ * Check the gradient of a YOLO loss with central differences.
+ */
+template<typename LossType>
+void CheckYOLOGradient(LossType& loss,
+                       arma::mat& prediction,
+                       const arma::mat& target)
+{
+  arma::mat gradient;
+  loss.Backward(prediction, target, gradient);
+  REQUIRE(gradient.n_rows == prediction.n_rows);
+  REQUIRE(gradient.n_cols == prediction.n_cols);
+
+  const double h = 1e-6;
+  for (size_t i = 0; i < prediction.n_elem; ++i)
+  {
+    const double value = prediction(i);
+    prediction(i) = value + h;
+    const double upper = loss.Forward(prediction, target);
+    prediction(i) = value - h;
+    const double lower = loss.Forward(prediction, target);
+    prediction(i) = value;
+
+    REQUIRE(gradient(i) == Approx((upper - lower) / (2 * h)).margin(1e-4));
+  }
+}
+
+/**
+ * Check that the sparse YOLO targets list the objects of the dense targets.
+ */
+TEST_CASE("YOLOSparsePreProcessorTest", "[LossFunctionsTest]")
+{
+  arma::field<arma::vec> annotations(1, 2);
+  annotations(0, 0) = arma::vec({1, 10, 10, 40, 40, 2, 12, 12, 38, 38,
+      3, 14, 14, 36, 36, 0, 60, 60, 90, 80});
+
+  arma::mat sparse, dense;
+  PreProcessor<arma::mat, arma::field<arma::vec>>::YOLOSparsePreProcessor(
+      annotations, sparse, 2, 100, 100, 2, 2, 2);
+  PreProcessor<arma::mat, arma::field<arma::vec>>::YOLOPreProcessor(
+      annotations, dense, 2, 100, 100, 2, 2, 2, 4);
+
+  // The third box of the first cell has no slot.
+  REQUIRE(sparse.n_rows == 1 + 7 * 3);
+  REQUIRE(sparse(0, 0) == 3);
+  REQUIRE(sparse(0, 1) == 0);
+  REQUIRE(arma::accu(arma::abs(sparse.col(1))) == 0);
+
+  const size_t gridSize = 4;
+  for (size_t j = 0; j < 3; ++j)
+  {
+    const arma::vec object = sparse.col(0).subvec(1 + 7 * j, 7 + 7 * j);
+    const size_t offset = (5 + 4) * (size_t) object(1);
+    for (size_t s = 0; s < 4; ++s)
+    {
+      REQUIRE(dense((size_t) object(0) + (offset + s) * gridSize, 0) ==
+          Approx(object(2 + s)).epsilon(1e-12));
+    }
+    REQUIRE(dense((size_t) object(0) + (offset + 5 + (size_t) object(6)) *
+        gridSize, 0) == 1.0);
+  }
+
+  // YOLO v1 keeps a single object per cell.
+  PreProcessor<arma::mat, arma::field<arma::vec>>::YOLOSparsePreProcessor(
+      annotations, sparse, 1, 100, 100, 2, 2, 2);
+  REQUIRE(sparse(0, 0) == 2);
+  REQUIRE(sparse(1, 0) == 0);
+  REQUIRE(sparse(8, 0) == 3);
+}
+
+/**
+ * Check the sparse YOLO v3 loss against the loss evaluated on the dense
+ * targets, and its gradient.
+ */
+TEST_CASE("SparseYOLOLossTest", "[LossFunctionsTest]")
+{
+  const size_t gridSize = 4, numBoxes = 2, numClasses = 3;
+  arma::field<arma::vec> annotations = RandomAnnotations(8, numClasses, 400);
+
+  arma::mat sparse, dense;
+  PreProcessor<arma::mat, arma::field<arma::vec>>::YOLOSparsePreProcessor(
+      annotations, sparse, 3, 400, 400, gridSize, gridSize, numBoxes);
+  PreProcessor<arma::mat, arma::field<arma::vec>>::YOLOPreProcessor(
+      annotations, dense, 3, 400, 400, gridSize, gridSize, numBoxes,
+      numClasses);
+
+  arma::mat prediction = arma::randu<arma::mat>(dense.n_rows, dense.n_cols);
+  SparseYOLOLoss loss(3, gridSize, gridSize, numBoxes, numClasses);
+
+  // Every box of every cell in the dense targets.
+  const size_t cells = gridSize * gridSize;
+  double expected = 0.0;
+  for (size_t i = 0; i < dense.n_cols; ++i)
+  {
+    for (size_t c = 0; c < cells; ++c)
+    {
+      for (size_t b = 0; b < numBoxes; ++b)
+      {
+        const size_t offset = (5 + numClasses) * b;
+        auto p = [&](const size_t s) { return prediction(c + s * cells, i); };
+        auto t = [&](const size_t s) { return dense(c + s * cells, i); };
+        if (t(offset + 4) == 0)
+        {
+          expected += 0.5 * std::pow(p(offset + 4), 2.0);
+          continue;
+        }
+
+        expected += 5.0 * (std::pow(p(offset) - t(offset), 2.0) +
+            std::pow(p(offset + 1) - t(offset + 1), 2.0) +
+            std::pow(std::sqrt(p(offset + 2)) - std::sqrt(t(offset + 2)),
+            2.0) + std::pow(std::sqrt(p(offset + 3)) -
+            std::sqrt(t(offset + 3)), 2.0));
+        expected += std::pow(1 - p(offset + 4), 2.0);
+        for (size_t k = 0; k < numClasses; ++k)
+          expected += std::pow(p(offset + 5 + k) - t(offset + 5 + k), 2.0);
+      }
+    }
+  }
+
+  REQUIRE(loss.Forward(prediction, sparse) == Approx(expected).epsilon(1e-8));
+  CheckYOLOGradient(loss, prediction, sparse);
+
+  loss.Reduction() = false;
+  REQUIRE(loss.Forward(prediction, sparse) ==
+      Approx(expected / dense.n_cols).epsilon(1e-8));
+  CheckYOLOGradient(loss, prediction, sparse);
+
+  // YOLO v1 picks the responsible box of each object.
+  PreProcessor<arma::mat, arma::field<arma::vec>>::YOLOSparsePreProcessor(
+      annotations, sparse, 1, 400, 400, gridSize, gridSize, numBoxes);
+  SparseYOLOLoss lossV1(1, gridSize, gridSize, numBoxes, numClasses);
+  prediction = arma::randu<arma::mat>(cells * (5 * numBoxes + numClasses),
+      dense.n_cols);
+  CheckYOLOGradient(lossV1, prediction, sparse);
+}
+
+/**
+ * Check the dense YOLO v1 loss against the sparse loss, which agree when
+ * every cell holds at most one object, and its gradient.
+ */
+TEST_CASE("YOLOLossTest", "[LossFunctionsTest]")
+{
+  const size_t gridSize = 4, numBoxes = 2, numClasses = 3;
+
+  // Objects on the diagonal of the image never share a cell.
+  arma::field<arma::vec> annotations(1, 6);
+  for (size_t i = 0; i < annotations.n_elem; ++i)
+  {
+    const size_t numObjects = i % 3;
+    annotations(0, i).set_size(5 * numObjects);
+    for (size_t j = 0; j < numObjects; ++j)
+    {
+      const arma::vec corner = (double) (j * 200) +
+          arma::randu<arma::vec>(2) * 50;
+      annotations(0, i).subvec(5 * j, 5 * j + 4) = arma::vec({(double) j,
+          corner(0), corner(1), corner(0) + 40, corner(1) + 60});
+    }
+  }
+
+  arma::mat sparse, dense;
+  PreProcessor<arma::mat, arma::field<arma::vec>>::YOLOSparsePreProcessor(
+      annotations, sparse, 1, 400, 400, gridSize, gridSize, numBoxes);
+  PreProcessor<arma::mat, arma::field<arma::vec>>::YOLOPreProcessor(
+      annotations, dense, 1, 400, 400, gridSize, gridSize, numBoxes,
+      numClasses);
+
+  arma::mat prediction = arma::randu<arma::mat>(dense.n_rows, dense.n_cols);
+  YOLOLoss loss(gridSize, gridSize, numBoxes, numClasses);
+  SparseYOLOLoss sparseLoss(1, gridSize, gridSize, numBoxes, numClasses);
+
+  REQUIRE(loss.Forward(prediction, dense) ==
+      Approx(sparseLoss.Forward(prediction, sparse)).epsilon(1e-8));
+
+  arma::mat gradient, sparseGradient;
+  loss.Backward(prediction, dense, gradient);
+  sparseLoss.Backward(prediction, sparse, sparseGradient);
+  CheckMatrices(gradient, sparseGradient);
+
+  CheckYOLOGradient(loss, prediction, dense);
+}
@@ -95,3 +95,87 @@ TEST_CASE("YOLOPreProcessor", "[PreProcessorsTest]")
       REQUIRE(desiredOutput(i) == Approx(output(i)).epsilon(1e-2));
   }
 }
+
+TEST_CASE("YOLOPreProcessorBatchTest", "[PreProcessorsTest]")
+{
+  // Three boxes in the same cell, only two fit for YOLOv2 with two boxes per
+  // cell.
+  arma::field<arma::vec> input(1, 1);
+  input(0, 0) = arma::vec({1, 10, 10, 40, 40, 2, 12, 12, 38, 38,
+      3, 14, 14, 36, 36});
+
+  arma::mat output;
+  PreProcessor<arma::mat, arma::field<arma::vec>>::YOLOPreProcessor(
+      input, output, 2, 100, 100, 2, 2, 2, 4);
+
+  // Cell (0, 0) holds the objectness of each slot at (5 + 4) * s + 4.
+  const size_t gridSize = 2 * 2;
+  REQUIRE(output(4 * gridSize) == 1.0);
+  REQUIRE(output(13 * gridSize) == 1.0);
+  REQUIRE(output((9 + 5 + 1) * gridSize) == 0.0);
+  REQUIRE(output((5 + 1) * gridSize) == 1.0);
+  REQUIRE(output((9 + 5 + 2) * gridSize) == 1.0);
+  REQUIRE(arma::accu(output == 1.0) == 4);
+
+  // Encoding a batch gives the same targets as encoding each image.
+  arma::field<arma::vec> batch(1, 64);
+  for (size_t i = 0; i < batch.n_elem; ++i)
+  {
+    const size_t numObjects = 1 + i % 4;
+    batch(0, i).set_size(5 * numObjects);
+    for (size_t j = 0; j < numObjects; ++j)
+    {
+      const arma::vec corner = arma::randu<arma::vec>(2) * 300;
+      batch(0, i).subvec(5 * j, 5 * j + 4) = arma::vec({(double) (j % 20),
+          corner(0), corner(1), corner(0) + 100, corner(1) + 80});
+    }
+  }
+
+  for (const size_t version : {1, 3})
+  {
+    PreProcessor<arma::mat, arma::field<arma::vec>>::YOLOPreProcessor(
+        batch, output, version, 400, 380);
+    for (size_t i = 0; i < batch.n_elem; i += 7)
+    {
+      arma::field<arma::vec> image(1, 1);
+      image(0, 0) = batch(0, i);
+      arma::mat single;
+      PreProcessor<arma::mat, arma::field<arma::vec>>::YOLOPreProcessor(
+          image, single, version, 400, 380);
+      REQUIRE(arma::approx_equal(output.col(i), single, "absdiff", 1e-10));
+    }
+  }
+}
+
+TEST_CASE("LayoutConverterTest", "[PreProcessorsTest]")
+{
+  // Two 3 x 2 images with 2 interleaved channels.
+  arma::mat input = arma::reshape(arma::regspace(0, 23), 12, 2);
+
+  LayoutConverter converter;
+  arma::mat output;
+  converter.ToChannelFirst(input, output, 3, 2, 2);
+
+  arma::vec desired = {0, 2, 4, 6, 8, 10, 1, 3, 5, 7, 9, 11};
+  REQUIRE(arma::approx_equal(output.col(0), desired, "absdiff", 1e-10));
+  REQUIRE(arma::approx_equal(output.col(1), desired + 12, "absdiff", 1e-10));
+
+  // Converting back in place restores the images.
+  converter.ToChannelLast(output, 3, 2, 2);
+  REQUIRE(arma::approx_equal(output, input, "absdiff", 1e-10));
+
+  // Scale and per channel normalization are applied during the conversion.
+  LayoutConverter normalizer(0.5, {1.0, 2.0}, {1.0, 4.0});
+  normalizer.ToChannelFirst(input, output, 3, 2, 2);
+  desired = {-1, 0, 1, 2, 3, 4, -0.375, -0.125, 0.125, 0.375, 0.625, 0.875};
+  REQUIRE(arma::approx_equal(output.col(0), desired, "absdiff", 1e-10));
+
+  // ChannelFirstImages works for any image size.
+  arma::mat images(5 * 4 * 3, 3, arma::fill::randu);
+  images *= 255;
+  arma::mat expected;
+  LayoutConverter(1.0 / 255.0).ToChannelFirst(images, expected, 5, 4, 3);
+  PreProcessor<>::ChannelFirstImages(images, 5, 4, 3);
+  REQUIRE(arma::approx_equal(images, expected, "absdiff", 1e-10));
+  REQUIRE(images.max() <= 1.0);
+}
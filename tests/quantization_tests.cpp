@@ -0,0 +1,158 @@
+/**
+ * @file quantization_tests.cpp
+ * @author Kartik Dutt
+ *
+ * Tests for the int8 layers and the Quantizer.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#define MLPACK_ENABLE_ANN_SERIALIZATION
+#include <mlpack.hpp>
+#include <dataloader/dataloader.hpp>
+#include <utils/quantizer.hpp>
+#include "catch.hpp"
+
+using namespace mlpack;
+using namespace mlpack::models;
+
+/**
+ * Check that the quantized convolution computes the convolution of the
+ * original weights up to the quantization error, with and without groups.
+ */
+TEST_CASE("QuantizedConvolutionTest", "[QuantizationTest]")
+{
+  for (const size_t groups : {1, 4})
+  {
+    FFN<MeanSquaredError, RandomInitialization> model;
+    model.InputDimensions() = std::vector<size_t>({9, 7, 4});
+    if (groups == 1)
+      model.Add<Convolution>(8, 3, 3, 2, 2, 1, 1);
+    else
+      model.Add<GroupedConvolution>(8, 3, 3, groups, 1, 1, 1, 1);
+    model.Reset();
+    model.Parameters().randn();
+
+    arma::mat input(9 * 7 * 4, 3, arma::fill::randn);
+    arma::mat output;
+    model.Predict(input, output);
+
+    // The convolution parameters are the weights followed by the bias.
+    const size_t weightSize = 3 * 3 * (4 / groups) * 8;
+    const arma::mat weights(model.Parameters().memptr(), weightSize / 8, 8);
+    const arma::mat bias(model.Parameters().memptr() + weightSize, 8, 1);
+    QuantizedConvolution quantized(weights, bias, 3, 3,
+        (groups == 1) ? 2 : 1, (groups == 1) ? 2 : 1, 1, 1, 1, 1, groups);
+    quantized.InputDimensions() = model.InputDimensions();
+    quantized.ComputeOutputDimensions();
+
+    arma::mat quantizedOutput(output.n_rows, output.n_cols);
+    quantized.Forward(input, quantizedOutput);
+
+    // The scale of the input is recorded until the layer is calibrated.
+    REQUIRE(quantized.InputRange() == Approx(arma::abs(input).max()));
+    REQUIRE(arma::abs(quantizedOutput - output).max() <
+        0.02 * arma::abs(output).max());
+  }
+}
+
+/**
+ * Check that the quantized linear layer computes the product of the original
+ * weights up to the quantization error.
+ */
+TEST_CASE("QuantizedLinearTest", "[QuantizationTest]")
+{
+  arma::mat weights(10, 50, arma::fill::randn);
+  arma::mat bias(10, 1, arma::fill::randn);
+  arma::mat input(50, 6, arma::fill::randn);
+  arma::mat output = weights * input + arma::repmat(bias, 1, 6);
+
+  QuantizedLinear quantized(weights, bias);
+  quantized.InputDimensions() = std::vector<size_t>({50});
+  quantized.ComputeOutputDimensions();
+  quantized.InputScale() = arma::abs(input).max() / 127.0;
+
+  arma::mat quantizedOutput(10, 6);
+  quantized.Forward(input, quantizedOutput);
+
+  REQUIRE(quantized.OutputSize() == 10);
+  REQUIRE(arma::abs(quantizedOutput - output).max() <
+      0.02 * arma::abs(output).max());
+}
+
+/**
+ * Check that a quantized network predicts the same classes as the original
+ * network, calibrated and evaluated with the splits of a DataLoader.
+ */
+TEST_CASE("QuantizerTest", "[QuantizationTest]")
+{
+  FFN<CrossEntropyError, RandomInitialization> model;
+  model.InputDimensions() = std::vector<size_t>({8, 8, 3});
+  model.Add<Convolution>(8, 3, 3, 1, 1, 1, 1, "none", false);
+  model.Add<BatchNorm>();
+  model.Add<ReLU>();
+  AddMerge* merge = new AddMerge();
+  merge->Add<Convolution>(8, 3, 3, 1, 1, 1, 1);
+  merge->Add<Identity>();
+  model.Add(merge);
+  model.Add<ReLU>();
+  model.Add<BatchNorm>();
+  model.Add<Linear>(5);
+  model.Add<LogSoftMax>();
+  model.Reset();
+  model.Parameters().randn();
+
+  // The second BatchNorm follows a ReLU, so it is not folded and keeps its
+  // running statistics.
+  BatchNorm* bn = dynamic_cast<BatchNorm*>(model.Network()[5]);
+  REQUIRE(bn != NULL);
+  for (Layer<arma::mat>* layer : model.Network())
+  {
+    BatchNorm* normalization = dynamic_cast<BatchNorm*>(layer);
+    if (normalization != NULL)
+    {
+      normalization->TrainingMean().randn();
+      normalization->TrainingVariance().randu();
+      normalization->TrainingVariance() += 0.5;
+    }
+  }
+
+  // The labels of the validation split are the classes the model predicts.
+  DataLoader<> dataloader;
+  dataloader.TrainFeatures() = arma::randu<arma::mat>(8 * 8 * 3, 64);
+  dataloader.ValidFeatures() = arma::randu<arma::mat>(8 * 8 * 3, 32);
+  arma::mat output;
+  model.Predict(dataloader.ValidFeatures(), output);
+  dataloader.ValidLabels() = arma::conv_to<arma::mat>::from(
+      arma::index_max(output, 0));
+
+  Quantizer<> quantizer(16, 2);
+  FFN<CrossEntropyError, RandomInitialization> quantized =
+      quantizer.Quantize(model, dataloader);
+
+  // Both convolutions and the linear layer are quantized, the first
+  // BatchNorm was folded into the first convolution and only the second one
+  // has parameters.
+  REQUIRE(quantizer.QuantizedLayers() == 3);
+  REQUIRE(quantized.Parameters().n_elem == bn->WeightSize());
+
+  BatchNorm* quantizedBN = NULL;
+  for (Layer<arma::mat>* layer : quantized.Network())
+  {
+    if (dynamic_cast<BatchNorm*>(layer) != NULL)
+      quantizedBN = dynamic_cast<BatchNorm*>(layer);
+  }
+
+  REQUIRE(quantizedBN != NULL);
+  REQUIRE(arma::approx_equal(quantizedBN->TrainingMean(), bn->TrainingMean(),
+      "absdiff", 1e-12));
+  REQUIRE(arma::approx_equal(quantizedBN->TrainingVariance(),
+      bn->TrainingVariance(), "absdiff", 1e-12));
+
+  const double delta = quantizer.Evaluate(model, quantized, dataloader);
+  REQUIRE(quantizer.ModelAccuracy() == Approx(1.0));
+  REQUIRE(delta == Approx(1.0 - quantizer.QuantizedAccuracy()));
+  REQUIRE(delta <= 0.1);
+}
@@ -12,6 +12,12 @@
 #include "serialization.hpp"
 #include "catch.hpp"
 
+#include "../models/vgg/vgg.hpp"
+#include "../models/alexnet/alexnet.hpp"
+#include "../models/xception/xception.hpp"
+#include "../models/squeezenet/squeezenet.hpp"
+#include "../utils/precision_converter.hpp"
+
 namespace mlpack {
 
 // Utility function to check the equality of two Armadillo matrices.
@@ -110,4 +116,197 @@ void CheckMatrices(const arma::cube& x,
   }
 }
 
+// Single precision network used by the serialization tests.
+typedef FFN<CrossEntropyErrorType<arma::fmat>, RandomInitialization,
+    arma::fmat> FloatFFN;
+
+/**
+ * Create a network holding the given model without classifier layers, whose
+ * output is reduced to ten values by a linear layer.
+ *
+ * @tparam LayerType Type of the model.
+ * @tparam NetworkType Type of the network to create.
+ *
+ * @param network The network to create.
+ * @param imageSize Width and height of the input images.
+ */
+template<typename LayerType, typename NetworkType>
+void MakeNetwork(NetworkType& network, const size_t imageSize)
+{
+  typedef typename std::remove_reference<
+      decltype(network.Parameters())>::type MatType;
+
+  network.template Add<LayerType>(10, false);
+  network.template Add<LinearType<MatType>>(10);
+  network.InputDimensions() = std::vector<size_t>({imageSize, imageSize, 3});
+  network.Reset();
+}
+
+/**
+ * Check that a single precision model predicts the same after it is saved and
+ * loaded again with each archive type.
+ *
+ * @tparam LayerType Type of the single precision model.
+ */
+template<typename LayerType>
+void FloatModelSerializationTest(const size_t imageSize = 64)
+{
+  arma::fmat input(imageSize * imageSize * 3, 2, arma::fill::randu);
+
+  FloatFFN model;
+  MakeNetwork<LayerType>(model, imageSize);
+
+  arma::fmat output;
+  model.Predict(input, output);
+
+  FloatFFN xmlModel, jsonModel, binaryModel;
+  SerializeObjectAll(model, xmlModel, jsonModel, binaryModel);
+
+  arma::fmat xmlOutput, jsonOutput, binaryOutput;
+  xmlModel.Predict(input, xmlOutput);
+  jsonModel.Predict(input, jsonOutput);
+  binaryModel.Predict(input, binaryOutput);
+
+  const arma::mat expected = arma::conv_to<arma::mat>::from(output);
+  CheckMatrices(expected, arma::conv_to<arma::mat>::from(xmlOutput), 1e-5);
+  CheckMatrices(expected, arma::conv_to<arma::mat>::from(jsonOutput), 1e-5);
+  CheckMatrices(expected, arma::conv_to<arma::mat>::from(binaryOutput),
+      1e-5);
+}
+
+TEST_CASE("VGG11FloatSerializationTest", "[SerializationTest]")
+{
+  FloatModelSerializationTest<models::VGGType<arma::fmat, 11>>();
+}
+
+TEST_CASE("VGG11BNFloatSerializationTest", "[SerializationTest]")
+{
+  FloatModelSerializationTest<models::VGGType<arma::fmat, 11, true>>();
+}
+
+TEST_CASE("AlexNetFloatSerializationTest", "[SerializationTest]")
+{
+  FloatModelSerializationTest<models::AlexNetType<arma::fmat>>();
+}
+
+TEST_CASE("XceptionFloatSerializationTest", "[SerializationTest]")
+{
+  FloatModelSerializationTest<models::XceptionType<arma::fmat>>();
+}
+
+TEST_CASE("SqueezeNetFloatSerializationTest", "[SerializationTest]")
+{
+  FloatModelSerializationTest<models::SqueezeNetType<arma::fmat, 0>>();
+  FloatModelSerializationTest<models::SqueezeNetType<arma::fmat, 1>>();
+}
+
+/**
+ * Save a double precision model, convert the checkpoint to single precision
+ * and check that the loaded single precision model predicts the same as the
+ * double precision one, with a checkpoint of half the size. A model
+ * converted in memory must predict the same as well.
+ *
+ * @tparam LayerType Type of the double precision model.
+ * @tparam FloatLayerType Type of the single precision model.
+ *
+ * @param expectedStatistics Number of normalization layers of the model.
+ * @param imageSize Width and height of the input images.
+ */
+template<typename LayerType, typename FloatLayerType>
+void PrecisionConverterTest(const size_t expectedStatistics,
+                            const size_t imageSize = 64)
+{
+  arma::mat input(imageSize * imageSize * 3, 2, arma::fill::randu);
+
+  FFN<CrossEntropyError, RandomInitialization> model;
+  MakeNetwork<LayerType>(model, imageSize);
+
+  // A forward pass in training mode moves the running statistics of the
+  // BatchNorm layers away from their initial values.
+  arma::mat output;
+  model.SetNetworkMode(true);
+  model.Forward(input, output);
+  model.SetNetworkMode(false);
+  model.Predict(input, output);
+
+  const std::string doubleFile = FilterFileName(typeid(LayerType).name()) +
+      ".bin";
+  const std::string floatFile = FilterFileName(
+      typeid(FloatLayerType).name()) + ".bin";
+  data::Save(doubleFile, "model", model, true);
+
+  FloatFFN converted;
+  converted.template Add<FloatLayerType>(10, false);
+  converted.template Add<LinearType<arma::fmat>>(10);
+
+  models::PrecisionConverter<> converter;
+  converter.Convert<FFN<CrossEntropyError, RandomInitialization>>(
+      doubleFile, floatFile, "model", converted);
+  REQUIRE(converter.ConvertedStatistics() == expectedStatistics);
+
+  FloatFFN loaded;
+  data::Load(floatFile, "model", loaded, true);
+
+  std::ifstream doubleStream(doubleFile, std::ios::binary | std::ios::ate);
+  std::ifstream floatStream(floatFile, std::ios::binary | std::ios::ate);
+  const double doubleSize = doubleStream.tellg();
+  const double floatSize = floatStream.tellg();
+  doubleStream.close();
+  floatStream.close();
+  remove(doubleFile.c_str());
+  remove(floatFile.c_str());
+
+  // The weights take most of the checkpoint.
+  REQUIRE(floatSize < 0.55 * doubleSize);
+
+  arma::fmat floatOutput;
+  loaded.Predict(arma::conv_to<arma::fmat>::from(input), floatOutput);
+
+  REQUIRE(floatOutput.n_rows == output.n_rows);
+  REQUIRE(floatOutput.n_cols == output.n_cols);
+  for (size_t i = 0; i < output.n_elem; ++i)
+    REQUIRE(floatOutput[i] == Approx(output[i]).epsilon(1e-3).margin(1e-4));
+
+  // A model converted in memory predicts with the converted parameters.
+  FloatFFN inMemory;
+  inMemory.template Add<FloatLayerType>(10, false);
+  inMemory.template Add<LinearType<arma::fmat>>(10);
+  converter.Convert(model, inMemory);
+  REQUIRE(converter.ConvertedStatistics() == expectedStatistics);
+
+  arma::fmat inMemoryOutput;
+  inMemory.Predict(arma::conv_to<arma::fmat>::from(input), inMemoryOutput);
+  REQUIRE(inMemoryOutput.n_elem == output.n_elem);
+  for (size_t i = 0; i < output.n_elem; ++i)
+  {
+    REQUIRE(inMemoryOutput[i] ==
+        Approx(output[i]).epsilon(1e-3).margin(1e-4));
+  }
+}
+
+TEST_CASE("VGG11BNPrecisionConverterTest", "[SerializationTest]")
+{
+  PrecisionConverterTest<models::VGGType<arma::mat, 11, true>,
+      models::VGGType<arma::fmat, 11, true>>(8);
+}
+
+TEST_CASE("AlexNetPrecisionConverterTest", "[SerializationTest]")
+{
+  PrecisionConverterTest<models::AlexNetType<arma::mat>,
+      models::AlexNetType<arma::fmat>>(0);
+}
+
+TEST_CASE("XceptionPrecisionConverterTest", "[SerializationTest]")
+{
+  // Two stem, 32 block, 4 shortcut and 2 exit BatchNorm layers.
+  PrecisionConverterTest<models::XceptionType<arma::mat>,
+      models::XceptionType<arma::fmat>>(40);
+}
+
+TEST_CASE("SqueezeNetPrecisionConverterTest", "[SerializationTest]")
+{
+  PrecisionConverterTest<models::SqueezeNetType<arma::mat, 1>,
+      models::SqueezeNetType<arma::fmat, 1>>(0);
+}
+
 } // namespace mlpack
@@ -0,0 +1,133 @@
+/**
+ * @file weight_file_tests.cpp
+ * @author Kartik Dutt
+ *
+ * Tests for the WeightFile.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#define MLPACK_ENABLE_ANN_SERIALIZATION
+#include <mlpack.hpp>
+#include <layers/conv_bn_leaky_relu.hpp>
+#include <utils/weight_file.hpp>
+#include "catch.hpp"
+
+using namespace mlpack;
+using namespace mlpack::models;
+
+/**
+ * Build the network of the tests, optionally without its classifier.
+ */
+void BuildWeightFileNetwork(FFN<CrossEntropyError, RandomInitialization>& model,
+                            const bool includeTop)
+{
+  model.InputDimensions() = std::vector<size_t>({8, 8, 3});
+  model.Add<ConvBNLeakyReLU>(4, 3, 3, 1, 1, 1, 1);
+  MultiLayer<arma::mat>* block = new MultiLayer<arma::mat>();
+  block->Add<Convolution>(6, 3, 3, 2, 2, 1, 1);
+  block->Add<BatchNorm>();
+  block->Add<ReLU>();
+  model.Add(block);
+  if (includeTop)
+  {
+    model.Add<Linear>(5);
+    model.Add<LogSoftMax>();
+  }
+}
+
+/**
+ * Check that a network bound to a weight file predicts the same as the saved
+ * network, and that a network without its classifier is bound to the first
+ * layers of the file.
+ */
+TEST_CASE("WeightFileBindTest", "[WeightFileTest]")
+{
+  FFN<CrossEntropyError, RandomInitialization> model;
+  BuildWeightFileNetwork(model, true);
+  model.Reset();
+  model.Parameters().randn();
+
+  ConvBNLeakyReLU* fused = dynamic_cast<ConvBNLeakyReLU*>(model.Network()[0]);
+  MultiLayer<arma::mat>* block =
+      dynamic_cast<MultiLayer<arma::mat>*>(model.Network()[1]);
+  BatchNorm* batchNorm = dynamic_cast<BatchNorm*>(block->Network()[1]);
+  fused->TrainingMean().randn();
+  fused->TrainingVariance().randu();
+  batchNorm->TrainingMean().randn();
+  batchNorm->TrainingVariance().randu();
+
+  WeightFile<>::Save("weight_file_test.weights", model);
+  REQUIRE(WeightFile<>::IsWeightFile("weight_file_test.weights"));
+
+  arma::mat input(8 * 8 * 3, 4, arma::fill::randn);
+  arma::mat output, boundOutput;
+  model.Predict(input, output);
+
+  WeightFile<> weights("weight_file_test.weights");
+  REQUIRE(weights.Layers() == 4);
+  REQUIRE(weights.Parameters() == model.Parameters().n_elem);
+
+  FFN<CrossEntropyError, RandomInitialization> bound;
+  BuildWeightFileNetwork(bound, true);
+  REQUIRE(weights.Bind(bound) == 4);
+  bound.Predict(input, boundOutput);
+  REQUIRE(arma::approx_equal(boundOutput, output, "absdiff", 1e-12));
+
+  FFN<CrossEntropyError, RandomInitialization> prefix;
+  BuildWeightFileNetwork(prefix, false);
+  REQUIRE(weights.Bind(prefix) == 2);
+  const size_t prefixSize = prefix.Parameters().n_elem;
+  REQUIRE(prefixSize == fused->WeightSize() + block->WeightSize());
+  REQUIRE(arma::approx_equal(prefix.Parameters(),
+      model.Parameters().rows(0, prefixSize - 1), "absdiff", 1e-12));
+
+  const BatchNorm* prefixBatchNorm = dynamic_cast<const BatchNorm*>(
+      dynamic_cast<MultiLayer<arma::mat>*>(prefix.Network()[1])->Network()[1]);
+  REQUIRE(arma::approx_equal(prefixBatchNorm->TrainingVariance(),
+      batchNorm->TrainingVariance(), "absdiff", 1e-12));
+
+  // A network with other layers can't be bound.
+  FFN<CrossEntropyError, RandomInitialization> other;
+  other.InputDimensions() = std::vector<size_t>({8, 8, 3});
+  other.Add<Convolution>(7, 3, 3, 1, 1, 1, 1);
+  REQUIRE_THROWS_AS(weights.Bind(other), std::runtime_error);
+
+  remove("weight_file_test.weights");
+}
+
+/**
+ * Check that a truncated weight file is rejected before it is read.
+ */
+TEST_CASE("WeightFileTruncatedTest", "[WeightFileTest]")
+{
+  FFN<CrossEntropyError, RandomInitialization> model;
+  BuildWeightFileNetwork(model, true);
+  model.Reset();
+  WeightFile<>::Save("weight_file_test.weights", model);
+
+  std::ifstream file("weight_file_test.weights", std::ios::binary);
+  const std::string contents((std::istreambuf_iterator<char>(file)),
+      std::istreambuf_iterator<char>());
+  file.close();
+
+  // Cut the file in the header, the layer table, the parameters and the
+  // statistics.
+  for (const size_t size : { (size_t) 16, (size_t) 80, (size_t) 100,
+      contents.size() - model.Parameters().n_elem * sizeof(double),
+      contents.size() - 1 })
+  {
+    std::ofstream truncated("weight_file_truncated.weights",
+        std::ios::binary | std::ios::trunc);
+    truncated.write(contents.data(), size);
+    truncated.close();
+
+    REQUIRE_THROWS_AS(WeightFile<>("weight_file_truncated.weights"),
+        std::runtime_error);
+  }
+
+  remove("weight_file_test.weights");
+  remove("weight_file_truncated.weights");
+}
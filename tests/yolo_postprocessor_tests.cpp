@@ -0,0 +1,94 @@
+/**
+ * @file yolo_postprocessor_tests.cpp
+ * @author Kartik Dutt
+ *
+ * Tests for decoding and suppressing the output of YOLO models.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#include <dataloader/preprocessor.hpp>
+#include <models/yolo/yolo_postprocessor.hpp>
+#include "test_catch_tools.hpp"
+#include "catch.hpp"
+
+using namespace mlpack::models;
+
+/**
+ * Check that decoding the targets of YOLOPreProcessor gives back the
+ * annotated boxes.
+ */
+TEST_CASE("YOLOPostProcessorDecodeTest", "[YOLOPostProcessorTest]")
+{
+  arma::field<arma::vec> annotations(1, 3);
+  annotations(0, 0) = arma::vec({1, 10, 20, 110, 220});
+  annotations(0, 1) = arma::vec({2, 200, 210, 300, 400, 0, 300, 50, 380, 90});
+  annotations(0, 2) = arma::vec();
+
+  for (const size_t version : {1, 3})
+  {
+    arma::mat targets;
+    PreProcessor<arma::mat, arma::field<arma::vec>>::YOLOPreProcessor(
+        annotations, targets, version, 400, 400, 7, 7, 2, 3);
+
+    YOLOPostProcessor postProcessor(version, 400, 400, 7, 7, 2, 3);
+    arma::field<arma::mat> detections;
+    postProcessor.Apply(targets, detections);
+
+    REQUIRE(detections.n_elem == 3);
+    REQUIRE(detections(0, 0).n_cols == 1);
+    REQUIRE(detections(0, 1).n_cols == 2);
+    REQUIRE(detections(0, 2).n_cols == 0);
+
+    // Both YOLO v1 boxes of a cell decode to the same box, one is removed.
+    CheckMatrices(detections(0, 0), arma::mat({1, 10, 20, 110, 220, 1}).t());
+    for (size_t i = 0; i < 2; ++i)
+    {
+      const arma::vec& box = annotations(0, 1).subvec(5 * i, 5 * i + 4);
+      const size_t j = (detections(0, 1)(0, 0) == box(0)) ? 0 : 1;
+      CheckMatrices(detections(0, 1).col(j).head(5), box);
+    }
+  }
+}
+
+/**
+ * Check class-wise suppression on a small example, and that bucketing keeps
+ * the same boxes on a large random set.
+ */
+TEST_CASE("YOLOPostProcessorSuppressTest", "[YOLOPostProcessorTest]")
+{
+  // Boxes 0 and 1 overlap with an IoU of 0.81, box 2 overlaps box 0 as well
+  // but has another class.
+  arma::mat detections = arma::mat({
+      {0, 0, 1, 0},
+      {0, 1, 0, 50},
+      {0, 1, 0, 50},
+      {10, 10, 10, 60},
+      {10, 10, 10, 60},
+      {0.6, 0.9, 0.8, 0.7}});
+
+  YOLOPostProcessor postProcessor(1, 100, 100, 7, 7, 2, 2, 0.25, 0.5);
+  postProcessor.Suppress(detections);
+
+  REQUIRE(detections.n_cols == 3);
+  REQUIRE(detections(5, 0) == Approx(0.9));
+  REQUIRE(detections(5, 1) == Approx(0.8));
+  REQUIRE(detections(5, 2) == Approx(0.7));
+
+  arma::mat boxes(6, 3000);
+  boxes.row(0) = arma::floor(arma::randu<arma::rowvec>(3000) * 3);
+  boxes.rows(1, 2) = arma::randu<arma::mat>(2, 3000) * 1000;
+  boxes.rows(3, 4) = boxes.rows(1, 2) + 10 + arma::randu<arma::mat>(2, 3000) *
+      40;
+  boxes.row(5) = arma::randu<arma::rowvec>(3000);
+
+  arma::mat all = boxes, bucketed = boxes;
+  postProcessor.Suppress(all);
+  postProcessor.Bucketed() = true;
+  postProcessor.Suppress(bucketed);
+
+  REQUIRE(all.n_cols < boxes.n_cols);
+  CheckMatrices(all, bucketed);
+}
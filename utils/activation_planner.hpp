@@ -0,0 +1,177 @@
+/**
+ * @file activation_planner.hpp
+ * @author Kartik Dutt
+ *
+ * Definition of ActivationPlanner class which runs the inference of a network
+ * with a small pool of reused activation buffers.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_UTILS_ACTIVATION_PLANNER_HPP
+#define MODELS_UTILS_ACTIVATION_PLANNER_HPP
+
+#define MLPACK_ENABLE_ANN_SERIALIZATION
+#include <mlpack.hpp>
+
+namespace mlpack {
+namespace models {
+
+/**
+ * Inference mode for a trained network that bounds the memory of the
+ * activations. A forward pass of an FFN keeps the output of every layer, so
+ * its activation memory is the sum of all outputs. The planner instead
+ * analyzes the layers of the network once:
+ *
+ *  - sequential containers (MultiLayer and the models built on it) are
+ *    flattened into steps that run their layers,
+ *  - the branches of an AddMerge are planned with the input of the merge and
+ *    added into the output of one of them, Identity branches (skip
+ *    connections) refer to the input without a copy,
+ *  - the outputs of the branches of a Concat are copied into its output,
+ *  - Identity layers are skipped.
+ *
+ * Each output is only live from the step that computes it to the last step
+ * that reads it, so the outputs are assigned to a pool of buffers which are
+ * reused once their output is dead. The activation memory is then bounded by
+ * the widest set of live outputs, e.g. the input of a residual block, its
+ * branch and the output of the branch, instead of the sum of all outputs.
+ *
+ * The planner holds the layers of the network, which must outlive it and
+ * must not change after the planner is created.
+ *
+ * @code
+ * ResNet152 resNet(3, 224, 224);
+ * ActivationPlanner<> planner(resNet.GetModel());
+ * planner.Predict(input, output);
+ * @endcode
+ *
+ * @tparam MatType Matrix representation to accept as input and use for
+ *    computation.
+ */
+template<typename MatType = arma::mat>
+class ActivationPlanner
+{
+ public:
+  /**
+   * Plan the inference of the given network. Its input dimensions must be
+   * set, and it must be initialized, e.g. trained, loaded or Reset().
+   *
+   * @param model Network to plan.
+   */
+  template<typename OutputLayerType, typename InitializationRuleType>
+  ActivationPlanner(
+      FFN<OutputLayerType, InitializationRuleType, MatType>& model);
+
+  /**
+   * Compute the output of the network for the given input.
+   *
+   * @param input Input data, a sample in each column.
+   * @param output Output of the network.
+   * @param batchSize Number of samples computed at once.
+   */
+  void Predict(const MatType& input,
+               MatType& output,
+               const size_t batchSize = 128);
+
+  //! Get the number of steps of the plan.
+  size_t Steps() const { return steps.size(); }
+
+  //! Get the number of buffers the outputs are assigned to.
+  size_t Buffers() const { return bufferSizes.size(); }
+
+  //! Get the number of elements of the buffers for each sample.
+  size_t PlannedSize() const;
+
+  //! Get the number of elements of all outputs for each sample, i.e. the
+  //! activation memory if every output is kept.
+  size_t TotalSize() const;
+
+ private:
+  //! The kind of a step.
+  enum StepType
+  {
+    LayerStep,
+    AddStep,
+    ConcatStep
+  };
+
+  //! An output of the plan.
+  struct Tensor
+  {
+    //! Number of elements for each sample.
+    size_t size;
+    //! Dimensions of the output.
+    std::vector<size_t> dimensions;
+    //! Index of the buffer holding the output.
+    size_t buffer;
+    //! Index of the last step that reads or writes the output.
+    size_t lastUse;
+  };
+
+  //! A step of the plan.
+  struct Step
+  {
+    //! The kind of the step.
+    StepType type;
+    //! Layer run by a LayerStep.
+    Layer<MatType>* layer;
+    //! Outputs read by the step.
+    std::vector<size_t> inputs;
+    //! Output written by the step.
+    size_t output;
+  };
+
+  //! Determine whether the layer is a container whose layers run in order.
+  static bool IsSequential(const Layer<MatType>* layer);
+
+  /**
+   * Append the steps computing the given layer.
+   *
+   * @param layer Layer to plan.
+   * @param input Output the layer reads.
+   * @return Output the layer writes.
+   */
+  size_t Plan(Layer<MatType>* layer, const size_t input);
+
+  //! Create an output with the given dimensions.
+  size_t AddTensor(const std::vector<size_t>& dimensions);
+
+  //! Assign the outputs to buffers.
+  void Assign();
+
+  //! Get an alias of the given output for a batch of the given size.
+  void Alias(const size_t tensor,
+             MatType& alias,
+             const MatType& input,
+             const size_t begin,
+             const size_t batchSize);
+
+  //! Copy the outputs of the branches of a Concat into its output.
+  void Concatenate(const Step& step, const MatType& input,
+                   const size_t begin, const size_t batchSize);
+
+  //! Locally stored outputs, the first one is the input of the network.
+  std::vector<Tensor> tensors;
+
+  //! Locally stored steps of the plan.
+  std::vector<Step> steps;
+
+  //! Locally stored output of the network.
+  size_t networkOutput;
+
+  //! Locally stored number of elements of each buffer for each sample.
+  std::vector<size_t> bufferSizes;
+
+  //! Locally stored buffers.
+  std::vector<MatType> buffers;
+};
+
+} // namespace models
+} // namespace mlpack
+
+#include "activation_planner_impl.hpp"
+
+#endif
@@ -0,0 +1,363 @@
+/**
+ * @file activation_planner_impl.hpp
+ * @author Kartik Dutt
+ *
+ * Implementation of ActivationPlanner class which runs the inference of a
+ * network with a small pool of reused activation buffers.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_UTILS_ACTIVATION_PLANNER_IMPL_HPP
+#define MODELS_UTILS_ACTIVATION_PLANNER_IMPL_HPP
+
+// Incase it has not been included already.
+#include "activation_planner.hpp"
+
+namespace mlpack {
+namespace models {
+
+template<typename MatType>
+template<typename OutputLayerType, typename InitializationRuleType>
+ActivationPlanner<MatType>::ActivationPlanner(
+    FFN<OutputLayerType, InitializationRuleType, MatType>& model)
+{
+  if (model.InputDimensions().empty())
+  {
+    mlpack::Log::Fatal << "ActivationPlanner: the input dimensions of the "
+        << "model must be set." << std::endl;
+  }
+
+  // Predicting a single sample makes the network set the memory of the
+  // weights of its layers and compute their dimensions, and switches the
+  // layers to inference mode.
+  size_t inputSize = 1;
+  for (size_t i = 0; i < model.InputDimensions().size(); ++i)
+    inputSize *= model.InputDimensions()[i];
+
+  MatType probe(inputSize, 1, arma::fill::zeros);
+  MatType probeOutput;
+  model.Predict(probe, probeOutput);
+
+  networkOutput = AddTensor(model.InputDimensions());
+  for (Layer<MatType>* layer : model.Network())
+    networkOutput = Plan(layer, networkOutput);
+
+  Assign();
+
+  Log::Info << "ActivationPlanner: " << steps.size() << " steps assigned to "
+      << bufferSizes.size() << " buffers of " << PlannedSize() << " elements "
+      << "instead of " << TotalSize() << " for each sample." << std::endl;
+}
+
+template<typename MatType>
+void ActivationPlanner<MatType>::Predict(const MatType& input,
+                                         MatType& output,
+                                         const size_t batchSize)
+{
+  if (input.n_rows != tensors[0].size)
+  {
+    mlpack::Log::Fatal << "ActivationPlanner::Predict(): the input has "
+        << input.n_rows << " rows, but the network expects "
+        << tensors[0].size << "." << std::endl;
+  }
+
+  const size_t maxBatchSize = std::min(batchSize, (size_t) input.n_cols);
+  buffers.resize(bufferSizes.size());
+  for (size_t b = 0; b < bufferSizes.size(); ++b)
+  {
+    if (buffers[b].n_elem < bufferSizes[b] * maxBatchSize)
+      buffers[b].set_size(bufferSizes[b] * maxBatchSize, 1);
+  }
+
+  output.set_size(tensors[networkOutput].size, input.n_cols);
+  for (size_t begin = 0; begin < input.n_cols; begin += batchSize)
+  {
+    const size_t size = std::min(batchSize, (size_t) input.n_cols - begin);
+    for (const Step& step : steps)
+    {
+      MatType stepOutput;
+      Alias(step.output, stepOutput, input, begin, size);
+
+      if (step.type == ConcatStep)
+      {
+        Concatenate(step, input, begin, size);
+        continue;
+      }
+
+      for (size_t i = 0; i < step.inputs.size(); ++i)
+      {
+        MatType stepInput;
+        Alias(step.inputs[i], stepInput, input, begin, size);
+        if (step.type == LayerStep)
+          step.layer->Forward(stepInput, stepOutput);
+        else if (i > 0)
+          stepOutput += stepInput;
+        else if (step.inputs[0] != step.output)
+          stepOutput = stepInput;
+      }
+    }
+
+    MatType networkResult;
+    Alias(networkOutput, networkResult, input, begin, size);
+    output.cols(begin, begin + size - 1) = networkResult;
+  }
+}
+
+template<typename MatType>
+size_t ActivationPlanner<MatType>::PlannedSize() const
+{
+  size_t size = 0;
+  for (const size_t bufferSize : bufferSizes)
+    size += bufferSize;
+
+  return size;
+}
+
+template<typename MatType>
+size_t ActivationPlanner<MatType>::TotalSize() const
+{
+  // The input of the network is not an activation.
+  size_t size = 0;
+  for (size_t t = 1; t < tensors.size(); ++t)
+    size += tensors[t].size;
+
+  return size;
+}
+
+template<typename MatType>
+bool ActivationPlanner<MatType>::IsSequential(const Layer<MatType>* layer)
+{
+  return dynamic_cast<const MultiLayer<MatType>*>(layer) != NULL &&
+      dynamic_cast<const AddMergeType<MatType>*>(layer) == NULL &&
+      dynamic_cast<const ConcatType<MatType>*>(layer) == NULL;
+}
+
+template<typename MatType>
+size_t ActivationPlanner<MatType>::Plan(Layer<MatType>* layer,
+                                        const size_t input)
+{
+  if (dynamic_cast<IdentityType<MatType>*>(layer) != NULL)
+    return input;
+
+  if (IsSequential(layer))
+  {
+    size_t output = input;
+    for (Layer<MatType>* child :
+        static_cast<MultiLayer<MatType>*>(layer)->Network())
+    {
+      output = Plan(child, output);
+    }
+
+    return output;
+  }
+
+  AddMergeType<MatType>* merge = dynamic_cast<AddMergeType<MatType>*>(layer);
+  ConcatType<MatType>* concat = dynamic_cast<ConcatType<MatType>*>(layer);
+  if (merge == NULL && concat == NULL)
+  {
+    const size_t output = AddTensor(layer->OutputDimensions());
+    steps.push_back(Step{LayerStep, layer, {input}, output});
+    return output;
+  }
+
+  if (static_cast<MultiLayer<MatType>*>(layer)->Network().empty())
+  {
+    mlpack::Log::Fatal << "ActivationPlanner: an AddMerge or Concat layer has "
+        << "no branches." << std::endl;
+  }
+
+  // The outputs created by the branches are only read by the merge.
+  const size_t firstBranchTensor = tensors.size();
+  std::vector<size_t> branches;
+  for (Layer<MatType>* branch :
+      static_cast<MultiLayer<MatType>*>(layer)->Network())
+  {
+    branches.push_back(Plan(branch, input));
+  }
+
+  if (concat != NULL)
+  {
+    const size_t output = AddTensor(layer->OutputDimensions());
+    steps.push_back(Step{ConcatStep, NULL, branches, output});
+    return output;
+  }
+
+  // The branches are added into the output of the first branch that computed
+  // one, skip connections are read without a copy.
+  std::vector<size_t> inputs;
+  for (const size_t branch : branches)
+  {
+    if (branch >= firstBranchTensor && (inputs.empty() ||
+        inputs[0] < firstBranchTensor))
+    {
+      inputs.insert(inputs.begin(), branch);
+    }
+    else
+    {
+      inputs.push_back(branch);
+    }
+  }
+
+  const size_t output = (inputs[0] >= firstBranchTensor) ? inputs[0] :
+      AddTensor(layer->OutputDimensions());
+  steps.push_back(Step{AddStep, NULL, inputs, output});
+  return output;
+}
+
+template<typename MatType>
+size_t ActivationPlanner<MatType>::AddTensor(
+    const std::vector<size_t>& dimensions)
+{
+  size_t size = 1;
+  for (size_t i = 0; i < dimensions.size(); ++i)
+    size *= dimensions[i];
+
+  tensors.push_back(Tensor{size, dimensions, 0, 0});
+  return tensors.size() - 1;
+}
+
+template<typename MatType>
+void ActivationPlanner<MatType>::Assign()
+{
+  for (size_t s = 0; s < steps.size(); ++s)
+  {
+    tensors[steps[s].output].lastUse = s;
+    for (const size_t input : steps[s].inputs)
+      tensors[input].lastUse = s;
+  }
+
+  // The output of the network is read after the last step.
+  tensors[networkOutput].lastUse = steps.size();
+
+  // Outputs are created in the order of the steps, so a buffer can be reused
+  // by a later step once the last step reading its output is done.
+  std::vector<bool> assigned(tensors.size(), false);
+  std::vector<size_t> freeBuffers;
+  std::vector<size_t> live;
+  for (size_t s = 0; s < steps.size(); ++s)
+  {
+    for (size_t i = 0; i < live.size(); )
+    {
+      if (tensors[live[i]].lastUse < s)
+      {
+        freeBuffers.push_back(tensors[live[i]].buffer);
+        live[i] = live.back();
+        live.pop_back();
+      }
+      else
+      {
+        ++i;
+      }
+    }
+
+    const size_t output = steps[s].output;
+    if (assigned[output])
+      continue;
+
+    // Pick the smallest free buffer that fits the output, else grow the
+    // largest free buffer, else create a new one.
+    const size_t size = tensors[output].size;
+    size_t best = freeBuffers.size();
+    for (size_t b = 0; b < freeBuffers.size(); ++b)
+    {
+      const size_t bufferSize = bufferSizes[freeBuffers[b]];
+      const size_t bestSize = (best == freeBuffers.size()) ? 0 :
+          bufferSizes[freeBuffers[best]];
+      const bool fits = (bufferSize >= size);
+      const bool bestFits = (best != freeBuffers.size() && bestSize >= size);
+      if (best == freeBuffers.size() ||
+          (fits && (!bestFits || bufferSize < bestSize)) ||
+          (!fits && !bestFits && bufferSize > bestSize))
+      {
+        best = b;
+      }
+    }
+
+    size_t buffer;
+    if (best == freeBuffers.size())
+    {
+      buffer = bufferSizes.size();
+      bufferSizes.push_back(size);
+    }
+    else
+    {
+      buffer = freeBuffers[best];
+      freeBuffers[best] = freeBuffers.back();
+      freeBuffers.pop_back();
+      bufferSizes[buffer] = std::max(bufferSizes[buffer], size);
+    }
+
+    tensors[output].buffer = buffer;
+    assigned[output] = true;
+    live.push_back(output);
+  }
+}
+
+template<typename MatType>
+void ActivationPlanner<MatType>::Alias(const size_t tensor,
+                                       MatType& alias,
+                                       const MatType& input,
+                                       const size_t begin,
+                                       const size_t batchSize)
+{
+  // The input of the network is read in place.
+  typedef typename MatType::elem_type ElemType;
+  ElemType* memory = (tensor == 0) ?
+      const_cast<ElemType*>(input.colptr(begin)) :
+      buffers[tensors[tensor].buffer].memptr();
+
+  MakeAlias(alias, memory, tensors[tensor].size, batchSize);
+}
+
+template<typename MatType>
+void ActivationPlanner<MatType>::Concatenate(const Step& step,
+                                             const MatType& input,
+                                             const size_t begin,
+                                             const size_t batchSize)
+{
+  MatType output;
+  Alias(step.output, output, input, begin, batchSize);
+
+  // The branches differ in the size of the concatenated axis, the first one
+  // whose size differs from the output.
+  const std::vector<size_t>& dimensions = tensors[step.output].dimensions;
+  const std::vector<size_t>& first = tensors[step.inputs[0]].dimensions;
+  size_t axis = 0;
+  while (axis + 1 < dimensions.size() && first[axis] == dimensions[axis])
+    ++axis;
+
+  // Each sample is a sequence of blocks, in which the branches are stacked.
+  size_t blocks = 1;
+  for (size_t i = axis + 1; i < dimensions.size(); ++i)
+    blocks *= dimensions[i];
+  const size_t outputBlock = tensors[step.output].size / blocks;
+
+  size_t offset = 0;
+  for (const size_t branch : step.inputs)
+  {
+    MatType branchOutput;
+    Alias(branch, branchOutput, input, begin, batchSize);
+    const size_t branchBlock = tensors[branch].size / blocks;
+
+    #pragma omp parallel for schedule(static)
+    for (omp_size_t s = 0; s < (omp_size_t) batchSize; ++s)
+    {
+      for (size_t b = 0; b < blocks; ++b)
+      {
+        std::copy(branchOutput.colptr(s) + b * branchBlock,
+            branchOutput.colptr(s) + (b + 1) * branchBlock,
+            output.colptr(s) + b * outputBlock + offset);
+      }
+    }
+
+    offset += branchBlock;
+  }
+}
+
+} // namespace models
+} // namespace mlpack
+
+#endif
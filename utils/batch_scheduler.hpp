@@ -0,0 +1,191 @@
+/**
+ * @file batch_scheduler.hpp
+ * @author Kartik Dutt
+ *
+ * Definition of BatchScheduler class which groups single requests into
+ * batches for an InferenceEngine.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_UTILS_BATCH_SCHEDULER_HPP
+#define MODELS_UTILS_BATCH_SCHEDULER_HPP
+
+#define MLPACK_ENABLE_ANN_SERIALIZATION
+#include <mlpack.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <thread>
+
+#include "inference_engine.hpp"
+#include "latency_histogram.hpp"
+
+namespace mlpack {
+namespace models {
+
+/**
+ * Dynamic batching for serving single samples. A network predicts a batch
+ * of samples much faster than the samples one by one, since its layers then
+ * compute matrix products instead of matrix-vector products, but a service
+ * receives its requests one by one. Callers submit a single sample and get a
+ * future of its output; the scheduler queues the samples and its workers
+ * predict them in batches, a batch as soon as the queue holds the maximum
+ * batch size or the oldest queued sample has waited for the maximum delay.
+ * Under light load a request is delayed by at most the maximum delay, under
+ * heavy load the batches fill up before the deadline.
+ *
+ * The workers predict with an InferenceEngine, so several workers share the
+ * parameters of the network and each uses a workspace of the engine. The
+ * scheduler records the time the requests wait in the queue and the time
+ * the batches take to compute in histograms, whose percentiles help to tune
+ * the maximum batch size and delay.
+ *
+ * @code
+ * ResNet50 resNet(3, 224, 224, true, true);
+ * InferenceEngine<> engine(resNet.GetModel());
+ * BatchScheduler<> scheduler(engine, 16, std::chrono::microseconds(2000));
+ *
+ * // From any thread.
+ * std::future<arma::mat> result = scheduler.Submit(image);
+ * arma::mat output = result.get();
+ *
+ * const double p99 = scheduler.QueueWait().Percentile(99);
+ * @endcode
+ *
+ * @tparam OutputLayerType The output layer type of the network.
+ * @tparam InitializationRuleType The initialization rule of the network.
+ * @tparam MatType Matrix representation to accept as input and use for
+ *    computation.
+ */
+template<
+  typename OutputLayerType = CrossEntropyError,
+  typename InitializationRuleType = RandomInitialization,
+  typename MatType = arma::mat
+>
+class BatchScheduler
+{
+ public:
+  //! The type of the engine that predicts the batches.
+  typedef InferenceEngine<OutputLayerType, InitializationRuleType, MatType>
+      EngineType;
+
+  /**
+   * Create the scheduler and start its workers. The engine must outlive the
+   * scheduler.
+   *
+   * @param engine Engine that predicts the batches.
+   * @param maxBatchSize Largest number of samples in a batch.
+   * @param maxDelay Longest time a sample waits for a batch to fill up.
+   * @param workers Number of batches predicted at once.
+   */
+  BatchScheduler(EngineType& engine,
+                 const size_t maxBatchSize = 16,
+                 const std::chrono::microseconds maxDelay =
+                     std::chrono::microseconds(2000),
+                 const size_t workers = 1);
+
+  //! Predict the queued samples and stop the workers.
+  ~BatchScheduler();
+
+  //! The workers refer to the scheduler.
+  BatchScheduler(const BatchScheduler&) = delete;
+  BatchScheduler& operator=(const BatchScheduler&) = delete;
+
+  /**
+   * Queue a sample for prediction. Can be called from several threads at
+   * once.
+   *
+   * @param sample Input data, a single column.
+   * @return The future output of the network for the sample.
+   */
+  std::future<MatType> Submit(const MatType& sample);
+
+  //! Get the time the requests waited in the queue, in microseconds.
+  LatencyHistogram QueueWait() const;
+
+  //! Get the time the batches took to compute, in microseconds.
+  LatencyHistogram Compute() const;
+
+  //! Get the number of predicted batches.
+  size_t Batches() const;
+
+  //! Get the number of predicted samples.
+  size_t Requests() const;
+
+  //! Forget the recorded latencies and counts.
+  void ResetStatistics();
+
+  //! Get the largest number of samples in a batch.
+  size_t MaxBatchSize() const { return maxBatchSize; }
+
+  //! Get the longest time a sample waits for a batch to fill up.
+  std::chrono::microseconds MaxDelay() const { return maxDelay; }
+
+ private:
+  typedef std::chrono::steady_clock Clock;
+
+  //! A queued sample.
+  struct Request
+  {
+    //! The sample.
+    MatType sample;
+    //! The promise of the output.
+    std::promise<MatType> result;
+    //! The time the sample was queued.
+    Clock::time_point arrival;
+  };
+
+  //! Take batches from the queue and predict them until the scheduler stops.
+  void Work();
+
+  //! Locally stored engine that predicts the batches.
+  EngineType& engine;
+
+  //! Locally stored largest number of samples in a batch.
+  size_t maxBatchSize;
+
+  //! Locally stored longest time a sample waits for a batch to fill up.
+  std::chrono::microseconds maxDelay;
+
+  //! Locally stored number of rows of a sample, set by the first sample.
+  size_t inputSize;
+
+  //! Locally stored queued samples.
+  std::deque<Request> queue;
+
+  //! Locally stored whether the workers stop once the queue is empty.
+  bool stopping;
+
+  //! Locally stored mutex guarding the queue.
+  std::mutex mutex;
+
+  //! Locally stored condition signalled when a sample is queued or the
+  //! scheduler stops.
+  std::condition_variable available;
+
+  //! Locally stored workers.
+  std::vector<std::thread> threads;
+
+  //! Locally stored time the requests waited in the queue.
+  LatencyHistogram queueWait;
+
+  //! Locally stored time the batches took to compute.
+  LatencyHistogram compute;
+
+  //! Locally stored number of predicted batches.
+  size_t batches;
+
+  //! Locally stored mutex guarding the statistics.
+  mutable std::mutex statisticsMutex;
+}; // class BatchScheduler
+
+} // namespace models
+} // namespace mlpack
+
+#include "batch_scheduler_impl.hpp"
+
+#endif
@@ -0,0 +1,256 @@
+/**
+ * @file batch_scheduler_impl.hpp
+ * @author Kartik Dutt
+ *
+ * Implementation of BatchScheduler class which groups single requests into
+ * batches for an InferenceEngine.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_UTILS_BATCH_SCHEDULER_IMPL_HPP
+#define MODELS_UTILS_BATCH_SCHEDULER_IMPL_HPP
+
+// Incase it has not been included already.
+#include "batch_scheduler.hpp"
+
+namespace mlpack {
+namespace models {
+
+template<
+  typename OutputLayerType,
+  typename InitializationRuleType,
+  typename MatType
+>
+BatchScheduler<OutputLayerType, InitializationRuleType, MatType>::
+BatchScheduler(EngineType& engine,
+               const size_t maxBatchSize,
+               const std::chrono::microseconds maxDelay,
+               const size_t workers) :
+    engine(engine),
+    maxBatchSize(maxBatchSize),
+    maxDelay(maxDelay),
+    inputSize(0),
+    stopping(false),
+    batches(0)
+{
+  if (maxBatchSize == 0 || workers == 0)
+  {
+    mlpack::Log::Fatal << "BatchScheduler: the maximum batch size and the "
+        << "number of workers must be positive." << std::endl;
+  }
+
+  // Each worker uses a workspace of the engine.
+  engine.Reserve(workers);
+  for (size_t i = 0; i < workers; ++i)
+    threads.emplace_back(&BatchScheduler::Work, this);
+}
+
+template<
+  typename OutputLayerType,
+  typename InitializationRuleType,
+  typename MatType
+>
+BatchScheduler<OutputLayerType, InitializationRuleType, MatType>::
+~BatchScheduler()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+
+  available.notify_all();
+  for (std::thread& thread : threads)
+    thread.join();
+}
+
+template<
+  typename OutputLayerType,
+  typename InitializationRuleType,
+  typename MatType
+>
+std::future<MatType>
+BatchScheduler<OutputLayerType, InitializationRuleType, MatType>::Submit(
+    const MatType& sample)
+{
+  if (sample.n_cols != 1)
+  {
+    mlpack::Log::Fatal << "BatchScheduler::Submit(): the sample must be a "
+        << "single column, but it has " << sample.n_cols << " columns."
+        << std::endl;
+  }
+
+  Request request;
+  request.sample = sample;
+  request.arrival = Clock::now();
+  std::future<MatType> result = request.result.get_future();
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (inputSize == 0)
+      inputSize = sample.n_rows;
+
+    if (sample.n_rows != inputSize)
+    {
+      mlpack::Log::Fatal << "BatchScheduler::Submit(): the sample has "
+          << sample.n_rows << " rows, but the samples before had "
+          << inputSize << "." << std::endl;
+    }
+
+    queue.push_back(std::move(request));
+  }
+
+  // A worker waiting for its batch to fill up or an idle worker.
+  available.notify_all();
+  return result;
+}
+
+template<
+  typename OutputLayerType,
+  typename InitializationRuleType,
+  typename MatType
+>
+LatencyHistogram
+BatchScheduler<OutputLayerType, InitializationRuleType, MatType>::
+QueueWait() const
+{
+  std::lock_guard<std::mutex> lock(statisticsMutex);
+  return queueWait;
+}
+
+template<
+  typename OutputLayerType,
+  typename InitializationRuleType,
+  typename MatType
+>
+LatencyHistogram
+BatchScheduler<OutputLayerType, InitializationRuleType, MatType>::
+Compute() const
+{
+  std::lock_guard<std::mutex> lock(statisticsMutex);
+  return compute;
+}
+
+template<
+  typename OutputLayerType,
+  typename InitializationRuleType,
+  typename MatType
+>
+size_t BatchScheduler<OutputLayerType, InitializationRuleType, MatType>::
+Batches() const
+{
+  std::lock_guard<std::mutex> lock(statisticsMutex);
+  return batches;
+}
+
+template<
+  typename OutputLayerType,
+  typename InitializationRuleType,
+  typename MatType
+>
+size_t BatchScheduler<OutputLayerType, InitializationRuleType, MatType>::
+Requests() const
+{
+  std::lock_guard<std::mutex> lock(statisticsMutex);
+  return queueWait.Count();
+}
+
+template<
+  typename OutputLayerType,
+  typename InitializationRuleType,
+  typename MatType
+>
+void BatchScheduler<OutputLayerType, InitializationRuleType, MatType>::
+ResetStatistics()
+{
+  std::lock_guard<std::mutex> lock(statisticsMutex);
+  queueWait.Reset();
+  compute.Reset();
+  batches = 0;
+}
+
+template<
+  typename OutputLayerType,
+  typename InitializationRuleType,
+  typename MatType
+>
+void BatchScheduler<OutputLayerType, InitializationRuleType, MatType>::Work()
+{
+  std::vector<Request> batch;
+  MatType input, output;
+  while (true)
+  {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      available.wait(lock, [this]() { return stopping || !queue.empty(); });
+      if (queue.empty())
+        return;
+
+      // Wait for the batch to fill up until the oldest sample is due; once
+      // the scheduler stops, the queued samples are predicted right away.
+      const Clock::time_point deadline = queue.front().arrival + maxDelay;
+      available.wait_until(lock, deadline, [this]()
+      {
+        return stopping || queue.size() >= maxBatchSize;
+      });
+
+      // Another worker may have taken the samples.
+      if (queue.empty())
+        continue;
+
+      const size_t size = std::min(maxBatchSize, queue.size());
+      batch.clear();
+      for (size_t i = 0; i < size; ++i)
+      {
+        batch.push_back(std::move(queue.front()));
+        queue.pop_front();
+      }
+    }
+
+    const Clock::time_point start = Clock::now();
+    input.set_size(batch[0].sample.n_rows, batch.size());
+    for (size_t i = 0; i < batch.size(); ++i)
+      input.col(i) = batch[i].sample;
+
+    std::exception_ptr error;
+    try
+    {
+      engine.Predict(input, output, batch.size());
+    }
+    catch (...)
+    {
+      error = std::current_exception();
+    }
+
+    // The statistics are recorded before the outputs are delivered, so they
+    // include every request whose output was received.
+    const Clock::time_point end = Clock::now();
+    {
+      std::lock_guard<std::mutex> lock(statisticsMutex);
+      for (size_t i = 0; i < batch.size(); ++i)
+      {
+        queueWait.Add(std::chrono::duration<double, std::micro>(
+            start - batch[i].arrival).count());
+      }
+
+      compute.Add(std::chrono::duration<double, std::micro>(end - start)
+          .count());
+      batches++;
+    }
+
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+      if (error)
+        batch[i].result.set_exception(error);
+      else
+        batch[i].result.set_value(output.col(i));
+    }
+  }
+}
+
+} // namespace models
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,102 @@
+/**
+ * @file concurrent_branches.hpp
+ * @author Kartik Dutt
+ *
+ * Utility to run the branches of the blocks of a network concurrently.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_UTILS_CONCURRENT_BRANCHES_HPP
+#define MODELS_UTILS_CONCURRENT_BRANCHES_HPP
+
+#define MLPACK_ENABLE_ANN_SERIALIZATION
+#include <mlpack.hpp>
+#include <layers/parallel_add_merge.hpp>
+#include <layers/view_concat.hpp>
+
+namespace mlpack {
+namespace models {
+
+/**
+ * Sets whether the ParallelAddMerge and ViewConcat blocks of a network run
+ * their branches concurrently, e.g. the residual blocks of ResNet and
+ * Xception and the Fire blocks of SqueezeNet. The results are the same either
+ * way, so the option only trades the parallelism inside the layers of a
+ * branch for the parallelism across the branches.
+ *
+ * @code
+ * ResNet50 resNet(3, 224, 224, true, false, 1000);
+ * ConcurrentBranches<>::Set(resNet.GetModel(), true);
+ * resNet.GetModel().Predict(image, output);
+ * @endcode
+ *
+ * @tparam MatType Matrix type of the network.
+ */
+template<typename MatType = arma::mat>
+class ConcurrentBranches
+{
+ public:
+  /**
+   * Set whether the blocks of the given network run their branches
+   * concurrently.
+   *
+   * @param model The network.
+   * @param concurrent Whether to run the branches concurrently.
+   * @return The number of blocks that were set.
+   */
+  template<typename OutputLayerType, typename InitializationRuleType>
+  static size_t Set(
+      FFN<OutputLayerType, InitializationRuleType, MatType>& model,
+      const bool concurrent = true)
+  {
+    size_t blocks = 0;
+    for (Layer<MatType>* layer : model.Network())
+      blocks += Set(layer, concurrent);
+
+    return blocks;
+  }
+
+  /**
+   * Set whether the given layer, if it is a block, and the blocks it holds
+   * run their branches concurrently.
+   *
+   * @param layer The layer.
+   * @param concurrent Whether to run the branches concurrently.
+   * @return The number of blocks that were set.
+   */
+  static size_t Set(Layer<MatType>* layer, const bool concurrent = true)
+  {
+    size_t blocks = 0;
+    ParallelAddMergeType<MatType>* merge =
+        dynamic_cast<ParallelAddMergeType<MatType>*>(layer);
+    ViewConcatType<MatType>* concat =
+        dynamic_cast<ViewConcatType<MatType>*>(layer);
+    if (merge != NULL)
+    {
+      merge->Concurrent() = concurrent;
+      ++blocks;
+    }
+    else if (concat != NULL)
+    {
+      concat->Concurrent() = concurrent;
+      ++blocks;
+    }
+
+    MultiLayer<MatType>* container = dynamic_cast<MultiLayer<MatType>*>(layer);
+    if (container != NULL)
+    {
+      for (Layer<MatType>* child : container->Network())
+        blocks += Set(child, concurrent);
+    }
+
+    return blocks;
+  }
+};
+
+} // namespace models
+} // namespace mlpack
+
+#endif
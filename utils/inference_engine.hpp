@@ -0,0 +1,152 @@
+/**
+ * @file inference_engine.hpp
+ * @author Kartik Dutt
+ *
+ * Definition of InferenceEngine class which runs the inference of a network
+ * from several threads with a single copy of its parameters.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_UTILS_INFERENCE_ENGINE_HPP
+#define MODELS_UTILS_INFERENCE_ENGINE_HPP
+
+#define MLPACK_ENABLE_ANN_SERIALIZATION
+#include <mlpack.hpp>
+#include <memory>
+#include <mutex>
+
+namespace mlpack {
+namespace models {
+
+/**
+ * Thread-safe inference for a trained network. FFN::Predict() writes the
+ * activations and the scratch buffers of the layers, so a network can only
+ * serve one thread at a time, and a copy of the network for each thread
+ * copies its parameters too. The engine instead keeps one read-only copy of
+ * the parameters and gives each concurrent call of Predict() a workspace: a
+ * network with clones of the layers, whose weights are aliases of the shared
+ * parameters. A workspace only holds the activations, the scratch buffers and
+ * the running statistics of the layers, so N threads predict concurrently
+ * with one copy of the weights. Creating a workspace clones one layer of the
+ * network after another, which briefly copies the weights of that layer;
+ * for models that are a single block, like VGG, SqueezeNet or Xception, that
+ * is a temporary copy of all the weights.
+ *
+ * Workspaces are created on demand, when every workspace is in use, and are
+ * reused afterwards, so their number is the largest number of concurrent
+ * calls; Reserve() creates them in advance. The layers of a workspace still
+ * use OpenMP, so with many serving threads OMP_NUM_THREADS is best lowered.
+ *
+ * @code
+ * ResNet50 resNet(3, 224, 224, true, true);
+ * InferenceEngine<> engine(resNet.GetModel());
+ *
+ * // From any number of threads.
+ * engine.Predict(image, output);
+ * @endcode
+ *
+ * @tparam OutputLayerType The output layer type of the network.
+ * @tparam InitializationRuleType The initialization rule of the network.
+ * @tparam MatType Matrix representation to accept as input and use for
+ *    computation.
+ */
+template<
+  typename OutputLayerType = CrossEntropyError,
+  typename InitializationRuleType = RandomInitialization,
+  typename MatType = arma::mat
+>
+class InferenceEngine
+{
+ public:
+  //! The type of the network and of the workspaces.
+  typedef FFN<OutputLayerType, InitializationRuleType, MatType> NetworkType;
+
+  /**
+   * Create the engine for the given network, whose input dimensions must be
+   * set and which must be initialized, e.g. trained, loaded or Reset(). The
+   * parameters are copied, unless they are shared, in which case the network
+   * must outlive the engine and its parameters must not change, e.g. a
+   * network bound to a WeightFile.
+   *
+   * @param model Network to run.
+   * @param shareParameters Whether to use the parameters of the network
+   *     instead of a copy.
+   */
+  InferenceEngine(const NetworkType& model,
+                  const bool shareParameters = false);
+
+  //! The workspaces alias the parameters of the engine.
+  InferenceEngine(const InferenceEngine&) = delete;
+  InferenceEngine& operator=(const InferenceEngine&) = delete;
+
+  /**
+   * Compute the output of the network for the given input, using a free
+   * workspace. Can be called from several threads at once.
+   *
+   * @param predictors Input data, a sample in each column.
+   * @param results Output of the network.
+   * @param batchSize Number of samples computed at once.
+   */
+  void Predict(const MatType& predictors,
+               MatType& results,
+               const size_t batchSize = 128);
+
+  /**
+   * Create workspaces until there are at least the given number, so the
+   * first concurrent calls don't create them.
+   *
+   * @param count Number of workspaces.
+   */
+  void Reserve(const size_t count);
+
+  //! Get the number of workspaces.
+  size_t Workspaces() const;
+
+  //! Get the shared parameters.
+  const MatType& Parameters() const { return parameters; }
+
+ private:
+  /**
+   * Create a network with clones of the given layers, whose weights are
+   * aliases of the shared parameters.
+   *
+   * @param network Layers to clone.
+   */
+  std::unique_ptr<NetworkType> Clone(
+      const std::vector<Layer<MatType>*>& network);
+
+  //! Take a free workspace, or create one if every workspace is in use.
+  NetworkType* Acquire();
+
+  //! Return a workspace to the free workspaces.
+  void Release(NetworkType* workspace);
+
+  //! Locally stored shared parameters.
+  MatType parameters;
+
+  //! Locally stored input dimensions of the network.
+  std::vector<size_t> inputDimensions;
+
+  //! Locally stored network the workspaces are cloned from, which never
+  //! runs, so it can be cloned while the workspaces run.
+  std::unique_ptr<NetworkType> prototype;
+
+  //! Locally stored workspaces.
+  std::vector<std::unique_ptr<NetworkType>> workspaces;
+
+  //! Locally stored workspaces which aren't in use.
+  std::vector<NetworkType*> freeWorkspaces;
+
+  //! Locally stored mutex guarding the workspaces.
+  mutable std::mutex mutex;
+}; // class InferenceEngine
+
+} // namespace models
+} // namespace mlpack
+
+#include "inference_engine_impl.hpp"
+
+#endif
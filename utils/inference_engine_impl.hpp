@@ -0,0 +1,202 @@
+/**
+ * @file inference_engine_impl.hpp
+ * @author Kartik Dutt
+ *
+ * Implementation of InferenceEngine class which runs the inference of a
+ * network from several threads with a single copy of its parameters.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_UTILS_INFERENCE_ENGINE_IMPL_HPP
+#define MODELS_UTILS_INFERENCE_ENGINE_IMPL_HPP
+
+// Incase it has not been included already.
+#include "inference_engine.hpp"
+
+namespace mlpack {
+namespace models {
+
+template<
+  typename OutputLayerType,
+  typename InitializationRuleType,
+  typename MatType
+>
+InferenceEngine<OutputLayerType, InitializationRuleType, MatType>::
+InferenceEngine(const NetworkType& model, const bool shareParameters) :
+    inputDimensions(model.InputDimensions())
+{
+  if (inputDimensions.empty())
+  {
+    mlpack::Log::Fatal << "InferenceEngine: the input dimensions of the "
+        << "model must be set." << std::endl;
+  }
+
+  if (model.Parameters().n_elem == 0)
+  {
+    mlpack::Log::Fatal << "InferenceEngine: the model must be initialized, "
+        << "e.g. trained, loaded or Reset()." << std::endl;
+  }
+
+  // The parameters of the network are only read.
+  if (shareParameters)
+  {
+    MakeAlias(parameters, const_cast<typename MatType::elem_type*>(
+        model.Parameters().memptr()), model.Parameters().n_elem, 1);
+  }
+  else
+  {
+    parameters = model.Parameters();
+  }
+
+  prototype = Clone(model.Network());
+}
+
+template<
+  typename OutputLayerType,
+  typename InitializationRuleType,
+  typename MatType
+>
+void InferenceEngine<OutputLayerType, InitializationRuleType, MatType>::
+Predict(const MatType& predictors, MatType& results, const size_t batchSize)
+{
+  NetworkType* workspace = Acquire();
+  try
+  {
+    workspace->Predict(predictors, results, batchSize);
+  }
+  catch (...)
+  {
+    Release(workspace);
+    throw;
+  }
+
+  Release(workspace);
+}
+
+template<
+  typename OutputLayerType,
+  typename InitializationRuleType,
+  typename MatType
+>
+void InferenceEngine<OutputLayerType, InitializationRuleType, MatType>::
+Reserve(const size_t count)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  while (workspaces.size() < count)
+  {
+    workspaces.push_back(Clone(prototype->Network()));
+    freeWorkspaces.push_back(workspaces.back().get());
+  }
+}
+
+template<
+  typename OutputLayerType,
+  typename InitializationRuleType,
+  typename MatType
+>
+size_t InferenceEngine<OutputLayerType, InitializationRuleType, MatType>::
+Workspaces() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return workspaces.size();
+}
+
+template<
+  typename OutputLayerType,
+  typename InitializationRuleType,
+  typename MatType
+>
+std::unique_ptr<
+    FFN<OutputLayerType, InitializationRuleType, MatType>
+> InferenceEngine<OutputLayerType, InitializationRuleType, MatType>::Clone(
+    const std::vector<Layer<MatType>*>& network)
+{
+  // Clone() copies the weights of a layer, and of every layer inside it for
+  // a MultiLayer such as the single block of VGG, SqueezeNet or Xception.
+  // SetWeights() right after frees that copy and points the weights at the
+  // shared parameters, so a workspace keeps no weights of its own, though
+  // creating it briefly needs the weights of its largest layer.
+  std::unique_ptr<NetworkType> workspace(new NetworkType());
+  workspace->InputDimensions() = inputDimensions;
+  std::vector<size_t> dimensions = inputDimensions;
+  size_t offset = 0;
+  for (const Layer<MatType>* layer : network)
+  {
+    Layer<MatType>* clone = layer->Clone();
+    clone->InputDimensions() = dimensions;
+    clone->ComputeOutputDimensions();
+    dimensions = clone->OutputDimensions();
+
+    if (offset + clone->WeightSize() > parameters.n_elem)
+    {
+      delete clone;
+      mlpack::Log::Fatal << "InferenceEngine: the layers of the model have "
+          << "more weights than its " << parameters.n_elem << " parameters."
+          << std::endl;
+    }
+
+    clone->SetWeights(parameters.memptr() + offset);
+    offset += clone->WeightSize();
+    workspace->Add(clone);
+  }
+
+  if (offset != parameters.n_elem)
+  {
+    mlpack::Log::Fatal << "InferenceEngine: the layers of the model have "
+        << offset << " weights, but the model has " << parameters.n_elem
+        << " parameters." << std::endl;
+  }
+
+  MakeAlias(workspace->Parameters(), parameters.memptr(), parameters.n_elem,
+      1);
+  return workspace;
+}
+
+template<
+  typename OutputLayerType,
+  typename InitializationRuleType,
+  typename MatType
+>
+typename InferenceEngine<
+    OutputLayerType, InitializationRuleType, MatType
+>::NetworkType*
+InferenceEngine<OutputLayerType, InitializationRuleType, MatType>::Acquire()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!freeWorkspaces.empty())
+    {
+      NetworkType* workspace = freeWorkspaces.back();
+      freeWorkspaces.pop_back();
+      return workspace;
+    }
+  }
+
+  // The prototype never runs, so it is cloned outside the lock.
+  std::unique_ptr<NetworkType> workspace = Clone(prototype->Network());
+  NetworkType* created = workspace.get();
+
+  std::lock_guard<std::mutex> lock(mutex);
+  workspaces.push_back(std::move(workspace));
+  return created;
+}
+
+template<
+  typename OutputLayerType,
+  typename InitializationRuleType,
+  typename MatType
+>
+void InferenceEngine<OutputLayerType, InitializationRuleType, MatType>::
+Release(NetworkType* workspace)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  freeWorkspaces.push_back(workspace);
+}
+
+} // namespace models
+} // namespace mlpack
+
+#endif
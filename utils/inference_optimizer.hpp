@@ -0,0 +1,239 @@
+/**
+ * @file inference_optimizer.hpp
+ * @author Kartik Dutt
+ *
+ * Definition of InferenceOptimizer class which simplifies trained networks
+ * for inference.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_UTILS_INFERENCE_OPTIMIZER_HPP
+#define MODELS_UTILS_INFERENCE_OPTIMIZER_HPP
+
+#define MLPACK_ENABLE_ANN_SERIALIZATION
+#include <mlpack.hpp>
+#include <layers/conv_bn_leaky_relu.hpp>
+#include <layers/depthwise_convolution.hpp>
+#include <layers/fast_convolution.hpp>
+#include <layers/parallel_add_merge.hpp>
+
+namespace mlpack {
+namespace models {
+
+/**
+ * Creates an inference only copy of a trained network with fewer layers. The
+ * optimized network computes the same function, but
+ *
+ *  - a BatchNorm that directly follows a Convolution or a GroupedConvolution,
+ *    including the depthwise convolutions of MobileNet, is folded into the
+ *    weights and bias of the convolution, using the running mean and
+ *    variance of the BatchNorm,
+ *  - a ConvBNLeakyReLU layer is replaced by a convolution with bias, into
+ *    which its normalization is folded, and a LeakyReLU,
+ *  - Identity layers in sequences of layers are removed,
+ *  - sequential containers (MultiLayer and the models built on it) are
+ *    flattened into the sequence that holds them.
+ *
+ * Branching containers such as AddMerge keep their branches, the branches
+ * themselves are optimized as well; an identity branch (a skip connection) is
+ * kept. Concat layers are copied as they are. Every other layer is cloned
+ * together with its parameters.
+ *
+ * The model must be initialized, i.e. its parameters must be set and its
+ * input dimensions known, e.g. after training or after calling Reset(). The
+ * output layer of the optimized network is the one that is passed, which is
+ * default constructed unless given, as the network is meant for inference.
+ *
+ * @code
+ * FFN<CrossEntropyError, RandomInitialization> model;
+ * // ... build and train the model ...
+ * InferenceOptimizer<> optimizer;
+ * FFN<CrossEntropyError, RandomInitialization> fast =
+ *     optimizer.Optimize(model);
+ * fast.Predict(input, output);
+ * @endcode
+ *
+ * @tparam MatType Matrix representation to accept as input and use for
+ *    computation.
+ */
+template<typename MatType = arma::mat>
+class InferenceOptimizer
+{
+ public:
+  //! Create the optimizer.
+  InferenceOptimizer();
+
+  /**
+   * Create the optimized copy of the given model.
+   *
+   * @param model Trained model to optimize, it is not modified.
+   * @param outputLayer Output layer of the optimized model.
+   * @return The optimized model.
+   */
+  template<typename OutputLayerType, typename InitializationRuleType>
+  FFN<OutputLayerType, InitializationRuleType, MatType> Optimize(
+      const FFN<OutputLayerType, InitializationRuleType, MatType>& model,
+      const OutputLayerType& outputLayer = OutputLayerType());
+
+  //! Get the number of BatchNorm layers folded by the last Optimize() call.
+  size_t FoldedBatchNorms() const { return foldedBatchNorms; }
+
+  //! Get the number of Identity layers removed by the last Optimize() call.
+  size_t RemovedIdentities() const { return removedIdentities; }
+
+  //! Get the number of containers flattened by the last Optimize() call.
+  size_t FlattenedContainers() const { return flattenedContainers; }
+
+  /**
+   * Copy the running statistics of the normalization layers of the given
+   * layer, and of the layers it holds, into its copy. Resetting a network
+   * initializes the running statistics again, so they are restored with this
+   * after the network holding the copy is reset.
+   *
+   * @param layer Layer to copy the statistics from.
+   * @param copy Copy of the layer, with the same architecture.
+   */
+  static void CopyStatistics(const Layer<MatType>* layer,
+                             Layer<MatType>* copy);
+
+ private:
+  //! The convolution type whose BatchNorm layers are folded.
+  typedef ConvolutionType<
+      NaiveConvolution<ValidConvolution>,
+      NaiveConvolution<FullConvolution>,
+      NaiveConvolution<ValidConvolution>,
+      MatType
+  > ConvolutionLayerType;
+
+  //! The grouped convolution type whose BatchNorm layers are folded.
+  typedef GroupedConvolutionType<
+      NaiveConvolution<ValidConvolution>,
+      NaiveConvolution<FullConvolution>,
+      NaiveConvolution<ValidConvolution>,
+      MatType
+  > GroupedConvolutionLayerType;
+
+  //! A layer of a flattened sequence and the offset of its parameters.
+  struct Unit
+  {
+    const Layer<MatType>* layer;
+    size_t offset;
+  };
+
+  //! Determine whether the layer is a container whose layers run in order.
+  static bool IsSequential(const Layer<MatType>* layer);
+
+  /**
+   * Append the layers of the given layer to a flattened sequence. Sequential
+   * containers are replaced by their layers, recursively.
+   *
+   * @param layer Layer to append.
+   * @param offset Offset of the parameters of the layer, advanced past them.
+   * @param units Flattened sequence.
+   */
+  void Gather(const Layer<MatType>* layer,
+              size_t& offset,
+              std::vector<Unit>& units);
+
+  /**
+   * Create the optimized layers of a flattened sequence.
+   *
+   * @param units Flattened sequence.
+   * @param parameters Parameters of the model.
+   * @param layers Optimized layers, created with new.
+   * @param values Parameters of the optimized layers, in the order in which
+   *     the layers hold them.
+   */
+  void Rebuild(const std::vector<Unit>& units,
+               const MatType& parameters,
+               std::vector<Layer<MatType>*>& layers,
+               std::vector<MatType>& values);
+
+  //! Create the optimized copy of a branch of an AddMerge layer.
+  Layer<MatType>* RebuildBranch(const Layer<MatType>* branch,
+                                const size_t offset,
+                                const MatType& parameters,
+                                std::vector<MatType>& values);
+
+  //! Clone the layer and record its parameters.
+  Layer<MatType>* Copy(const Unit& unit,
+                       const MatType& parameters,
+                       std::vector<MatType>& values);
+
+  /**
+   * Create a convolution with bias computing the convolution, or the grouped
+   * convolution, followed by the BatchNorm. Returns NULL if the two layers
+   * can't be folded.
+   */
+  Layer<MatType>* Fold(const Unit& convolution,
+                       const Unit& batchNorm,
+                       const MatType& parameters,
+                       std::vector<MatType>& values);
+
+  /**
+   * Create a convolution with bias computing the convolution and the
+   * normalization of a ConvBNLeakyReLU layer. Returns NULL if the
+   * normalization can't be folded.
+   */
+  Layer<MatType>* Fold(const Unit& block,
+                       const MatType& parameters,
+                       std::vector<MatType>& values);
+
+  //! Get the number of input maps of a convolution.
+  static size_t InputMaps(const Layer<MatType>& layer);
+
+  /**
+   * Scale the weights of a convolution by the normalization that follows it
+   * and compute the bias. Returns false if the sizes don't match.
+   *
+   * @param parameters Parameters of the model.
+   * @param offset Offset of the weights of the convolution.
+   * @param layerWeightSize Number of parameters of the convolution.
+   * @param kernelSize Number of weights of each output map.
+   * @param maps Number of output maps.
+   * @param gamma Scale of the normalization.
+   * @param beta Shift of the normalization.
+   * @param mean Running mean of the normalization.
+   * @param variance Running variance of the normalization.
+   * @param eps Epsilon of the normalization.
+   * @param folded Folded weights, followed by the bias.
+   */
+  static bool FoldWeights(const MatType& parameters,
+                          const size_t offset,
+                          const size_t layerWeightSize,
+                          const size_t kernelSize,
+                          const size_t maps,
+                          const typename MatType::elem_type* gamma,
+                          const typename MatType::elem_type* beta,
+                          const MatType& mean,
+                          const MatType& variance,
+                          const double eps,
+                          MatType& folded);
+
+  //! Copy the running statistics of a normalization layer.
+  template<typename LayerType>
+  static bool CopyLayerStatistics(const Layer<MatType>* layer,
+                                  Layer<MatType>* copy);
+
+  //! Locally stored layers cloned by Copy() and their clones.
+  std::vector<std::pair<const Layer<MatType>*, Layer<MatType>*>> copies;
+
+  //! Locally stored number of folded BatchNorm layers.
+  size_t foldedBatchNorms;
+
+  //! Locally stored number of removed Identity layers.
+  size_t removedIdentities;
+
+  //! Locally stored number of flattened containers.
+  size_t flattenedContainers;
+};
+
+} // namespace models
+} // namespace mlpack
+
+#include "inference_optimizer_impl.hpp"
+
+#endif
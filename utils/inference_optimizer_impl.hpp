@@ -0,0 +1,474 @@
+/**
+ * @file inference_optimizer_impl.hpp
+ * @author Kartik Dutt
+ *
+ * Implementation of InferenceOptimizer class which simplifies trained
+ * networks for inference.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_UTILS_INFERENCE_OPTIMIZER_IMPL_HPP
+#define MODELS_UTILS_INFERENCE_OPTIMIZER_IMPL_HPP
+
+// Incase it has not been included already.
+#include "inference_optimizer.hpp"
+
+namespace mlpack {
+namespace models {
+
+template<typename MatType>
+InferenceOptimizer<MatType>::InferenceOptimizer() :
+    foldedBatchNorms(0),
+    removedIdentities(0),
+    flattenedContainers(0)
+{
+  // Nothing to do here.
+}
+
+template<typename MatType>
+template<typename OutputLayerType, typename InitializationRuleType>
+FFN<OutputLayerType, InitializationRuleType, MatType>
+InferenceOptimizer<MatType>::Optimize(
+    const FFN<OutputLayerType, InitializationRuleType, MatType>& model,
+    const OutputLayerType& outputLayer)
+{
+  foldedBatchNorms = 0;
+  removedIdentities = 0;
+  flattenedContainers = 0;
+  copies.clear();
+
+  const MatType& parameters = model.Parameters();
+  if (parameters.n_elem == 0)
+  {
+    mlpack::Log::Fatal << "InferenceOptimizer::Optimize(): the model must be "
+        << "initialized, e.g. trained or Reset(), before it is optimized."
+        << std::endl;
+  }
+
+  std::vector<Unit> units;
+  size_t offset = 0;
+  for (const Layer<MatType>* layer : model.Network())
+    Gather(layer, offset, units);
+
+  if (offset != parameters.n_elem)
+  {
+    mlpack::Log::Fatal << "InferenceOptimizer::Optimize(): the layers of the "
+        << "model hold " << offset << " parameters, but the model has "
+        << parameters.n_elem << "." << std::endl;
+  }
+
+  std::vector<Layer<MatType>*> layers;
+  std::vector<MatType> values;
+  Rebuild(units, parameters, layers, values);
+
+  FFN<OutputLayerType, InitializationRuleType, MatType> optimized(outputLayer);
+  for (Layer<MatType>* layer : layers)
+    optimized.Add(layer);
+
+  optimized.InputDimensions() = model.InputDimensions();
+  optimized.Reset();
+
+  // The parameters of the layers are stored in the order in which the layers
+  // were visited, which is the order of the new network.
+  size_t total = 0;
+  for (const MatType& value : values)
+    total += value.n_elem;
+
+  if (total != optimized.Parameters().n_elem)
+  {
+    mlpack::Log::Fatal << "InferenceOptimizer::Optimize(): the optimized model "
+        << "has " << optimized.Parameters().n_elem << " parameters, but "
+        << total << " were computed." << std::endl;
+  }
+
+  offset = 0;
+  for (const MatType& value : values)
+  {
+    if (value.n_elem == 0)
+      continue;
+
+    optimized.Parameters().rows(offset, offset + value.n_elem - 1) =
+        arma::vectorise(value);
+    offset += value.n_elem;
+  }
+
+  // Reset() initialized the running statistics of the cloned layers again.
+  for (const std::pair<const Layer<MatType>*, Layer<MatType>*>& copy : copies)
+    CopyStatistics(copy.first, copy.second);
+
+  copies.clear();
+  return optimized;
+}
+
+template<typename MatType>
+bool InferenceOptimizer<MatType>::IsSequential(const Layer<MatType>* layer)
+{
+  return dynamic_cast<const MultiLayer<MatType>*>(layer) != NULL &&
+      dynamic_cast<const AddMergeType<MatType>*>(layer) == NULL &&
+      dynamic_cast<const ConcatType<MatType>*>(layer) == NULL;
+}
+
+template<typename MatType>
+void InferenceOptimizer<MatType>::Gather(const Layer<MatType>* layer,
+                                         size_t& offset,
+                                         std::vector<Unit>& units)
+{
+  if (!IsSequential(layer))
+  {
+    units.push_back(Unit{layer, offset});
+    offset += layer->WeightSize();
+    return;
+  }
+
+  flattenedContainers++;
+  const MultiLayer<MatType>* container =
+      static_cast<const MultiLayer<MatType>*>(layer);
+  for (const Layer<MatType>* child : container->Network())
+    Gather(child, offset, units);
+}
+
+template<typename MatType>
+void InferenceOptimizer<MatType>::Rebuild(
+    const std::vector<Unit>& units,
+    const MatType& parameters,
+    std::vector<Layer<MatType>*>& layers,
+    std::vector<MatType>& values)
+{
+  for (size_t i = 0; i < units.size(); ++i)
+  {
+    const Unit& unit = units[i];
+    if (dynamic_cast<const IdentityType<MatType>*>(unit.layer) != NULL)
+    {
+      removedIdentities++;
+      continue;
+    }
+
+    // LeakyReLU computes max(x, slope * x), which is the activation of the
+    // layer for slopes up to one.
+    const ConvBNLeakyReLUType<MatType>* block =
+        dynamic_cast<const ConvBNLeakyReLUType<MatType>*>(unit.layer);
+    if (block != NULL && block->NegativeSlope() <= 1.0)
+    {
+      Layer<MatType>* folded = Fold(unit, parameters, values);
+      if (folded != NULL)
+      {
+        layers.push_back(folded);
+        layers.push_back(new LeakyReLUType<MatType>(block->NegativeSlope()));
+        foldedBatchNorms++;
+        continue;
+      }
+    }
+
+    if (i + 1 < units.size() &&
+        (dynamic_cast<const ConvolutionLayerType*>(unit.layer) != NULL ||
+        dynamic_cast<const GroupedConvolutionLayerType*>(unit.layer) !=
+        NULL) &&
+        dynamic_cast<const BatchNormType<MatType>*>(units[i + 1].layer) !=
+        NULL)
+    {
+      Layer<MatType>* folded = Fold(unit, units[i + 1], parameters, values);
+      if (folded != NULL)
+      {
+        layers.push_back(folded);
+        foldedBatchNorms++;
+        ++i;
+        continue;
+      }
+    }
+
+    const AddMergeType<MatType>* merge =
+        dynamic_cast<const AddMergeType<MatType>*>(unit.layer);
+    if (merge != NULL)
+    {
+      // A ParallelAddMerge keeps whether its branches run concurrently.
+      const ParallelAddMergeType<MatType>* parallelMerge =
+          dynamic_cast<const ParallelAddMergeType<MatType>*>(merge);
+      AddMergeType<MatType>* optimizedMerge = (parallelMerge != NULL) ?
+          new ParallelAddMergeType<MatType>(parallelMerge->Concurrent()) :
+          new AddMergeType<MatType>();
+      size_t offset = unit.offset;
+      for (const Layer<MatType>* branch : merge->Network())
+      {
+        optimizedMerge->Add(RebuildBranch(branch, offset, parameters,
+            values));
+        offset += branch->WeightSize();
+      }
+
+      layers.push_back(optimizedMerge);
+      continue;
+    }
+
+    layers.push_back(Copy(unit, parameters, values));
+  }
+}
+
+template<typename MatType>
+Layer<MatType>* InferenceOptimizer<MatType>::RebuildBranch(
+    const Layer<MatType>* branch,
+    const size_t offset,
+    const MatType& parameters,
+    std::vector<MatType>& values)
+{
+  // An identity branch is the skip connection of a residual block.
+  if (dynamic_cast<const IdentityType<MatType>*>(branch) != NULL)
+    return Copy(Unit{branch, offset}, parameters, values);
+
+  std::vector<Unit> units;
+  size_t end = offset;
+  Gather(branch, end, units);
+
+  std::vector<Layer<MatType>*> layers;
+  Rebuild(units, parameters, layers, values);
+  if (layers.empty())
+    return new IdentityType<MatType>();
+  else if (layers.size() == 1)
+    return layers[0];
+
+  MultiLayer<MatType>* block = new MultiLayer<MatType>();
+  for (Layer<MatType>* layer : layers)
+    block->Add(layer);
+
+  return block;
+}
+
+template<typename MatType>
+Layer<MatType>* InferenceOptimizer<MatType>::Copy(
+    const Unit& unit,
+    const MatType& parameters,
+    std::vector<MatType>& values)
+{
+  const size_t weightSize = unit.layer->WeightSize();
+  if (weightSize > 0)
+  {
+    values.push_back(parameters.rows(unit.offset,
+        unit.offset + weightSize - 1));
+  }
+
+  Layer<MatType>* copy = unit.layer->Clone();
+  copies.push_back(std::make_pair(unit.layer, copy));
+  return copy;
+}
+
+template<typename MatType>
+void InferenceOptimizer<MatType>::CopyStatistics(const Layer<MatType>* layer,
+                                                 Layer<MatType>* copy)
+{
+  if (CopyLayerStatistics<BatchNormType<MatType>>(layer, copy) ||
+      CopyLayerStatistics<ConvBNLeakyReLUType<MatType>>(layer, copy))
+  {
+    return;
+  }
+
+  // Containers, including AddMerge and Concat, hold their layers in the same
+  // order in the copy.
+  const MultiLayer<MatType>* container =
+      dynamic_cast<const MultiLayer<MatType>*>(layer);
+  MultiLayer<MatType>* copiedContainer =
+      dynamic_cast<MultiLayer<MatType>*>(copy);
+  if (container == NULL || copiedContainer == NULL)
+    return;
+
+  if (copiedContainer->Network().size() != container->Network().size())
+  {
+    mlpack::Log::Fatal << "InferenceOptimizer::CopyStatistics(): the copy "
+        << "doesn't have the architecture of the layer." << std::endl;
+  }
+
+  for (size_t i = 0; i < container->Network().size(); ++i)
+    CopyStatistics(container->Network()[i], copiedContainer->Network()[i]);
+}
+
+template<typename MatType>
+template<typename LayerType>
+bool InferenceOptimizer<MatType>::CopyLayerStatistics(
+    const Layer<MatType>* layer,
+    Layer<MatType>* copy)
+{
+  const LayerType* normalization = dynamic_cast<const LayerType*>(layer);
+  LayerType* copiedNormalization = dynamic_cast<LayerType*>(copy);
+  if (normalization == NULL || copiedNormalization == NULL)
+    return false;
+
+  copiedNormalization->TrainingMean() = normalization->TrainingMean();
+  copiedNormalization->TrainingVariance() = normalization->TrainingVariance();
+  return true;
+}
+
+template<typename MatType>
+Layer<MatType>* InferenceOptimizer<MatType>::Fold(
+    const Unit& convolution,
+    const Unit& batchNorm,
+    const MatType& parameters,
+    std::vector<MatType>& values)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  const BatchNormType<MatType>& bn =
+      static_cast<const BatchNormType<MatType>&>(*batchNorm.layer);
+  const size_t maps = bn.TrainingMean().n_elem;
+  if (bn.WeightSize() != 2 * maps)
+    return NULL;
+
+  const ElemType* gamma = parameters.colptr(0) + batchNorm.offset;
+  MatType folded;
+
+  // Each output map of a grouped convolution only reads the input maps of its
+  // group.
+  const GroupedConvolutionLayerType* grouped =
+      dynamic_cast<const GroupedConvolutionLayerType*>(convolution.layer);
+  if (grouped != NULL)
+  {
+    const size_t kernelSize = grouped->KernelWidth() *
+        grouped->KernelHeight() * InputMaps(*grouped) / grouped->Groups();
+    if (grouped->Maps() != maps || !FoldWeights(parameters,
+        convolution.offset, grouped->WeightSize(), kernelSize, maps, gamma,
+        gamma + maps, bn.TrainingMean(), bn.TrainingVariance(), bn.Epsilon(),
+        folded))
+    {
+      return NULL;
+    }
+
+    values.push_back(std::move(folded));
+    if (dynamic_cast<const DepthwiseConvolutionType<MatType>*>(grouped) !=
+        NULL && grouped->PadWLeft() == grouped->PadWRight() &&
+        grouped->PadHTop() == grouped->PadHBottom())
+    {
+      return new DepthwiseConvolutionType<MatType>(maps,
+          grouped->KernelWidth(), grouped->KernelHeight(), grouped->Groups(),
+          grouped->StrideWidth(), grouped->StrideHeight(),
+          grouped->PadWLeft(), grouped->PadHTop(), "none", true);
+    }
+
+    return new GroupedConvolutionLayerType(maps, grouped->KernelWidth(),
+        grouped->KernelHeight(), grouped->Groups(), grouped->StrideWidth(),
+        grouped->StrideHeight(),
+        std::make_tuple(grouped->PadWLeft(), grouped->PadWRight()),
+        std::make_tuple(grouped->PadHTop(), grouped->PadHBottom()), "none",
+        true);
+  }
+
+  const ConvolutionLayerType& conv =
+      static_cast<const ConvolutionLayerType&>(*convolution.layer);
+  const size_t kernelSize = conv.KernelWidth() * conv.KernelHeight() *
+      InputMaps(conv);
+  if (conv.Maps() != maps || !FoldWeights(parameters, convolution.offset,
+      conv.WeightSize(), kernelSize, maps, gamma, gamma + maps,
+      bn.TrainingMean(), bn.TrainingVariance(), bn.Epsilon(), folded))
+  {
+    return NULL;
+  }
+
+  values.push_back(std::move(folded));
+
+  // A FastConvolution stays one.
+  if (dynamic_cast<const FastConvolutionType<MatType>*>(convolution.layer) !=
+      NULL)
+  {
+    return new FastConvolutionType<MatType>(maps, conv.KernelWidth(),
+        conv.KernelHeight(), conv.StrideWidth(), conv.StrideHeight(),
+        std::make_tuple(conv.PadWLeft(), conv.PadWRight()),
+        std::make_tuple(conv.PadHTop(), conv.PadHBottom()), "none", true);
+  }
+
+  return new ConvolutionLayerType(maps, conv.KernelWidth(),
+      conv.KernelHeight(), conv.StrideWidth(), conv.StrideHeight(),
+      std::make_tuple(conv.PadWLeft(), conv.PadWRight()),
+      std::make_tuple(conv.PadHTop(), conv.PadHBottom()), "none", true);
+}
+
+template<typename MatType>
+Layer<MatType>* InferenceOptimizer<MatType>::Fold(
+    const Unit& block,
+    const MatType& parameters,
+    std::vector<MatType>& values)
+{
+  const ConvBNLeakyReLUType<MatType>& layer =
+      static_cast<const ConvBNLeakyReLUType<MatType>&>(*block.layer);
+
+  // The scale and the shift of the normalization follow the weights of the
+  // convolution, which has no bias.
+  const size_t maps = layer.Maps();
+  const size_t kernelSize = layer.KernelWidth() * layer.KernelHeight() *
+      InputMaps(layer);
+  const size_t weightSize = kernelSize * maps;
+  if (layer.WeightSize() != weightSize + 2 * maps)
+    return NULL;
+
+  const typename MatType::elem_type* gamma = parameters.colptr(0) +
+      block.offset + weightSize;
+  MatType folded;
+  if (!FoldWeights(parameters, block.offset, weightSize, kernelSize, maps,
+      gamma, gamma + maps, layer.TrainingMean(), layer.TrainingVariance(),
+      layer.Epsilon(), folded))
+  {
+    return NULL;
+  }
+
+  values.push_back(std::move(folded));
+  return new FastConvolutionType<MatType>(maps, layer.KernelWidth(),
+      layer.KernelHeight(), layer.StrideWidth(), layer.StrideHeight(),
+      layer.PadW(), layer.PadH(), "none", true);
+}
+
+template<typename MatType>
+size_t InferenceOptimizer<MatType>::InputMaps(const Layer<MatType>& layer)
+{
+  // The input maps of a convolution are all dimensions past the second.
+  size_t inMaps = 1;
+  for (size_t d = 2; d < layer.InputDimensions().size(); ++d)
+    inMaps *= layer.InputDimensions()[d];
+
+  return inMaps;
+}
+
+template<typename MatType>
+bool InferenceOptimizer<MatType>::FoldWeights(
+    const MatType& parameters,
+    const size_t offset,
+    const size_t layerWeightSize,
+    const size_t kernelSize,
+    const size_t maps,
+    const typename MatType::elem_type* gamma,
+    const typename MatType::elem_type* beta,
+    const MatType& mean,
+    const MatType& variance,
+    const double eps,
+    MatType& folded)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  // The weights are stored as slices of outMap * inMaps + inMap, so the
+  // kernels of an output map are contiguous.
+  const size_t weightSize = kernelSize * maps;
+  const bool hasBias = (layerWeightSize == weightSize + maps);
+  if ((layerWeightSize != weightSize && !hasBias) || mean.n_elem != maps ||
+      variance.n_elem != maps)
+  {
+    return false;
+  }
+
+  folded.set_size(weightSize + maps, 1);
+  folded.rows(0, weightSize - 1) = parameters.rows(offset,
+      offset + weightSize - 1);
+
+  for (size_t o = 0; o < maps; ++o)
+  {
+    // BatchNorm computes gamma * (x - mean) / sqrt(var + eps) + beta.
+    const ElemType scale = gamma[o] / std::sqrt(variance[o] + eps);
+    const ElemType bias = hasBias ? parameters[offset + weightSize + o] :
+        ElemType(0);
+
+    folded.rows(o * kernelSize, (o + 1) * kernelSize - 1) *= scale;
+    folded[weightSize + o] = scale * (bias - mean[o]) + beta[o];
+  }
+
+  return true;
+}
+
+} // namespace models
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,146 @@
+/**
+ * @file latency_histogram.hpp
+ * @author Kartik Dutt
+ *
+ * Definition of LatencyHistogram class which records latencies in buckets
+ * of bounded relative error and reports their percentiles.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_UTILS_LATENCY_HISTOGRAM_HPP
+#define MODELS_UTILS_LATENCY_HISTOGRAM_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace mlpack {
+namespace models {
+
+/**
+ * A histogram of latencies in microseconds. The buckets grow geometrically,
+ * eight for each power of two from one microsecond to about an hour, so a
+ * percentile is reported within about 5% of the recorded latency, with a
+ * fixed amount of memory however many latencies are recorded. The histogram
+ * isn't synchronized; the BatchScheduler guards its histograms.
+ *
+ * @code
+ * LatencyHistogram histogram;
+ * histogram.Add(125.0);
+ * const double p99 = histogram.Percentile(99);
+ * @endcode
+ */
+class LatencyHistogram
+{
+ public:
+  //! Create an empty histogram.
+  LatencyHistogram() :
+      counts(bucketsPerOctave * octaves + 1, 0),
+      count(0),
+      sum(0.0),
+      maximum(0.0)
+  {
+    // Nothing to do here.
+  }
+
+  /**
+   * Record a latency.
+   *
+   * @param microseconds The latency in microseconds.
+   */
+  void Add(const double microseconds)
+  {
+    counts[Bucket(microseconds)]++;
+    count++;
+    sum += microseconds;
+    maximum = std::max(maximum, microseconds);
+  }
+
+  /**
+   * Get the given percentile of the recorded latencies, the geometric middle
+   * of the bucket it falls in, at most the largest latency.
+   *
+   * @param percentile The percentile, between 0 and 100.
+   * @return The latency in microseconds, 0 if no latency was recorded.
+   */
+  double Percentile(const double percentile) const
+  {
+    if (count == 0)
+      return 0.0;
+
+    const size_t rank = std::max((size_t) 1,
+        (size_t) std::ceil(percentile / 100.0 * count));
+    size_t seen = 0;
+    for (size_t b = 0; b < counts.size(); ++b)
+    {
+      seen += counts[b];
+      if (seen >= rank)
+      {
+        if (b == 0)
+          return std::min(1.0, maximum);
+
+        return std::min(std::pow(2.0, (b - 0.5) / bucketsPerOctave), maximum);
+      }
+    }
+
+    return maximum;
+  }
+
+  //! Get the number of recorded latencies.
+  size_t Count() const { return count; }
+
+  //! Get the mean of the recorded latencies.
+  double Mean() const { return (count == 0) ? 0.0 : sum / count; }
+
+  //! Get the largest recorded latency.
+  double Max() const { return maximum; }
+
+  //! Forget the recorded latencies.
+  void Reset()
+  {
+    std::fill(counts.begin(), counts.end(), 0);
+    count = 0;
+    sum = 0.0;
+    maximum = 0.0;
+  }
+
+ private:
+  //! Get the bucket of the given latency; the first bucket holds the
+  //! latencies below a microsecond.
+  size_t Bucket(const double microseconds) const
+  {
+    if (microseconds < 1.0)
+      return 0;
+
+    const size_t bucket = 1 + (size_t) (std::log2(microseconds) *
+        bucketsPerOctave);
+    return std::min(bucket, counts.size() - 1);
+  }
+
+  //! The number of buckets for each power of two.
+  static constexpr size_t bucketsPerOctave = 8;
+
+  //! The number of powers of two covered by the buckets.
+  static constexpr size_t octaves = 32;
+
+  //! Locally stored number of latencies in each bucket.
+  std::vector<size_t> counts;
+
+  //! Locally stored number of recorded latencies.
+  size_t count;
+
+  //! Locally stored sum of the recorded latencies.
+  double sum;
+
+  //! Locally stored largest recorded latency.
+  double maximum;
+}; // class LatencyHistogram
+
+} // namespace models
+} // namespace mlpack
+
+#endif
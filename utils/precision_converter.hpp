@@ -0,0 +1,123 @@
+/**
+ * @file precision_converter.hpp
+ * @author Kartik Dutt
+ *
+ * Definition of PrecisionConverter class which converts the weights of a
+ * trained network to another matrix type, e.g. from double to float.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_UTILS_PRECISION_CONVERTER_HPP
+#define MODELS_UTILS_PRECISION_CONVERTER_HPP
+
+#define MLPACK_ENABLE_ANN_SERIALIZATION
+#include <mlpack.hpp>
+#include <layers/serialization.hpp>
+#include <layers/conv_bn_leaky_relu.hpp>
+#include <algorithm>
+
+namespace mlpack {
+namespace models {
+
+/**
+ * Converts the weights of a network to another matrix type, which is mostly
+ * used to serve a model trained in double precision as a single precision
+ * model at half the memory.
+ *
+ * The converted network must have the same architecture as the given one,
+ * built with the other matrix type, e.g. a VGGType<arma::fmat, 16> for a
+ * trained VGGType<arma::mat, 16>. The parameters of the network and the
+ * running statistics of its BatchNorm and ConvBNLeakyReLU layers are
+ * converted, the layers themselves are not created by the converter.
+ *
+ * @code
+ * FFN<CrossEntropyErrorType<arma::fmat>, RandomInitialization, arma::fmat>
+ *     floatModel;
+ * floatModel.Add<VGGType<arma::fmat, 16>>();
+ *
+ * // Load a double checkpoint and write the float one.
+ * PrecisionConverter<> converter;
+ * converter.Convert<FFN<CrossEntropyError, RandomInitialization>>(
+ *     "vgg16.bin", "vgg16_float.bin", "vgg16", floatModel);
+ * @endcode
+ *
+ * @tparam InputMatType Matrix type of the given network.
+ * @tparam OutputMatType Matrix type of the converted network.
+ */
+template<
+  typename InputMatType = arma::mat,
+  typename OutputMatType = arma::fmat
+>
+class PrecisionConverter
+{
+ public:
+  //! Create the converter.
+  PrecisionConverter();
+
+  /**
+   * Convert the weights of the given model into the converted model. If the
+   * converted model isn't initialized yet, it is reset with the input
+   * dimensions of the given model.
+   *
+   * @param model Trained model to convert, it is not modified.
+   * @param converted Model with the same architecture and the other matrix
+   *     type, which receives the converted weights.
+   */
+  template<
+    typename OutputLayerType,
+    typename InitializationRuleType,
+    typename ConvertedOutputLayerType,
+    typename ConvertedInitializationRuleType
+  >
+  void Convert(
+      const FFN<OutputLayerType, InitializationRuleType, InputMatType>& model,
+      FFN<ConvertedOutputLayerType, ConvertedInitializationRuleType,
+          OutputMatType>& converted);
+
+  /**
+   * Load a checkpoint, convert its weights into the converted model and save
+   * the converted model.
+   *
+   * @tparam ModelType Type of the network stored in the checkpoint.
+   * @param inputFile Checkpoint to load.
+   * @param outputFile File to save the converted model to.
+   * @param name Name of the model in both files.
+   * @param converted Model with the same architecture and the other matrix
+   *     type, which receives the converted weights.
+   */
+  template<typename ModelType, typename ConvertedModelType>
+  void Convert(const std::string& inputFile,
+               const std::string& outputFile,
+               const std::string& name,
+               ConvertedModelType& converted);
+
+  //! Get the number of layers whose running statistics were converted by the
+  //! last Convert() call.
+  size_t ConvertedStatistics() const { return convertedStatistics; }
+
+ private:
+  /**
+   * Convert the running statistics of the given layer, and of the layers it
+   * holds, into the corresponding converted layer.
+   */
+  void ConvertLayer(const Layer<InputMatType>* layer,
+                    Layer<OutputMatType>* converted);
+
+  //! Convert the running statistics of a normalization layer.
+  template<typename LayerType, typename ConvertedLayerType>
+  bool ConvertStatistics(const Layer<InputMatType>* layer,
+                         Layer<OutputMatType>* converted);
+
+  //! Locally stored number of layers whose running statistics were converted.
+  size_t convertedStatistics;
+};
+
+} // namespace models
+} // namespace mlpack
+
+#include "precision_converter_impl.hpp"
+
+#endif
@@ -0,0 +1,171 @@
+/**
+ * @file precision_converter_impl.hpp
+ * @author Kartik Dutt
+ *
+ * Implementation of PrecisionConverter class which converts the weights of a
+ * trained network to another matrix type.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_UTILS_PRECISION_CONVERTER_IMPL_HPP
+#define MODELS_UTILS_PRECISION_CONVERTER_IMPL_HPP
+
+// Incase it has not been included already.
+#include "precision_converter.hpp"
+
+namespace mlpack {
+namespace models {
+
+template<typename InputMatType, typename OutputMatType>
+PrecisionConverter<InputMatType, OutputMatType>::PrecisionConverter() :
+    convertedStatistics(0)
+{
+  // Nothing to do here.
+}
+
+template<typename InputMatType, typename OutputMatType>
+template<
+  typename OutputLayerType,
+  typename InitializationRuleType,
+  typename ConvertedOutputLayerType,
+  typename ConvertedInitializationRuleType
+>
+void PrecisionConverter<InputMatType, OutputMatType>::Convert(
+    const FFN<OutputLayerType, InitializationRuleType, InputMatType>& model,
+    FFN<ConvertedOutputLayerType, ConvertedInitializationRuleType,
+        OutputMatType>& converted)
+{
+  convertedStatistics = 0;
+
+  if (model.Parameters().n_elem == 0)
+  {
+    mlpack::Log::Fatal << "PrecisionConverter::Convert(): the model must be "
+        << "initialized, e.g. trained or Reset(), before it is converted."
+        << std::endl;
+  }
+
+  if (converted.Parameters().n_elem == 0)
+  {
+    converted.InputDimensions() = model.InputDimensions();
+    converted.Reset();
+  }
+
+  if (converted.Network().size() != model.Network().size() ||
+      converted.Parameters().n_elem != model.Parameters().n_elem)
+  {
+    mlpack::Log::Fatal << "PrecisionConverter::Convert(): the converted model "
+        << "has " << converted.Network().size() << " layers and "
+        << converted.Parameters().n_elem << " parameters, but the model has "
+        << model.Network().size() << " layers and "
+        << model.Parameters().n_elem << " parameters." << std::endl;
+  }
+
+  // The layers alias the parameters, so they are converted into the memory
+  // of the parameters; assigning a new matrix could free that memory.
+  typedef typename OutputMatType::elem_type OutputElemType;
+  std::transform(model.Parameters().begin(), model.Parameters().end(),
+      converted.Parameters().begin(),
+      [](const typename InputMatType::elem_type value)
+      {
+        return (OutputElemType) value;
+      });
+
+  for (size_t i = 0; i < model.Network().size(); ++i)
+    ConvertLayer(model.Network()[i], converted.Network()[i]);
+}
+
+template<typename InputMatType, typename OutputMatType>
+template<typename ModelType, typename ConvertedModelType>
+void PrecisionConverter<InputMatType, OutputMatType>::Convert(
+    const std::string& inputFile,
+    const std::string& outputFile,
+    const std::string& name,
+    ConvertedModelType& converted)
+{
+  ModelType model;
+  data::Load(inputFile, name, model, true);
+  Log::Info << "Loaded model." << std::endl;
+
+  Convert(model, converted);
+
+  data::Save(outputFile, name, converted, true);
+  Log::Info << "Converted model saved in " << outputFile << "." << std::endl;
+}
+
+template<typename InputMatType, typename OutputMatType>
+void PrecisionConverter<InputMatType, OutputMatType>::ConvertLayer(
+    const Layer<InputMatType>* layer,
+    Layer<OutputMatType>* converted)
+{
+  if (layer->WeightSize() != converted->WeightSize())
+  {
+    mlpack::Log::Fatal << "PrecisionConverter::Convert(): a layer of the "
+        << "converted model has " << converted->WeightSize() << " weights, "
+        << "but the corresponding layer of the model has "
+        << layer->WeightSize() << "." << std::endl;
+  }
+
+  if (ConvertStatistics<BatchNormType<InputMatType>,
+          BatchNormType<OutputMatType>>(layer, converted) ||
+      ConvertStatistics<ConvBNLeakyReLUType<InputMatType>,
+          ConvBNLeakyReLUType<OutputMatType>>(layer, converted))
+  {
+    return;
+  }
+
+  // Containers, including the models built on MultiLayer, AddMerge and
+  // Concat, hold their layers in the same order in both networks.
+  const MultiLayer<InputMatType>* container =
+      dynamic_cast<const MultiLayer<InputMatType>*>(layer);
+  if (container == NULL)
+    return;
+
+  MultiLayer<OutputMatType>* convertedContainer =
+      dynamic_cast<MultiLayer<OutputMatType>*>(converted);
+  if (convertedContainer == NULL ||
+      convertedContainer->Network().size() != container->Network().size())
+  {
+    mlpack::Log::Fatal << "PrecisionConverter::Convert(): the architecture of "
+        << "the converted model doesn't match the model." << std::endl;
+  }
+
+  for (size_t i = 0; i < container->Network().size(); ++i)
+  {
+    ConvertLayer(container->Network()[i],
+        convertedContainer->Network()[i]);
+  }
+}
+
+template<typename InputMatType, typename OutputMatType>
+template<typename LayerType, typename ConvertedLayerType>
+bool PrecisionConverter<InputMatType, OutputMatType>::ConvertStatistics(
+    const Layer<InputMatType>* layer,
+    Layer<OutputMatType>* converted)
+{
+  const LayerType* normalization = dynamic_cast<const LayerType*>(layer);
+  if (normalization == NULL)
+    return false;
+
+  ConvertedLayerType* convertedNormalization =
+      dynamic_cast<ConvertedLayerType*>(converted);
+  if (convertedNormalization == NULL)
+  {
+    mlpack::Log::Fatal << "PrecisionConverter::Convert(): the architecture of "
+        << "the converted model doesn't match the model." << std::endl;
+  }
+
+  convertedNormalization->TrainingMean() =
+      arma::conv_to<OutputMatType>::from(normalization->TrainingMean());
+  convertedNormalization->TrainingVariance() =
+      arma::conv_to<OutputMatType>::from(normalization->TrainingVariance());
+  convertedStatistics++;
+  return true;
+}
+
+} // namespace models
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,219 @@
+/**
+ * @file quantizer.hpp
+ * @author Kartik Dutt
+ *
+ * Definition of Quantizer class which creates an int8 copy of a trained
+ * network for inference.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_UTILS_QUANTIZER_HPP
+#define MODELS_UTILS_QUANTIZER_HPP
+
+#define MLPACK_ENABLE_ANN_SERIALIZATION
+#include <mlpack.hpp>
+#include <layers/quantized_convolution.hpp>
+#include <layers/quantized_linear.hpp>
+#include "inference_optimizer.hpp"
+
+namespace mlpack {
+namespace models {
+
+/**
+ * Post-training quantization of a trained network. The network is first
+ * simplified by the InferenceOptimizer, which folds the BatchNorm layers into
+ * the convolutions, then every Convolution, GroupedConvolution and Linear
+ * layer is replaced by a QuantizedConvolution or QuantizedLinear layer, whose
+ * weights are quantized to int8 with a scale for each output channel. The
+ * other layers are copied.
+ *
+ * The scale of the input of each quantized layer is calibrated by running
+ * batches of the calibration data, e.g. the training split of a DataLoader,
+ * through the quantized network and recording the range of the inputs of the
+ * layers. Evaluate() compares the accuracy of the quantized network with the
+ * accuracy of the original one on the validation split of a DataLoader.
+ *
+ * @code
+ * ResNet50 resNet(3, 224, 224);
+ * // ... train the model or load pre-trained weights ...
+ * Quantizer<> quantizer;
+ * auto quantized = quantizer.Quantize(resNet.GetModel(), dataloader);
+ * const double delta = quantizer.Evaluate(resNet.GetModel(), quantized,
+ *     dataloader);
+ * @endcode
+ *
+ * @tparam MatType Matrix representation to accept as input and use for
+ *    computation.
+ */
+template<typename MatType = arma::mat>
+class Quantizer
+{
+ public:
+  /**
+   * Create the quantizer.
+   *
+   * @param batchSize Number of samples of each calibration batch.
+   * @param calibrationBatches Number of batches used for calibration, all
+   *     samples are used if zero.
+   */
+  Quantizer(const size_t batchSize = 32,
+            const size_t calibrationBatches = 10);
+
+  /**
+   * Create the quantized copy of the given model, calibrated with the given
+   * data.
+   *
+   * @param model Trained model to quantize, it is not modified.
+   * @param calibrationData Samples used to calibrate the input scales, one
+   *     sample in each column.
+   * @param outputLayer Output layer of the quantized model.
+   * @return The quantized model.
+   */
+  template<typename OutputLayerType, typename InitializationRuleType>
+  FFN<OutputLayerType, InitializationRuleType, MatType> Quantize(
+      const FFN<OutputLayerType, InitializationRuleType, MatType>& model,
+      const MatType& calibrationData,
+      const OutputLayerType& outputLayer = OutputLayerType());
+
+  /**
+   * Create the quantized copy of the given model, calibrated with the
+   * training split of the given DataLoader.
+   *
+   * @param model Trained model to quantize, it is not modified.
+   * @param dataloader DataLoader whose training features are used for
+   *     calibration.
+   * @param outputLayer Output layer of the quantized model.
+   * @return The quantized model.
+   */
+  template<
+    typename OutputLayerType,
+    typename InitializationRuleType,
+    typename DataLoaderType
+  >
+  FFN<OutputLayerType, InitializationRuleType, MatType> Quantize(
+      const FFN<OutputLayerType, InitializationRuleType, MatType>& model,
+      const DataLoaderType& dataloader,
+      const OutputLayerType& outputLayer = OutputLayerType())
+  {
+    return Quantize(model, dataloader.TrainFeatures(), outputLayer);
+  }
+
+  /**
+   * Compute the classification accuracy of the model and of its quantized
+   * copy on the validation split of the given DataLoader.
+   *
+   * @param model Trained model.
+   * @param quantized Quantized copy of the model.
+   * @param dataloader DataLoader holding the validation split.
+   * @return The accuracy of the model minus the accuracy of the quantized
+   *     model.
+   */
+  template<
+    typename OutputLayerType,
+    typename InitializationRuleType,
+    typename DataLoaderType
+  >
+  double Evaluate(
+      FFN<OutputLayerType, InitializationRuleType, MatType>& model,
+      FFN<OutputLayerType, InitializationRuleType, MatType>& quantized,
+      const DataLoaderType& dataloader);
+
+  //! Get the number of layers quantized by the last Quantize() call.
+  size_t QuantizedLayers() const { return quantizedLayers; }
+
+  //! Get the accuracy of the model of the last Evaluate() call.
+  double ModelAccuracy() const { return modelAccuracy; }
+
+  //! Get the accuracy of the quantized model of the last Evaluate() call.
+  double QuantizedAccuracy() const { return quantizedAccuracy; }
+
+  //! Get the number of samples of each calibration batch.
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the number of samples of each calibration batch.
+  size_t& BatchSize() { return batchSize; }
+
+  //! Get the number of calibration batches.
+  size_t CalibrationBatches() const { return calibrationBatches; }
+  //! Modify the number of calibration batches.
+  size_t& CalibrationBatches() { return calibrationBatches; }
+
+ private:
+  //! The convolution type that is quantized.
+  typedef ConvolutionType<
+      NaiveConvolution<ValidConvolution>,
+      NaiveConvolution<FullConvolution>,
+      NaiveConvolution<ValidConvolution>,
+      MatType
+  > ConvolutionLayerType;
+
+  //! The grouped convolution type that is quantized.
+  typedef GroupedConvolutionType<
+      NaiveConvolution<ValidConvolution>,
+      NaiveConvolution<FullConvolution>,
+      NaiveConvolution<ValidConvolution>,
+      MatType
+  > GroupedConvolutionLayerType;
+
+  /**
+   * Create the quantized copy of the given layer. Containers are copied with
+   * their layers quantized.
+   *
+   * @param layer Layer to quantize.
+   * @param offset Offset of the parameters of the layer, advanced past them.
+   * @param parameters Parameters of the model.
+   * @param values Parameters of the layers that are copied, in the order in
+   *     which the layers hold them.
+   */
+  Layer<MatType>* Rebuild(const Layer<MatType>* layer,
+                          size_t& offset,
+                          const MatType& parameters,
+                          std::vector<MatType>& values);
+
+  //! Create the quantized copy of a (grouped) convolution.
+  template<typename LayerType>
+  Layer<MatType>* QuantizeConvolution(const LayerType& convolution,
+                                      const size_t groups,
+                                      const size_t offset,
+                                      const MatType& parameters);
+
+  //! Set the input scale of the quantized layers from the calibrated range.
+  void Finalize(const std::vector<Layer<MatType>*>& network);
+
+  //! Compute the fraction of samples that are classified correctly.
+  template<
+    typename OutputLayerType,
+    typename InitializationRuleType,
+    typename LabelsType
+  >
+  double Accuracy(FFN<OutputLayerType, InitializationRuleType, MatType>& model,
+                  const MatType& features,
+                  const LabelsType& labels);
+
+  //! Locally stored layers cloned by Rebuild() and their clones.
+  std::vector<std::pair<const Layer<MatType>*, Layer<MatType>*>> copies;
+
+  //! Locally stored number of samples of each calibration batch.
+  size_t batchSize;
+
+  //! Locally stored number of calibration batches.
+  size_t calibrationBatches;
+
+  //! Locally stored number of quantized layers.
+  size_t quantizedLayers;
+
+  //! Locally stored accuracy of the model.
+  double modelAccuracy;
+
+  //! Locally stored accuracy of the quantized model.
+  double quantizedAccuracy;
+};
+
+} // namespace models
+} // namespace mlpack
+
+#include "quantizer_impl.hpp"
+
+#endif
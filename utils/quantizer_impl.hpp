@@ -0,0 +1,307 @@
+/**
+ * @file quantizer_impl.hpp
+ * @author Kartik Dutt
+ *
+ * Implementation of Quantizer class which creates an int8 copy of a trained
+ * network for inference.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_UTILS_QUANTIZER_IMPL_HPP
+#define MODELS_UTILS_QUANTIZER_IMPL_HPP
+
+// Incase it has not been included already.
+#include "quantizer.hpp"
+
+namespace mlpack {
+namespace models {
+
+template<typename MatType>
+Quantizer<MatType>::Quantizer(const size_t batchSize,
+                              const size_t calibrationBatches) :
+    batchSize(batchSize),
+    calibrationBatches(calibrationBatches),
+    quantizedLayers(0),
+    modelAccuracy(0),
+    quantizedAccuracy(0)
+{
+  // Nothing to do here.
+}
+
+template<typename MatType>
+template<typename OutputLayerType, typename InitializationRuleType>
+FFN<OutputLayerType, InitializationRuleType, MatType>
+Quantizer<MatType>::Quantize(
+    const FFN<OutputLayerType, InitializationRuleType, MatType>& model,
+    const MatType& calibrationData,
+    const OutputLayerType& outputLayer)
+{
+  quantizedLayers = 0;
+  copies.clear();
+
+  if (calibrationData.n_cols == 0)
+  {
+    mlpack::Log::Fatal << "Quantizer::Quantize(): no calibration data was "
+        << "given." << std::endl;
+  }
+
+  // Folding the BatchNorm layers first quantizes the weights that are
+  // actually applied.
+  InferenceOptimizer<MatType> optimizer;
+  FFN<OutputLayerType, InitializationRuleType, MatType> optimized =
+      optimizer.Optimize(model, outputLayer);
+
+  const MatType& parameters = optimized.Parameters();
+  std::vector<Layer<MatType>*> layers;
+  std::vector<MatType> values;
+  size_t offset = 0;
+  for (const Layer<MatType>* layer : optimized.Network())
+    layers.push_back(Rebuild(layer, offset, parameters, values));
+
+  FFN<OutputLayerType, InitializationRuleType, MatType> quantized(outputLayer);
+  for (Layer<MatType>* layer : layers)
+    quantized.Add(layer);
+
+  quantized.InputDimensions() = model.InputDimensions();
+  quantized.Reset();
+
+  size_t total = 0;
+  for (const MatType& value : values)
+    total += value.n_elem;
+
+  if (total != quantized.Parameters().n_elem)
+  {
+    mlpack::Log::Fatal << "Quantizer::Quantize(): the quantized model has "
+        << quantized.Parameters().n_elem << " parameters, but " << total
+        << " were copied." << std::endl;
+  }
+
+  offset = 0;
+  for (const MatType& value : values)
+  {
+    if (value.n_elem == 0)
+      continue;
+
+    quantized.Parameters().rows(offset, offset + value.n_elem - 1) =
+        arma::vectorise(value);
+    offset += value.n_elem;
+  }
+
+  // Reset() initialized the running statistics of the copied layers again,
+  // e.g. of a BatchNorm that was not folded.
+  for (const std::pair<const Layer<MatType>*, Layer<MatType>*>& copy : copies)
+    InferenceOptimizer<MatType>::CopyStatistics(copy.first, copy.second);
+
+  copies.clear();
+
+  // Until they are calibrated, the quantized layers record the range of
+  // their inputs.
+  const size_t numBatches = (calibrationData.n_cols + batchSize - 1) /
+      batchSize;
+  const size_t batches = (calibrationBatches == 0) ? numBatches :
+      std::min(numBatches, calibrationBatches);
+  MatType output;
+  for (size_t b = 0; b < batches; ++b)
+  {
+    const size_t begin = b * batchSize;
+    const size_t end = std::min(begin + batchSize, calibrationData.n_cols) - 1;
+    quantized.Predict(calibrationData.cols(begin, end), output);
+  }
+
+  Finalize(quantized.Network());
+  Log::Info << "Quantized " << quantizedLayers << " layers, calibrated with "
+      << batches << " batches." << std::endl;
+
+  return quantized;
+}
+
+template<typename MatType>
+template<
+  typename OutputLayerType,
+  typename InitializationRuleType,
+  typename DataLoaderType
+>
+double Quantizer<MatType>::Evaluate(
+    FFN<OutputLayerType, InitializationRuleType, MatType>& model,
+    FFN<OutputLayerType, InitializationRuleType, MatType>& quantized,
+    const DataLoaderType& dataloader)
+{
+  modelAccuracy = Accuracy(model, dataloader.ValidFeatures(),
+      dataloader.ValidLabels());
+  quantizedAccuracy = Accuracy(quantized, dataloader.ValidFeatures(),
+      dataloader.ValidLabels());
+
+  Log::Info << "Validation accuracy: " << modelAccuracy << " (model), "
+      << quantizedAccuracy << " (quantized), delta "
+      << modelAccuracy - quantizedAccuracy << "." << std::endl;
+
+  return modelAccuracy - quantizedAccuracy;
+}
+
+template<typename MatType>
+Layer<MatType>* Quantizer<MatType>::Rebuild(const Layer<MatType>* layer,
+                                            size_t& offset,
+                                            const MatType& parameters,
+                                            std::vector<MatType>& values)
+{
+  const size_t weightSize = layer->WeightSize();
+  Layer<MatType>* quantized = NULL;
+
+  const ConvolutionLayerType* convolution =
+      dynamic_cast<const ConvolutionLayerType*>(layer);
+  const GroupedConvolutionLayerType* groupedConvolution =
+      dynamic_cast<const GroupedConvolutionLayerType*>(layer);
+  const LinearType<MatType>* linear =
+      dynamic_cast<const LinearType<MatType>*>(layer);
+  const MultiLayer<MatType>* container =
+      dynamic_cast<const MultiLayer<MatType>*>(layer);
+
+  if (convolution != NULL)
+  {
+    quantized = QuantizeConvolution(*convolution, 1, offset, parameters);
+  }
+  else if (groupedConvolution != NULL)
+  {
+    quantized = QuantizeConvolution(*groupedConvolution,
+        groupedConvolution->Groups(), offset, parameters);
+  }
+  else if (linear != NULL)
+  {
+    size_t inSize = 1;
+    for (size_t i = 0; i < linear->InputDimensions().size(); ++i)
+      inSize *= linear->InputDimensions()[i];
+
+    // The weights are followed by the bias.
+    const size_t outSize = weightSize / (inSize + 1);
+    const MatType weights(parameters.memptr() + offset, outSize, inSize);
+    const MatType bias(parameters.memptr() + offset + weights.n_elem,
+        outSize, 1);
+    quantized = new QuantizedLinearType<MatType>(weights, bias);
+  }
+  else if (container != NULL)
+  {
+    // The copy of the container holds copies of its layers, which are
+    // replaced by their quantized copies.
+    MultiLayer<MatType>* copy =
+        dynamic_cast<MultiLayer<MatType>*>(layer->Clone());
+    size_t childOffset = offset;
+    for (size_t i = 0; i < container->Network().size(); ++i)
+    {
+      Layer<MatType>* child = Rebuild(container->Network()[i], childOffset,
+          parameters, values);
+      delete copy->Network()[i];
+      copy->Network()[i] = child;
+    }
+
+    offset += weightSize;
+    return copy;
+  }
+
+  offset += weightSize;
+  if (quantized != NULL)
+  {
+    quantizedLayers++;
+    return quantized;
+  }
+
+  if (weightSize > 0)
+    values.push_back(parameters.rows(offset - weightSize, offset - 1));
+
+  Layer<MatType>* copy = layer->Clone();
+  copies.push_back(std::make_pair(layer, copy));
+  return copy;
+}
+
+template<typename MatType>
+template<typename LayerType>
+Layer<MatType>* Quantizer<MatType>::QuantizeConvolution(
+    const LayerType& convolution,
+    const size_t groups,
+    const size_t offset,
+    const MatType& parameters)
+{
+  size_t inMaps = 1;
+  for (size_t d = 2; d < convolution.InputDimensions().size(); ++d)
+    inMaps *= convolution.InputDimensions()[d];
+
+  // The weight slices are ordered by output map, so the kernels of each
+  // output map are a column.
+  const size_t maps = convolution.Maps();
+  const size_t kernelSize = convolution.KernelWidth() *
+      convolution.KernelHeight() * inMaps / groups;
+  const size_t weightSize = kernelSize * maps;
+  const bool hasBias = (convolution.WeightSize() == weightSize + maps);
+
+  const MatType weights(parameters.memptr() + offset, kernelSize, maps);
+  MatType bias;
+  if (hasBias)
+    bias = MatType(parameters.memptr() + offset + weightSize, maps, 1);
+
+  return new QuantizedConvolutionType<MatType>(weights, bias,
+      convolution.KernelWidth(), convolution.KernelHeight(),
+      convolution.StrideWidth(), convolution.StrideHeight(),
+      convolution.PadWLeft(), convolution.PadWRight(),
+      convolution.PadHTop(), convolution.PadHBottom(), groups);
+}
+
+template<typename MatType>
+void Quantizer<MatType>::Finalize(const std::vector<Layer<MatType>*>& network)
+{
+  for (Layer<MatType>* layer : network)
+  {
+    QuantizedConvolutionType<MatType>* convolution =
+        dynamic_cast<QuantizedConvolutionType<MatType>*>(layer);
+    QuantizedLinearType<MatType>* linear =
+        dynamic_cast<QuantizedLinearType<MatType>*>(layer);
+    MultiLayer<MatType>* container = dynamic_cast<MultiLayer<MatType>*>(layer);
+
+    if (convolution != NULL)
+      convolution->InputScale() = convolution->InputRange() / Int8Range;
+    else if (linear != NULL)
+      linear->InputScale() = linear->InputRange() / Int8Range;
+    else if (container != NULL)
+      Finalize(container->Network());
+  }
+}
+
+template<typename MatType>
+template<
+  typename OutputLayerType,
+  typename InitializationRuleType,
+  typename LabelsType
+>
+double Quantizer<MatType>::Accuracy(
+    FFN<OutputLayerType, InitializationRuleType, MatType>& model,
+    const MatType& features,
+    const LabelsType& labels)
+{
+  if (features.n_cols == 0 || labels.n_cols != features.n_cols)
+  {
+    mlpack::Log::Fatal << "Quantizer::Evaluate(): the validation split must "
+        << "hold a label for each sample." << std::endl;
+  }
+
+  MatType predictions;
+  model.Predict(features, predictions);
+
+  // The labels are either the class of each sample or one-hot encoded.
+  size_t correct = 0;
+  for (size_t i = 0; i < features.n_cols; ++i)
+  {
+    const size_t label = (labels.n_rows == 1) ?
+        (size_t) std::round((double) labels(0, i)) :
+        (size_t) labels.col(i).index_max();
+    if (predictions.col(i).index_max() == label)
+      correct++;
+  }
+
+  return (double) correct / features.n_cols;
+}
+
+} // namespace models
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,184 @@
+/**
+ * @file weight_file.hpp
+ * @author Kartik Dutt
+ *
+ * Definition of WeightFile, a flat weight format which is memory-mapped and
+ * bound to the parameters of a model without copying them.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_UTILS_WEIGHT_FILE_HPP
+#define MODELS_UTILS_WEIGHT_FILE_HPP
+
+#define MLPACK_ENABLE_ANN_SERIALIZATION
+#include <mlpack.hpp>
+#include <layers/conv_bn_leaky_relu.hpp>
+
+namespace mlpack {
+namespace models {
+
+/**
+ * A flat weight file, which holds the weights of a network so that they can
+ * be memory-mapped and used in place. Loading a model with data::Load()
+ * deserializes every layer and copies every weight; a weight file only needs
+ * the architecture, which the model builders create, and binds the
+ * parameters of the network to the mapped file. The pages of the file are
+ * read when the weights are first used and copied only if they are modified.
+ *
+ * The file consists of
+ *
+ *  - a header, with the magic "MLPKWGT", the version, the size of an element
+ *    and the number of layers, parameters and statistics,
+ *  - a table with an entry for each layer of the network: the offset and the
+ *    size of its weights and of its statistics,
+ *  - the parameters of the network, aligned to a page, in the order of the
+ *    layers as FFN::Parameters() holds them,
+ *  - the statistics, the running mean and variance of each BatchNorm and
+ *    ConvBNLeakyReLU layer, which aren't part of the parameters.
+ *
+ * The layers of the table are the layers of the network, so a network can be
+ * bound to the first layers of a file, e.g. a model built with includeTop set
+ * to false to the weights of the model with its classifier.
+ *
+ * @code
+ * WeightFile<>::Save("resnet50.weights", resNet.GetModel());
+ *
+ * // Later, build the backbone and bind it to the file.
+ * ResNet50 backbone(3, 224, 224, false);
+ * WeightFile<> weights("resnet50.weights");
+ * weights.Bind(backbone.GetModel());
+ * @endcode
+ *
+ * The WeightFile must outlive the networks bound to it.
+ *
+ * @tparam MatType Matrix type of the network.
+ */
+template<typename MatType = arma::mat>
+class WeightFile
+{
+ public:
+  //! Create an empty WeightFile.
+  WeightFile();
+
+  /**
+   * Map the given weight file.
+   *
+   * @param filePath Path of the weight file.
+   */
+  WeightFile(const std::string& filePath);
+
+  //! Unmap the weight file.
+  ~WeightFile();
+
+  //! The mapping can't be shared by copies.
+  WeightFile(const WeightFile&) = delete;
+  WeightFile& operator=(const WeightFile&) = delete;
+
+  /**
+   * Bind the parameters and the statistics of the given network to the
+   * weight file. The network must have its input dimensions, but doesn't
+   * need to be initialized; it may have fewer layers than the file, which
+   * are then bound to the first layers of the file.
+   *
+   * @param model Network to bind.
+   * @return Number of bound layers.
+   */
+  template<typename OutputLayerType, typename InitializationRuleType>
+  size_t Bind(FFN<OutputLayerType, InitializationRuleType, MatType>& model);
+
+  /**
+   * Save the weights of the given network as a weight file.
+   *
+   * @param filePath Path of the weight file.
+   * @param model Network to save, which must be initialized.
+   */
+  template<typename OutputLayerType, typename InitializationRuleType>
+  static void Save(
+      const std::string& filePath,
+      const FFN<OutputLayerType, InitializationRuleType, MatType>& model);
+
+  /**
+   * Check whether the given file is a weight file.
+   *
+   * @param filePath Path of the file.
+   */
+  static bool IsWeightFile(const std::string& filePath);
+
+  //! Get the number of layers of the file.
+  size_t Layers() const { return header ? header->layers : 0; }
+
+  //! Get the number of parameters of the file.
+  size_t Parameters() const { return header ? header->parameters : 0; }
+
+ private:
+  //! The header of a weight file.
+  struct Header
+  {
+    char magic[8];
+    uint32_t version;
+    uint32_t elementSize;
+    uint64_t layers;
+    uint64_t parameters;
+    uint64_t statistics;
+    uint64_t dataOffset;
+    uint64_t statisticsOffset;
+    uint64_t reserved;
+  };
+
+  //! The entry of a layer in the table of a weight file, offsets and sizes
+  //! are in elements.
+  struct Entry
+  {
+    uint64_t weightOffset;
+    uint64_t weightSize;
+    uint64_t statisticsOffset;
+    uint64_t statisticsSize;
+  };
+
+  /**
+   * Collect the running statistics of the given layer and the layers it
+   * holds, the mean and the variance of each normalization, with their sizes
+   * given by the dimensions of the layers. The statistics of a network which
+   * was never run may still be empty.
+   *
+   * @param layer The layer.
+   * @param statistics The collected statistics.
+   * @param sizes The number of elements of each statistic.
+   */
+  static void Statistics(const Layer<MatType>* layer,
+                         std::vector<const MatType*>& statistics,
+                         std::vector<size_t>& sizes);
+
+  /**
+   * Check that the header, the layer table and the data of the mapped file
+   * lie within the mapping.
+   *
+   * @param filePath Path of the file, for the error messages.
+   */
+  void Check(const std::string& filePath) const;
+
+  //! Release the mapped file.
+  void Unmap();
+
+  //! Locally stored mapped file.
+  char* mapping;
+
+  //! Locally stored size of the mapped file.
+  size_t mappingSize;
+
+  //! Locally stored header of the mapped file.
+  const Header* header;
+
+  //! Locally stored table of the mapped file.
+  const Entry* table;
+}; // class WeightFile
+
+} // namespace models
+} // namespace mlpack
+
+#include "weight_file_impl.hpp"
+
+#endif
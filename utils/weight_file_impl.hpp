@@ -0,0 +1,406 @@
+/**
+ * @file weight_file_impl.hpp
+ * @author Kartik Dutt
+ *
+ * Implementation of WeightFile.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MODELS_UTILS_WEIGHT_FILE_IMPL_HPP
+#define MODELS_UTILS_WEIGHT_FILE_IMPL_HPP
+
+// Incase it has not been included already.
+#include "weight_file.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#ifndef _WIN32
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+namespace mlpack {
+namespace models {
+
+template<typename MatType>
+WeightFile<MatType>::WeightFile() :
+    mapping(NULL),
+    mappingSize(0),
+    header(NULL),
+    table(NULL)
+{
+  // Nothing to do here.
+}
+
+template<typename MatType>
+WeightFile<MatType>::WeightFile(const std::string& filePath) :
+    mapping(NULL),
+    mappingSize(0),
+    header(NULL),
+    table(NULL)
+{
+  if (!IsWeightFile(filePath))
+  {
+    mlpack::Log::Fatal << "WeightFile: " << filePath << " is not a weight "
+        << "file." << std::endl;
+  }
+
+  #ifdef _WIN32
+    // Without mmap(), the file is read into memory.
+    std::ifstream file(filePath, std::ios::binary | std::ios::ate);
+    mappingSize = file.tellg();
+    mapping = new char[mappingSize];
+    file.seekg(0);
+    file.read(mapping, mappingSize);
+  #else
+    // The mapping is private, so the weights can be modified, e.g. by
+    // training, without writing to the file.
+    const int file = open(filePath.c_str(), O_RDONLY);
+    struct stat status;
+    if (file < 0 || fstat(file, &status) != 0)
+    {
+      mlpack::Log::Fatal << "WeightFile: cannot open " << filePath << "."
+          << std::endl;
+    }
+
+    mappingSize = status.st_size;
+    void* address = mmap(NULL, mappingSize, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE, file, 0);
+    close(file);
+    if (address == MAP_FAILED)
+    {
+      mlpack::Log::Fatal << "WeightFile: cannot map " << filePath << "."
+          << std::endl;
+    }
+
+    mapping = static_cast<char*>(address);
+  #endif
+
+  // The destructor doesn't run if the constructor throws.
+  try
+  {
+    Check(filePath);
+  }
+  catch (...)
+  {
+    Unmap();
+    throw;
+  }
+
+  header = reinterpret_cast<const Header*>(mapping);
+  table = reinterpret_cast<const Entry*>(mapping + sizeof(Header));
+}
+
+template<typename MatType>
+WeightFile<MatType>::~WeightFile()
+{
+  Unmap();
+}
+
+template<typename MatType>
+template<typename OutputLayerType, typename InitializationRuleType>
+size_t WeightFile<MatType>::Bind(
+    FFN<OutputLayerType, InitializationRuleType, MatType>& model)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  if (header == NULL)
+  {
+    mlpack::Log::Fatal << "WeightFile::Bind(): no weight file is mapped."
+        << std::endl;
+  }
+
+  if (model.InputDimensions().empty())
+  {
+    mlpack::Log::Fatal << "WeightFile::Bind(): the input dimensions of the "
+        << "model must be set." << std::endl;
+  }
+
+  std::vector<Layer<MatType>*>& network = model.Network();
+  if (network.size() > header->layers)
+  {
+    mlpack::Log::Fatal << "WeightFile::Bind(): the model has "
+        << network.size() << " layers, but the weight file only has "
+        << header->layers << "." << std::endl;
+  }
+
+  // The weight sizes of the layers follow from their dimensions.
+  std::vector<size_t> dimensions = model.InputDimensions();
+  size_t parameters = 0;
+  for (size_t i = 0; i < network.size(); ++i)
+  {
+    network[i]->InputDimensions() = dimensions;
+    network[i]->ComputeOutputDimensions();
+    dimensions = network[i]->OutputDimensions();
+
+    if (network[i]->WeightSize() != table[i].weightSize)
+    {
+      mlpack::Log::Fatal << "WeightFile::Bind(): layer " << i << " of the "
+          << "model has " << network[i]->WeightSize() << " weights, but the "
+          << "weight file has " << table[i].weightSize << "." << std::endl;
+    }
+
+    parameters += table[i].weightSize;
+  }
+
+  // The parameters of the first layers are the beginning of the parameters
+  // of the file.
+  ElemType* data = reinterpret_cast<ElemType*>(mapping + header->dataOffset);
+  MakeAlias(model.Parameters(), data, parameters, 1);
+  for (size_t i = 0; i < network.size(); ++i)
+    network[i]->SetWeights(data + table[i].weightOffset);
+
+  // The statistics are small, so they are copied.
+  const ElemType* statistics = reinterpret_cast<const ElemType*>(mapping +
+      header->statisticsOffset);
+  for (size_t i = 0; i < network.size(); ++i)
+  {
+    std::vector<const MatType*> layerStatistics;
+    std::vector<size_t> sizes;
+    Statistics(network[i], layerStatistics, sizes);
+    if (std::accumulate(sizes.begin(), sizes.end(), (size_t) 0) !=
+        table[i].statisticsSize)
+    {
+      mlpack::Log::Fatal << "WeightFile::Bind(): the statistics of layer "
+          << i << " don't match the weight file." << std::endl;
+    }
+
+    // The statistics belong to the model, which is bound, so they are
+    // written.
+    size_t offset = table[i].statisticsOffset;
+    for (size_t j = 0; j < layerStatistics.size(); ++j)
+    {
+      MatType& statistic = const_cast<MatType&>(*layerStatistics[j]);
+      statistic.set_size(sizes[j], 1);
+      std::copy(statistics + offset, statistics + offset + sizes[j],
+          statistic.memptr());
+      offset += sizes[j];
+    }
+  }
+
+  return network.size();
+}
+
+template<typename MatType>
+template<typename OutputLayerType, typename InitializationRuleType>
+void WeightFile<MatType>::Save(
+    const std::string& filePath,
+    const FFN<OutputLayerType, InitializationRuleType, MatType>& model)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  const MatType& parameters = model.Parameters();
+  if (parameters.n_elem == 0)
+  {
+    mlpack::Log::Fatal << "WeightFile::Save(): the model must be initialized, "
+        << "e.g. trained or Reset(), before it is saved." << std::endl;
+  }
+
+  const std::vector<Layer<MatType>*>& network = model.Network();
+  std::vector<Entry> entries(network.size());
+  std::vector<const MatType*> statistics;
+  std::vector<size_t> sizes;
+  size_t weightOffset = 0, statisticsOffset = 0;
+  for (size_t i = 0; i < network.size(); ++i)
+  {
+    const size_t collected = sizes.size();
+    Statistics(network[i], statistics, sizes);
+    const size_t statisticsSize = std::accumulate(sizes.begin() + collected,
+        sizes.end(), (size_t) 0);
+
+    entries[i] = Entry{weightOffset, network[i]->WeightSize(),
+        statisticsOffset, statisticsSize};
+    weightOffset += network[i]->WeightSize();
+    statisticsOffset += statisticsSize;
+  }
+
+  if (weightOffset != parameters.n_elem)
+  {
+    mlpack::Log::Fatal << "WeightFile::Save(): the layers of the model have "
+        << weightOffset << " weights, but the model has " << parameters.n_elem
+        << " parameters." << std::endl;
+  }
+
+  // The parameters start on a page and the statistics on a cache line.
+  const size_t tableEnd = sizeof(Header) + entries.size() * sizeof(Entry);
+  const size_t dataOffset = (tableEnd + 4095) / 4096 * 4096;
+  const size_t dataEnd = dataOffset + parameters.n_elem * sizeof(ElemType);
+
+  Header fileHeader;
+  std::memset(&fileHeader, 0, sizeof(Header));
+  std::memcpy(fileHeader.magic, "MLPKWGT", 8);
+  fileHeader.version = 1;
+  fileHeader.elementSize = sizeof(ElemType);
+  fileHeader.layers = network.size();
+  fileHeader.parameters = parameters.n_elem;
+  fileHeader.statistics = statisticsOffset;
+  fileHeader.dataOffset = dataOffset;
+  fileHeader.statisticsOffset = (dataEnd + 63) / 64 * 64;
+
+  std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+  if (!file.is_open())
+  {
+    mlpack::Log::Fatal << "WeightFile::Save(): cannot open " << filePath
+        << "." << std::endl;
+  }
+
+  const std::vector<char> padding(4096, 0);
+  file.write(reinterpret_cast<const char*>(&fileHeader), sizeof(Header));
+  file.write(reinterpret_cast<const char*>(entries.data()),
+      entries.size() * sizeof(Entry));
+  file.write(padding.data(), dataOffset - tableEnd);
+  file.write(reinterpret_cast<const char*>(parameters.memptr()),
+      parameters.n_elem * sizeof(ElemType));
+  file.write(padding.data(), fileHeader.statisticsOffset - dataEnd);
+  // Statistics which were never computed are written as the initial ones,
+  // a mean of zero and a variance of one.
+  for (size_t j = 0; j < statistics.size(); ++j)
+  {
+    if (statistics[j]->n_elem == sizes[j])
+    {
+      file.write(reinterpret_cast<const char*>(statistics[j]->memptr()),
+          sizes[j] * sizeof(ElemType));
+    }
+    else
+    {
+      const std::vector<ElemType> initial(sizes[j], ElemType(j % 2));
+      file.write(reinterpret_cast<const char*>(initial.data()),
+          sizes[j] * sizeof(ElemType));
+    }
+  }
+
+  if (!file.good())
+  {
+    mlpack::Log::Fatal << "WeightFile::Save(): cannot write " << filePath
+        << "." << std::endl;
+  }
+}
+
+template<typename MatType>
+bool WeightFile<MatType>::IsWeightFile(const std::string& filePath)
+{
+  std::ifstream file(filePath, std::ios::binary);
+  char magic[8];
+  if (!file.read(magic, 8))
+    return false;
+
+  return std::memcmp(magic, "MLPKWGT", 8) == 0;
+}
+
+template<typename MatType>
+void WeightFile<MatType>::Statistics(const Layer<MatType>* layer,
+                                     std::vector<const MatType*>& statistics,
+                                     std::vector<size_t>& sizes)
+{
+  const BatchNormType<MatType>* batchNorm =
+      dynamic_cast<const BatchNormType<MatType>*>(layer);
+  const ConvBNLeakyReLUType<MatType>* convBNLeakyReLU =
+      dynamic_cast<const ConvBNLeakyReLUType<MatType>*>(layer);
+  if (batchNorm != NULL)
+  {
+    // The weights of the normalization are its scale and shift.
+    statistics.push_back(&batchNorm->TrainingMean());
+    statistics.push_back(&batchNorm->TrainingVariance());
+    sizes.insert(sizes.end(), 2, batchNorm->WeightSize() / 2);
+    return;
+  }
+  else if (convBNLeakyReLU != NULL)
+  {
+    statistics.push_back(&convBNLeakyReLU->TrainingMean());
+    statistics.push_back(&convBNLeakyReLU->TrainingVariance());
+    sizes.insert(sizes.end(), 2, convBNLeakyReLU->Maps());
+    return;
+  }
+
+  const MultiLayer<MatType>* container =
+      dynamic_cast<const MultiLayer<MatType>*>(layer);
+  if (container == NULL)
+    return;
+
+  for (const Layer<MatType>* child : container->Network())
+    Statistics(child, statistics, sizes);
+}
+
+template<typename MatType>
+void WeightFile<MatType>::Check(const std::string& filePath) const
+{
+  if (mappingSize < sizeof(Header))
+  {
+    mlpack::Log::Fatal << "WeightFile: " << filePath << " is truncated."
+        << std::endl;
+  }
+
+  const Header* fileHeader = reinterpret_cast<const Header*>(mapping);
+  const size_t elementSize = sizeof(typename MatType::elem_type);
+  if (fileHeader->elementSize != elementSize)
+  {
+    mlpack::Log::Fatal << "WeightFile: " << filePath << " holds elements of "
+        << fileHeader->elementSize << " bytes, but the matrix type has "
+        << "elements of " << elementSize << " bytes; use the "
+        << "PrecisionConverter to convert the weights." << std::endl;
+  }
+
+  // Each region is compared with the room left after its offset, so large
+  // sizes in a damaged header can't overflow.
+  auto fits = [](const uint64_t offset, const uint64_t count,
+      const size_t unit, const size_t size)
+  {
+    return offset <= size && count <= (size - offset) / unit;
+  };
+
+  if (!fits(sizeof(Header), fileHeader->layers, sizeof(Entry), mappingSize) ||
+      !fits(fileHeader->dataOffset, fileHeader->parameters, elementSize,
+          mappingSize) ||
+      !fits(fileHeader->statisticsOffset, fileHeader->statistics,
+          elementSize, mappingSize))
+  {
+    mlpack::Log::Fatal << "WeightFile: " << filePath << " is truncated."
+        << std::endl;
+  }
+
+  if (fileHeader->dataOffset % elementSize != 0 ||
+      fileHeader->statisticsOffset % elementSize != 0)
+  {
+    mlpack::Log::Fatal << "WeightFile: the data of " << filePath << " isn't "
+        << "aligned to its elements." << std::endl;
+  }
+
+  const Entry* entries = reinterpret_cast<const Entry*>(mapping +
+      sizeof(Header));
+  for (size_t i = 0; i < fileHeader->layers; ++i)
+  {
+    if (!fits(entries[i].weightOffset, entries[i].weightSize, 1,
+            fileHeader->parameters) ||
+        !fits(entries[i].statisticsOffset, entries[i].statisticsSize, 1,
+            fileHeader->statistics))
+    {
+      mlpack::Log::Fatal << "WeightFile: layer " << i << " of " << filePath
+          << " lies outside of the file." << std::endl;
+    }
+  }
+}
+
+template<typename MatType>
+void WeightFile<MatType>::Unmap()
+{
+  if (mapping == NULL)
+    return;
+
+  #ifdef _WIN32
+    delete[] mapping;
+  #else
+    munmap(mapping, mappingSize);
+  #endif
+  mapping = NULL;
+}
+
+} // namespace models
+} // namespace mlpack
+
+#endif